@@ -0,0 +1,137 @@
+// BrokerBenchmark.cpp : Measures how many messages per second producer threads can pump into one MessageBroker.
+// Run with the argument "pool" to deliver the messages with the default ThreadPool instead of the brokers own threads.
+//
+
+#include <MessageBroker.h>
+#include <ExplicitMessages.h>
+#include <Atomic.h>
+
+#include <iostream>
+#include <vector>
+#include <cstring>
+
+#ifdef linux
+#	include <sys/time.h>
+#endif
+
+#define NUM_MESSAGES 400000
+
+/**
+ * @brief	Returns the current time in seconds.
+ */
+double now()
+{
+#ifdef linux
+	struct timeval tv;
+	gettimeofday( &tv, NULL );
+	return tv.tv_sec + tv.tv_usec / 1000000.0;
+#else
+	return GetTickCount() / 1000.0;
+#endif
+}
+
+/**
+ * @brief	Counts the delivered messages.
+ */
+class CountingListener : public oocl::MessageListener
+{
+public:
+	CountingListener() : m_uiReceived( 0 ) {}
+
+	bool cbMessage( oocl::Message const * const pMessage )
+	{
+		m_uiReceived.fetchAdd( 1 );
+		return true;
+	}
+
+	oocl::Atomic<unsigned int> m_uiReceived;
+};
+
+/**
+ * @brief	Pumps its share of the messages as fast as possible once the start flag is set.
+ */
+class Producer : public oocl::Thread
+{
+public:
+	Producer( oocl::MessageBroker* pBroker, oocl::Atomic<unsigned int>* pStart, unsigned int uiMessages )
+		: m_pBroker( pBroker )
+		, m_pStart( pStart )
+	{
+		// allocate the messages up front, so that only the queue is measured
+		for( unsigned int i = 0; i < uiMessages; i++ )
+			m_vpMessages.push_back( new oocl::StandardMessage( "benchmark" ) );
+	}
+
+protected:
+	void run()
+	{
+		while( m_pStart->load() == 0 );
+
+		for( unsigned int i = 0; i < m_vpMessages.size(); i++ )
+			m_pBroker->pumpMessage( m_vpMessages[i] );
+	}
+
+private:
+	oocl::MessageBroker* m_pBroker;
+	oocl::Atomic<unsigned int>* m_pStart;
+	std::vector<oocl::Message*> m_vpMessages;
+};
+
+int main( int argc, char** argv )
+{
+	oocl::Log::getLog( "oocl" )->setLogLevel( oocl::Log::EL_WARNING );
+
+	if( argc > 1 && strcmp( argv[1], "pool" ) == 0 )
+		oocl::MessageBroker::setThreadPool( oocl::ThreadPool::getDefault() );
+
+	const unsigned int auiProducers[] = { 1, 4, 16 };
+
+	for( unsigned int uiRun = 0; uiRun < 3; uiRun++ )
+	{
+		unsigned int uiProducers = auiProducers[uiRun];
+		unsigned int uiPerProducer = NUM_MESSAGES / uiProducers;
+
+		// every run gets its own broker and with it its own queue and thread
+		oocl::MessageBroker* pBroker = oocl::MessageBroker::getBrokerFor( 1000 + uiRun );
+		pBroker->enableContinuousProcessing();
+
+		CountingListener listener;
+		pBroker->registerListener( &listener );
+
+		oocl::Atomic<unsigned int> uiStart( 0 );
+		std::vector<Producer*> vpProducers;
+		for( unsigned int i = 0; i < uiProducers; i++ )
+		{
+			vpProducers.push_back( new Producer( pBroker, &uiStart, uiPerProducer ) );
+			vpProducers.back()->start();
+		}
+
+		// join() only waits for threads that are already running
+		for( unsigned int i = 0; i < uiProducers; i++ )
+			while( !vpProducers[i]->isAlive() )
+				oocl::Thread::sleep( 1 );
+
+		double dStart = now();
+		uiStart.store( 1 );
+
+		for( unsigned int i = 0; i < uiProducers; i++ )
+			vpProducers[i]->join();
+
+		double dPumped = now();
+
+		while( listener.m_uiReceived.load() < uiPerProducer * uiProducers )
+			oocl::Thread::sleep( 1 );
+
+		double dDelivered = now();
+
+		std::cout << uiProducers << " producer(s): "
+			<< (unsigned int)( uiPerProducer * uiProducers / (dPumped - dStart) ) << " messages/s pumped, "
+			<< (unsigned int)( uiPerProducer * uiProducers / (dDelivered - dStart) ) << " messages/s delivered" << std::endl;
+
+		pBroker->unregisterListener( &listener );
+		for( unsigned int i = 0; i < uiProducers; i++ )
+			delete vpProducers[i];
+	}
+
+	return 0;
+}
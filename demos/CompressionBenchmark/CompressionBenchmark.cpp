@@ -0,0 +1,163 @@
+// CompressionBenchmark.cpp : Compares the bytes on the wire and the cpu time of the codecs for typical message bodies.
+// Run with a number as argument to change the number of repetitions per measurement.
+//
+
+#include <ExplicitMessages.h>
+#include <Codec.h>
+
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <cstdlib>
+#include <cstring>
+
+#ifdef linux
+#	include <sys/time.h>
+#endif
+
+/**
+ * @brief	Returns the current time in seconds.
+ */
+double now()
+{
+#ifdef linux
+	struct timeval tv;
+	gettimeofday( &tv, NULL );
+	return tv.tv_sec + tv.tv_usec / 1000000.0;
+#else
+	return GetTickCount() / 1000.0;
+#endif
+}
+
+/**
+ * @brief	State records as JSON text, like the snapshots that are sent between peers.
+ */
+std::string makeJSON( unsigned int uiLength )
+{
+	std::ostringstream os;
+	os << "{\"entities\":[";
+
+	srand( 42 );
+	for( unsigned int i = 0; os.tellp() < (std::streampos)uiLength; i++ )
+	{
+		os << "{\"id\":" << i << ",\"type\":\"" << ( rand() % 2 ? "player" : "npc" )
+		   << "\",\"position\":{\"x\":" << rand() % 10000 << ".5,\"y\":" << rand() % 10000 << ".25,\"z\":0.0}"
+		   << ",\"health\":" << rand() % 100 << ",\"alive\":true},";
+	}
+
+	return os.str().substr( 0, uiLength );
+}
+
+/**
+ * @brief	Log lines, very repetitive text.
+ */
+std::string makeLog( unsigned int uiLength )
+{
+	std::ostringstream os;
+
+	srand( 7 );
+	for( unsigned int i = 0; os.tellp() < (std::streampos)uiLength; i++ )
+		os << "12:00:" << i % 60 << " INFO       : Peer " << rand() % 16 << " sent message " << rand() % 8 << " with " << rand() % 2000 << " bytes\n";
+
+	return os.str().substr( 0, uiLength );
+}
+
+/**
+ * @brief	Random bytes, e.g. already compressed or encrypted data.
+ */
+std::string makeRandom( unsigned int uiLength )
+{
+	std::string str( uiLength, 0 );
+
+	srand( 1 );
+	for( unsigned int i = 0; i < uiLength; i++ )
+		str[i] = (char)( rand() & 0xFF );
+
+	return str;
+}
+
+/**
+ * @brief	Compresses and decompresses one message uiRepetitions times with the given codec and prints the results.
+ */
+void measure( const char* pcPayload, const std::string& strBody, unsigned char ucCodec, const char* pcCodec, unsigned int uiRepetitions )
+{
+	oocl::Codec::useFor( MT_StandardMessage, ucCodec, 0 );
+
+	oocl::StandardMessage message( strBody );
+	oocl::WriteBuffer wbFrame( strBody.size() + 64 );
+	oocl::WriteBuffer wbScratch( strBody.size() + 64 );
+	std::string strInflated;
+
+	unsigned int uiOriginal = 0;
+	bool bCompressed = false;
+
+	double dStart = now();
+	for( unsigned int i = 0; i < uiRepetitions; i++ )
+	{
+		wbFrame.clear();
+		message.serializeInto( wbFrame );
+		uiOriginal = wbFrame.size();
+		bCompressed = oocl::Codec::compressFrame( wbFrame, ~0u, wbScratch );
+	}
+	double dCompress = ( now() - dStart ) / uiRepetitions;
+
+	double dDecompress = 0.0;
+	if( bCompressed )
+	{
+		dStart = now();
+		for( unsigned int i = 0; i < uiRepetitions; i++ )
+		{
+			if( !oocl::Codec::decompressFrame( wbFrame.data(), wbFrame.size(), strInflated ) )
+			{
+				std::cout << "decompression failed!" << std::endl;
+				return;
+			}
+		}
+		dDecompress = ( now() - dStart ) / uiRepetitions;
+
+		if( strInflated.size() != uiOriginal || std::memcmp( strInflated.data() + 4 + ( uiOriginal > 0xFFFF ? 4 : 0 ), strBody.data(), strBody.size() ) != 0 )
+			std::cout << "decompressed message differs!" << std::endl;
+	}
+
+	std::cout << std::setw(8) << pcPayload << std::setw(9) << strBody.size() << std::setw(6) << pcCodec
+		<< std::setw(10) << wbFrame.size()
+		<< std::setw(8) << std::fixed << std::setprecision(2) << (double)uiOriginal / wbFrame.size()
+		<< std::setw(12) << std::setprecision(1) << dCompress * 1000000.0
+		<< std::setw(12) << dDecompress * 1000000.0
+		<< std::setw(10) << std::setprecision(0) << ( dCompress > 0.0 ? uiOriginal / dCompress / 1000000.0 : 0.0 )
+		<< std::endl;
+}
+
+int main( int argc, char** argv )
+{
+	oocl::Log::getLog( "oocl" )->setLogLevel( oocl::Log::EL_WARNING );
+
+	unsigned int uiRepetitions = argc > 1 ? atoi( argv[1] ) : 200;
+	const unsigned int auiSizes[] = { 200, 4096, 65536, 1048576 };
+
+	std::cout << " payload     size codec  on wire   ratio  compr [us]  decomp [us]  MB/s" << std::endl;
+
+	for( unsigned int uiPayload = 0; uiPayload < 3; uiPayload++ )
+	{
+		for( unsigned int uiSize = 0; uiSize < 4; uiSize++ )
+		{
+			std::string strBody;
+			const char* pcPayload = NULL;
+			switch( uiPayload )
+			{
+			case 0: strBody = makeJSON( auiSizes[uiSize] ); pcPayload = "json"; break;
+			case 1: strBody = makeLog( auiSizes[uiSize] ); pcPayload = "log"; break;
+			default: strBody = makeRandom( auiSizes[uiSize] ); pcPayload = "random"; break;
+			}
+
+			unsigned int uiRuns = auiSizes[uiSize] > 65536 ? uiRepetitions / 10 + 1 : uiRepetitions;
+
+			measure( pcPayload, strBody, CODEC_None, "none", uiRuns );
+			measure( pcPayload, strBody, CODEC_LZ, "lz", uiRuns );
+			if( oocl::Codec::getCodec( CODEC_Zlib ) != NULL )
+				measure( pcPayload, strBody, CODEC_Zlib, "zlib", uiRuns );
+		}
+	}
+
+	return 0;
+}
@@ -16,36 +16,8 @@ subject to the following restrictions:
 #include "ChatMessage.h"
 
 
-ChatMessage::ChatMessage( unsigned int uiUserID, std::string strMessage ) :
-	m_uiUserID( uiUserID ),
-	m_strMessage( strMessage )
+ChatMessage::ChatMessage( unsigned int uiUserID, std::string strMessage )
 {
-	m_iProtocoll = SOCK_STREAM;
-	m_type = MT_ChatMessage;
+	m_value0 = uiUserID;
+	m_value1 = strMessage;
 }
-	
-std::string ChatMessage::getMsgString()
-{
-	unsigned short usMsg[4];
-	usMsg[0] = MT_ChatMessage;
-	usMsg[1] = getBodyLength();
-	usMsg[2] = ((unsigned short*)&m_uiUserID)[0]; // TODO: this seems unnessecary
-	usMsg[3] = ((unsigned short*)&m_uiUserID)[1];
-
-	std::string strHeader( (char*)usMsg, 8 );
-
-	return strHeader+m_strMessage;
-}
-
-unsigned short ChatMessage::getBodyLength()
-{
-	return 4 + m_strMessage.length();
-}
-
-oocl::Message* ChatMessage::create(const char * in)
-{
-	unsigned int uiUserID = ((unsigned int*)in)[1];
-	std::string strMessage( &in[8], ((unsigned short*)in)[1]-4 );
-
-	return new ChatMessage( uiUserID, strMessage );
-}
\ No newline at end of file
@@ -16,30 +16,17 @@ subject to the following restrictions:
 #ifndef CHATMESSAGE_H
 #define CHATMESSAGE_H
 
-#include <Message.h>
+#include <MessageSchema.h>
 
 #define MT_ChatMessage 6
-class ChatMessage : public oocl::Message
+class ChatMessage : public oocl::MessageSchema< ChatMessage, MT_ChatMessage, oocl::Field<unsigned int>, oocl::VarBytes >
 {
 public:
-	static void registerMsg(){
-		Message::registerMsg( MT_ChatMessage, ChatMessage::create );
-	}
-
+	ChatMessage() {}
 	ChatMessage( unsigned int uiUserID, std::string strMessage );
-	
-	virtual std::string getMsgString();
-	virtual unsigned short getBodyLength();
-	
-	unsigned int	getPeerID() { return m_uiUserID; }
-	std::string		getMessage() { return m_strMessage; }
-
-protected:
-	static Message* create(const char * in);
 
-private:
-	unsigned int	m_uiUserID;
-	std::string		m_strMessage;
+	unsigned int	getPeerID() { return m_value0; }
+	std::string		getMessage() { return m_value1; }
 };
 
 #endif // CHATMESSAGE_H
\ No newline at end of file
@@ -16,36 +16,8 @@ subject to the following restrictions:
 #include "IntroductionMessage.h"
 
 
-IntroductionMessage::IntroductionMessage( unsigned int uiUserID, std::string strUsername ) :
-	m_uiUserID( uiUserID ),
-	m_strUsername( strUsername )
+IntroductionMessage::IntroductionMessage( unsigned int uiUserID, std::string strUsername )
 {
-	m_iProtocoll = SOCK_STREAM;
-	m_type = MT_IntroductionMessage;
+	m_value0 = uiUserID;
+	m_value1 = strUsername;
 }
-	
-std::string IntroductionMessage::getMsgString()
-{
-	unsigned short usMsg[4];
-	usMsg[0] = MT_IntroductionMessage;
-	usMsg[1] = getBodyLength();
-	usMsg[2] = ((unsigned short*)&m_uiUserID)[0];
-	usMsg[3] = ((unsigned short*)&m_uiUserID)[1];
-
-	std::string strHeader( (char*)usMsg, 8 );
-
-	return strHeader+m_strUsername;
-}
-
-unsigned short IntroductionMessage::getBodyLength()
-{
-	return 4 + m_strUsername.length();
-}
-
-oocl::Message* IntroductionMessage::create(const char * in)
-{
-	unsigned int uiUserID = ((unsigned int*)in)[1];
-	std::string strUsername( &in[8], ((unsigned short*)in)[1]-4 );
-
-	return new IntroductionMessage( uiUserID, strUsername );
-}
\ No newline at end of file
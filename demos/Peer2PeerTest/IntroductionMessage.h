@@ -16,31 +16,17 @@ subject to the following restrictions:
 #ifndef INTRODUCTIONMESSAGE_H
 #define INTRODUCTIONMESSAGE_H
 
-#include <Message.h>
+#include <MessageSchema.h>
 
 #define MT_IntroductionMessage 7
-class IntroductionMessage : public oocl::Message
+class IntroductionMessage : public oocl::MessageSchema< IntroductionMessage, MT_IntroductionMessage, oocl::Field<unsigned int>, oocl::VarBytes >
 {
 public:
-	static void registerMsg(){
-		Message::registerMsg( MT_IntroductionMessage, IntroductionMessage::create );
-	}
-
-	IntroductionMessage( unsigned int uiUserID, std::string strUsername);
-	
-	virtual std::string getMsgString();
-	virtual unsigned short getBodyLength();
-	
-	unsigned int	getPeerID() { return m_uiUserID; }
-	std::string		getUsername() { return m_strUsername; }
-
-protected:
-	static Message* create(const char * in);
-
-public:
-	unsigned int	m_uiUserID;
-	std::string		m_strUsername;
+	IntroductionMessage() {}
+	IntroductionMessage( unsigned int uiUserID, std::string strUsername );
 
+	unsigned int	getPeerID() { return m_value0; }
+	std::string		getUsername() { return m_value1; }
 };
 
 #endif // INTRODUCTIONMESSAGE_H
\ No newline at end of file
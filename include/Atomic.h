@@ -0,0 +1,171 @@
+/*
+Object Oriented Communication Library
+Copyright (c) 2011 Jürgen Lorenz and Jörn Teuber
+
+This software is provided 'as-is', without any express or implied warranty.
+In no event will the authors be held liable for any damages arising from the use of this software.
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it freely,
+subject to the following restrictions:
+
+1. The origin of this software must not be misrepresented; you must not claim that you wrote the original software. If you use this software in a product, an acknowledgment in the product documentation would be appreciated but is not required.
+2. Altered source versions must be plainly marked as such, and must not be misrepresented as being the original software.
+3. This notice may not be removed or altered from any source distribution.
+*/
+// This file was written by Jörn Teuber
+
+#ifndef ATOMIC_H_
+#define ATOMIC_H_
+
+#if defined USE_CPP11
+#	include <atomic>
+#elif defined _MSC_VER
+#	include <windows.h>
+#endif
+
+namespace oocl
+{
+	/**
+	 * @brief	Wrapper class for atomic integers and pointers on different platforms.
+	 *
+	 * @note	If USE_CPP11 is defined it uses the c++11 std::atomic, else the gcc builtins or the windows Interlocked functions.
+	 * 			T has to be an integer or pointer type of 4 or 8 bytes. All operations are sequentially consistent.
+	 *
+	 * @author	Jörn Teuber
+	 * @date	16.10.2026
+	 */
+	template<typename T>
+	class Atomic
+	{
+	public:
+		Atomic( T value = T() ) : m_value( value ) {}
+
+		T		load() const;
+		void	store( T value );
+		T		exchange( T value );
+		bool	compareExchange( T& expected, T desired );
+		T		fetchAdd( T value );
+
+	private:
+		Atomic( Atomic& a );
+		Atomic& operator=(const Atomic&);
+
+	private:
+#if defined USE_CPP11
+		std::atomic<T> m_value;
+#else
+		volatile T m_value;
+#endif
+	};
+
+
+	/**
+	 * @brief	Get the current value.
+	 *
+	 * @return	The value.
+	 */
+	template<typename T>
+	T Atomic<T>::load() const
+	{
+#if defined USE_CPP11
+		return m_value.load();
+#elif defined __GNUC__
+		return __atomic_load_n( &m_value, __ATOMIC_SEQ_CST );
+#else
+		MemoryBarrier();
+		T value = m_value;
+		MemoryBarrier();
+		return value;
+#endif
+	}
+
+	/**
+	 * @brief	Set a new value.
+	 *
+	 * @param	value	The new value.
+	 */
+	template<typename T>
+	void Atomic<T>::store( T value )
+	{
+#if defined USE_CPP11
+		m_value.store( value );
+#elif defined __GNUC__
+		__atomic_store_n( &m_value, value, __ATOMIC_SEQ_CST );
+#else
+		exchange( value );
+#endif
+	}
+
+	/**
+	 * @brief	Set a new value and return the old one.
+	 *
+	 * @param	value	The new value.
+	 *
+	 * @return	The value before the exchange.
+	 */
+	template<typename T>
+	T Atomic<T>::exchange( T value )
+	{
+#if defined USE_CPP11
+		return m_value.exchange( value );
+#elif defined __GNUC__
+		return __atomic_exchange_n( &m_value, value, __ATOMIC_SEQ_CST );
+#else
+		T expected = load();
+		while( !compareExchange( expected, value ) );
+		return expected;
+#endif
+	}
+
+	/**
+	 * @brief	Set the value to desired if it is equal to expected.
+	 *
+	 * @param [in,out]	expected	The expected value, set to the current value if the exchange failed.
+	 * @param	desired				The new value.
+	 *
+	 * @return	true if the value was exchanged, false if not.
+	 */
+	template<typename T>
+	bool Atomic<T>::compareExchange( T& expected, T desired )
+	{
+#if defined USE_CPP11
+		return m_value.compare_exchange_strong( expected, desired );
+#elif defined __GNUC__
+		return __atomic_compare_exchange_n( &m_value, &expected, desired, false, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST );
+#else
+		T previous;
+		if( sizeof(T) == 8 )
+			previous = (T)InterlockedCompareExchange64( (volatile LONGLONG*)&m_value, (LONGLONG)desired, (LONGLONG)expected );
+		else
+			previous = (T)InterlockedCompareExchange( (volatile LONG*)&m_value, (LONG)desired, (LONG)expected );
+
+		bool bExchanged = previous == expected;
+		expected = previous;
+		return bExchanged;
+#endif
+	}
+
+	/**
+	 * @brief	Add to the value.
+	 *
+	 * @param	value	The value to add, may be negative for signed types.
+	 *
+	 * @return	The value before the addition.
+	 */
+	template<typename T>
+	T Atomic<T>::fetchAdd( T value )
+	{
+#if defined USE_CPP11
+		return m_value.fetch_add( value );
+#elif defined __GNUC__
+		return __atomic_fetch_add( &m_value, value, __ATOMIC_SEQ_CST );
+#else
+		T expected = load();
+		while( !compareExchange( expected, expected + value ) );
+		return expected;
+#endif
+	}
+
+} /* namespace oocl */
+
+#endif /* ATOMIC_H_ */
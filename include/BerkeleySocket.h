@@ -21,20 +21,26 @@
 #include <sstream>
 #include <cstring>
 #include <errno.h>
+#include <vector>
 
 #ifdef linux
 #	include <unistd.h>
+#	include <poll.h>
+#	include <time.h>
+#	include <sys/uio.h>
 #endif
 
 #include "oocl_import_export.h"
 
 #include "Socket.h"
 #include "Log.h"
+#include "WriteBuffer.h"
 
 namespace oocl
 {
 
 #define MAX_BUFFER_SIZE 1024
+#define MAX_DATAGRAM_SIZE 65507	///< the largest payload of an udp datagram over ipv4
 
 	/**
 	 * @brief	Socket class for simple unencrypted berkeley sockets.
@@ -62,6 +68,7 @@ namespace oocl
 		virtual bool read( char* pcBuf, int& count );
 
 		virtual bool readFrom( std::string& str, int count = 0, unsigned int* hostIP = NULL );
+		virtual int  readDatagrams( DatagramSlab& slab );
 
 		virtual bool write( std::string in );
 		virtual bool write( char in );
@@ -69,6 +76,14 @@ namespace oocl
 
 		virtual bool writeTo( std::string in, std::string host, unsigned short port );
 
+		virtual bool setBatching( EFlushPolicy ePolicy, unsigned int uiThreshold = 0 );
+		virtual bool flush();
+		virtual bool flushIfDue();
+
+		virtual unsigned int getPathMTU();
+
+		static unsigned long long getMicroseconds();
+
 		virtual void close();
 
 		virtual int getCSocket();
@@ -89,6 +104,26 @@ namespace oocl
 
 	private:
 		unsigned int getAddrFromString( const char* hostnameOrIp );
+
+		static bool wouldBlock();
+		bool waitForWritable();
+
+		bool sendAll( const char* in, int count );
+		bool queue( const char* in, int count );
+		bool flushStream( const char* pcExtra, int iExtraCount );
+		bool flushDatagrams();
+
+	private:
+		EFlushPolicy	m_eFlushPolicy;
+		unsigned int	m_uiFlushThreshold;
+
+		WriteBuffer					m_wbOutbound;			///< packages that were written but not sent yet
+		std::vector<unsigned int>	m_vuiDatagramEnds;		///< udp only: the end of every queued package in m_wbOutbound
+		unsigned long long			m_ullFirstQueuedTime;	///< time in microseconds when the oldest queued package was written
+#ifdef linux
+		std::vector<struct mmsghdr>	m_vDatagramHeaders;
+		std::vector<struct iovec>	m_vDatagramVectors;
+#endif
 	};
 
 }
@@ -0,0 +1,171 @@
+/*
+Object Oriented Communication Library
+Copyright (c) 2011 Jürgen Lorenz and Jörn Teuber
+
+This software is provided 'as-is', without any express or implied warranty.
+In no event will the authors be held liable for any damages arising from the use of this software.
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it freely,
+subject to the following restrictions:
+
+1. The origin of this software must not be misrepresented; you must not claim that you wrote the original software. If you use this software in a product, an acknowledgment in the product documentation would be appreciated but is not required.
+2. Altered source versions must be plainly marked as such, and must not be misrepresented as being the original software.
+3. This notice may not be removed or altered from any source distribution.
+*/
+// This file was written by Jörn Teuber
+
+#ifndef BINARYLOGFILE_H_INCLUDED
+#define BINARYLOGFILE_H_INCLUDED
+
+#include <map>
+#include <string>
+#include <vector>
+
+#ifdef WIN32
+#	include <windows.h>
+#endif
+
+#include "Log.h"
+#include "Atomic.h"
+#include "Mutex.h"
+
+namespace oocl
+{
+#define BLF_MAGIC				"OOCLBLOG"
+#define BLF_VERSION				1
+#define BLF_FILE_SIZE			(16*1024*1024)	///< default size of one file
+#define BLF_MAX_FILES			4				///< default number of files that are rotated, older ones are overwritten
+#define BLF_MAX_RECORD_LENGTH	1024			///< longer strings are cut so that a record does not exceed this length
+#define BLF_FORMAT_RECORD		0xFFFFFFFF		///< format ID of the records that describe a LogFormat
+
+	/**
+	 * @brief	The memory-mapped files a log writes to in binary mode, see Log::setBinary().
+	 *
+	 * @note	The log is written to the files "<name>.0.blog" to "<name>.<max files - 1>.blog" in turn, each of them
+	 * 			starts with a FileHeader, followed by one record for every LogFormat registered so far, followed by the
+	 * 			records of the logged messages. A thread that logs reserves room for its record with one atomic add
+	 * 			and copies the record into the mapping, it only takes a lock when the current file is full and the
+	 * 			next one has to be opened. As the files are mapped, records that were written before the program
+	 * 			crashed are not lost. oocl_logdump reconstructs the text of the messages.
+	 *
+	 * @author	Jörn Teuber
+	 * @date	17.10.2026
+	 */
+	class BinaryLogFile
+	{
+	public:
+		/**
+		 * @brief	The header at the start of every file.
+		 */
+		struct FileHeader
+		{
+			char			acMagic[8];
+			unsigned int	uiVersion;
+			unsigned int	uiSequence;				///< counts the files of a log, the oldest one has the lowest sequence
+			long long		llTicksPerSecond;
+			long long		llStartTicks;			///< tick count when the file was opened
+			long long		llStartSeconds;			///< seconds since the epoch when the file was opened
+			long long		llStartMicroseconds;
+		};
+
+		/**
+		 * @brief	The header of every record, uiLength includes the header and is a multiple of 8.
+		 *
+		 * @note	A format record is followed by the ID, error level and line of the format, its file and its
+		 * 			format as null-terminated strings. All other records are followed by the arguments of the message,
+		 * 			see LogFormat::encode().
+		 */
+		struct RecordHeader
+		{
+			unsigned int	uiFormatID;
+			unsigned int	uiLength;
+			long long		llTicks;
+		};
+
+		BinaryLogFile( const std::string& strName, unsigned int uiFileSize = BLF_FILE_SIZE, unsigned int uiMaxFiles = BLF_MAX_FILES );
+		~BinaryLogFile();
+
+		bool write( const char* pcRecord, unsigned int uiLength );
+		void flush();
+
+		static unsigned int registerFormat( const LogFormat& format );
+		static long long getTicks();
+		static long long getTicksPerSecond();
+
+		// getter
+		bool isOpen() const { return m_pSegment.load() != NULL; }
+
+	private:
+		BinaryLogFile( BinaryLogFile& blf );
+		BinaryLogFile& operator=(const BinaryLogFile&);
+
+		/**
+		 * @brief	One mapped file.
+		 */
+		struct Segment
+		{
+			char*					pcData;
+			Atomic<unsigned int>	uiUsed;		///< bytes reserved so far, can grow beyond the file size when it is full
+			Atomic<unsigned int>	uiWriters;	///< threads that are about to reserve room in this file
+#ifdef linux
+			int						iFile;
+#else
+			HANDLE					hFile;
+			HANDLE					hMapping;
+#endif
+		};
+
+		bool append( const char* pcRecord, unsigned int uiLength, bool bRotate );
+		void rotate( Segment* pFull );
+
+		bool openSegment( Segment* pSegment, std::string& strError );
+		void closeSegment( Segment* pSegment, std::string& strError );
+
+	private:
+		std::string				m_strName;
+		unsigned int			m_uiFileSize;
+		unsigned int			m_uiMaxFiles;
+		unsigned int			m_uiSequence;		///< sequence of the next file
+
+		Segment					m_aSegments[2];		///< the current file and the one before, which is closed already
+		Atomic<Segment*>		m_pSegment;			///< the current file, NULL if it could not be opened
+		Mutex					m_mxRotate;
+	};
+
+
+	/**
+	 * @brief	Reads the messages of a file written by a BinaryLogFile.
+	 *
+	 * @author	Jörn Teuber
+	 * @date	17.10.2026
+	 */
+	class BinaryLogReader
+	{
+	public:
+		BinaryLogReader();
+		~BinaryLogReader();
+
+		bool open( const std::string& strFileName );
+		bool next( std::string& strLine, bool bWithSource = false );
+
+		// getter
+		const BinaryLogFile::FileHeader& getHeader() const { return m_header; }
+
+	private:
+		BinaryLogReader( BinaryLogReader& blr );
+		BinaryLogReader& operator=(const BinaryLogReader&);
+
+		bool readRecord( unsigned int uiPos, BinaryLogFile::RecordHeader& header ) const;
+		void readFormat( const BinaryLogFile::RecordHeader& header, unsigned int uiPos );
+
+	private:
+		std::vector<char>					m_vData;
+		unsigned int						m_uiPos;	///< position of the next record
+		BinaryLogFile::FileHeader			m_header;
+
+		std::map<unsigned int, LogFormat*>	m_mapFormats;
+	};
+
+}
+
+#endif // BINARYLOGFILE_H_INCLUDED
@@ -0,0 +1,73 @@
+/*
+Object Oriented Communication Library
+Copyright (c) 2011 Jürgen Lorenz and Jörn Teuber
+
+This software is provided 'as-is', without any express or implied warranty.
+In no event will the authors be held liable for any damages arising from the use of this software.
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it freely,
+subject to the following restrictions:
+
+1. The origin of this software must not be misrepresented; you must not claim that you wrote the original software. If you use this software in a product, an acknowledgment in the product documentation would be appreciated but is not required.
+2. Altered source versions must be plainly marked as such, and must not be misrepresented as being the original software.
+3. This notice may not be removed or altered from any source distribution.
+*/
+// This file was written by Jörn Teuber
+
+#ifndef CHUNKWRITER_H_INCLUDED
+#define CHUNKWRITER_H_INCLUDED
+
+#include "oocl_import_export.h"
+
+#include "Message.h"
+#include "Mutex.h"
+#include "Atomic.h"
+
+namespace oocl
+{
+	/**
+	 * @brief	Splits large messages into chunks, so that they do not block other messages on the same connection.
+	 *
+	 * @note	Every chunk is a frame of its own that goes over the connection like any other message:
+	 * 			| MT_ChunkFrame | Length | Stream | Piece of the message
+	 * 			| 2 byte        | 2 byte | 2 byte |   ....
+	 * 			The pieces of one stream are in order and the first one starts with the header of the message, the
+	 * 			FrameDecoder of the receiver puts them together again. The sender takes the lock of the connection
+	 * 			once per chunk, and messages that wait for the lock go first, so a small message waits for at most
+	 * 			one chunk instead of the whole large message. Use lock() instead of locking the mutex directly
+	 * 			for all other messages to get this priority.
+	 *
+	 * @author	Jörn Teuber
+	 * @date	16.10.2026
+	 */
+	class OOCL_EXPORTIMPORT ChunkWriter
+	{
+	public:
+		ChunkWriter( unsigned int uiChunkSize = 16384 );
+
+		void setChunkSize( unsigned int uiChunkSize );
+
+		bool needsChunks( Message const * pMessage ) const;
+
+		unsigned short	beginStream();
+		void			appendChunk( WriteBuffer& buffer, unsigned short usStream, const char* pcFrame, unsigned int uiFrameLength, unsigned int& uiOffset ) const;
+
+		void lock( Mutex& mxConnection );
+		void yield();
+
+		// getter
+		unsigned int getChunkSize() const { return m_uiChunkSize; }
+
+	private:
+		ChunkWriter( ChunkWriter& cw );
+		ChunkWriter& operator=(const ChunkWriter&);
+
+	private:
+		unsigned int			m_uiChunkSize;			///< maximum number of message bytes per chunk, 0 sends every message at once
+		Atomic<unsigned int>	m_uiNextStream;
+		Atomic<unsigned int>	m_uiWaitingWriters;		///< number of threads in lock() that wait for the connection
+	};
+
+}
+
+#endif // CHUNKWRITER_H_INCLUDED
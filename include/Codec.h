@@ -0,0 +1,130 @@
+/*
+Object Oriented Communication Library
+Copyright (c) 2011 Jürgen Lorenz and Jörn Teuber
+
+This software is provided 'as-is', without any express or implied warranty.
+In no event will the authors be held liable for any damages arising from the use of this software.
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it freely,
+subject to the following restrictions:
+
+1. The origin of this software must not be misrepresented; you must not claim that you wrote the original software. If you use this software in a product, an acknowledgment in the product documentation would be appreciated but is not required.
+2. Altered source versions must be plainly marked as such, and must not be misrepresented as being the original software.
+3. This notice may not be removed or altered from any source distribution.
+*/
+// This file was written by Jörn Teuber
+
+#ifndef CODEC_H_INCLUDED
+#define CODEC_H_INCLUDED
+
+#include <string>
+#include <vector>
+
+#include "oocl_import_export.h"
+
+#include "WriteBuffer.h"
+
+namespace oocl
+{
+
+#define CODEC_None	0
+#define CODEC_LZ	1	///< the built-in LZCodec, always available
+#define CODEC_Zlib	2	///< the ZlibCodec, only available if oocl was built with OOCL_USE_ZLIB
+
+#define CODEC_MaxID	31
+
+	/**
+	 * @brief	Interface for compression algorithms and the compression of whole frames.
+	 *
+	 * @note	Compression is chosen per message type when registering it, see Message::registerMsg(). Peers tell each
+	 * 			other which codecs they support in their ConnectMessage and only those are used. A compressed message
+	 * 			goes over tcp as a frame of its own, FrameDecoder decompresses it before it is handed on:
+	 * 			| MT_CompressedFrame | Length | Codec  | Original length | Compressed message
+	 * 			| 2 byte             | 2 byte | 1 byte | 4 byte          |   ....
+	 * 			Udp messages are never compressed.
+	 *
+	 * @author	Jörn Teuber
+	 * @date	16.10.2026
+	 */
+	class OOCL_EXPORTIMPORT Codec
+	{
+	public:
+		virtual ~Codec() {}
+
+		/**
+		 * @brief	Appends the compressed bytes to the buffer.
+		 *
+		 * @param	pcIn		The bytes to compress.
+		 * @param	uiLength	The number of bytes.
+		 * @param [in,out]	out	The buffer to append to.
+		 */
+		virtual void compress( const char* pcIn, unsigned int uiLength, WriteBuffer& out ) const = 0;
+
+		/**
+		 * @brief	Decompresses exactly uiOutLength bytes.
+		 *
+		 * @param	pcIn		The compressed bytes.
+		 * @param	uiLength	The number of compressed bytes.
+		 * @param [out]	pcOut	Where to write the decompressed bytes.
+		 * @param	uiOutLength	The length of the original bytes.
+		 *
+		 * @return	false if the input is corrupt or does not decompress to uiOutLength bytes.
+		 */
+		virtual bool decompress( const char* pcIn, unsigned int uiLength, char* pcOut, unsigned int uiOutLength ) const = 0;
+
+		static void				registerCodec( unsigned char ucID, Codec* pCodec );
+		static Codec*			getCodec( unsigned char ucID );
+		static unsigned int		getSupportedCodecs();
+
+		static void				useFor( unsigned short usType, unsigned char ucCodec, unsigned int uiThreshold );
+
+		static bool				compressFrame( WriteBuffer& wbFrame, unsigned int uiCodecs, WriteBuffer& wbScratch );
+		static bool				decompressFrame( const char* pcFrame, unsigned int uiLength, std::string& strOut );
+
+	private:
+		static Codec*						sm_apCodecs[CODEC_MaxID+1];	///< codecs registered by the user
+		static std::vector<unsigned char>	sm_vucTypeCodecs;			///< the codec of each message type
+		static std::vector<unsigned int>	sm_vuiTypeThresholds;		///< messages of the type that are shorter are not compressed
+	};
+
+
+	/**
+	 * @brief	Fast LZ77 compression without dependencies, good for text and repetitive binary data.
+	 *
+	 * @note	Uses the block format of LZ4: a token with the number of literals and the match length, the literals
+	 * 			and a 2 byte offset of the match. Compresses less than zlib but is many times faster.
+	 *
+	 * @author	Jörn Teuber
+	 * @date	16.10.2026
+	 */
+	class OOCL_EXPORTIMPORT LZCodec : public Codec
+	{
+	public:
+		virtual void compress( const char* pcIn, unsigned int uiLength, WriteBuffer& out ) const;
+		virtual bool decompress( const char* pcIn, unsigned int uiLength, char* pcOut, unsigned int uiOutLength ) const;
+	};
+
+
+#ifdef OOCL_USE_ZLIB
+	/**
+	 * @brief	Compression with zlib, slower than LZCodec but smaller output.
+	 *
+	 * @author	Jörn Teuber
+	 * @date	16.10.2026
+	 */
+	class OOCL_EXPORTIMPORT ZlibCodec : public Codec
+	{
+	public:
+		ZlibCodec( int iLevel = 6 );
+
+		virtual void compress( const char* pcIn, unsigned int uiLength, WriteBuffer& out ) const;
+		virtual bool decompress( const char* pcIn, unsigned int uiLength, char* pcOut, unsigned int uiOutLength ) const;
+
+	private:
+		int m_iLevel;
+	};
+#endif
+
+}
+
+#endif // CODEC_H_INCLUDED
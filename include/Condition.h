@@ -0,0 +1,66 @@
+/*
+Object Oriented Communication Library
+Copyright (c) 2011 Jürgen Lorenz and Jörn Teuber
+
+This software is provided 'as-is', without any express or implied warranty.
+In no event will the authors be held liable for any damages arising from the use of this software.
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it freely,
+subject to the following restrictions:
+
+1. The origin of this software must not be misrepresented; you must not claim that you wrote the original software. If you use this software in a product, an acknowledgment in the product documentation would be appreciated but is not required.
+2. Altered source versions must be plainly marked as such, and must not be misrepresented as being the original software.
+3. This notice may not be removed or altered from any source distribution.
+*/
+// This file was written by Jörn Teuber
+
+#ifndef CONDITION_H_
+#define CONDITION_H_
+
+#ifdef USE_CPP11
+#	include <condition_variable>
+#endif
+
+#include "Mutex.h"
+
+namespace oocl
+{
+	/**
+	 * @brief	Wrapper class for condition variables on different platforms, used to sleep until another thread signals.
+	 *
+	 * @note	If USE_CPP11 is defined it uses the c++11 std::condition_variable, else the platform specific implementation,
+	 * 			which needs at least Windows Vista on windows. Timed waits are measured with a monotonic clock.
+	 * 			As with every condition variable wait() can return spuriously, so always check the predicate in a loop.
+	 *
+	 * @author	Jörn Teuber
+	 * @date	16.10.2026
+	 */
+	class Condition
+	{
+	public:
+		Condition();
+		~Condition();
+
+		void wait( Mutex& mutex );
+		bool wait( Mutex& mutex, int iMilliseconds );
+
+		void signal();
+		void broadcast();
+
+	private:
+		Condition( Condition& c );
+		Condition& operator=(const Condition&);
+
+	private:
+#if defined USE_CPP11
+		std::condition_variable m_condition;
+#elif defined USE_PTHREADS
+		pthread_cond_t m_condition;
+#elif defined USE_WINTHREADS
+		CONDITION_VARIABLE m_condition;
+#endif
+	};
+
+} /* namespace oocl */
+
+#endif /* CONDITION_H_ */
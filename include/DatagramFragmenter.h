@@ -0,0 +1,109 @@
+/*
+Object Oriented Communication Library
+Copyright (c) 2011 Jürgen Lorenz and Jörn Teuber
+
+This software is provided 'as-is', without any express or implied warranty.
+In no event will the authors be held liable for any damages arising from the use of this software.
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it freely,
+subject to the following restrictions:
+
+1. The origin of this software must not be misrepresented; you must not claim that you wrote the original software. If you use this software in a product, an acknowledgment in the product documentation would be appreciated but is not required.
+2. Altered source versions must be plainly marked as such, and must not be misrepresented as being the original software.
+3. This notice may not be removed or altered from any source distribution.
+*/
+// This file was written by Jörn Teuber
+
+
+#ifndef DATAGRAMFRAGMENTER_H_INCLUDED
+#define DATAGRAMFRAGMENTER_H_INCLUDED
+
+#include <map>
+#include <vector>
+#include <string>
+
+#include "oocl_import_export.h"
+
+#include "Message.h"
+#include "Socket.h"
+
+namespace oocl
+{
+
+#define DF_DEFAULT_MTU 1500			///< used if the path MTU is neither set nor known by the socket
+#define DF_MIN_MTU 576				///< every ipv4 host has to accept packets of this size
+#define DF_IP_UDP_OVERHEAD 28		///< ipv4 and udp header in front of the payload
+#define DF_FRAGMENT_HEADER 12		///< the bytes between the header of an MT_FragmentFrame and the piece
+#define DF_MAX_FRAGMENTS 1024		///< longer messages are not sent
+#define DF_MAX_PENDING 32			///< messages that are reassembled at the same time, the oldest one is dropped for a new one
+#define DF_TIMEOUT 1000000			///< microseconds after which an incomplete message is dropped
+#define DF_FIXED_ID 0x80000000		///< set in message IDs chosen by the caller, the others are counted by the fragmenter
+
+	/**
+	 * @brief	Splits udp datagrams that are larger than the path MTU into fragments and puts them together again on the other side.
+	 *
+	 * @note	A fragment is a frame of its own that is sent as one datagram:
+	 * 			| MT_FragmentFrame | Length | Message ID | Index  | Count  | Total length | Piece of the message | Trailer
+	 * 			| 2 byte           | 2 byte | 4 byte     | 2 byte | 2 byte | 4 byte       |   ....               |
+	 * 			All pieces of a message have the same length except the last one, so the receiver can place them in any
+	 * 			order. The trailer of the original datagram (e.g. the PeerID in the Peer2PeerNetwork) is repeated behind
+	 * 			every fragment. If one fragment is lost the whole message is lost, incomplete messages are dropped after
+	 * 			DF_TIMEOUT or when DF_MAX_PENDING other messages are incomplete. A caller that sends the same datagram
+	 * 			again, like the ReliableChannel, can give it the same ID, so that the fragments of all copies are combined.
+	 * 			This keeps ip from fragmenting the datagrams, which would lose the message as well but also fill
+	 * 			the reassembly buffers of the kernel, and datagrams larger than DS_DEFAULT_DATAGRAM_SIZE would be
+	 * 			truncated by the receiver.
+	 *
+	 * @author	Jörn Teuber
+	 * @date	17.10.2026
+	 */
+	class OOCL_EXPORTIMPORT DatagramFragmenter
+	{
+	public:
+		DatagramFragmenter( unsigned int uiTrailerLength = 0 );
+
+		void setPathMTU( unsigned int uiMTU );
+
+		// sender, the caller has to hold the lock of the socket
+		bool write( Socket* pSocket, const char* pcDatagram, unsigned int uiLength );
+		bool write( Socket* pSocket, const char* pcDatagram, unsigned int uiLength, unsigned int uiMessageID );
+
+		// receiver, only called by the network thread
+		bool receive( const char* pcFragment, unsigned int uiLength, const char*& pcFrame, unsigned int& uiFrameLength );
+
+		// getter
+		unsigned int getPayloadSize() const		{ return m_uiPayloadSize; }
+		unsigned int getPendingCount() const	{ return m_mapPending.size(); }
+
+	private:
+		DatagramFragmenter( DatagramFragmenter& df );
+		DatagramFragmenter& operator=(const DatagramFragmenter&);
+
+		void updatePayloadSize( Socket* pSocket );
+		void dropIncomplete( unsigned long long ullNow );
+
+		/**
+		 * @brief	A message whose fragments did not all arrive yet.
+		 */
+		struct Reassembly
+		{
+			std::string			strFrame;
+			std::vector<bool>	vbReceived;
+			unsigned int		uiMissing;
+			unsigned long long	ullStartTime;
+		};
+
+	private:
+		unsigned int	m_uiTrailerLength;
+		unsigned int	m_uiPathMTU;		///< the configured path MTU, 0 asks the socket
+		unsigned int	m_uiPayloadSize;	///< the largest datagram that is sent unfragmented, 0 until the first write
+		unsigned int	m_uiNextID;
+		WriteBuffer		m_wbFragment;
+
+		std::map<unsigned int, Reassembly>	m_mapPending;
+		std::string							m_strComplete;	///< the message returned by the last receive() call
+	};
+
+}
+
+#endif // DATAGRAMFRAGMENTER_H_INCLUDED
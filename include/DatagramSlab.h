@@ -0,0 +1,85 @@
+/*
+Object Oriented Communication Library
+Copyright (c) 2011 Jürgen Lorenz and Jörn Teuber
+
+This software is provided 'as-is', without any express or implied warranty.
+In no event will the authors be held liable for any damages arising from the use of this software.
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it freely,
+subject to the following restrictions:
+
+1. The origin of this software must not be misrepresented; you must not claim that you wrote the original software. If you use this software in a product, an acknowledgment in the product documentation would be appreciated but is not required.
+2. Altered source versions must be plainly marked as such, and must not be misrepresented as being the original software.
+3. This notice may not be removed or altered from any source distribution.
+*/
+// This file was written by Jörn Teuber
+
+#ifndef DATAGRAMSLAB_H_INCLUDED
+#define DATAGRAMSLAB_H_INCLUDED
+
+#include <cstring>
+
+#ifdef linux
+#	include <sys/types.h>
+#	include <sys/socket.h>
+#	include <sys/uio.h>
+#endif
+
+#include "oocl_import_export.h"
+
+namespace oocl
+{
+
+#define DS_DEFAULT_DATAGRAM_SIZE 2048	///< senders do not make datagrams larger than this, see DatagramFragmenter
+
+	/**
+	 * @brief	Preallocated memory for receiving many datagrams with one call of Socket::readDatagrams().
+	 *
+	 * @note	All datagram buffers are allocated in one block by the constructor, receiving does not allocate.
+	 * 			The received datagrams stay valid until the slab is passed to readDatagrams() again.
+	 *
+	 * @author	Jörn Teuber
+	 * @date	16.10.2026
+	 */
+	class OOCL_EXPORTIMPORT DatagramSlab
+	{
+		friend class Socket;
+		friend class BerkeleySocket;
+
+	public:
+		DatagramSlab( unsigned int uiMaxDatagrams = 32, unsigned int uiDatagramSize = DS_DEFAULT_DATAGRAM_SIZE );
+		~DatagramSlab();
+
+		// getter
+		unsigned int	size() const								{ return m_uiCount; }
+		unsigned int	capacity() const							{ return m_uiMaxDatagrams; }
+		unsigned int	getDatagramSize() const						{ return m_uiDatagramSize; }
+
+		const char*		getDatagram( unsigned int uiIndex ) const	{ return m_pcData + uiIndex * m_uiDatagramSize; }
+		unsigned int	getLength( unsigned int uiIndex ) const		{ return m_puiLengths[uiIndex]; }
+		bool			isTruncated( unsigned int uiIndex ) const	{ return m_pbTruncated[uiIndex]; }
+
+	private:
+		DatagramSlab( DatagramSlab& ds );
+		DatagramSlab& operator=(const DatagramSlab&);
+
+		char*	getBuffer( unsigned int uiIndex )	{ return m_pcData + uiIndex * m_uiDatagramSize; }
+
+	private:
+		char*			m_pcData;
+		unsigned int*	m_puiLengths;
+		bool*			m_pbTruncated;		///< true if the datagram was bigger than the buffer and got cut off
+
+		unsigned int	m_uiMaxDatagrams;
+		unsigned int	m_uiDatagramSize;
+		unsigned int	m_uiCount;			///< number of datagrams received by the last readDatagrams()
+
+#ifdef linux
+		struct mmsghdr*	m_pHeaders;			///< prepared once for recvmmsg(), each points to its datagram buffer
+		struct iovec*	m_pVectors;
+#endif
+	};
+
+}
+
+#endif // DATAGRAMSLAB_H_INCLUDED
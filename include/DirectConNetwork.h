@@ -18,6 +18,7 @@ subject to the following restrictions:
 #define DIRECTCONNETWORK_H
 
 #include <list>
+#include <algorithm>
 
 #include "oocl_import_export.h"
 
@@ -27,6 +28,11 @@ subject to the following restrictions:
 #include "BerkeleySocket.h"
 #include "Thread.h"
 #include "ExplicitMessages.h"
+#include "Reactor.h"
+#include "FrameDecoder.h"
+#include "ChunkWriter.h"
+#include "ReliableChannel.h"
+#include "Mutex.h"
 
 namespace oocl
 {
@@ -36,7 +42,7 @@ namespace oocl
 	 * @author	Jörn Teuber
 	 * @date	14.9.2011
 	 */
-	class OOCL_EXPORTIMPORT DirectConNetwork : public Thread
+	class OOCL_EXPORTIMPORT DirectConNetwork : public Thread, public ReactorListener
 	{
 	public:
 		DirectConNetwork();
@@ -48,15 +54,32 @@ namespace oocl
 
 		bool sendMessage( Message const * const pMessage );
 
+		void setBatching( Socket::EFlushPolicy ePolicy, unsigned int uiThreshold = 0 );
+		void setChunkSize( unsigned int uiChunkSize );
+		void setPathMTU( unsigned int uiMTU );
+		bool flush();
+
 		bool registerListener( MessageListener* pListener );
 		bool unregisterListener( MessageListener* pListener );
 
 		// getter
 		bool isConnected();
 
+		virtual void cbReadable( SocketStub* pSocket, void* pContext );
+
 	protected:
 		virtual void run();
 
+	private:
+		bool acceptConnection();
+		void receiveFromTCP();
+		void receiveFromUDP();
+		void deliverMessage( const MessageView& view );
+		void receiveFrame( const MessageView& view );
+		void receiveReliable( const MessageView& view );
+		void sendChunked( Message const * const pMessage );
+		void applyBatching();
+
 	private:
 		Socket* m_pSocketUDPIn;
 		Socket* m_pSocketUDPOut;
@@ -68,6 +91,21 @@ namespace oocl
 
 		std::list<MessageListener*> m_lListeners;
 
+		Reactor		m_reactor;
+		FrameDecoder m_frameDecoder; ///< splits the stream received on the tcp socket into messages
+		DatagramSlab m_dsReceiveSlab; ///< the udp socket receives into this slab
+
+		WriteBuffer	m_wbSendBuffer; ///< outgoing messages are serialized into this buffer
+		Mutex		m_mxSendBuffer; ///< guards the send buffer and the outgoing sockets
+		ChunkWriter	m_chunkWriter;	///< splits large tcp messages, so that they do not block the others
+		ReliableChannel	m_reliable;	///< sequences and retransmits the SOCK_RDM and SOCK_SEQPACKET messages
+		DatagramFragmenter	m_fragmenter;	///< splits udp messages that are larger than the path MTU and reassembles them
+		WriteBuffer	m_wbCompressBuffer; ///< used by Codec::compressFrame(), guarded by m_mxSendBuffer
+		unsigned int m_uiCodecs;	///< the codecs both sides support, known once the ConnectMessage of the other side arrived
+
+		Socket::EFlushPolicy	m_eFlushPolicy;
+		unsigned int			m_uiFlushThreshold;
+
 		bool m_bConnected;
 	};
 
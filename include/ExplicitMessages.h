@@ -25,6 +25,7 @@ subject to the following restrictions:
  */
 
 #include "Message.h"
+#include "MessageSchema.h"
 
 namespace oocl
 {
@@ -36,31 +37,15 @@ namespace oocl
 	 * @author	Jörn Teuber
 	 * @date	1.3.2012
 	 */
-	class OOCL_EXPORTIMPORT StandardMessage : public Message
+	class OOCL_EXPORTIMPORT StandardMessage : public MessageSchema< StandardMessage, MT_StandardMessage, VarBytes >
 	{
 	public:
-		/** @brief registers the message type with the message system
-		 *
-		 *  @note must be present in every implementation of Message!
-		 */
-		static void registerMsg(){
-			Message::registerMsg( MT_StandardMessage, StandardMessage::create );
-		}
-
-		StandardMessage( const char * cMsgBody, unsigned short length );
+		StandardMessage();
+		StandardMessage( const char * cMsgBody, unsigned int length );
 		StandardMessage( std::string strMsgBody );
 
-		virtual std::string getMsgString() const;
-		virtual unsigned short getBodyLength() const;
-
-		std::string getBody() const { return m_strMsgBody; }
+		std::string getBody() const { return m_value0; }
 		void setProtocoll( int iProtocoll ) { m_iProtocoll = iProtocoll; }
-
-	protected:
-		static Message* create(const char * in);
-
-	private:
-		std::string m_strMsgBody;
 	};
 
 	
@@ -71,30 +56,13 @@ namespace oocl
 	 * @author	Jörn Teuber
 	 * @date	3/1/2012
 	 */
-	class OOCL_EXPORTIMPORT SubscribeMessage : public Message
+	class OOCL_EXPORTIMPORT SubscribeMessage : public MessageSchema< SubscribeMessage, MT_SubscribeMessage, Field<unsigned short> >
 	{
 	public:
-		/** @brief registers the message type with the message system
-		 *
-		 *  @note must be present in every implementation of Message!
-		 */
-		static void registerMsg(){
-			Message::registerMsg( MT_SubscribeMessage, SubscribeMessage::create );
-		}
-
-		SubscribeMessage( unsigned short usTypeToSubscribe );
-
-		virtual std::string getMsgString() const;
-		virtual unsigned short getBodyLength() const;
+		SubscribeMessage( unsigned short usTypeToSubscribe = 0 );
 
 		// getter
-		unsigned short getTypeToSubscribe() const { return m_usTypeToSubscribe; }
-
-	protected:
-		static Message* create(const char * in);
-
-	private:
-		unsigned short m_usTypeToSubscribe;
+		unsigned short getTypeToSubscribe() const { return m_value0; }
 	};
 	
 	
@@ -105,31 +73,14 @@ namespace oocl
 	 * @author	Jörn Teuber
 	 * @date	3/1/2012
 	 */
-	class OOCL_EXPORTIMPORT ConnectMessage : public Message
+	class OOCL_EXPORTIMPORT ConnectMessage : public MessageSchema< ConnectMessage, MT_ConnectMessage, Field<unsigned short>, Field<unsigned int>, Field<unsigned int> >
 	{
 	public:
-		/** @brief registers the message type with the message system
-		 *
-		 *  @note must be present in every implementation of Message!
-		 */
-		static void registerMsg(){
-			Message::registerMsg( MT_ConnectMessage, ConnectMessage::create );
-		}
-
-		ConnectMessage( unsigned short usMyPort, unsigned int uiPeerID = 0 );
-
-		virtual std::string getMsgString() const;
-		virtual unsigned short getBodyLength() const;
-
-		unsigned short getPort() const { return m_usPort; }
-		unsigned int getPeerID() const { return m_uiPeerID; }
-
-	protected:
-		static Message* create(const char * in);
+		ConnectMessage( unsigned short usMyPort = 0, unsigned int uiPeerID = 0, unsigned int uiCodecs = 0 );
 
-	private:
-		unsigned short	m_usPort;
-		unsigned int	m_uiPeerID;
+		unsigned short getPort() const { return m_value0; }
+		unsigned int getPeerID() const { return m_value1; }
+		unsigned int getCodecs() const { return m_value2; }	///< the codecs the sender can decompress, see Codec::getSupportedCodecs()
 	};
 	
 	
@@ -140,24 +91,10 @@ namespace oocl
 	 * @author	Jörn Teuber
 	 * @date	3/1/2012
 	 */
-	class OOCL_EXPORTIMPORT DisconnectMessage : public Message
+	class OOCL_EXPORTIMPORT DisconnectMessage : public MessageSchema< DisconnectMessage, MT_DisconnectMessage >
 	{
 	public:
-		/** @brief registers the message type with the message system
-		 *
-		 *  @note must be present in every implementation of Message!
-		 */
-		static void registerMsg(){
-			Message::registerMsg( MT_DisconnectMessage, DisconnectMessage::create );
-		}
-
 		DisconnectMessage();
-
-		virtual std::string getMsgString() const;
-		virtual unsigned short getBodyLength() const;
-
-	protected:
-		static Message* create(const char * in);
 	};
 	
 	class Peer;
@@ -0,0 +1,69 @@
+/*
+Object Oriented Communication Library
+Copyright (c) 2011 Jürgen Lorenz and Jörn Teuber
+
+This software is provided 'as-is', without any express or implied warranty.
+In no event will the authors be held liable for any damages arising from the use of this software.
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it freely,
+subject to the following restrictions:
+
+1. The origin of this software must not be misrepresented; you must not claim that you wrote the original software. If you use this software in a product, an acknowledgment in the product documentation would be appreciated but is not required.
+2. Altered source versions must be plainly marked as such, and must not be misrepresented as being the original software.
+3. This notice may not be removed or altered from any source distribution.
+*/
+// This file was written by Jörn Teuber
+
+#ifndef FRAMEDECODER_H_INCLUDED
+#define FRAMEDECODER_H_INCLUDED
+
+#include <map>
+#include <string>
+
+#include "oocl_import_export.h"
+
+#include "RingBuffer.h"
+#include "Socket.h"
+
+namespace oocl
+{
+	/**
+	 * @brief	Splits the byte stream of a connection into the messages as written by Message::serializeInto().
+	 *
+	 * @note	Every connection keeps its own decoder, so that a message that was only partially received
+	 * 			is completed with the next readiness event instead of blocking until the rest arrives.
+	 * 			Usage: call receive() until it returns 0 and call nextFrame() after each receive() until it returns false.
+	 * 			Large messages that were split by a ChunkWriter are put together again, nextFrame() only returns
+	 * 			them once they are complete. Compressed messages are decompressed, see Codec.
+	 *
+	 * @author	Jörn Teuber
+	 * @date	16.10.2026
+	 */
+	class OOCL_EXPORTIMPORT FrameDecoder
+	{
+	public:
+		FrameDecoder( unsigned int uiCapacity = 4096 );
+
+		int  receive( Socket* pSocket );
+		bool nextFrame( const char*& pcFrame, unsigned int& uiLength );
+
+		void swap( FrameDecoder& other );
+		void clear();
+
+		// getter
+		unsigned int getBufferedBytes() const { return m_rbBuffer.size(); }
+
+	private:
+		bool appendChunk( const char* pcBody, unsigned int uiBodyLength, const char*& pcFrame, unsigned int& uiLength );
+
+	private:
+		RingBuffer m_rbBuffer;
+
+		std::map< unsigned short, std::string >	m_mapStreams;	///< the chunks received so far of each large message
+		std::string								m_strComplete;	///< the last large message returned by nextFrame()
+		std::string								m_strInflated;	///< the last decompressed message returned by nextFrame()
+	};
+
+}
+
+#endif // FRAMEDECODER_H_INCLUDED
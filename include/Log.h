@@ -23,20 +23,114 @@ subject to the following restrictions:
 #include <fstream>
 #include <iostream>
 #include <time.h>
+#include <stdarg.h>
+#include <vector>
 
 #include "oocl_import_export.h"
+#include "Atomic.h"
+
+#ifndef OOCL_LOG_LEVEL
+#	define OOCL_LOG_LEVEL 0		///< messages below this error level are removed at compile time, e.g. 1 for warnings and up
+#endif
+
+#define LOG_LINE_LENGTH 256		///< longer messages of the OOCL_LOG macros are cut
+
+/**
+ * @brief	Logs a message that is composed with stream operators, e.g. OOCL_LOG_WARNING( "oocl", "lost " << uiCount << " messages" ).
+ *
+ * @note	The message is only evaluated if its error level is logged, neither the arguments nor their formatting cost
+ * 			anything otherwise. The log is looked up once per call site. The message is formatted into a LogLine on the
+ * 			stack of the calling thread and written as a whole, so these macros can be used from any thread.
+ * 			Every call site is rate limited and sampled on its own, see Log::setRateLimit() and Log::setSampling().
+ */
+#define OOCL_LOG( strLogName, elErrorLevel, message ) \
+	do { \
+		if( (elErrorLevel) >= OOCL_LOG_LEVEL ) \
+		{ \
+			static oocl::Log* s_pOoclLog = oocl::Log::getLog( strLogName ); \
+			if( s_pOoclLog->isLogged( elErrorLevel ) ) \
+			{ \
+				static oocl::LogSite s_ooclLogSite( __FILE__, __LINE__ ); \
+				if( s_pOoclLog->admit( s_ooclLogSite, elErrorLevel ) ) \
+				{ \
+					oocl::LogLine ooclLogLine( s_pOoclLog, elErrorLevel ); \
+					ooclLogLine << message; \
+				} \
+			} \
+		} \
+	} while( false )
+
+#define OOCL_LOG_INFO( strLogName, message )			OOCL_LOG( strLogName, oocl::Log::EL_INFO, message )
+#define OOCL_LOG_WARNING( strLogName, message )		OOCL_LOG( strLogName, oocl::Log::EL_WARNING, message )
+#define OOCL_LOG_ERROR( strLogName, message )			OOCL_LOG( strLogName, oocl::Log::EL_ERROR, message )
+#define OOCL_LOG_FATAL_ERROR( strLogName, message )	OOCL_LOG( strLogName, oocl::Log::EL_FATAL_ERROR, message )
+
+/**
+ * @brief	Logs a printf formatted message, e.g. OOCL_LOGF_WARNING( "oocl", "lost %u messages", uiCount ).
+ *
+ * @note	Like OOCL_LOG the arguments are only evaluated if the error level is logged. Every call site registers its
+ * 			format once as a LogFormat, so a log in binary mode, see Log::setBinary(), only records the ID of the
+ * 			format, a time stamp and the raw arguments. Otherwise the message is formatted and written as text.
+ * 			At least one argument has to follow the format, the macros do not rely on the ## extension for empty
+ * 			argument lists, use OOCL_LOG for constant messages.
+ */
+#define OOCL_LOGF( strLogName, elErrorLevel, pcFormat, ... ) \
+	do { \
+		if( (elErrorLevel) >= OOCL_LOG_LEVEL ) \
+		{ \
+			static oocl::Log* s_pOoclLog = oocl::Log::getLog( strLogName ); \
+			if( s_pOoclLog->isLogged( elErrorLevel ) ) \
+			{ \
+				static oocl::LogSite s_ooclLogSite( __FILE__, __LINE__ ); \
+				static const oocl::LogFormat s_ooclLogFormat( __FILE__, __LINE__, elErrorLevel, pcFormat ); \
+				if( s_pOoclLog->admit( s_ooclLogSite, elErrorLevel ) ) \
+					s_pOoclLog->logFormat( s_ooclLogFormat, pcFormat, __VA_ARGS__ ); \
+			} \
+		} \
+	} while( false )
+
+#define OOCL_LOGF_INFO( strLogName, pcFormat, ... )			OOCL_LOGF( strLogName, oocl::Log::EL_INFO, pcFormat, __VA_ARGS__ )
+#define OOCL_LOGF_WARNING( strLogName, pcFormat, ... )		OOCL_LOGF( strLogName, oocl::Log::EL_WARNING, pcFormat, __VA_ARGS__ )
+#define OOCL_LOGF_ERROR( strLogName, pcFormat, ... )			OOCL_LOGF( strLogName, oocl::Log::EL_ERROR, pcFormat, __VA_ARGS__ )
+#define OOCL_LOGF_FATAL_ERROR( strLogName, pcFormat, ... )	OOCL_LOGF( strLogName, oocl::Log::EL_FATAL_ERROR, pcFormat, __VA_ARGS__ )
+
+#ifdef __GNUC__
+#	define OOCL_PRINTF_FORMAT( iFormat, iFirstArgument ) __attribute__(( format( printf, iFormat, iFirstArgument ) ))
+#else
+#	define OOCL_PRINTF_FORMAT( iFormat, iFirstArgument )
+#endif
 
 namespace oocl
 {	
+	class LogWriter;
+	class LogLine;
+	class LogFormat;
+	class LogSite;
+	class BinaryLogFile;
+	class BinaryLogReader;
+	class Mutex;
+
 	/**
 	 * @brief	a simple logger class with multiple log support.
 	 *
+	 * @note	By default every message is written to the standard output and the log file before the logging method
+	 * 			returns. In asynchronous mode, see setAsync(), the messages are handed to a background LogWriter.
+	 * 			The stream operators of this class share one stream per log and must not be used by more than one
+	 * 			thread at a time, use the OOCL_LOG macros instead.
+	 * 			In binary mode, see setBinary(), all messages go to a memory-mapped BinaryLogFile instead, which
+	 * 			oocl_logdump turns back into text.
+	 * 			The messages of the OOCL_LOG macros can be rate limited and sampled per error level, so that a
+	 * 			flood of warnings does not slow down the program, see setRateLimit() and setSampling().
+	 *
 	 * @author	Jörn Teuber
 	 * @date	14.9.2011
 	 */
 	class Log
 	{
 		friend Log& endl(Log& log);
+		friend class LogWriter;
+		friend class LogLine;
+		friend class BinaryLogReader;
 		
 	public:
 		/**
@@ -52,8 +146,8 @@ namespace oocl
 			EL_FATAL_ERROR	///< Errors that crashes the programm
 		};
 
-		static Log* getLog( std::string strLogName );
-		static Log& getLogRef( std::string strLogName );
+		static Log* getLog( const std::string& strLogName );
+		static Log& getLogRef( const std::string& strLogName );
 		
 		static Log* getDefaultLog();
 		static Log& getDefaultLogRef();
@@ -66,6 +160,8 @@ namespace oocl
 		bool logWarning( const std::string strMessage );
 		bool logError( const std::string strMessage );
 		bool logFatalError( const std::string strMessage );
+
+		bool logFormat( const LogFormat& format, const char* pcFormat, ... ) OOCL_PRINTF_FORMAT( 3, 4 );
 		
 		
 		Log& operator << (const EErrorLevel eLvl);
@@ -88,6 +184,20 @@ namespace oocl
 		void flush();
 
 		void setLogLevel( EErrorLevel elLowestLoggedLevel );
+		void setAsync( bool bAsync );
+		bool setBinary( bool bBinary );
+
+		void setRateLimit( EErrorLevel elErrorLevel, unsigned int uiMessagesPerSecond, unsigned int uiBurst = 10 );
+		void setSampling( EErrorLevel elErrorLevel, unsigned int uiOneIn );
+
+		/**
+		 * @brief	Check whether a call site of the OOCL_LOG macros may log another message, the check is skipped
+		 * 			if neither a rate limit nor sampling is set.
+		 */
+		bool admit( LogSite& site, EErrorLevel elErrorLevel ) { return !m_bLimited || admitLimited( site, elErrorLevel ); }
+
+		// getter
+		bool isLogged( EErrorLevel elErrorLevel ) const { return elErrorLevel >= m_elLowestLoggedLevel && elErrorLevel <= (int)sm_uiMaxLogLevel; }
 
 	private:
 		Log( std::string strLogName );
@@ -95,6 +205,10 @@ namespace oocl
 
 		std::string getTime();
 
+		bool write( EErrorLevel elErrorLevel, const char* pcText, unsigned int uiLength );
+		bool admitLimited( LogSite& site, EErrorLevel elErrorLevel );
+		void updateLimited();
+
 	private:
 		EErrorLevel m_elLowestLoggedLevel;
 		EErrorLevel m_elLastStreamLogLvl;
@@ -103,7 +217,22 @@ namespace oocl
 		std::stringstream m_ssLogStream;
 		std::ofstream m_fsLogFile;
 
+		std::string m_strLogName;
+
 		bool m_bFlushing;
+		bool m_bAsync;
+		bool m_bBinary;
+
+		Mutex* m_pmxWrite;		///< serializes the messages written by write()
+
+		BinaryLogFile* m_pBinaryFile;	///< the file of the binary mode, created by the first call of setBinary(true)
+
+		bool m_bLimited;					///< true if a rate limit or sampling is set for any error level
+		long long m_allInterval[4];			///< ticks between two messages of a call site per error level, 0 for no limit
+		long long m_allBurst[4];			///< ticks of the messages a call site may log at once per error level
+		unsigned int m_auiSampling[4];		///< only one in this many messages of a call site is logged per error level
+
+		Atomic<unsigned int> m_uiDroppedRecords;	///< messages the LogWriter had no room for since its last batch
 		
 		
 		static std::map<std::string, Log*> sm_mapLogs;
@@ -116,6 +245,166 @@ namespace oocl
 	
 	Log& endl(Log& log);
 
+
+	/**
+	 * @brief	The format of the messages of one OOCL_LOGF call site.
+	 *
+	 * @note	The format is parsed once when the call site is reached the first time, binary logs then record the
+	 * 			arguments as raw bytes in the order of the conversions, integers always as 8 bytes and strings as
+	 * 			length and characters. A format with a '*' width or precision or a %n conversion can not be recorded,
+	 * 			binary logs store only its text.
+	 *
+	 * @author	Jörn Teuber
+	 * @date	17.10.2026
+	 */
+	class LogFormat
+	{
+		friend class BinaryLogReader;
+
+	public:
+		/**
+		 * @enum	EArgumentType
+		 *
+		 * @brief	Values that represent the type an argument is passed to printf with.
+		 */
+		enum EArgumentType
+		{
+			AT_Int = 0,
+			AT_UnsignedInt,
+			AT_Long,
+			AT_UnsignedLong,
+			AT_LongLong,
+			AT_UnsignedLongLong,
+			AT_Double,
+			AT_LongDouble,
+			AT_Pointer,
+			AT_String
+		};
+
+		/**
+		 * @brief	One conversion of a format.
+		 */
+		struct Argument
+		{
+			EArgumentType	eType;
+			unsigned int	uiStart;	///< position of the conversion in the format
+			unsigned int	uiLength;	///< length of the conversion including the '%'
+		};
+
+		LogFormat( const char* pcFile, unsigned int uiLine, Log::EErrorLevel elErrorLevel, const char* pcFormat );
+
+		unsigned int encode( char* pcRecord, unsigned int uiCapacity, va_list args ) const;
+		unsigned int encodeText( char* pcRecord, unsigned int uiCapacity, const char* pcText, unsigned int uiLength ) const;
+		std::string decode( const char* pcArguments, unsigned int uiLength ) const;
+
+		static bool parse( const char* pcFormat, std::vector<Argument>& vArguments );
+
+		// getter
+		unsigned int		getID() const			{ return m_uiID; }
+		const char*			getFile() const			{ return m_pcFile; }
+		unsigned int		getLine() const			{ return m_uiLine; }
+		Log::EErrorLevel	getErrorLevel() const	{ return m_elErrorLevel; }
+		const char*			getFormat() const		{ return m_pcFormat; }
+		bool				isValid() const			{ return m_bValid; }
+
+	private:
+		LogFormat( unsigned int uiID, const char* pcFile, unsigned int uiLine, Log::EErrorLevel elErrorLevel, const char* pcFormat );
+		LogFormat( LogFormat& lf );
+		LogFormat& operator=(const LogFormat&);
+
+		void init();
+
+	private:
+		unsigned int			m_uiID;
+		const char*				m_pcFile;
+		unsigned int			m_uiLine;
+		Log::EErrorLevel		m_elErrorLevel;
+		const char*				m_pcFormat;
+
+		std::vector<Argument>	m_vArguments;
+		bool					m_bValid;			///< false if the arguments can not be recorded
+		unsigned int			m_uiFixedLength;	///< length of a record if all strings are empty
+	};
+
+
+	/**
+	 * @brief	The state of one call site of the OOCL_LOG macros for rate limiting and sampling.
+	 *
+	 * @note	The rate limit is a token bucket, which is kept as the time the bucket will be full again, so that it
+	 * 			takes a single compare and swap. The messages a call site drops are counted, and the next message
+	 * 			it logs is preceded by a summary of them.
+	 *
+	 * @author	Jörn Teuber
+	 * @date	17.10.2026
+	 */
+	class LogSite
+	{
+		friend class Log;
+
+	public:
+		LogSite( const char* pcFile, unsigned int uiLine );
+
+	private:
+		LogSite( LogSite& ls );
+		LogSite& operator=(const LogSite&);
+
+	private:
+		const char*				m_pcFile;
+		unsigned int			m_uiLine;
+
+		Atomic<long long>		m_llFull;			///< tick count when the bucket is full again
+		Atomic<unsigned int>	m_uiMessages;		///< messages of this call site, for sampling
+		Atomic<unsigned int>	m_uiSuppressed;		///< messages dropped since the last one that was logged
+	};
+
+
+	/**
+	 * @brief	One message of the OOCL_LOG macros, it is formatted into a fixed buffer and written to its log when the
+	 * 			line is destroyed.
+	 *
+	 * @author	Jörn Teuber
+	 * @date	17.10.2026
+	 */
+	class LogLine
+	{
+	public:
+		LogLine( Log* pLog, Log::EErrorLevel elErrorLevel );
+		~LogLine();
+
+		LogLine& operator << (const char* pc);
+		LogLine& operator << (const std::string& str);
+
+		LogLine& operator << (const char c);
+		LogLine& operator << (const bool b);
+		LogLine& operator << (const float f);
+		LogLine& operator << (const double d);
+
+		LogLine& operator << (const short int i);
+		LogLine& operator << (const unsigned short int i);
+		LogLine& operator << (const int i);
+		LogLine& operator << (const unsigned int i);
+		LogLine& operator << (const long i);
+		LogLine& operator << (const unsigned long i);
+		LogLine& operator << (const long long i);
+		LogLine& operator << (const unsigned long long i);
+
+		LogLine& operator << (const void* p);
+
+	private:
+		LogLine( LogLine& ll );
+		LogLine& operator=(const LogLine&);
+
+		void append( const char* pcText, unsigned int uiLength );
+		void format( const char* pcFormat, ... );
+
+	private:
+		Log*				m_pLog;
+		Log::EErrorLevel	m_elErrorLevel;
+
+		unsigned int		m_uiLength;
+		char				m_acText[LOG_LINE_LENGTH];
+	};
+
 }
 
 #endif //LOG_H
@@ -0,0 +1,97 @@
+/*
+Object Oriented Communication Library
+Copyright (c) 2011 Jürgen Lorenz and Jörn Teuber
+
+This software is provided 'as-is', without any express or implied warranty.
+In no event will the authors be held liable for any damages arising from the use of this software.
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it freely,
+subject to the following restrictions:
+
+1. The origin of this software must not be misrepresented; you must not claim that you wrote the original software. If you use this software in a product, an acknowledgment in the product documentation would be appreciated but is not required.
+2. Altered source versions must be plainly marked as such, and must not be misrepresented as being the original software.
+3. This notice may not be removed or altered from any source distribution.
+*/
+// This file was written by Jörn Teuber
+
+#ifndef LOGWRITER_H_INCLUDED
+#define LOGWRITER_H_INCLUDED
+
+#include <map>
+#include <string>
+
+#include "Log.h"
+#include "Thread.h"
+#include "Mutex.h"
+#include "Condition.h"
+#include "MPSCQueue.h"
+
+namespace oocl
+{
+#define LOG_RECORD_TEXT_LENGTH	232		///< longer messages are cut, so that a record fills 256 bytes
+#define LOG_NUM_BUFFERS			8		///< the threads that log are spread over this many buffers
+#define LOG_BUFFER_CAPACITY		1024	///< records per buffer, a record that does not fit anymore is dropped
+#define LOG_WRITE_INTERVAL		20		///< milliseconds the writer sleeps between two batches
+
+	/**
+	 * @brief	Background thread that writes the messages of all logs in asynchronous mode, see Log::setAsync().
+	 *
+	 * @note	A logging thread copies its message into a fixed-size record and pushes it into one of the lock-free
+	 * 			buffers, which is picked once per thread, so threads rarely compete for the same buffer. The writer
+	 * 			collects all buffered records every LOG_WRITE_INTERVAL milliseconds and writes them with one write
+	 * 			and one flush per log. If the writer falls behind and a buffer is full, the new record is dropped
+	 * 			and counted, the writer reports the number of dropped records in the affected log.
+	 * 			The records of one thread are written in the order they were logged.
+	 *
+	 * @author	Jörn Teuber
+	 * @date	17.10.2026
+	 */
+	class LogWriter : public Thread
+	{
+	public:
+		static LogWriter* getInstance();
+		static void shutdown();
+
+		bool push( Log* pLog, Log::EErrorLevel elErrorLevel, const char* pcText, unsigned int uiLength );
+		void flush();
+
+	protected:
+		void run();
+
+	private:
+		LogWriter();
+		~LogWriter();
+
+		LogWriter( LogWriter& lw );
+		LogWriter& operator=(const LogWriter&);
+
+		void drain();
+
+		/**
+		 * @brief	One logged message.
+		 */
+		struct Record
+		{
+			Log*			pLog;
+			time_t			time;
+			unsigned short	usErrorLevel;
+			unsigned short	usLength;
+			char			acText[LOG_RECORD_TEXT_LENGTH];
+		};
+
+	private:
+		MPSCQueue<Record>*				m_apBuffers[LOG_NUM_BUFFERS];
+		Atomic<unsigned int>			m_uiNextBuffer;		///< the buffer the next thread that logs for the first time gets
+
+		std::map<Log*, std::string>		m_mapPendingText;	///< the formatted text of the current batch for every log
+		bool							m_bRunning;
+
+		Mutex		m_mxDrain;		///< only one thread at a time may pop records
+		Condition	m_condWakeUp;
+
+		static Atomic<LogWriter*>	sm_pInstance;
+	};
+
+}
+
+#endif // LOGWRITER_H_INCLUDED
@@ -0,0 +1,254 @@
+/*
+Object Oriented Communication Library
+Copyright (c) 2011 Jürgen Lorenz and Jörn Teuber
+
+This software is provided 'as-is', without any express or implied warranty.
+In no event will the authors be held liable for any damages arising from the use of this software.
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it freely,
+subject to the following restrictions:
+
+1. The origin of this software must not be misrepresented; you must not claim that you wrote the original software. If you use this software in a product, an acknowledgment in the product documentation would be appreciated but is not required.
+2. Altered source versions must be plainly marked as such, and must not be misrepresented as being the original software.
+3. This notice may not be removed or altered from any source distribution.
+*/
+// This file was written by Jörn Teuber
+
+#ifndef MPSCQUEUE_H_
+#define MPSCQUEUE_H_
+
+#include <queue>
+
+#include "Atomic.h"
+#include "Mutex.h"
+
+namespace oocl
+{
+	/**
+	 * @brief	Queue for many producer threads and one consumer thread, e.g. the messages of a MessageBroker.
+	 *
+	 * @note	Values are pushed into a bounded lock-free ring, producers only compete for a slot and never wait
+	 * 			for the consumer. If the ring is full, values go to an unbounded overflow queue that is protected by
+	 * 			a mutex, so push() never fails. The values of one producer are popped in the order they were pushed.
+	 * 			Only one thread at a time may call pop().
+	 *
+	 * @author	Jörn Teuber
+	 * @date	16.10.2026
+	 */
+	template<typename T>
+	class MPSCQueue
+	{
+	public:
+		MPSCQueue( unsigned int uiCapacity = 1024 );
+		~MPSCQueue();
+
+		void push( T value );
+		bool tryPush( T value );
+		bool pop( T& value );
+
+		bool empty() const;
+
+		// getter
+		unsigned int capacity() const { return m_uiMask + 1; }
+
+	private:
+		MPSCQueue( MPSCQueue& q );
+		MPSCQueue& operator=(const MPSCQueue&);
+
+		bool pushToRing( T value );
+
+		/**
+		 * @brief	One slot of the ring, the sequence tells producers and consumer whether the slot is free or filled.
+		 */
+		struct Slot
+		{
+			Atomic<unsigned int>	sequence;
+			T						value;
+		};
+
+	private:
+		Slot*					m_pSlots;
+		unsigned int			m_uiMask;
+
+		// producers and consumer work on different cache lines
+		char					m_acPad0[64];
+		Atomic<unsigned int>	m_uiEnqueuePos;		///< next slot a producer will claim
+		char					m_acPad1[64];
+		unsigned int			m_uiDequeuePos;		///< next slot the consumer will read, only touched by the consumer
+		char					m_acPad2[64];
+
+		Atomic<unsigned int>	m_uiOverflowCount;	///< number of values in m_qOverflow, producers use the ring only while it is 0
+		std::queue<T>			m_qOverflow;
+		Mutex					m_mxOverflow;
+	};
+
+
+	/**
+	 * @brief	Constructor.
+	 *
+	 * @param	uiCapacity	The capacity of the lock-free ring, will be rounded up to the next power of two.
+	 */
+	template<typename T>
+	MPSCQueue<T>::MPSCQueue( unsigned int uiCapacity )
+		: m_uiEnqueuePos( 0 )
+		, m_uiDequeuePos( 0 )
+		, m_uiOverflowCount( 0 )
+	{
+		unsigned int uiSize = 2;
+		while( uiSize < uiCapacity )
+			uiSize <<= 1;
+
+		m_pSlots = new Slot[uiSize];
+		m_uiMask = uiSize - 1;
+
+		for( unsigned int i = 0; i < uiSize; i++ )
+			m_pSlots[i].sequence.store( i );
+	}
+
+
+	/**
+	 * @brief	Destructor, values that are still queued are not freed.
+	 */
+	template<typename T>
+	MPSCQueue<T>::~MPSCQueue()
+	{
+		delete[] m_pSlots;
+	}
+
+
+	/**
+	 * @brief	Appends a value, can be called from any thread.
+	 *
+	 * @param	value	The value.
+	 */
+	template<typename T>
+	void MPSCQueue<T>::push( T value )
+	{
+		// as long as older values wait in the overflow queue, newer ones have to go there as well to keep their order
+		if( m_uiOverflowCount.load() == 0 && pushToRing( value ) )
+			return;
+
+		m_mxOverflow.lock();
+		m_qOverflow.push( value );
+		m_uiOverflowCount.fetchAdd( 1 );
+		m_mxOverflow.unlock();
+	}
+
+
+	/**
+	 * @brief	Appends a value only if there is room in the lock-free ring, can be called from any thread.
+	 *
+	 * @param	value	The value.
+	 *
+	 * @return	true if the value was queued, false if the ring is full.
+	 */
+	template<typename T>
+	bool MPSCQueue<T>::tryPush( T value )
+	{
+		return m_uiOverflowCount.load() == 0 && pushToRing( value );
+	}
+
+
+	/**
+	 * @brief	Removes the oldest value, must only be called by the consumer thread.
+	 *
+	 * @param [out]	value	The removed value.
+	 *
+	 * @return	true if a value was removed, false if the queue was empty.
+	 */
+	template<typename T>
+	bool MPSCQueue<T>::pop( T& value )
+	{
+		Slot& slot = m_pSlots[m_uiDequeuePos & m_uiMask];
+
+		if( slot.sequence.load() == m_uiDequeuePos + 1 )
+		{
+			value = slot.value;
+
+			// release the slot for the producers of the next round
+			slot.sequence.store( m_uiDequeuePos + m_uiMask + 1 );
+			m_uiDequeuePos++;
+
+			return true;
+		}
+
+		if( m_uiOverflowCount.load() == 0 )
+			return false;
+
+		m_mxOverflow.lock();
+
+		// values in the overflow queue are only taken when no producer is writing into the ring anymore,
+		// as an older value of the same producer might still arrive there
+		if( m_qOverflow.empty() || m_uiEnqueuePos.load() != m_uiDequeuePos )
+		{
+			m_mxOverflow.unlock();
+			return false;
+		}
+
+		value = m_qOverflow.front();
+		m_qOverflow.pop();
+		m_uiOverflowCount.fetchAdd( (unsigned int)-1 );
+
+		m_mxOverflow.unlock();
+
+		return true;
+	}
+
+
+	/**
+	 * @brief	Check whether a value can be popped, must only be called by the consumer thread.
+	 *
+	 * @return	true if the queue is empty, false if not.
+	 */
+	template<typename T>
+	bool MPSCQueue<T>::empty() const
+	{
+		return m_pSlots[m_uiDequeuePos & m_uiMask].sequence.load() != m_uiDequeuePos + 1 && m_uiOverflowCount.load() == 0;
+	}
+
+
+	/**
+	 * @brief	Tries to put a value into the lock-free ring.
+	 *
+	 * @param	value	The value.
+	 *
+	 * @return	true if it succeeds, false if the ring is full.
+	 */
+	template<typename T>
+	bool MPSCQueue<T>::pushToRing( T value )
+	{
+		unsigned int uiPos = m_uiEnqueuePos.load();
+		Slot* pSlot = NULL;
+
+		for(;;)
+		{
+			pSlot = &m_pSlots[uiPos & m_uiMask];
+			int iDiff = (int)(pSlot->sequence.load() - uiPos);
+
+			if( iDiff == 0 )
+			{
+				// the slot is free, claim it
+				if( m_uiEnqueuePos.compareExchange( uiPos, uiPos + 1 ) )
+					break;
+			}
+			else if( iDiff < 0 )
+			{
+				// the slot still holds a value of the last round
+				return false;
+			}
+			else
+			{
+				// another producer claimed the slot first
+				uiPos = m_uiEnqueuePos.load();
+			}
+		}
+
+		pSlot->value = value;
+		pSlot->sequence.store( uiPos + 1 );
+
+		return true;
+	}
+
+} /* namespace oocl */
+
+#endif /* MPSCQUEUE_H_ */
@@ -33,42 +33,75 @@ subject to the following restrictions:
 
 #include "oocl_import_export.h"
 #include "Log.h"
+#include "WriteBuffer.h"
+#include "Codec.h"
+#include "Atomic.h"
 
 
 namespace oocl
 {
 	class Message;
+	class MessagePool;
 }
 
 EXPIMP_TEMPLATE template class OOCL_EXPORTIMPORT std::allocator<oocl::Message* (*)(const char*)>;
 EXPIMP_TEMPLATE template class OOCL_EXPORTIMPORT std::vector<oocl::Message* (*)(const char*)>;
+EXPIMP_TEMPLATE template class OOCL_EXPORTIMPORT std::allocator<oocl::MessagePool*>;
+EXPIMP_TEMPLATE template class OOCL_EXPORTIMPORT std::vector<oocl::MessagePool*>;
 
 namespace oocl
 {
 
 #define MT_InvalidMessage 0
+#define MT_ChunkFrame 0xFFFF		///< reserved for the pieces of large messages, see ChunkWriter
+#define MT_CompressedFrame 0xFFFE	///< reserved for compressed messages, see Codec
+#define MT_ReliableFrame 0xFFFD		///< reserved for messages sent with SOCK_RDM or SOCK_SEQPACKET, see ReliableChannel
+#define MT_AckFrame 0xFFFC			///< reserved for the acknowledgements of a ReliableChannel
+#define MT_FragmentFrame 0xFFFB	///< reserved for the pieces of udp messages that are larger than a datagram, see DatagramFragmenter
+
+#define MSG_EXTENDED_LENGTH 0xFFFF	///< in the length field of the header: the real length follows as 4 byte value
+#define MSG_MAX_HEADER_LENGTH 8
 	/**
 	 * @brief	Interface and manager for all message classes.
 	 *
+	 * @note	Messages are reference counted. A new message has no references, everyone who keeps it retains it, e.g.
+	 * 			with a MessagePtr, and the last release() deletes it. The MessageBroker and the networks free a message
+	 * 			that nobody retained once they are done with it, so just pass them a new message and forget about it.
+	 *
+	 * 			To port a message class that overrides getMsgString(), move its code into an override of serializeInto()
+	 * 			that appends the header (see writeHeader()) and the body to the buffer, and let getBodyLength() return
+	 * 			unsigned int. Until then the default serializeInto() sends the string of getMsgString(), which costs a
+	 * 			copy per message.
+	 *
 	 * @author	Jörn Teuber
 	 * @date	1.3.2012
 	 */
 	class OOCL_EXPORTIMPORT Message
 	{
 		friend class MessageBroker;
+		friend class MessagePool;
 
 	public:
 		static Message* createFromString( const char* cMsg );
 
+		static unsigned int getHeaderLength( unsigned int uiBodyLength ) { return uiBodyLength < MSG_EXTENDED_LENGTH ? 4 : 8; }
+		static unsigned int writeHeader( char* pcOut, unsigned short usType, unsigned int uiBodyLength );
+		static unsigned int readHeader( const char* pcFrame, unsigned int& uiBodyLength );
+
 		// *********** getter *************
 		/**
-		 * @brief return a ready-to-send string representation of the message
+		 * @brief append a ready-to-send representation of the message to the buffer
 		 *  | Type  |Length | Messagebody
 		 *  |2 byte |2 byte |   |   .... 
 		 * => Length = length of the messageBody in bytes (as returned by getBodyLength() )
+		 *  bodies of 64 KB and more use the extended header:
+		 *  | Type  | 0xFFFF |Length | Messagebody
+		 *  |2 byte | 2 byte |4 byte |   |   ....
 		 */
+		virtual void			serializeInto( WriteBuffer& buffer ) const;
+		virtual unsigned int	getBodyLength() const;
+
 		virtual std::string		getMsgString()  const;
-		virtual unsigned short	getBodyLength() const;
 
 		void setSenderID( unsigned int uiSenderID );
 		void setProtocoll( int iProtocol );
@@ -79,11 +112,18 @@ namespace oocl
 		unsigned int			getSenderID() 	const;
 		bool					isIncoming() 	const;
 
+		void					retain()		const;
+		void					release()		const;
+		unsigned int			getRefCount()	const;
+
 	protected:
 		Message();
 		virtual ~Message(void) {}
 
-		static void registerMsg( unsigned short type, Message* (*create)(const char*) );
+		static void registerMsg( unsigned short type, Message* (*create)(const char*), unsigned int uiPoolSize = 0,
+								 unsigned char ucCodec = CODEC_None, unsigned int uiCompressThreshold = 256 );
+
+		virtual bool readFrom( const char* cMsg );
 
 	protected:
 		unsigned short 	m_type;
@@ -92,8 +132,49 @@ namespace oocl
 		bool			m_bIncoming; ///< true if message came from a network, false if this client is sending it
 
 	private:
+		Message( const Message& msg );
+		Message& operator=(const Message&);
+
+		mutable Atomic<unsigned int> m_uiRefCount;
+		bool m_bPooled; ///< true if the message goes back to the pool of its type when it is released
 		
 		static std::vector<oocl::Message* (*)(const char*)> sm_msgTypeList;
+		static std::vector<oocl::MessagePool*> sm_vpPools;
+	};
+
+
+	/**
+	 * @brief	Holds a reference to a message, the message is deleted when the last reference is gone.
+	 *
+	 * @note	Copying the pointer only increments the reference count, so one message can be handed to any number
+	 * 			of listeners and peers without copying it.
+	 *
+	 * @author	Jörn Teuber
+	 * @date	16.10.2026
+	 */
+	class OOCL_EXPORTIMPORT MessagePtr
+	{
+	public:
+		MessagePtr( Message const * pMessage = NULL ) : m_pMessage( pMessage ) { if( m_pMessage ) m_pMessage->retain(); }
+		MessagePtr( const MessagePtr& ptr ) : m_pMessage( ptr.m_pMessage ) { if( m_pMessage ) m_pMessage->retain(); }
+		~MessagePtr() { if( m_pMessage ) m_pMessage->release(); }
+
+		MessagePtr& operator=( const MessagePtr& ptr )
+		{
+			// retain first, the old and the new message may be the same
+			if( ptr.m_pMessage ) ptr.m_pMessage->retain();
+			if( m_pMessage ) m_pMessage->release();
+			m_pMessage = ptr.m_pMessage;
+			return *this;
+		}
+
+		// getter
+		Message const * get() const { return m_pMessage; }
+		Message const * operator->() const { return m_pMessage; }
+		Message const & operator*() const { return *m_pMessage; }
+
+	private:
+		Message const * m_pMessage;
 	};
 }
 
@@ -19,13 +19,17 @@ subject to the following restrictions:
 
 #include <map>
 #include <list>
-#include <queue>
+#include <vector>
 
 #include "oocl_import_export.h"
 
 #include "Thread.h"
 #include "Mutex.h"
+#include "Condition.h"
+#include "Atomic.h"
+#include "MPSCQueue.h"
 #include "MessageListener.h"
+#include "MessageView.h"
 
 namespace oocl
 {
@@ -42,19 +46,24 @@ namespace oocl
 	 * 			
 	 * @note	To subscribe for a specific message type call MessageBroker::getBrokerFor(messageType)->registerListener(this). 
 	 * 			Now you will get all messages that are sent through MessageBroker::pumpMessage().
+	 * 			Every broker delivers its messages in its own thread, unless setThreadPool() was called.
 	 *
 	 * @author	Jörn Teuber
 	 * @date	22.02.2012
 	 */
-	class OOCL_EXPORTIMPORT MessageBroker : public Thread
+	class OOCL_EXPORTIMPORT MessageBroker : public Thread, public Task
 	{
 	public:
 		static MessageBroker* getBrokerFor( unsigned short usMessageType );
+		static bool hasListenersFor( unsigned short usMessageType );
+
+		static void setThreadPool( ThreadPool* pPool );
 
 		void registerListener( MessageListener* pListener );
 		void unregisterListener( MessageListener* pListener );
 
 		void pumpMessage( Message* pMessage );
+		void pumpMessage( const MessageView& view );
 
 		bool requestExclusiveMessaging( MessageListener* pListener );
 		bool discardExclusiveMessaging( MessageListener* pListener );
@@ -65,28 +74,60 @@ namespace oocl
 		void enableSynchronousMessaging();
 		void disableSynchronousMessaging();
 
+		void enableSpinWaiting( unsigned int uiSpinCount = 1000 );
+		void disableSpinWaiting();
+
+		void setMaxBatchSize( unsigned int uiMaxBatchSize );
+
 	private:
 		virtual void run();
+		virtual void execute();
+		virtual void cancel();
+
+		void schedule();
+		unsigned int popMessages();
+		void deliverMessages( Message const * const * ppMessages, size_t uiCount, const MessageView* pView = NULL );
+		void releaseMessages( unsigned int uiCount );
 
-		void deliverMessage( Message* pMessage );
+		typedef std::vector< MessageListener* > ListenerArray;
+
+		ListenerArray const * beginRead( unsigned int& uiReaderSlot );
+		void endRead( unsigned int uiReaderSlot );
+		void publishListeners( ListenerArray* pListeners );
+		void waitForReaders();
+		void reclaimListeners();
+		void waitForMessage();
+		bool spinForMessage();
 
 		MessageBroker(void);
 		~MessageBroker(void);
 
 	private:
 		MessageListener*	m_pExclusiveListener;
-		std::list< MessageListener* > m_lListeners;
-		std::queue< Message* > m_lMessageQueue;
-
-		bool m_bRunThread;
+		Atomic< ListenerArray* > m_pListeners;	///< never changed once published, register and unregister publish a new copy
+		Atomic<unsigned int> m_uiNumListeners;
+		Atomic<unsigned int> m_uiReaderEpoch;	///< its lowest bit selects the slot of m_auiReaders new readers count themselves in
+		Atomic<unsigned int> m_auiReaders[2];	///< number of threads currently reading the listener array, in two slots
+		std::vector< ListenerArray* > m_vpRetiredListeners;	///< replaced listener arrays that may still be read
+		MPSCQueue< Message* > m_qMessages;
+		std::vector< Message* > m_vpBatch;	///< the messages taken from the queue for the current delivery, only used by the queue owner
+
+		Atomic<unsigned int> m_uiRunThread;	///< 1 while a thread or pool task is running, whoever sets it to 1 owns the consumer side of the queue
+		Atomic<unsigned int> m_uiSleeping;	///< 1 while the thread waits for m_cvQueue
 		bool m_bRunContinuously;
 		bool m_bSynchronous;
 
-		Mutex m_mxQueue;
-		Mutex m_mxListener;
+		unsigned int m_uiSpinCount; ///< number of times the queue is polled before the thread goes to sleep
+		unsigned int m_uiMaxBatchSize; ///< maximum number of messages handed to the listeners at once
+
+		Mutex m_mxQueue;		///< only used to sleep on m_cvQueue, the queue itself is lock-free
+		Condition m_cvQueue;	///< signaled by pumpMessage() when a message was queued while the thread sleeps
+		Mutex m_mxListener;	///< serializes register and unregister, delivery does not lock it
 		Mutex m_mxExclusiveListener;
 
 		static std::map< unsigned int, MessageBroker* > sm_vBroker;
+		static ThreadPool* sm_pThreadPool;
+		static const unsigned int sm_uiMessagesPerTask = 64; ///< messages delivered by one pool task before the other brokers get a turn
 	};
 
 }
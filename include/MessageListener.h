@@ -17,12 +17,16 @@ subject to the following restrictions:
 #ifndef MESSAGELISTENER_H_INCLUDED
 #define MESSAGELISTENER_H_INCLUDED
 
+#include <cstddef>
+
 #include "oocl_import_export.h"
 
 #include "Message.h"
 
 namespace oocl
 {
+	class MessageView;
+
 	/**
 	 * @brief	Interface for all classes that need to receive messages of any type.
 	 *
@@ -49,12 +53,17 @@ namespace oocl
 		 * @note	Please note that every message type has its own thread to deliver the messages.
 		 * 			So be sure to either only process thread-safe data here or make the data thread-safe.
 		 * 			If you do not want to handle the message now you can return false to let the message delivery thread return to you with this messsage later.
+		 * 			The message is deleted after delivery, keep a MessagePtr to it if you need it longer.
 		 *
 		 * @param [in]	pMessage	the message.
 		 *
 		 * @return	return true if you have processed the data, false if you want to be called later with the same message.
 		 */
 		virtual bool cbMessage( Message const * const pMessage ) = 0;
+
+		virtual size_t cbMessages( Message const * const * ppMessages, size_t uiCount );
+
+		virtual bool cbMessageView( const MessageView& view );
 	};
 
 }
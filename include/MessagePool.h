@@ -0,0 +1,58 @@
+/*
+Object Oriented Communication Library
+Copyright (c) 2011 Jürgen Lorenz and Jörn Teuber
+
+This software is provided 'as-is', without any express or implied warranty.
+In no event will the authors be held liable for any damages arising from the use of this software.
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it freely,
+subject to the following restrictions:
+
+1. The origin of this software must not be misrepresented; you must not claim that you wrote the original software. If you use this software in a product, an acknowledgment in the product documentation would be appreciated but is not required.
+2. Altered source versions must be plainly marked as such, and must not be misrepresented as being the original software.
+3. This notice may not be removed or altered from any source distribution.
+*/
+// This file was written by Jörn Teuber
+
+#ifndef MESSAGEPOOL_H_
+#define MESSAGEPOOL_H_
+
+#include "oocl_import_export.h"
+
+#include "MPSCQueue.h"
+#include "Mutex.h"
+
+namespace oocl
+{
+	class Message;
+
+	/**
+	 * @brief	Keeps released messages of one type, so that received messages can reuse them instead of allocating.
+	 *
+	 * @note	Any thread may give a message back without locking, the decoding threads take them out again one at a time.
+	 * 			Set up with Message::registerMsg(), the message type has to implement Message::readFrom().
+	 *
+	 * @author	Jörn Teuber
+	 * @date	16.10.2026
+	 */
+	class OOCL_EXPORTIMPORT MessagePool
+	{
+	public:
+		MessagePool( unsigned int uiCapacity );
+		~MessagePool();
+
+		Message* acquire();
+		bool recycle( Message* pMessage );
+
+	private:
+		MessagePool( MessagePool& mp );
+		MessagePool& operator=(const MessagePool&);
+
+	private:
+		MPSCQueue<Message*>	m_qFree;
+		Mutex				m_mxAcquire;	///< lets only one thread at a time take messages out of m_qFree
+	};
+
+} /* namespace oocl */
+
+#endif /* MESSAGEPOOL_H_ */
@@ -0,0 +1,245 @@
+/*
+Object Oriented Communication Library
+Copyright (c) 2011 Jürgen Lorenz and Jörn Teuber
+
+This software is provided 'as-is', without any express or implied warranty.
+In no event will the authors be held liable for any damages arising from the use of this software.
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it freely,
+subject to the following restrictions:
+
+1. The origin of this software must not be misrepresented; you must not claim that you wrote the original software. If you use this software in a product, an acknowledgment in the product documentation would be appreciated but is not required.
+2. Altered source versions must be plainly marked as such, and must not be misrepresented as being the original software.
+3. This notice may not be removed or altered from any source distribution.
+*/
+// This file was written by Jörn Teuber
+
+#ifndef MESSAGESCHEMA_H_
+#define MESSAGESCHEMA_H_
+
+#include <cstring>
+#include <string>
+
+#include "Message.h"
+
+namespace oocl
+{
+	/**
+	 * @brief	A field of a MessageSchema with a fixed size, e.g. Field<unsigned short> or Field<unsigned int>.
+	 *
+	 * @note	T has to be copyable with memcpy. The value is stored in host byte order, like in all other messages.
+	 */
+	template<typename T>
+	struct Field
+	{
+		typedef T Type;
+		enum { Size = sizeof(T), IsFixed = 1, IsEmpty = 0 };
+
+		static unsigned int length( const T& /*value*/ )						{ return Size; }
+		static void write( char* pcOut, const T& value )						{ std::memcpy( pcOut, &value, Size ); }
+		static void read( const char* pcIn, unsigned int /*uiLength*/, T& value )	{ std::memcpy( &value, pcIn, Size ); }
+	};
+
+
+	/**
+	 * @brief	A field of a MessageSchema that takes the rest of the message body, stored as std::string.
+	 *
+	 * @note	Only the last field of a schema may be VarBytes.
+	 */
+	struct VarBytes
+	{
+		typedef std::string Type;
+		enum { Size = 0, IsFixed = 0, IsEmpty = 0 };
+
+		static unsigned int length( const std::string& value )								{ return value.length(); }
+		static void write( char* pcOut, const std::string& value )							{ std::memcpy( pcOut, value.data(), value.length() ); }
+		static void read( const char* pcIn, unsigned int uiLength, std::string& value )	{ value.assign( pcIn, uiLength ); }
+	};
+
+
+	/**
+	 * @brief	Placeholder for the unused fields of a MessageSchema.
+	 */
+	struct NoField
+	{
+		struct Type {};
+		enum { Size = 0, IsFixed = 1, IsEmpty = 1 };
+
+		static unsigned int length( const Type& /*value*/ )								{ return 0; }
+		static void write( char* /*pcOut*/, const Type& /*value*/ )						{}
+		static void read( const char* /*pcIn*/, unsigned int /*uiLength*/, Type& /*value*/ )	{}
+	};
+
+
+	/**
+	 * @brief	Base class for messages that generates serialization, decoding and registration from a list of fields.
+	 *
+	 * @note	Derive your message from it and pass the message class itself as Derived, e.g.
+	 * 			class ConnectMessage : public MessageSchema< ConnectMessage, MT_ConnectMessage, Field<unsigned short>, Field<unsigned int> >.
+	 * 			The values are stored in m_value0 to m_value5 in the order of the fields. Every field sits at a fixed
+	 * 			offset, so the body is written and read with memcpy only. Without VarBytes the body length is a
+	 * 			compile-time constant (FixedBodyLength). Derived needs a default constructor for received messages.
+	 * 			Received messages can be pooled, see registerMsg().
+	 *
+	 * @author	Jörn Teuber
+	 * @date	16.10.2026
+	 */
+	template< typename Derived, unsigned short usType,
+			  typename F0 = NoField, typename F1 = NoField, typename F2 = NoField,
+			  typename F3 = NoField, typename F4 = NoField, typename F5 = NoField >
+	class MessageSchema : public Message
+	{
+	public:
+		enum {
+			Offset1 = F0::Size,
+			Offset2 = Offset1 + F1::Size,
+			Offset3 = Offset2 + F2::Size,
+			Offset4 = Offset3 + F3::Size,
+			Offset5 = Offset4 + F4::Size,
+			FixedBodyLength = Offset5 + F5::Size,
+			IsFixedLength = F0::IsFixed && F1::IsFixed && F2::IsFixed && F3::IsFixed && F4::IsFixed && F5::IsFixed
+		};
+
+		/**
+		 * @brief	Registers the message type with the message system.
+		 *
+		 * @param	uiPoolSize			Number of released messages that are reused for received ones, 0 for no pool.
+		 * @param	ucCodec				The codec to compress the messages with, see Message::registerMsg().
+		 * @param	uiCompressThreshold	Messages shorter than this are never compressed.
+		 */
+		static void registerMsg( unsigned int uiPoolSize = 0, unsigned char ucCodec = CODEC_None, unsigned int uiCompressThreshold = 256 )
+		{
+			Message::registerMsg( usType, MessageSchema::create, uiPoolSize, ucCodec, uiCompressThreshold );
+		}
+
+		/**
+		 * @brief	Appends the message to the buffer, all fields are copied to their offsets.
+		 *
+		 * @param [in,out]	buffer	The buffer to append the message to.
+		 */
+		virtual void serializeInto( WriteBuffer& buffer ) const
+		{
+			unsigned int uiBodyLength = bodyLength();
+
+			char* pcOut = buffer.grow( getHeaderLength( uiBodyLength ) + uiBodyLength );
+			char* pcBody = pcOut + writeHeader( pcOut, usType, uiBodyLength );
+
+			F0::write( pcBody, m_value0 );
+			F1::write( pcBody + Offset1, m_value1 );
+			F2::write( pcBody + Offset2, m_value2 );
+			F3::write( pcBody + Offset3, m_value3 );
+			F4::write( pcBody + Offset4, m_value4 );
+			F5::write( pcBody + Offset5, m_value5 );
+		}
+
+		/**
+		 * @brief	Returns the size in bytes of the message body (message without header).
+		 *
+		 * @return	The body length in byte.
+		 */
+		virtual unsigned int getBodyLength() const
+		{
+			return bodyLength();
+		}
+
+	protected:
+		MessageSchema()
+		{
+			m_type = usType;
+			m_iProtocoll = SOCK_STREAM;
+		}
+
+		/**
+		 * @brief	Creates the message out of the received byte array.
+		 *
+		 * @param	in	The incoming byte buffer.
+		 *
+		 * @return	a new message built from in or NULL if the body length does not match the schema.
+		 */
+		static Message* create( const char* in )
+		{
+			Derived* pMessage = new Derived();
+			if( !pMessage->decode( in ) )
+			{
+				delete pMessage;
+				return NULL;
+			}
+
+			return pMessage;
+		}
+
+		/**
+		 * @brief	Refills a pooled message with the received byte array.
+		 *
+		 * @param	in	The incoming byte buffer.
+		 *
+		 * @return	true if it succeeds, false if the body length does not match the schema.
+		 */
+		virtual bool readFrom( const char* in )
+		{
+			m_iProtocoll = SOCK_STREAM;
+			return decode( in );
+		}
+
+		/**
+		 * @brief	Reads all fields from their offsets in the received byte array.
+		 *
+		 * @param	in	The incoming byte buffer.
+		 *
+		 * @return	true if it succeeds, false if the body length does not match the schema.
+		 */
+		bool decode( const char* in )
+		{
+			unsigned int uiBodyLength = 0;
+			const char* pcBody = in + readHeader( in, uiBodyLength );
+
+			if( uiBodyLength < (unsigned int)FixedBodyLength || ( IsFixedLength && uiBodyLength != (unsigned int)FixedBodyLength ) )
+				return false;
+
+			F0::read( pcBody, uiBodyLength, m_value0 );
+			F1::read( pcBody + Offset1, uiBodyLength - Offset1, m_value1 );
+			F2::read( pcBody + Offset2, uiBodyLength - Offset2, m_value2 );
+			F3::read( pcBody + Offset3, uiBodyLength - Offset3, m_value3 );
+			F4::read( pcBody + Offset4, uiBodyLength - Offset4, m_value4 );
+			F5::read( pcBody + Offset5, uiBodyLength - Offset5, m_value5 );
+
+			return true;
+		}
+
+		/**
+		 * @brief	Computes the body length, a constant for schemas without VarBytes.
+		 *
+		 * @return	The body length in byte.
+		 */
+		unsigned int bodyLength() const
+		{
+			if( IsFixedLength )
+				return FixedBodyLength;
+
+			return F0::length( m_value0 ) + F1::length( m_value1 ) + F2::length( m_value2 )
+				 + F3::length( m_value3 ) + F4::length( m_value4 ) + F5::length( m_value5 );
+		}
+
+	protected:
+		typename F0::Type m_value0;
+		typename F1::Type m_value1;
+		typename F2::Type m_value2;
+		typename F3::Type m_value3;
+		typename F4::Type m_value4;
+		typename F5::Type m_value5;
+
+	private:
+		// a field with a variable length takes the rest of the body, so no other field may follow it
+		enum {
+			VarBytesIsLast = ( F0::IsFixed || ( F1::IsEmpty && F2::IsEmpty && F3::IsEmpty && F4::IsEmpty && F5::IsEmpty ) )
+						  && ( F1::IsFixed || ( F2::IsEmpty && F3::IsEmpty && F4::IsEmpty && F5::IsEmpty ) )
+						  && ( F2::IsFixed || ( F3::IsEmpty && F4::IsEmpty && F5::IsEmpty ) )
+						  && ( F3::IsFixed || ( F4::IsEmpty && F5::IsEmpty ) )
+						  && ( F4::IsFixed || F5::IsEmpty )
+		};
+		typedef char AssertVarBytesIsLast[ VarBytesIsLast ? 1 : -1 ];
+	};
+
+} /* namespace oocl */
+
+#endif /* MESSAGESCHEMA_H_ */
@@ -0,0 +1,94 @@
+/*
+Object Oriented Communication Library
+Copyright (c) 2011 Jürgen Lorenz and Jörn Teuber
+
+This software is provided 'as-is', without any express or implied warranty.
+In no event will the authors be held liable for any damages arising from the use of this software.
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it freely,
+subject to the following restrictions:
+
+1. The origin of this software must not be misrepresented; you must not claim that you wrote the original software. If you use this software in a product, an acknowledgment in the product documentation would be appreciated but is not required.
+2. Altered source versions must be plainly marked as such, and must not be misrepresented as being the original software.
+3. This notice may not be removed or altered from any source distribution.
+*/
+// This file was written by Jörn Teuber
+
+#ifndef MESSAGEVIEW_H_
+#define MESSAGEVIEW_H_
+
+#include <cstring>
+
+#include "oocl_import_export.h"
+
+#include "Message.h"
+
+namespace oocl
+{
+	/**
+	 * @brief	A received message that is still in the receive buffer, its fields are read on access.
+	 *
+	 * @note	The networks hand views to listeners that are called synchronously, see MessageListener::cbMessageView().
+	 * 			A view is only valid during the callback, as the receive buffer is reused afterwards. Use getField() with
+	 * 			the offsets of the message schema to read single values, or retain() to keep the message longer, which
+	 * 			creates a Message object from the frame once.
+	 *
+	 * @author	Jörn Teuber
+	 * @date	16.10.2026
+	 */
+	class OOCL_EXPORTIMPORT MessageView
+	{
+	public:
+		MessageView( const char* pcFrame );
+		~MessageView();
+
+		void setSenderID( unsigned int uiSenderID );
+
+		// getter
+		unsigned short	getType() const;
+		unsigned int	getBodyLength() const	{ return m_uiBodyLength; }
+		unsigned int	getHeaderLength() const	{ return m_uiHeaderLength; }
+		const char*		getBody() const		{ return m_pcFrame + m_uiHeaderLength; }
+		const char*		getFrame() const	{ return m_pcFrame; }
+		unsigned int	getSenderID() const	{ return m_uiSenderID; }
+
+		template<typename T>
+		T getField( unsigned int uiOffset ) const;
+
+		Message*	getMessage() const;
+		MessagePtr	retain() const;
+
+	private:
+		MessageView( MessageView& mv );
+		MessageView& operator=(const MessageView&);
+
+	private:
+		const char*		m_pcFrame;
+		unsigned int	m_uiHeaderLength;
+		unsigned int	m_uiBodyLength;
+		unsigned int	m_uiSenderID;
+
+		mutable Message* m_pMessage;	///< created by the first call to getMessage(), the view holds a reference to it
+	};
+
+
+	/**
+	 * @brief	Reads a value from the body without creating a message.
+	 *
+	 * @param	uiOffset	Offset of the value in the body, e.g. Offset1 of the message schema.
+	 *
+	 * @return	The value or T() if the body is too short.
+	 */
+	template<typename T>
+	T MessageView::getField( unsigned int uiOffset ) const
+	{
+		T value = T();
+		if( uiOffset + sizeof(T) <= getBodyLength() )
+			std::memcpy( &value, getBody() + uiOffset, sizeof(T) );
+
+		return value;
+	}
+
+} /* namespace oocl */
+
+#endif /* MESSAGEVIEW_H_ */
@@ -35,6 +35,8 @@ namespace oocl
 	 */
 	class Mutex
 	{
+		friend class Condition;
+
 	public:
 		Mutex();
 		~Mutex();
@@ -55,7 +57,7 @@ namespace oocl
 #elif defined USE_PTHREADS
 		pthread_mutex_t m_mutex;
 #elif defined USE_WINTHREADS
-		HANDLE m_hMutex;
+		CRITICAL_SECTION m_csMutex;
 #endif
 	};
 
@@ -23,10 +23,18 @@ subject to the following restrictions:
 #include "MessageBroker.h"
 #include "ExplicitMessages.h"
 #include "BerkeleySocket.h"
+#include "FrameDecoder.h"
+#include "ChunkWriter.h"
+#include "ReliableChannel.h"
+#include "DatagramFragmenter.h"
+#include "SendQueue.h"
+#include "Thread.h"
 #include "Mutex.h"
 
 // #define SIM_DELAY
 
+#define PEER_DRAIN_TIMEOUT 1000	///< milliseconds a peer may take to receive a queued message when disconnecting
+
 namespace oocl
 {
 
@@ -35,10 +43,14 @@ namespace oocl
 	 */
 	typedef unsigned int PeerID;
 
+	class RoutingTable;
+
 	/**
 	 * @brief	This class manages one peer in the peer 2 peer network.
 	 * 			
 	 * @note	To create a peer call Peer2PeerNetwork::addPeer(...).
+	 * 			The RoutingTable of the network puts the messages the peer subscribed into its SendQueue and a writer
+	 * 			thread of this peer sends them, so a peer that does not receive fast enough does not stall the broker.
 	 *
 	 * @author	Jörn Teuber
 	 * @date	9.12.2011
@@ -46,14 +58,21 @@ namespace oocl
 	class OOCL_EXPORTIMPORT Peer : public MessageListener
 	{
 		friend class Peer2PeerNetwork;
+		friend class RoutingTable;
 
 	public:
 		// will be send to the peer
 		bool sendMessage( Message const * const pMessage );
 		bool subscribe( unsigned short usType );
 
+		void setBatching( Socket::EFlushPolicy ePolicy, unsigned int uiThreshold = 0 );
+		void setChunkSize( unsigned int uiChunkSize );
+		void setPathMTU( unsigned int uiMTU );
+		void setSendQueue( unsigned int uiCapacity, SendQueue::EOverflowPolicy ePolicy );
+		bool flush();
+
 		// was sent by the peer
-		bool receiveMessage( Message* pMessage );
+		bool receiveMessage( MessageView& view );
 
 		// getter
 		bool	isConnected();
@@ -61,6 +80,7 @@ namespace oocl
 
 		unsigned int	getIP();
 		unsigned short 	getListeningPort();
+		unsigned int	getDroppedCount();
 
 		virtual bool cbMessage( Message const * const pMessage );
 
@@ -75,6 +95,37 @@ namespace oocl
 		bool connectSockets();
 
 		void deactivate();
+		void stopWriter( bool bDrain );
+
+		bool send( Message const * const pMessage, SerializedMessage const * pSerialized );
+		bool sendChunked( Message const * const pMessage, SerializedMessage const * pSerialized );
+		void queueMessage( SerializedMessage const * pMessage );
+
+		bool receiveReliable( MessageView& view );
+		bool receiveFragment( MessageView& view );
+		bool sendAck();
+		int  resendDue();
+
+		bool flushIfDue();
+		void applyBatching();
+
+		/**
+		 * @brief	Sends the messages of the SendQueue of a peer until it is closed.
+		 *
+		 * @note	Started when the connection is established and joined by disconnect(), so a peer that never
+		 * 			connects does not cost a thread.
+		 */
+		class Writer : public Thread
+		{
+		public:
+			Writer( Peer* pPeer );
+
+		protected:
+			void run();
+
+		private:
+			Peer* m_pPeer;
+		};
 
 #ifdef SIM_DELAY
 		class MessageDelayer : public Thread
@@ -93,11 +144,22 @@ namespace oocl
 	private:
 		unsigned char m_ucConnectStatus;
 
-		std::list<unsigned short> m_lusSubscribedMsgTypes;
-
 		Socket* m_pSocketTCP;
 		Socket* m_pSocketUDPOut;
 
+		FrameDecoder	m_frameDecoder; ///< splits the stream received on the tcp socket into messages
+		WriteBuffer		m_wbSendBuffer; ///< outgoing messages are serialized into this buffer, guarded by m_mxSockets
+		WriteBuffer		m_wbCompressBuffer; ///< used by Codec::compressFrame(), guarded by m_mxSockets
+		unsigned int	m_uiCodecs;		///< the codecs both sides support, set by the handshake
+		ChunkWriter		m_chunkWriter;	///< splits large tcp messages, so that they do not block the others
+		ReliableChannel	m_reliable;		///< sequences and retransmits the SOCK_RDM and SOCK_SEQPACKET messages
+		DatagramFragmenter	m_fragmenter;	///< splits udp messages that are larger than the path MTU and reassembles them, guarded by m_mxSockets for sending
+		SendQueue		m_sendQueue;	///< the subscribed messages that wait for m_writer
+		RoutingTable*	m_pRoutingTable; ///< the table that knows the subscriptions of this peer, guarded by its lock
+		unsigned int	m_uiSlot;		///< the slot of this peer in m_pRoutingTable
+		unsigned int	m_uiRoutings;	///< number of brokers that queue a message for this peer, guarded by the lock of m_pRoutingTable
+		Writer			m_writer;
+
 		std::string		m_strHostname;
 		unsigned int	m_uiIP;
 		unsigned short	m_usPort;
@@ -105,6 +167,9 @@ namespace oocl
 		PeerID			m_uiUserID; ///< the ID of the peer running this instance
 		bool 			m_bActive;
 
+		Socket::EFlushPolicy	m_eFlushPolicy;
+		unsigned int			m_uiFlushThreshold;
+
 		Mutex	m_mxSockets;
 
 		static unsigned int sm_uiNumPeers;
@@ -19,12 +19,16 @@ subject to the following restrictions:
 
 #include <list>
 #include <map>
+#include <vector>
+#include <algorithm>
 
 #include "Peer.h"
 #include "Thread.h"
 #include "MessageBroker.h"
 #include "ExplicitMessages.h"
 #include "ServerSocket.h"
+#include "Reactor.h"
+#include "RoutingTable.h"
 
 namespace oocl
 {
@@ -32,11 +36,13 @@ namespace oocl
 	 * @brief	Manager class for a message based peer2peer network.
 	 * 			
 	 * @note	sends message: NewPeerMessage
+	 * 			All sockets are registered with one Reactor, so the network thread only wakes up for sockets that are ready.
+	 * 			Outgoing messages are routed to the subscribed peers by a RoutingTable.
 	 *
 	 * @author	Jörn Teuber
 	 * @date	8.12.2011
 	 */
-	class OOCL_EXPORTIMPORT Peer2PeerNetwork : public Thread
+	class OOCL_EXPORTIMPORT Peer2PeerNetwork : public Thread, public ReactorListener
 	{
 	public:
 		Peer2PeerNetwork( unsigned short usListeningPort, PeerID uiUserID );
@@ -48,11 +54,19 @@ namespace oocl
 		void subPeer( PeerID uiPeerID );
 		void disconnect();
 
+		void setBatching( Socket::EFlushPolicy ePolicy, unsigned int uiThreshold = 0 );
+		void setChunkSize( unsigned int uiChunkSize );
+		void setPathMTU( unsigned int uiMTU );
+		void setSendQueue( unsigned int uiCapacity, SendQueue::EOverflowPolicy ePolicy );
+		void flush();
+
 		// getter
 		Peer*				getPeerByID( PeerID uiPeerID );
 		unsigned int		getPeersIP( PeerID uiPeerID );
 		std::list<Peer*>*	getPeerList();
 		unsigned int		getUserID();
+
+		virtual void cbReadable( SocketStub* pSocket, void* pContext );
 		
 	protected:
 		virtual void run();
@@ -60,16 +74,35 @@ namespace oocl
 	private:
 		bool connectAndInsertPeer( Peer* pPeer );
 
+		void acceptConnections();
+		void receiveFromUDP();
+		void receiveFromPeer( Peer* pPeer );
+		void receiveFromUnknown( Socket* pSocket );
+		void reclaimPeers();
+
 	private:
 		std::list<Peer*> m_lpPeers;
 		std::map<PeerID, Peer*> m_mapPeersByID;
-		std::list<Socket*> m_lpSocketsWithoutPeers;
+		std::map<Socket*, FrameDecoder*> m_mapSocketsWithoutPeers; ///< tcp sockets that did not send a ConnectMessage yet and the decoders for the bytes received on them
+
+		Reactor			m_reactor;
+		RoutingTable	m_routingTable;	///< sends every outgoing message to the peers that subscribed its type
+		DatagramSlab	m_dsReceiveSlab; ///< the udp server socket receives into this slab
+		std::vector<Peer*>	m_vpAckPending;	///< peers that received reliable udp messages in the current batch
+		std::vector<Peer*>	m_vpRetiredPeers; ///< peers removed by other threads, the current dispatch might still call them, guarded by m_mxPeers
 
 		Socket*			m_pServerSocketUDP;
 		ServerSocket*	m_pServerSocketTCP;
 
 		Mutex		m_mxPeers;
 
+		Socket::EFlushPolicy	m_eFlushPolicy;		///< the flush policy for all peers, guarded by m_mxPeers
+		unsigned int			m_uiFlushThreshold;
+		unsigned int			m_uiChunkSize;		///< the chunk size for all peers, guarded by m_mxPeers
+		unsigned int			m_uiPathMTU;		///< the path MTU for all peers, 0 asks their sockets, guarded by m_mxPeers
+		unsigned int				m_uiSendQueueCapacity;	///< the send queue of all peers, guarded by m_mxPeers
+		SendQueue::EOverflowPolicy	m_eOverflowPolicy;
+
 		bool			m_bActive;
 		unsigned short	m_usListeningPort;
 		PeerID			m_uiUserID;
@@ -0,0 +1,54 @@
+/*
+Object Oriented Communication Library
+Copyright (c) 2011 Jürgen Lorenz and Jörn Teuber
+
+This software is provided 'as-is', without any express or implied warranty.
+In no event will the authors be held liable for any damages arising from the use of this software.
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it freely,
+subject to the following restrictions:
+
+1. The origin of this software must not be misrepresented; you must not claim that you wrote the original software. If you use this software in a product, an acknowledgment in the product documentation would be appreciated but is not required.
+2. Altered source versions must be plainly marked as such, and must not be misrepresented as being the original software.
+3. This notice may not be removed or altered from any source distribution.
+*/
+// This file was written by Jörn Teuber
+
+#ifndef PEERSET_H_INCLUDED
+#define PEERSET_H_INCLUDED
+
+#include <vector>
+
+#include "oocl_import_export.h"
+
+namespace oocl
+{
+	/**
+	 * @brief	Compact set of peers, one bit per slot that the RoutingTable gave a peer.
+	 *
+	 * @note	Iterate with next(), which skips 32 peers per word that are not in the set:
+	 * 			for( int i = set.next( 0 ); i >= 0; i = set.next( i + 1 ) )
+	 *
+	 * @author	Jörn Teuber
+	 * @date	17.10.2026
+	 */
+	class OOCL_EXPORTIMPORT PeerSet
+	{
+	public:
+		PeerSet();
+
+		void insert( unsigned int uiSlot );
+		void erase( unsigned int uiSlot );
+
+		bool contains( unsigned int uiSlot ) const;
+		bool empty() const;
+		int  next( unsigned int uiSlot ) const;
+
+	private:
+		std::vector<unsigned int>	m_vuiWords;
+		unsigned int				m_uiCount;	///< number of peers in the set
+	};
+
+}
+
+#endif // PEERSET_H_INCLUDED
@@ -0,0 +1,123 @@
+/*
+Object Oriented Communication Library
+Copyright (c) 2011 Jürgen Lorenz and Jörn Teuber
+
+This software is provided 'as-is', without any express or implied warranty.
+In no event will the authors be held liable for any damages arising from the use of this software.
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it freely,
+subject to the following restrictions:
+
+1. The origin of this software must not be misrepresented; you must not claim that you wrote the original software. If you use this software in a product, an acknowledgment in the product documentation would be appreciated but is not required.
+2. Altered source versions must be plainly marked as such, and must not be misrepresented as being the original software.
+3. This notice may not be removed or altered from any source distribution.
+*/
+// This file was written by Jörn Teuber
+
+#ifndef REACTOR_H_INCLUDED
+#define REACTOR_H_INCLUDED
+
+#include <map>
+#include <list>
+
+#ifdef linux
+#	include <sys/epoll.h>
+#	include <sys/eventfd.h>
+#	include <unistd.h>
+#	include <stdint.h>
+#endif
+
+#include "oocl_import_export.h"
+
+#include "SocketStub.h"
+#include "Mutex.h"
+#include "Log.h"
+
+namespace oocl
+{
+	/**
+	 * @brief	Interface for all classes that need to be notified when a socket registered with a Reactor is ready.
+	 *
+	 * @author	Jörn Teuber
+	 * @date	16.10.2026
+	 */
+	class OOCL_EXPORTIMPORT ReactorListener
+	{
+	public:
+		virtual ~ReactorListener() {}
+
+		/**
+		 * @brief	This is the callback method for sockets that have data to receive, a pending connection or an error.
+		 *
+		 * @note	The notification is edge-triggered, so read from the socket until it would block,
+		 * 			else the remaining data will not be reported again until new data arrives.
+		 *
+		 * @param [in]	pSocket		The socket that is ready.
+		 * @param [in]	pContext	The context pointer that was given when registering the socket.
+		 */
+		virtual void cbReadable( SocketStub* pSocket, void* pContext ) = 0;
+	};
+
+
+	/**
+	 * @brief	Waits for incoming data on any number of sockets and dispatches readiness callbacks to the registered listeners.
+	 *
+	 * @note	Sockets are registered once and switched to non-blocking mode, so the cost of one dispatch()
+	 * 			depends on the number of ready sockets and not on the number of registered ones.
+	 * 			On linux this uses edge-triggered epoll, on other platforms it falls back to select.
+	 *
+	 * @author	Jörn Teuber
+	 * @date	16.10.2026
+	 */
+	class OOCL_EXPORTIMPORT Reactor
+	{
+	public:
+		Reactor();
+		~Reactor();
+
+		bool registerSocket( SocketStub* pSocket, ReactorListener* pListener, void* pContext = NULL );
+		bool unregisterSocket( SocketStub* pSocket );
+		bool unregisterSocket( int iSocket );
+
+		int dispatch( int iTimeoutMS = -1 );
+		void interrupt();
+
+		bool isValid();
+
+	private:
+		Reactor( Reactor& r );
+		Reactor& operator=(const Reactor&);
+
+		/**
+		 * @brief	Everything the reactor needs to know about one registered socket.
+		 */
+		struct Registration
+		{
+			SocketStub*			pSocket;
+			ReactorListener*	pListener;
+			void*				pContext;
+			int					iSocket;
+			bool				bRemoved;
+		};
+
+		void reclaimRegistrations();
+
+	private:
+		std::map< int, Registration* > m_mapRegistrations;
+		std::list< Registration* > m_lpRetiredRegistrations; ///< unregistered sockets that might still be referenced by the current dispatch
+
+		Mutex m_mxRegistrations;
+
+		bool m_bValid;
+
+#ifdef linux
+		int m_iEpollFD;
+		int m_iWakeupFD;
+#endif
+
+		static const int sm_iMaxEventsPerDispatch = 64;
+	};
+
+}
+
+#endif // REACTOR_H_INCLUDED
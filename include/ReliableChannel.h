@@ -0,0 +1,156 @@
+/*
+Object Oriented Communication Library
+Copyright (c) 2011 Jürgen Lorenz and Jörn Teuber
+
+This software is provided 'as-is', without any express or implied warranty.
+In no event will the authors be held liable for any damages arising from the use of this software.
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it freely,
+subject to the following restrictions:
+
+1. The origin of this software must not be misrepresented; you must not claim that you wrote the original software. If you use this software in a product, an acknowledgment in the product documentation would be appreciated but is not required.
+2. Altered source versions must be plainly marked as such, and must not be misrepresented as being the original software.
+3. This notice may not be removed or altered from any source distribution.
+*/
+// This file was written by Jörn Teuber
+
+
+#ifndef RELIABLECHANNEL_H_INCLUDED
+#define RELIABLECHANNEL_H_INCLUDED
+
+#include <map>
+#include <set>
+#include <deque>
+#include <string>
+
+#include "oocl_import_export.h"
+
+#include "Message.h"
+#include "Socket.h"
+#include "Mutex.h"
+#include "DatagramFragmenter.h"
+
+namespace oocl
+{
+	class Reactor;
+
+#define RC_INITIAL_RTO 200000	///< retransmission timeout in microseconds until the first round trip was measured
+#define RC_MIN_RTO 10000
+#define RC_MAX_RTO 2000000
+#define RC_MAX_RETRIES 10		///< number of retransmissions before a message is dropped
+#define RC_WINDOW 4096			///< sequences further ahead of the next expected one are dropped by the receiver
+#define RC_FRAME_HEADER 9		///< the bytes between the header of an MT_ReliableFrame and the message
+#define RC_MAX_RANGES 32		///< maximum number of ranges of received sequences per channel in one acknowledgement
+
+	/**
+	 * @brief	Adds sequence numbers, acknowledgements and retransmission to the messages sent over one udp connection.
+	 *
+	 * @note	Messages with the protocol SOCK_RDM are delivered exactly once in any order, messages with SOCK_SEQPACKET
+	 * 			exactly once in the order they were sent. Both are wrapped into a frame of their own:
+	 * 			| MT_ReliableFrame | Length | Channel | Sequence | Oldest unacknowledged | Message
+	 * 			| 2 byte           | 2 byte | 1 byte  | 4 byte   | 4 byte                |   ....
+	 * 			The receiver answers with the next sequence it expects and the ranges of later sequences that already arrived,
+	 * 			once for the RDM and once for the SEQPACKET channel:
+	 * 			| MT_AckFrame | Length | Next   | Count  | First  | Last   | ... | Next   | Count  | ...
+	 * 			| 2 byte      | 2 byte | 4 byte | 1 byte | 4 byte | 4 byte | ... | 4 byte | 1 byte | ...
+	 * 			A gap in front of an acknowledged sequence counts as lost and is sent again at once, everything else
+	 * 			when its retransmission timeout expires. The timeout follows the measured round trip time like in tcp
+	 * 			(RFC 6298) and doubles with every retry, after RC_MAX_RETRIES a message is dropped. The oldest sequence the
+	 * 			sender still waits for tells the receiver that it must not wait for the dropped ones any longer.
+	 * 			The sending methods may be called from any thread, the receiving ones only by the network thread, which also
+	 * 			has to call resendDue() when the returned timeout expired.
+	 *
+	 * @author	Jörn Teuber
+	 * @date	16.10.2026
+	 */
+	class OOCL_EXPORTIMPORT ReliableChannel
+	{
+	public:
+		ReliableChannel();
+
+		void setReactor( Reactor* pReactor ) { m_pReactor = pReactor; }
+
+		static bool isReliable( int iProtocol ) { return iProtocol == SOCK_RDM || iProtocol == SOCK_SEQPACKET; }
+		static unsigned int getFragmentID( const char* pcDatagram );
+
+		// sender
+		bool	send( Message const * pMessage, WriteBuffer& wbDatagram, const void* pTrailer = NULL, unsigned int uiTrailerLength = 0 );
+		bool	send( int iProtocol, const char* pcFrame, unsigned int uiFrameLength, WriteBuffer& wbDatagram, const void* pTrailer = NULL, unsigned int uiTrailerLength = 0 );
+		int		resendDue( Socket* pSocket, DatagramFragmenter& fragmenter );
+
+		// receiver
+		bool	receive( const char* pcFrame, unsigned int uiFrameLength );
+		bool	nextMessage( const char*& pcFrame, unsigned int& uiFrameLength );
+		bool	appendAck( WriteBuffer& wbDatagram );
+
+		// getter
+		bool			isAckPending() const { return m_aReceivers[0].bAckPending || m_aReceivers[1].bAckPending; }
+		unsigned int	getRetransmissionTimeout() const { return (unsigned int)m_ullRTO; }
+		unsigned int	getDroppedCount() const { return m_uiDropped; }
+
+	private:
+		ReliableChannel( ReliableChannel& rc );
+		ReliableChannel& operator=(const ReliableChannel&);
+
+		bool beginDatagram( int iProtocol, unsigned int uiMessageLength, WriteBuffer& wbDatagram );
+		void finishDatagram( WriteBuffer& wbDatagram, const void* pTrailer, unsigned int uiTrailerLength );
+		void processAck( unsigned int uiChannel, unsigned int uiNext, const unsigned int* puiRanges, unsigned int uiRangeCount, unsigned long long ullNow );
+		void skipTo( unsigned int uiChannel, unsigned int uiSequence );
+		void advance( unsigned int uiChannel );
+		void updateRTO( unsigned long long ullSample );
+
+		/**
+		 * @brief	Orders sequence numbers so that they may wrap around.
+		 */
+		struct SequenceLess
+		{
+			bool operator()( unsigned int a, unsigned int b ) const { return (int)(a - b) < 0; }
+		};
+
+		/**
+		 * @brief	A sent datagram that was not acknowledged yet.
+		 */
+		struct Pending
+		{
+			std::string			strDatagram;
+			unsigned long long	ullSentTime;
+			unsigned long long	ullDueTime;
+			unsigned int		uiRetries;
+		};
+
+		struct Sender
+		{
+			unsigned int										uiNextSequence;
+			std::map<unsigned int, Pending, SequenceLess>		mapUnacked;
+		};
+
+		struct Receiver
+		{
+			unsigned int										uiNextExpected;	///< all sequences before this one arrived
+			std::set<unsigned int, SequenceLess>				setReceived;	///< sequences after uiNextExpected that arrived on the unordered channel
+			std::map<unsigned int, std::string, SequenceLess>	mapOutOfOrder;	///< messages that wait for a gap on the ordered channel
+			bool												bAckPending;
+		};
+
+	private:
+		Sender				m_aSenders[2];
+		Receiver			m_aReceivers[2];
+
+		unsigned long long	m_ullNextDue;		///< the earliest due time of all unacknowledged datagrams
+		unsigned long long	m_ullSRTT;			///< smoothed round trip time in microseconds, 0 until the first sample
+		unsigned long long	m_ullRTTVar;
+		unsigned long long	m_ullRTO;			///< retransmission timeout in microseconds
+		unsigned int		m_uiDropped;		///< number of messages that were given up after RC_MAX_RETRIES
+
+		const char*				m_pcDirect;			///< the message of the last received datagram if it can be delivered at once
+		unsigned int			m_uiDirectLength;
+		std::deque<std::string>	m_dqReady;			///< messages of the ordered channel whose gap was closed
+		std::string				m_strCurrent;		///< the message returned by the last nextMessage() call
+
+		Reactor*	m_pReactor;		///< woken up when a retransmission is due earlier than all others
+		Mutex		m_mxSender;		///< guards the sender state and the timeouts
+	};
+
+}
+
+#endif // RELIABLECHANNEL_H_INCLUDED
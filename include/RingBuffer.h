@@ -0,0 +1,73 @@
+/*
+Object Oriented Communication Library
+Copyright (c) 2011 Jürgen Lorenz and Jörn Teuber
+
+This software is provided 'as-is', without any express or implied warranty.
+In no event will the authors be held liable for any damages arising from the use of this software.
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it freely,
+subject to the following restrictions:
+
+1. The origin of this software must not be misrepresented; you must not claim that you wrote the original software. If you use this software in a product, an acknowledgment in the product documentation would be appreciated but is not required.
+2. Altered source versions must be plainly marked as such, and must not be misrepresented as being the original software.
+3. This notice may not be removed or altered from any source distribution.
+*/
+// This file was written by Jörn Teuber
+
+#ifndef RINGBUFFER_H_INCLUDED
+#define RINGBUFFER_H_INCLUDED
+
+#include <cstring>
+#include <algorithm>
+
+#include "oocl_import_export.h"
+
+namespace oocl
+{
+	/**
+	 * @brief	Byte ring buffer with a power of two capacity that grows on demand.
+	 *
+	 * @note	Writing and reading is done in place: writeRegion() and readRegion() return the largest contiguous
+	 * 			part of the free or used space, which is then committed with commit() or consumed with consume().
+	 *
+	 * @author	Jörn Teuber
+	 * @date	16.10.2026
+	 */
+	class OOCL_EXPORTIMPORT RingBuffer
+	{
+	public:
+		RingBuffer( unsigned int uiCapacity = 4096 );
+		~RingBuffer();
+
+		char*		writeRegion( unsigned int& uiLength );
+		void		commit( unsigned int uiLength );
+
+		const char*	readRegion( unsigned int& uiLength );
+		void		consume( unsigned int uiLength );
+
+		void		peek( char* pcDest, unsigned int uiLength ) const;
+		const char*	linearize( unsigned int uiLength );
+
+		void		reserve( unsigned int uiCapacity );
+		void		swap( RingBuffer& other );
+		void		clear();
+
+		// getter
+		unsigned int size() const		{ return m_uiWritePos - m_uiReadPos; }
+		unsigned int capacity() const	{ return m_uiCapacity; }
+		unsigned int space() const		{ return m_uiCapacity - size(); }
+
+	private:
+		RingBuffer( RingBuffer& rb );
+		RingBuffer& operator=(const RingBuffer&);
+
+	private:
+		char*			m_pcData;
+		unsigned int	m_uiCapacity;
+		unsigned int	m_uiReadPos;	///< running read counter, the index is m_uiReadPos & (m_uiCapacity-1)
+		unsigned int	m_uiWritePos;	///< running write counter, the index is m_uiWritePos & (m_uiCapacity-1)
+	};
+
+}
+
+#endif // RINGBUFFER_H_INCLUDED
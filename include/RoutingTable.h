@@ -0,0 +1,88 @@
+/*
+Object Oriented Communication Library
+Copyright (c) 2011 Jürgen Lorenz and Jörn Teuber
+
+This software is provided 'as-is', without any express or implied warranty.
+In no event will the authors be held liable for any damages arising from the use of this software.
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it freely,
+subject to the following restrictions:
+
+1. The origin of this software must not be misrepresented; you must not claim that you wrote the original software. If you use this software in a product, an acknowledgment in the product documentation would be appreciated but is not required.
+2. Altered source versions must be plainly marked as such, and must not be misrepresented as being the original software.
+3. This notice may not be removed or altered from any source distribution.
+*/
+// This file was written by Jörn Teuber
+
+#ifndef ROUTINGTABLE_H_INCLUDED
+#define ROUTINGTABLE_H_INCLUDED
+
+#include <map>
+#include <vector>
+
+#include "oocl_import_export.h"
+
+#include "MessageBroker.h"
+#include "PeerSet.h"
+#include "Mutex.h"
+#include "Condition.h"
+
+namespace oocl
+{
+	class Peer;
+
+	/**
+	 * @brief	Knows which peers subscribed which message types and hands every outgoing message to exactly those peers.
+	 *
+	 * @note	Every peer gets a slot, and every subscribed type a route with the PeerSet of its subscribers. The route is
+	 * 			the only listener of the network at the MessageBroker of its type, so a message is serialized once and the
+	 * 			same SerializedMessage is put into the send queues of all subscribers, no matter how many peers and types
+	 * 			there are. Used by the Peer2PeerNetwork.
+	 *
+	 * @author	Jörn Teuber
+	 * @date	17.10.2026
+	 */
+	class OOCL_EXPORTIMPORT RoutingTable
+	{
+	public:
+		RoutingTable();
+		~RoutingTable();
+
+		void addPeer( Peer* pPeer );
+		void removePeer( Peer* pPeer );
+
+		void subscribe( Peer* pPeer, unsigned short usType );
+
+	private:
+		RoutingTable( RoutingTable& rt );
+		RoutingTable& operator=(const RoutingTable&);
+
+		/**
+		 * @brief	The listener for one message type, holds the peers that subscribed it.
+		 */
+		class Route : public MessageListener
+		{
+		public:
+			Route( RoutingTable* pTable ) : m_pTable( pTable ) {}
+
+			virtual bool cbMessage( Message const * const pMessage );
+
+			PeerSet	m_setPeers;		///< guarded by the m_mxRoutes of the table
+
+		private:
+			RoutingTable* m_pTable;
+		};
+
+		void route( Message const * pMessage, const Route* pRoute );
+
+	private:
+		std::map<unsigned short, Route*>	m_mapRoutes;
+		std::vector<Peer*>					m_vpPeers;		///< the peers by their slots, NULL for free slots
+
+		Mutex		m_mxRoutes;
+		Condition	m_condRouted;	///< signaled when route() is done with a peer that is being removed
+	};
+
+}
+
+#endif // ROUTINGTABLE_H_INCLUDED
@@ -0,0 +1,111 @@
+/*
+Object Oriented Communication Library
+Copyright (c) 2011 Jürgen Lorenz and Jörn Teuber
+
+This software is provided 'as-is', without any express or implied warranty.
+In no event will the authors be held liable for any damages arising from the use of this software.
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it freely,
+subject to the following restrictions:
+
+1. The origin of this software must not be misrepresented; you must not claim that you wrote the original software. If you use this software in a product, an acknowledgment in the product documentation would be appreciated but is not required.
+2. Altered source versions must be plainly marked as such, and must not be misrepresented as being the original software.
+3. This notice may not be removed or altered from any source distribution.
+*/
+// This file was written by Jörn Teuber
+
+#ifndef SENDQUEUE_H_INCLUDED
+#define SENDQUEUE_H_INCLUDED
+
+#include <deque>
+
+#include "oocl_import_export.h"
+
+#include "SerializedMessage.h"
+#include "Mutex.h"
+#include "Condition.h"
+
+namespace oocl
+{
+	/**
+	 * @brief	Bounded queue of the messages that wait to be sent to one connection.
+	 *
+	 * @note	The threads that deliver messages push them and one writer thread pops and sends them, so a connection
+	 * 			that can not keep up only fills its own queue instead of blocking the pushing thread. What happens to a
+	 * 			message that does not fit anymore is decided by the overflow policy. The queue holds a reference to
+	 * 			every queued message, which is already serialized so that it can be queued for many connections.
+	 *
+	 * @author	Jörn Teuber
+	 * @date	17.10.2026
+	 */
+	class OOCL_EXPORTIMPORT SendQueue
+	{
+	public:
+		/**
+		 * @enum	EOverflowPolicy
+		 *
+		 * @brief	Values that represent what push() does when the queue is full, see setCapacity().
+		 */
+		enum EOverflowPolicy
+		{
+			OP_Block = 0,	///< wait until the writer made room, nothing is lost but the pushing thread stalls, and with it
+							///< everyone who waits for that thread, e.g. to unregister a listener from its MessageBroker
+			OP_DropOldest,	///< drop the message that waited longest, for messages that are replaced by newer ones
+			OP_DropNewest,	///< drop the new message
+			OP_Disconnect	///< drop all messages and close the queue, the connection should be closed as well
+		};
+
+		/**
+		 * @enum	EPushResult
+		 *
+		 * @brief	Values that represent the outcome of push().
+		 */
+		enum EPushResult
+		{
+			PR_Queued = 0,		///< the message was queued
+			PR_DroppedOldest,	///< the message was queued, the oldest one was dropped for it
+			PR_DroppedNewest,	///< the message was dropped
+			PR_Overflow,		///< the message was dropped and the queue closed because of OP_Disconnect
+			PR_Closed			///< the message was dropped because the queue is closed
+		};
+
+	public:
+		SendQueue( unsigned int uiCapacity = 1024, EOverflowPolicy ePolicy = OP_Block );
+		~SendQueue();
+
+		void setCapacity( unsigned int uiCapacity, EOverflowPolicy ePolicy );
+
+		EPushResult push( SerializedMessage const * pMessage );
+		bool pop( SerializedMessage const *& pMessage );
+
+		void close( bool bDiscard );
+		bool waitUntilSent( int iMilliseconds );
+
+		// getter
+		unsigned int	size();
+		unsigned int	getDroppedCount();
+		bool			isClosed();
+
+	private:
+		SendQueue( SendQueue& sq );
+		SendQueue& operator=(const SendQueue&);
+
+		void discard();
+
+	private:
+		std::deque<SerializedMessage const *>	m_dqMessages;
+
+		unsigned int	m_uiCapacity;
+		EOverflowPolicy	m_ePolicy;
+		unsigned int	m_uiDropped;	///< number of messages that were dropped because the queue was full
+		bool			m_bClosed;
+		bool			m_bSending;		///< true while the writer sends the message it popped last
+
+		Mutex		m_mxQueue;
+		Condition	m_condNotEmpty;		///< signaled for the writer when a message was pushed or the queue closed
+		Condition	m_condNotFull;		///< signaled when a message was popped, the writer is done or the queue closed
+	};
+
+}
+
+#endif // SENDQUEUE_H_INCLUDED
@@ -0,0 +1,74 @@
+/*
+Object Oriented Communication Library
+Copyright (c) 2011 Jürgen Lorenz and Jörn Teuber
+
+This software is provided 'as-is', without any express or implied warranty.
+In no event will the authors be held liable for any damages arising from the use of this software.
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it freely,
+subject to the following restrictions:
+
+1. The origin of this software must not be misrepresented; you must not claim that you wrote the original software. If you use this software in a product, an acknowledgment in the product documentation would be appreciated but is not required.
+2. Altered source versions must be plainly marked as such, and must not be misrepresented as being the original software.
+3. This notice may not be removed or altered from any source distribution.
+*/
+// This file was written by Jörn Teuber
+
+#ifndef SERIALIZEDMESSAGE_H_INCLUDED
+#define SERIALIZEDMESSAGE_H_INCLUDED
+
+#include "oocl_import_export.h"
+
+#include "Message.h"
+#include "WriteBuffer.h"
+#include "Atomic.h"
+#include "Mutex.h"
+
+namespace oocl
+{
+	/**
+	 * @brief	A message together with its frame, so that a message to many peers is only serialized once.
+	 *
+	 * @note	Reference counted like a Message, a new one has no references and the last release() deletes it.
+	 * 			The frame is also compressed only once for the codecs of the first peer that asks for it, peers
+	 * 			with other codecs compress their own copy.
+	 *
+	 * @author	Jörn Teuber
+	 * @date	17.10.2026
+	 */
+	class OOCL_EXPORTIMPORT SerializedMessage
+	{
+	public:
+		SerializedMessage( Message const * pMessage );
+
+		void appendFrame( WriteBuffer& wbOut, unsigned int uiCodecs, WriteBuffer& wbScratch ) const;
+
+		void retain() const;
+		void release() const;
+
+		// getter
+		Message const *	getMessage() const		{ return m_ptrMessage.get(); }
+		const char*		getFrame() const		{ return m_wbFrame.data(); }
+		unsigned int	getFrameLength() const	{ return m_wbFrame.size(); }
+
+	private:
+		~SerializedMessage() {}
+
+		SerializedMessage( SerializedMessage& sm );
+		SerializedMessage& operator=(const SerializedMessage&);
+
+	private:
+		MessagePtr	m_ptrMessage;
+		WriteBuffer	m_wbFrame;
+
+		mutable WriteBuffer		m_wbCompressed;			///< the frame compressed for m_uiCompressedCodecs, guarded by m_mxCompressed
+		mutable unsigned int	m_uiCompressedCodecs;
+		mutable bool			m_bCompressed;			///< true once m_wbCompressed was filled
+		mutable Mutex			m_mxCompressed;
+
+		mutable Atomic<unsigned int> m_uiRefCount;
+	};
+
+}
+
+#endif // SERIALIZEDMESSAGE_H_INCLUDED
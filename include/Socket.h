@@ -20,6 +20,7 @@ subject to the following restrictions:
 #include "oocl_import_export.h"
 
 #include "SocketStub.h"
+#include "DatagramSlab.h"
 
 namespace oocl
 {
@@ -33,6 +34,19 @@ namespace oocl
 	{
 		friend class ServerSocket;
 		
+	public:
+		/**
+		 * @enum	EFlushPolicy
+		 *
+		 * @brief	Values that represent when written packages are actually sent, see setBatching().
+		 */
+		enum EFlushPolicy
+		{
+			FP_Immediate = 0,	///< every write is sent right away
+			FP_SizeThreshold,	///< writes are queued until the given number of bytes is pending or flush() is called
+			FP_Deadline			///< writes are queued until the oldest one waited the given number of microseconds
+		};
+
 	public:
 		Socket();
 		virtual ~Socket() {}
@@ -115,6 +129,8 @@ namespace oocl
 		 */
 		virtual bool readFrom( std::string& str, int count = 0, unsigned int* hostIP = NULL ) = 0;
 
+		virtual int readDatagrams( DatagramSlab& slab );
+
 
 		/**
 		 * @brief	Send a package to the connected process.
@@ -156,6 +172,14 @@ namespace oocl
 		virtual bool writeTo( std::string in, std::string host, unsigned short port ) = 0;
 
 
+		virtual bool setBatching( EFlushPolicy ePolicy, unsigned int uiThreshold = 0 );
+		virtual bool flush();
+		virtual bool flushIfDue();
+
+		virtual unsigned int getPathMTU();
+
+		virtual void interrupt();
+
 		/**
 		 * @brief	Closes this socket.
 		 */
@@ -32,6 +32,7 @@ subject to the following restrictions:
 #	include <arpa/inet.h>
 #	include <netinet/tcp.h>
 #	include <netdb.h>
+#	include <fcntl.h>
 #else
 #	include <windows.h>
 #	include <WinSock.h>
@@ -60,6 +61,8 @@ namespace oocl
 		 * @return	The Sockets underlying CSocket.
 		 */
 		virtual int getCSocket() = 0;
+
+		virtual bool setBlocking( bool bBlocking );
 		
 	private:
 		static int iSocketCounter;
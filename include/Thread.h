@@ -32,11 +32,26 @@ subject to the following restrictions:
 #	include <windows.h>
 #endif
 
+// storage class for variables that every thread has its own copy of
+#if defined USE_CPP11
+#	define OOCL_THREAD_LOCAL thread_local
+#elif defined _MSC_VER
+#	define OOCL_THREAD_LOCAL __declspec(thread)
+#else
+#	define OOCL_THREAD_LOCAL __thread
+#endif
+
+#include <vector>
+
 #include "oocl_import_export.h"
 #include "Log.h"
+#include "Atomic.h"
 
 namespace oocl
 {
+	class Mutex;
+	class Condition;
+
 	/**
 	 * @brief	Wrapper class for threads on different platforms.
 	 *
@@ -95,6 +110,9 @@ namespace oocl
 		static DWORD WINAPI entryPoint(LPVOID runnableInstance);
 #endif
 
+	private:
+		void joinLocked();
+
 	private:
 #if defined USE_CPP11
 		std::thread* m_pThread;
@@ -113,7 +131,168 @@ namespace oocl
 		///< Number of threads
 		static int sm_iThreadCount;
 
-		bool m_bActive;
+		Atomic<unsigned int> m_uiActive;	///< 1 while run() executes, written by the starting and the started thread
+		bool m_bJoinable;	///< true if a thread was started and not joined yet, guarded by m_pmxHandle
+		Mutex* m_pmxHandle;	///< guards the handle of the thread, start() and join() may be called by different threads
+	};
+
+
+	/**
+	 * @brief	Interface for work that is executed by a ThreadPool.
+	 *
+	 * @author	Jörn Teuber
+	 * @date	16.10.2026
+	 */
+	class OOCL_EXPORTIMPORT Task
+	{
+	public:
+		virtual ~Task() {}
+
+		/**
+		 * @brief	This is the method called by a thread of the pool.
+		 *
+		 * @note	Overwrite this with your task code.
+		 */
+		virtual void execute() = 0;
+
+		/**
+		 * @brief	Called instead of execute() when the pool is shut down before the task was started.
+		 *
+		 * @note	Overwrite this if the work must not get lost, e.g. to do it in another thread.
+		 */
+		virtual void cancel() {}
+	};
+
+
+	class ThreadPool;
+
+	/**
+	 * @brief	Tells whether a task that was submitted with ThreadPool::submitWithFuture() has finished.
+	 *
+	 * @note	The future is shared by the submitter and the pool, each side releases its reference when it is done
+	 * 			with it, so call release() instead of deleting it. Waiting for a future inside a task of the same pool
+	 * 			blocks one of its threads, with a single thread the task waited for would never start.
+	 *
+	 * @author	Jörn Teuber
+	 * @date	17.10.2026
+	 */
+	class OOCL_EXPORTIMPORT Future
+	{
+		friend class ThreadPool;
+
+	public:
+		bool wait( int iMilliseconds = -1 );
+		void release();
+
+		// getter
+		bool isDone() const			{ return m_uiState.load() != FS_Pending; }
+		bool isCancelled() const	{ return m_uiState.load() == FS_Cancelled; }
+		Task* getTask() const		{ return m_pTask; }
+
+	private:
+		/**
+		 * @brief	Values that represent the state of the task.
+		 */
+		enum EState
+		{
+			FS_Pending = 0,	///< the task is queued or executed
+			FS_Done,		///< execute() returned
+			FS_Cancelled	///< the task was not executed because the pool was shut down
+		};
+
+		Future( ThreadPool* pPool, Task* pTask, unsigned int uiReferences );
+		~Future() {}
+
+		Future( Future& f );
+		Future& operator=(const Future&);
+
+		void complete( EState eState );
+
+	private:
+		ThreadPool*				m_pPool;
+		Task*					m_pTask;
+		Atomic<unsigned int>	m_uiState;
+		Atomic<unsigned int>	m_uiReferences;
+	};
+
+
+	/**
+	 * @brief	A fixed number of threads that execute submitted tasks.
+	 *
+	 * @note	Every thread has its own task queue, tasks submitted by one of the threads go to its own queue,
+	 * 			all other tasks are distributed round-robin over the queues.
+	 * 			A thread takes tasks from the front of its own queue and, once that is empty, steals from the
+	 * 			back of the other queues. Idle threads sleep until a task is submitted.
+	 * 			The pool does not take ownership of the submitted tasks. Brokers and other parts of the library can
+	 * 			share the pool returned by getDefault() with the tasks of the application.
+	 *
+	 * @author	Jörn Teuber
+	 * @date	16.10.2026
+	 */
+	class OOCL_EXPORTIMPORT ThreadPool
+	{
+	public:
+		ThreadPool( unsigned int uiNumThreads = 0 );
+		~ThreadPool();
+
+		bool submit( Task* pTask );
+		Future* submitWithFuture( Task* pTask );
+
+		void shutdown( bool bFinishQueued = true );
+
+		// getter
+		unsigned int getNumThreads() const { return m_vpWorkers.size(); }
+		bool isRunning() const { return m_uiState.load() == PS_Running; }
+
+		static unsigned int getNumCores();
+		static ThreadPool* getDefault();
+
+	private:
+		ThreadPool( ThreadPool& tp );
+		ThreadPool& operator=(const ThreadPool&);
+
+		class Worker;
+		friend class Worker;
+		friend class Future;
+
+		/**
+		 * @brief	Values that represent the state of the pool, see shutdown().
+		 */
+		enum EState
+		{
+			PS_Running = 0,	///< tasks are accepted
+			PS_Draining,	///< no new tasks are accepted, the threads finish the queued ones
+			PS_Stopped		///< no new tasks are accepted, the threads finish the task they execute
+		};
+
+		/**
+		 * @brief	A task in the queue of a worker together with its future, if it has one.
+		 */
+		struct QueuedTask
+		{
+			Task*	pTask;
+			Future*	pFuture;
+		};
+
+		bool enqueue( Task* pTask, Future* pFuture );
+		bool findTask( unsigned int uiWorker, QueuedTask& task );
+		void waitForTask();
+
+	private:
+		std::vector<Worker*>	m_vpWorkers;
+
+		Atomic<unsigned int>	m_uiPendingTasks;	///< number of submitted tasks that were not taken by a thread yet
+		Atomic<unsigned int>	m_uiSleeping;		///< number of threads waiting for m_pcvTaskSubmitted
+		Atomic<unsigned int>	m_uiNextWorker;		///< the queue the next submitted task goes to
+		Atomic<unsigned int>	m_uiState;			///< see EState
+		Atomic<unsigned int>	m_uiSubmitting;		///< number of threads inside submit(), shutdown() waits for them
+		Atomic<unsigned int>	m_uiWaiting;		///< number of threads waiting for m_pcvTaskDone
+
+		Mutex*		m_pmxSleep;
+		Condition*	m_pcvTaskSubmitted;
+		Condition*	m_pcvTaskDone;		///< broadcast with m_pmxSleep when a task with a future finished
+
+		static Atomic<ThreadPool*> sm_pDefault;
 	};
 
 }
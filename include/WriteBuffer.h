@@ -0,0 +1,70 @@
+/*
+Object Oriented Communication Library
+Copyright (c) 2011 Jürgen Lorenz and Jörn Teuber
+
+This software is provided 'as-is', without any express or implied warranty.
+In no event will the authors be held liable for any damages arising from the use of this software.
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it freely,
+subject to the following restrictions:
+
+1. The origin of this software must not be misrepresented; you must not claim that you wrote the original software. If you use this software in a product, an acknowledgment in the product documentation would be appreciated but is not required.
+2. Altered source versions must be plainly marked as such, and must not be misrepresented as being the original software.
+3. This notice may not be removed or altered from any source distribution.
+*/
+// This file was written by Jörn Teuber
+
+#ifndef WRITEBUFFER_H_INCLUDED
+#define WRITEBUFFER_H_INCLUDED
+
+#include <cstring>
+#include <string>
+
+#include "oocl_import_export.h"
+
+namespace oocl
+{
+	/**
+	 * @brief	Growable byte buffer that messages serialize themselves into, see Message::serializeInto().
+	 *
+	 * @note	clear() keeps the allocated memory, so a buffer that is reused for every send stops
+	 * 			allocating as soon as it has grown to the size of the biggest message.
+	 *
+	 * @author	Jörn Teuber
+	 * @date	16.10.2026
+	 */
+	class OOCL_EXPORTIMPORT WriteBuffer
+	{
+	public:
+		WriteBuffer( unsigned int uiCapacity = 256 );
+		~WriteBuffer();
+
+		void	append( const void* pData, unsigned int uiLength );
+		void	append( const std::string& str )	{ append( str.data(), str.length() ); }
+		void	appendShort( unsigned short us )	{ append( &us, sizeof(unsigned short) ); }
+		void	appendInt( unsigned int ui )		{ append( &ui, sizeof(unsigned int) ); }
+
+		char*	grow( unsigned int uiLength );
+		void	reserve( unsigned int uiCapacity );
+		void	truncate( unsigned int uiSize )	{ if( uiSize < m_uiSize ) m_uiSize = uiSize; }
+		void	swap( WriteBuffer& other );
+		void	clear() { m_uiSize = 0; }
+
+		// getter
+		const char*		data() const		{ return m_pcData; }
+		unsigned int	size() const		{ return m_uiSize; }
+		unsigned int	capacity() const	{ return m_uiCapacity; }
+
+	private:
+		WriteBuffer( WriteBuffer& wb );
+		WriteBuffer& operator=(const WriteBuffer&);
+
+	private:
+		char*			m_pcData;
+		unsigned int	m_uiSize;
+		unsigned int	m_uiCapacity;
+	};
+
+}
+
+#endif // WRITEBUFFER_H_INCLUDED
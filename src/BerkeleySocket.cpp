@@ -33,6 +33,10 @@ namespace oocl
 		, m_iSockType( 0 )
 		, m_bValid( true )
 		, m_bConnected( true )
+		, m_eFlushPolicy( FP_Immediate )
+		, m_uiFlushThreshold( 0 )
+		, m_wbOutbound( 0 )
+		, m_ullFirstQueuedTime( 0 )
 	{
 #ifdef WIN32
 		int iLength = sizeof(int);
@@ -52,11 +56,15 @@ namespace oocl
 		, m_iSockType( iSockType )
 		, m_bValid( true )
 		, m_bConnected( false )
+		, m_eFlushPolicy( FP_Immediate )
+		, m_uiFlushThreshold( 0 )
+		, m_wbOutbound( 0 )
+		, m_ullFirstQueuedTime( 0 )
 	{
 
 		if( iSockType != SOCK_STREAM && iSockType != SOCK_DGRAM )
 		{
-			Log::getLog( "oocl" )->logWarning( "Socket got invalid protocoll type; defaults to TCP" );
+			OOCL_LOG_WARNING( "oocl", "Socket got invalid protocoll type; defaults to TCP" );
 			iSockType = SOCK_STREAM;
 		}
 
@@ -68,7 +76,7 @@ namespace oocl
 #endif
 		{
 			m_bValid = false;
-			Log::getLog( "oocl" )->logError( "Creating socket failed" );
+			OOCL_LOG_ERROR( "oocl", "Creating socket failed" );
 		}
 	}
 
@@ -113,7 +121,7 @@ namespace oocl
 					std::ostringstream os;
 					os << "Connecting socket to " << (int)m_addrData.sin_addr.s_net << "." << (int)m_addrData.sin_addr.s_host << "." << (int)m_addrData.sin_addr.s_lh << "." << (int)m_addrData.sin_addr.s_impno << ":" << usPort << " failed";
 #endif
-				Log::getLog( "oocl" )->logError( os.str() );
+				OOCL_LOG_ERROR( "oocl", os.str() );
 
 				close();
 				return false;
@@ -130,7 +138,7 @@ namespace oocl
 #else
 		os << "Connecting to " << (int)m_addrData.sin_addr.s_net << "." << (int)m_addrData.sin_addr.s_host << "." << (int)m_addrData.sin_addr.s_lh << "." << (int)m_addrData.sin_addr.s_impno << ":" << usPort << " failed due to invalid socket";
 #endif
-		Log::getLog( "oocl" )->logError( os.str() );
+		OOCL_LOG_ERROR( "oocl", os.str() );
 
 		return false;
 	}
@@ -157,9 +165,7 @@ namespace oocl
 			if( result == SOCKET_ERROR )
 #endif
 			{
-				std::ostringstream os;
-				os << "Binding socket to port " << usPort << " failed";
-				Log::getLog( "oocl" )->logError( os.str() );
+				OOCL_LOG_ERROR( "oocl", "Binding socket to port " << usPort << " failed" );
 
 				close();
 				return false;
@@ -211,7 +217,7 @@ namespace oocl
 
 			if( iStatus > 0 )
 			{
-				Log::getLogRef( "oocl" ) << Log::EL_ERROR << "Socket discovered an error. ErrNo: " << iStatus << endl;
+				OOCL_LOG_ERROR( "oocl", "Socket discovered an error. ErrNo: " << iStatus );
 				close();
 			}
 		}
@@ -232,14 +238,17 @@ namespace oocl
 		if( count == 0 )
 			count = MAX_BUFFER_SIZE;
 
-		int readCount = count;
-		char* in = new char[count];
+		// only allocate if the stack buffer is too small
+		char acBuffer[MAX_BUFFER_SIZE];
+		char* in = count > MAX_BUFFER_SIZE ? new char[count] : acBuffer;
 
+		int readCount = count;
 		bool bRet = read( in, readCount );
 		if( bRet )
-			str = std::string( in, readCount );
+			str.assign( in, readCount );
 
-		delete[] in;
+		if( in != acBuffer )
+			delete[] in;
 		return bRet;
 	}
 
@@ -275,9 +284,15 @@ namespace oocl
 			{
 				return true;
 			}
-			else if( rc < 0 )
+			else if( rc == 0 )
 			{
-				Log::getLog( "oocl" )->logError( "receiving on connected socket failed" );
+				// the remote side shut the connection down in an orderly fashion
+				if( m_iSockType == SOCK_STREAM )
+					close();
+			}
+			else if( !wouldBlock() ) // a non-blocking socket without pending data is not an error
+			{
+				OOCL_LOG_ERROR( "oocl", "receiving on connected socket failed" );
 				close();
 			}
 		}
@@ -297,10 +312,12 @@ namespace oocl
 	{
 		if( m_bValid && !m_bConnected )
 		{
+			// without a limit take the whole datagram, the rest of a longer one would be lost
 			if( count == 0 )
-				count = MAX_BUFFER_SIZE;
+				count = m_iSockType == SOCK_DGRAM ? MAX_DATAGRAM_SIZE : MAX_BUFFER_SIZE;
 
-			char * buffer = new char[count];
+			char acBuffer[MAX_BUFFER_SIZE];
+			char* buffer = count > MAX_BUFFER_SIZE ? new char[count] : acBuffer;
 #ifdef WIN32
 			int fromlen = sizeof( sockaddr_in );
 #else
@@ -314,12 +331,19 @@ namespace oocl
 			{
 				if( hostIP != NULL )
 					*hostIP = addr.sin_addr.s_addr;
-				str = std::string( buffer, rc );
-				return true;
+				str.assign( buffer, rc );
 			}
-			else if( rc < 0 )
+
+			bool bWouldBlock = rc < 0 && wouldBlock();
+
+			if( buffer != acBuffer )
+				delete[] buffer;
+
+			if( rc > 0 )
+				return true;
+			else if( rc < 0 && !bWouldBlock )
 			{
-				Log::getLog( "oocl" )->logError( "receiving on connectionless socket failed" );
+				OOCL_LOG_ERROR( "oocl", "receiving on connectionless socket failed" );
 				close();
 				return false;
 			}
@@ -328,6 +352,49 @@ namespace oocl
 		return false;
 	}
 
+	/**
+	 * @brief	Receives as many pending datagrams as fit into the slab with one system call.
+	 *
+	 * @note	Uses recvmmsg() on linux, the socket should be non-blocking (e.g. registered with a Reactor).
+	 *
+	 * @param [in,out]	slab	The slab to receive into, the datagrams in it are replaced.
+	 *
+	 * @return	The number of received datagrams, 0 if nothing was pending or the socket failed.
+	 */
+	int BerkeleySocket::readDatagrams( DatagramSlab& slab )
+	{
+#ifdef linux
+		slab.m_uiCount = 0;
+
+		if( !m_bConnected )
+			return 0;
+
+		int rc = ::recvmmsg( m_iSockFD, slab.m_pHeaders, slab.m_uiMaxDatagrams, 0, NULL );
+		if( rc < 0 )
+		{
+			if( !wouldBlock() )
+			{
+				OOCL_LOG_ERROR( "oocl", "receiving datagrams failed" );
+				close();
+			}
+
+			return 0;
+		}
+
+		for( int i = 0; i < rc; i++ )
+		{
+			slab.m_puiLengths[i] = slab.m_pHeaders[i].msg_len;
+			slab.m_pbTruncated[i] = (slab.m_pHeaders[i].msg_hdr.msg_flags & MSG_TRUNC) != 0;
+		}
+
+		slab.m_uiCount = rc;
+
+		return rc;
+#else
+		return Socket::readDatagrams( slab );
+#endif
+	}
+
 	/**
 	 * @brief	Send a package to the connected process.
 	 *
@@ -355,6 +422,8 @@ namespace oocl
 	/**
 	 * @brief	Sends a byte array to the connected process.
 	 *
+	 * @note	If batching is enabled the bytes are queued and sent according to the flush policy.
+	 *
 	 * @param	in   	The byte array.
 	 * @param	count	Number of bytes to send.
 	 *
@@ -364,30 +433,51 @@ namespace oocl
 	{
 		if( m_bConnected && count > 0 )
 		{
-			unsigned int iBytesSent = 0;
-			while( iBytesSent < count )
+			if( m_eFlushPolicy == FP_Immediate )
+				return sendAll( in, count );
+
+			return queue( in, count );
+		}
+
+		OOCL_LOG_WARNING( "oocl", "Sending failed due to unconnected socket" );
+
+		return false;
+	}
+
+	/**
+	 * @brief	Sends a byte array right away, waits if the send buffer of the socket is full.
+	 *
+	 * @param	in   	The byte array.
+	 * @param	count	Number of bytes to send.
+	 *
+	 * @return	true if it succeeds, false if it fails.
+	 */
+	bool BerkeleySocket::sendAll( const char * in, int count )
+	{
+		int iBytesSent = 0;
+		while( iBytesSent < count )
+		{
+			int rc = ::send( m_iSockFD, in + iBytesSent, count - iBytesSent, 0 );
+			if( rc < 0 && wouldBlock() )
 			{
-				int rc = ::send( m_iSockFD, in + iBytesSent, count - iBytesSent, 0 );
-				if( rc < 0 )
-				{
-					std::ostringstream os;
-					os << "Sending failed: " << count << ":" << rc << ":" << in;
-					Log::getLog( "oocl" )->logError( os.str() );
-					close();
-					// TODO: implement fail-count, close connection after n failed sends
+				// the socket is non-blocking and its send buffer is full, so wait until there is room again
+				if( waitForWritable() )
+					continue;
+			}
 
-					return false;
-				}
+			if( rc < 0 )
+			{
+				OOCL_LOG_ERROR( "oocl", "Sending failed: " << count << ":" << rc << ":" << in );
+				close();
+				// TODO: implement fail-count, close connection after n failed sends
 
-				iBytesSent += rc;
+				return false;
 			}
 
-			return true;
+			iBytesSent += rc;
 		}
 
-		Log::getLog( "oocl" )->logWarning( "Sending failed due to unconnected socket" );
-
-		return false;
+		return true;
 	}
 
 	/**
@@ -412,10 +502,227 @@ namespace oocl
 	}
 
 	/**
-	 * @brief	Closes this socket.
+	 * @brief	Sets when written packages are sent, so that many small writes can be sent with one system call.
+	 *
+	 * @note	Queued tcp packages are sent with one writev() call, queued udp packages with one sendmmsg() call.
+	 * 			Packages that are still queued are sent when the policy changes and when the socket is closed.
+	 *
+	 * @param	ePolicy		The flush policy.
+	 * @param	uiThreshold	The number of bytes for FP_SizeThreshold or the number of microseconds for FP_Deadline.
+	 *
+	 * @return	true if it succeeds, false if it fails.
+	 */
+	bool BerkeleySocket::setBatching( EFlushPolicy ePolicy, unsigned int uiThreshold )
+	{
+		bool bReturn = flush();
+
+		m_eFlushPolicy = ePolicy;
+		m_uiFlushThreshold = uiThreshold;
+
+		if( ePolicy != FP_Immediate )
+			m_wbOutbound.reserve( ePolicy == FP_SizeThreshold ? uiThreshold : MAX_BUFFER_SIZE );
+
+		return bReturn;
+	}
+
+	/**
+	 * @brief	Sends all queued packages.
+	 *
+	 * @return	true if it succeeds, false if it fails.
+	 */
+	bool BerkeleySocket::flush()
+	{
+		if( m_wbOutbound.size() == 0 )
+			return true;
+
+		if( m_iSockType == SOCK_DGRAM )
+			return flushDatagrams();
+		else
+			return flushStream( NULL, 0 );
+	}
+
+	/**
+	 * @brief	Sends all queued packages if the deadline of the FP_Deadline policy has passed.
+	 *
+	 * @return	true if it succeeds or nothing had to be sent, false if it fails.
+	 */
+	bool BerkeleySocket::flushIfDue()
+	{
+		if( m_eFlushPolicy == FP_Deadline && m_wbOutbound.size() > 0 && getMicroseconds() - m_ullFirstQueuedTime >= m_uiFlushThreshold )
+			return flush();
+
+		return true;
+	}
+
+	/**
+	 * @brief	Queues a package and sends the queue if the flush policy says so.
+	 *
+	 * @param	in   	The byte array.
+	 * @param	count	Number of bytes to send.
+	 *
+	 * @return	true if it succeeds, false if it fails.
+	 */
+	bool BerkeleySocket::queue( const char * in, int count )
+	{
+		// a tcp write that reaches the threshold is sent together with the queue, without copying it into the queue first
+		if( m_iSockType == SOCK_STREAM && m_eFlushPolicy == FP_SizeThreshold && m_wbOutbound.size() + count >= m_uiFlushThreshold )
+			return flushStream( in, count );
+
+		if( m_wbOutbound.size() == 0 )
+			m_ullFirstQueuedTime = getMicroseconds();
+
+		m_wbOutbound.append( in, count );
+		if( m_iSockType == SOCK_DGRAM )
+			m_vuiDatagramEnds.push_back( m_wbOutbound.size() );
+
+		if( m_eFlushPolicy == FP_SizeThreshold && m_wbOutbound.size() >= m_uiFlushThreshold )
+			return flush();
+
+		return flushIfDue();
+	}
+
+	/**
+	 * @brief	Sends the queued bytes of a tcp socket followed by the given bytes with as few system calls as possible.
+	 *
+	 * @param	pcExtra    	Bytes to send after the queue, may be NULL.
+	 * @param	iExtraCount	The number of bytes in pcExtra.
+	 *
+	 * @return	true if it succeeds, false if it fails.
+	 */
+	bool BerkeleySocket::flushStream( const char* pcExtra, int iExtraCount )
+	{
+		const char* pcQueued = m_wbOutbound.data();
+		unsigned int uiQueued = m_wbOutbound.size();
+
+		// the queue is emptied first, so that a failing send that closes the socket does not send it again
+		m_wbOutbound.clear();
+
+#ifdef linux
+		struct iovec aIov[2];
+		aIov[0].iov_base = (void*)pcQueued;
+		aIov[0].iov_len = uiQueued;
+		aIov[1].iov_base = (void*)pcExtra;
+		aIov[1].iov_len = iExtraCount;
+
+		struct iovec* pIov = aIov;
+		int iCount = pcExtra != NULL ? 2 : 1;
+
+		while( iCount > 0 )
+		{
+			ssize_t rc = ::writev( m_iSockFD, pIov, iCount );
+			if( rc < 0 && wouldBlock() )
+			{
+				if( waitForWritable() )
+					continue;
+			}
+
+			if( rc < 0 )
+			{
+				OOCL_LOG_ERROR( "oocl", "Sending " << uiQueued + iExtraCount << " batched bytes failed: " << strerror( errno ) );
+				close();
+				return false;
+			}
+
+			// skip everything that was sent and continue with the rest
+			while( iCount > 0 && (size_t)rc >= pIov->iov_len )
+			{
+				rc -= pIov->iov_len;
+				++pIov;
+				--iCount;
+			}
+
+			if( iCount > 0 )
+			{
+				pIov->iov_base = (char*)pIov->iov_base + rc;
+				pIov->iov_len -= rc;
+			}
+		}
+
+		return true;
+#else
+		if( uiQueued > 0 && !sendAll( pcQueued, uiQueued ) )
+			return false;
+
+		return pcExtra == NULL || sendAll( pcExtra, iExtraCount );
+#endif
+	}
+
+	/**
+	 * @brief	Sends the queued packages of a udp socket, each as its own datagram.
+	 *
+	 * @return	true if it succeeds, false if it fails.
+	 */
+	bool BerkeleySocket::flushDatagrams()
+	{
+		const char* pcQueued = m_wbOutbound.data();
+		unsigned int uiDatagrams = m_vuiDatagramEnds.size();
+
+		m_wbOutbound.clear();
+
+#ifdef linux
+		m_vDatagramHeaders.resize( uiDatagrams );
+		m_vDatagramVectors.resize( uiDatagrams );
+
+		unsigned int uiStart = 0;
+		for( unsigned int i = 0; i < uiDatagrams; i++ )
+		{
+			m_vDatagramVectors[i].iov_base = (void*)(pcQueued + uiStart);
+			m_vDatagramVectors[i].iov_len = m_vuiDatagramEnds[i] - uiStart;
+			uiStart = m_vuiDatagramEnds[i];
+
+			std::memset( &m_vDatagramHeaders[i], 0, sizeof(struct mmsghdr) );
+			m_vDatagramHeaders[i].msg_hdr.msg_iov = &m_vDatagramVectors[i];
+			m_vDatagramHeaders[i].msg_hdr.msg_iovlen = 1;
+		}
+
+		m_vuiDatagramEnds.clear();
+
+		unsigned int uiSent = 0;
+		while( uiSent < uiDatagrams )
+		{
+			int rc = ::sendmmsg( m_iSockFD, &m_vDatagramHeaders[uiSent], uiDatagrams - uiSent, 0 );
+			if( rc < 0 && wouldBlock() )
+			{
+				if( waitForWritable() )
+					continue;
+			}
+
+			if( rc < 0 )
+			{
+				OOCL_LOG_ERROR( "oocl", "Sending " << uiDatagrams - uiSent << " batched datagrams failed: " << strerror( errno ) );
+				close();
+				return false;
+			}
+
+			uiSent += rc;
+		}
+
+		return true;
+#else
+		std::vector<unsigned int> vuiDatagramEnds;
+		vuiDatagramEnds.swap( m_vuiDatagramEnds );
+
+		unsigned int uiStart = 0;
+		for( unsigned int i = 0; i < uiDatagrams; i++ )
+		{
+			if( !sendAll( pcQueued + uiStart, vuiDatagramEnds[i] - uiStart ) )
+				return false;
+
+			uiStart = vuiDatagramEnds[i];
+		}
+
+		return true;
+#endif
+	}
+
+	/**
+	 * @brief	Closes this socket, packages that are still queued are sent first.
 	 */
 	void BerkeleySocket::close()
 	{
+		if( m_bConnected )
+			flush();
+
 		m_bConnected = false;
 #ifdef linux
 		shutdown( m_iSockFD, 2 );
@@ -446,6 +753,85 @@ namespace oocl
 		return m_addrData.sin_addr.s_addr;
 	}
 
+	/**
+	 * @brief	Get the largest ip packet that reaches the connected host without being fragmented.
+	 *
+	 * @note	On linux this is the path MTU the kernel knows for the route of the connected socket, which starts with the
+	 * 			MTU of the outgoing interface and shrinks when a router reports a smaller one.
+	 *
+	 * @return	The path MTU in bytes or 0 if it is unknown.
+	 */
+	unsigned int BerkeleySocket::getPathMTU()
+	{
+#if defined linux && defined IP_MTU
+		if( m_bConnected )
+		{
+			int iMTU = 0;
+			socklen_t len = sizeof(int);
+			if( getsockopt( m_iSockFD, IPPROTO_IP, IP_MTU, &iMTU, &len ) == 0 && iMTU > 0 )
+				return (unsigned int)iMTU;
+		}
+#endif
+
+		return 0;
+	}
+
+
+	/**
+	 * @brief	Check whether the last failed call on a socket only failed because the non-blocking socket was not ready.
+	 *
+	 * @return	true if the call would have blocked, false if it failed for real.
+	 */
+	bool BerkeleySocket::wouldBlock()
+	{
+#ifdef linux
+		return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+#else
+		return WSAGetLastError() == WSAEWOULDBLOCK;
+#endif
+	}
+
+	/**
+	 * @brief	Blocks until the socket is able to send again, used by write() on non-blocking sockets.
+	 *
+	 * @return	true if the socket is writable, false if waiting failed.
+	 */
+	bool BerkeleySocket::waitForWritable()
+	{
+#ifdef linux
+		struct pollfd pfd;
+		pfd.fd = m_iSockFD;
+		pfd.events = POLLOUT;
+		pfd.revents = 0;
+
+		int iRet = poll( &pfd, 1, -1 );
+		return iRet > 0 && !(pfd.revents & (POLLERR | POLLHUP | POLLNVAL));
+#else
+		fd_set writeSet;
+		FD_ZERO( &writeSet );
+		FD_SET( m_iSockFD, &writeSet );
+
+		return select( m_iSockFD+1, NULL, &writeSet, NULL, NULL ) > 0;
+#endif
+	}
+
+	/**
+	 * @brief	Get a monotonic timestamp, used for the deadline of the FP_Deadline flush policy.
+	 *
+	 * @return	The current time in microseconds.
+	 */
+	unsigned long long BerkeleySocket::getMicroseconds()
+	{
+#ifdef linux
+		struct timespec ts;
+		clock_gettime( CLOCK_MONOTONIC, &ts );
+
+		return (unsigned long long)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+#else
+		return (unsigned long long)GetTickCount() * 1000;
+#endif
+	}
+
 
 	/**
 	 * @brief	Gets the IP from a string, this can be an IP as string or a domain name.
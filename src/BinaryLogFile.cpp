@@ -0,0 +1,653 @@
+/*
+Object Oriented Communication Library
+Copyright (c) 2011 Jürgen Lorenz and Jörn Teuber
+
+This software is provided 'as-is', without any express or implied warranty.
+In no event will the authors be held liable for any damages arising from the use of this software.
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it freely,
+subject to the following restrictions:
+
+1. The origin of this software must not be misrepresented; you must not claim that you wrote the original software. If you use this software in a product, an acknowledgment in the product documentation would be appreciated but is not required.
+2. Altered source versions must be plainly marked as such, and must not be misrepresented as being the original software.
+3. This notice may not be removed or altered from any source distribution.
+*/
+// This file was written by Jörn Teuber
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <fstream>
+#include <iterator>
+
+#ifdef linux
+#	include <fcntl.h>
+#	include <unistd.h>
+#	include <sys/mman.h>
+#	include <sys/time.h>
+#endif
+
+// the time stamp counter of x86 processors is read much faster than the clocks of the system
+#if defined linux && defined __GNUC__ && ( defined __x86_64__ || defined __i386__ )
+#	include <x86intrin.h>
+#	define BLF_USE_TSC
+#endif
+
+#include "BinaryLogFile.h"
+#include "Thread.h"
+
+namespace oocl
+{
+	/**
+	 * @brief	The formats registered so far and the files they have to be written to.
+	 */
+	struct FormatRegistry
+	{
+		FormatRegistry() : uiLastID( 0 ) {}
+
+		Mutex						mxRegistry;
+		unsigned int				uiLastID;
+		std::string					strFormatRecords;	///< the format records of all registered formats
+		std::vector<BinaryLogFile*>	vFiles;
+	};
+
+
+	/**
+	 * @brief	Get the format registry, it is created on first use as formats are registered during static
+	 * 			initialization.
+	 */
+	static FormatRegistry& getFormatRegistry()
+	{
+		static FormatRegistry s_registry;
+		return s_registry;
+	}
+
+
+	/**
+	 * @brief	Constructor, opens the first file.
+	 *
+	 * @param	strName   	Name of the files without the index and extension.
+	 * @param	uiFileSize	Size of one file in bytes.
+	 * @param	uiMaxFiles	Number of files that are written in turn.
+	 */
+	BinaryLogFile::BinaryLogFile( const std::string& strName, unsigned int uiFileSize, unsigned int uiMaxFiles )
+		: m_strName( strName )
+		, m_uiFileSize( uiFileSize )
+		, m_uiMaxFiles( uiMaxFiles > 0 ? uiMaxFiles : 1 )
+		, m_uiSequence( 0 )
+		, m_pSegment( NULL )
+	{
+		for( unsigned int i = 0; i < 2; i++ )
+			m_aSegments[i].pcData = NULL;
+
+		// register first, so that no format is missing in the first file
+		FormatRegistry& registry = getFormatRegistry();
+		registry.mxRegistry.lock();
+		registry.vFiles.push_back( this );
+		registry.mxRegistry.unlock();
+
+		rotate( NULL );
+	}
+
+
+	/**
+	 * @brief	Destructor, closes the current file.
+	 */
+	BinaryLogFile::~BinaryLogFile()
+	{
+		FormatRegistry& registry = getFormatRegistry();
+		registry.mxRegistry.lock();
+		for( std::vector<BinaryLogFile*>::iterator it = registry.vFiles.begin(); it != registry.vFiles.end(); ++it )
+		{
+			if( *it == this )
+			{
+				registry.vFiles.erase( it );
+				break;
+			}
+		}
+		registry.mxRegistry.unlock();
+
+		std::string strError;
+		m_mxRotate.lock();
+
+		Segment* pSegment = m_pSegment.exchange( NULL );
+		if( pSegment )
+		{
+			while( pSegment->uiWriters.load() > 0 )
+				Thread::sleep( 0 );
+
+			closeSegment( pSegment, strError );
+		}
+
+		m_mxRotate.unlock();
+
+		if( !strError.empty() )
+			OOCL_LOG_WARNING( "oocl", strError );
+	}
+
+
+	/**
+	 * @brief	Writes a record, can be called from any thread.
+	 *
+	 * @param	pcRecord	The record, starting with a RecordHeader.
+	 * @param	uiLength	Length of the record, a multiple of 8.
+	 *
+	 * @return	true if it succeeds, false if no file could be opened.
+	 */
+	bool BinaryLogFile::write( const char* pcRecord, unsigned int uiLength )
+	{
+		return append( pcRecord, uiLength, true );
+	}
+
+
+	/**
+	 * @brief	Writes the records of the current file to the disk.
+	 *
+	 * @note	This is not needed to keep records when the program crashes, only when the whole system goes down.
+	 */
+	void BinaryLogFile::flush()
+	{
+		m_mxRotate.lock();
+
+		Segment* pSegment = m_pSegment.load();
+		if( pSegment )
+		{
+#ifdef linux
+			msync( pSegment->pcData, m_uiFileSize, MS_SYNC );
+#else
+			FlushViewOfFile( pSegment->pcData, 0 );
+#endif
+		}
+
+		m_mxRotate.unlock();
+	}
+
+
+	/**
+	 * @brief	Assigns an ID to a format and writes its format record to all open files, called by the constructor
+	 * 			of LogFormat.
+	 *
+	 * @param	format	The format.
+	 *
+	 * @return	The ID of the format.
+	 */
+	unsigned int BinaryLogFile::registerFormat( const LogFormat& format )
+	{
+		FormatRegistry& registry = getFormatRegistry();
+		registry.mxRegistry.lock();
+
+		unsigned int uiID = ++registry.uiLastID;
+
+		// ID, error level and line, then file and format including their terminating zeros
+		unsigned int auiValues[3] = { uiID, (unsigned int)format.getErrorLevel(), format.getLine() };
+		unsigned int uiFileLength = strlen( format.getFile() ) + 1;
+		unsigned int uiFormatLength = strlen( format.getFormat() ) + 1;
+
+		unsigned int uiLength = sizeof(RecordHeader) + sizeof(auiValues) + uiFileLength + uiFormatLength;
+		uiLength = (uiLength + 7) & ~7u;
+
+		std::string strRecord( uiLength, '\0' );
+		RecordHeader header = { BLF_FORMAT_RECORD, uiLength, 0 };
+		unsigned int uiPos = 0;
+
+		memcpy( &strRecord[uiPos], &header, sizeof(header) );
+		uiPos += sizeof(header);
+		memcpy( &strRecord[uiPos], auiValues, sizeof(auiValues) );
+		uiPos += sizeof(auiValues);
+		memcpy( &strRecord[uiPos], format.getFile(), uiFileLength );
+		uiPos += uiFileLength;
+		memcpy( &strRecord[uiPos], format.getFormat(), uiFormatLength );
+
+		registry.strFormatRecords += strRecord;
+
+		// a file that is full gets the record together with all others when the next file is opened
+		for( std::vector<BinaryLogFile*>::iterator it = registry.vFiles.begin(); it != registry.vFiles.end(); ++it )
+			(*it)->append( strRecord.data(), uiLength, false );
+
+		registry.mxRegistry.unlock();
+
+		return uiID;
+	}
+
+
+	/**
+	 * @brief	Get the current value of the time stamp counter or a monotonic clock, the time stamp of every record.
+	 *
+	 * @return	The ticks, see FileHeader::llTicksPerSecond.
+	 */
+	long long BinaryLogFile::getTicks()
+	{
+#if defined BLF_USE_TSC
+		return (long long)__rdtsc();
+#elif defined linux
+		timespec ts;
+		clock_gettime( CLOCK_MONOTONIC, &ts );
+		return (long long)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+#else
+		LARGE_INTEGER liTicks;
+		QueryPerformanceCounter( &liTicks );
+		return liTicks.QuadPart;
+#endif
+	}
+
+
+	/**
+	 * @brief	Get the resolution of getTicks().
+	 *
+	 * @note	The time stamp counter is measured once against the monotonic clock, which takes 20 milliseconds.
+	 *
+	 * @return	The ticks per second.
+	 */
+	long long BinaryLogFile::getTicksPerSecond()
+	{
+#if defined BLF_USE_TSC
+		// measure the time stamp counter once against the monotonic clock
+		struct Calibration
+		{
+			static long long measure()
+			{
+				timespec tsStart, tsEnd;
+				clock_gettime( CLOCK_MONOTONIC, &tsStart );
+				long long llStartTicks = BinaryLogFile::getTicks();
+
+				Thread::sleep( 20 );
+
+				clock_gettime( CLOCK_MONOTONIC, &tsEnd );
+				long long llTicks = BinaryLogFile::getTicks() - llStartTicks;
+
+				long long llNanoseconds = (long long)(tsEnd.tv_sec - tsStart.tv_sec) * 1000000000LL + tsEnd.tv_nsec - tsStart.tv_nsec;
+				return llTicks * 1000000000LL / llNanoseconds;
+			}
+		};
+
+		static const long long s_llTicksPerSecond = Calibration::measure();
+		return s_llTicksPerSecond;
+#elif defined linux
+		return 1000000000LL;
+#else
+		LARGE_INTEGER liFrequency;
+		QueryPerformanceFrequency( &liFrequency );
+		return liFrequency.QuadPart;
+#endif
+	}
+
+
+	/**
+	 * @brief	Copies a record into the current file.
+	 *
+	 * @param	pcRecord	The record.
+	 * @param	uiLength	Length of the record.
+	 * @param	bRotate 	true to open the next file if the record does not fit, false to drop the record then.
+	 *
+	 * @return	true if the record was written.
+	 */
+	bool BinaryLogFile::append( const char* pcRecord, unsigned int uiLength, bool bRotate )
+	{
+		for(;;)
+		{
+			Segment* pSegment = m_pSegment.load();
+			if( !pSegment )
+				return false;
+
+			// announce the write before checking that the file is still the current one, so that rotate() waits for it
+			pSegment->uiWriters.fetchAdd( 1 );
+			if( pSegment != m_pSegment.load() )
+			{
+				pSegment->uiWriters.fetchAdd( (unsigned int)-1 );
+				continue;
+			}
+
+			unsigned int uiStart = pSegment->uiUsed.fetchAdd( uiLength );
+			bool bFits = uiStart + uiLength <= m_uiFileSize;
+
+			if( bFits )
+				memcpy( pSegment->pcData + uiStart, pcRecord, uiLength );
+
+			pSegment->uiWriters.fetchAdd( (unsigned int)-1 );
+
+			if( bFits )
+				return true;
+			if( !bRotate )
+				return false;
+
+			rotate( pSegment );
+		}
+	}
+
+
+	/**
+	 * @brief	Opens the next file, unless another thread did so already.
+	 *
+	 * @param	pFull	The file that is full, NULL to open the first one.
+	 */
+	void BinaryLogFile::rotate( Segment* pFull )
+	{
+		// errors are logged after the locks are released, the log might write to this file
+		std::string strError;
+
+		m_mxRotate.lock();
+
+		if( m_pSegment.load() == pFull )
+		{
+			Segment* pNext = pFull == &m_aSegments[0] ? &m_aSegments[1] : &m_aSegments[0];
+			bool bOpened = openSegment( pNext, strError );
+
+			// the format records are copied and the file is published under the lock, so that a format that gets
+			// registered meanwhile is appended afterwards
+			FormatRegistry& registry = getFormatRegistry();
+			registry.mxRegistry.lock();
+
+			if( bOpened )
+			{
+				unsigned int uiLength = registry.strFormatRecords.size();
+				unsigned int uiUsed = pNext->uiUsed.load();
+
+				if( uiUsed + uiLength <= m_uiFileSize )
+				{
+					memcpy( pNext->pcData + uiUsed, registry.strFormatRecords.data(), uiLength );
+					pNext->uiUsed.store( uiUsed + uiLength );
+				}
+				else
+				{
+					strError = "the formats do not fit into a binary log file of " + m_strName;
+				}
+			}
+
+			m_pSegment.store( bOpened ? pNext : NULL );
+
+			registry.mxRegistry.unlock();
+
+			if( pFull )
+			{
+				while( pFull->uiWriters.load() > 0 )
+					Thread::sleep( 0 );
+
+				closeSegment( pFull, strError );
+			}
+		}
+
+		m_mxRotate.unlock();
+
+		if( !strError.empty() )
+			OOCL_LOG_ERROR( "oocl", strError );
+	}
+
+
+	/**
+	 * @brief	Creates and maps the file of the next sequence and writes its header.
+	 *
+	 * @param [in,out]	pSegment	The segment to open the file in.
+	 * @param [out]	strError		The reason if it fails.
+	 *
+	 * @return	true if it succeeds, false if it fails.
+	 */
+	bool BinaryLogFile::openSegment( Segment* pSegment, std::string& strError )
+	{
+		char acIndex[32];
+		sprintf( acIndex, ".%u.blog", m_uiSequence % m_uiMaxFiles );
+		std::string strFileName = m_strName + acIndex;
+
+		FileHeader header;
+		memcpy( header.acMagic, BLF_MAGIC, sizeof(header.acMagic) );
+		header.uiVersion = BLF_VERSION;
+		header.uiSequence = m_uiSequence++;
+		header.llTicksPerSecond = getTicksPerSecond();
+
+#ifdef linux
+		pSegment->iFile = ::open( strFileName.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644 );
+		if( pSegment->iFile < 0 )
+		{
+			strError = "could not create the binary log file " + strFileName;
+			return false;
+		}
+
+		void* pData = MAP_FAILED;
+		if( ftruncate( pSegment->iFile, m_uiFileSize ) == 0 )
+			pData = mmap( NULL, m_uiFileSize, PROT_READ | PROT_WRITE, MAP_SHARED, pSegment->iFile, 0 );
+
+		if( pData == MAP_FAILED )
+		{
+			strError = "could not map the binary log file " + strFileName;
+			::close( pSegment->iFile );
+			return false;
+		}
+
+		pSegment->pcData = (char*)pData;
+
+		timeval tv;
+		gettimeofday( &tv, NULL );
+		header.llStartSeconds = tv.tv_sec;
+		header.llStartMicroseconds = tv.tv_usec;
+#else
+		pSegment->hFile = CreateFileA( strFileName.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL );
+		if( pSegment->hFile == INVALID_HANDLE_VALUE )
+		{
+			strError = "could not create the binary log file " + strFileName;
+			return false;
+		}
+
+		pSegment->hMapping = CreateFileMappingA( pSegment->hFile, NULL, PAGE_READWRITE, 0, m_uiFileSize, NULL );
+		pSegment->pcData = pSegment->hMapping ? (char*)MapViewOfFile( pSegment->hMapping, FILE_MAP_WRITE, 0, 0, m_uiFileSize ) : NULL;
+
+		if( !pSegment->pcData )
+		{
+			strError = "could not map the binary log file " + strFileName;
+			if( pSegment->hMapping )
+				CloseHandle( pSegment->hMapping );
+			CloseHandle( pSegment->hFile );
+			return false;
+		}
+
+		// 100 nanosecond intervals since 1.1.1601
+		FILETIME ft;
+		GetSystemTimeAsFileTime( &ft );
+		long long llTime = (((long long)ft.dwHighDateTime << 32) | ft.dwLowDateTime) - 116444736000000000LL;
+
+		header.llStartSeconds = llTime / 10000000;
+		header.llStartMicroseconds = (llTime % 10000000) / 10;
+#endif
+
+		header.llStartTicks = getTicks();
+
+		memcpy( pSegment->pcData, &header, sizeof(header) );
+		pSegment->uiUsed.store( sizeof(header) );
+
+		return true;
+	}
+
+
+	/**
+	 * @brief	Unmaps a file and cuts off the unused rest.
+	 *
+	 * @param [in,out]	pSegment	The segment to close, no thread may write to it anymore.
+	 * @param [out]	strError		The reason if the unused rest could not be cut off.
+	 */
+	void BinaryLogFile::closeSegment( Segment* pSegment, std::string& strError )
+	{
+		unsigned int uiUsed = pSegment->uiUsed.load();
+		if( uiUsed > m_uiFileSize )
+			uiUsed = m_uiFileSize;
+
+#ifdef linux
+		munmap( pSegment->pcData, m_uiFileSize );
+		// if this fails, the rest of the file stays zero, which readers take as its end
+		if( ftruncate( pSegment->iFile, uiUsed ) != 0 )
+			strError = "could not truncate a binary log file of " + m_strName;
+		::close( pSegment->iFile );
+#else
+		UnmapViewOfFile( pSegment->pcData );
+		CloseHandle( pSegment->hMapping );
+		SetFilePointer( pSegment->hFile, uiUsed, NULL, FILE_BEGIN );
+		SetEndOfFile( pSegment->hFile );
+		CloseHandle( pSegment->hFile );
+#endif
+
+		pSegment->pcData = NULL;
+	}
+
+
+	// ******************** BinaryLogReader *********************
+
+	/**
+	 * @brief	Default constructor.
+	 */
+	BinaryLogReader::BinaryLogReader()
+		: m_uiPos( 0 )
+	{
+		memset( &m_header, 0, sizeof(m_header) );
+	}
+
+
+	/**
+	 * @brief	Destructor.
+	 */
+	BinaryLogReader::~BinaryLogReader()
+	{
+		for( std::map<unsigned int, LogFormat*>::iterator it = m_mapFormats.begin(); it != m_mapFormats.end(); ++it )
+			delete it->second;
+	}
+
+
+	/**
+	 * @brief	Reads a whole file and the formats in it.
+	 *
+	 * @param	strFileName	Name of the file.
+	 *
+	 * @return	true if it succeeds, false if the file could not be read or was not written by a BinaryLogFile.
+	 */
+	bool BinaryLogReader::open( const std::string& strFileName )
+	{
+		std::ifstream fsFile( strFileName.c_str(), std::ios::in | std::ios::binary );
+		if( !fsFile )
+			return false;
+
+		m_vData.assign( std::istreambuf_iterator<char>( fsFile ), std::istreambuf_iterator<char>() );
+
+		if( m_vData.size() < sizeof(m_header) )
+			return false;
+
+		memcpy( &m_header, &m_vData[0], sizeof(m_header) );
+		if( memcmp( m_header.acMagic, BLF_MAGIC, sizeof(m_header.acMagic) ) != 0 || m_header.uiVersion != BLF_VERSION || m_header.llTicksPerSecond <= 0 )
+			return false;
+
+		// formats can be registered at any time, so all of them are read before the first message
+		BinaryLogFile::RecordHeader header;
+		for( unsigned int uiPos = sizeof(m_header); readRecord( uiPos, header ); uiPos += header.uiLength )
+		{
+			if( header.uiFormatID == BLF_FORMAT_RECORD )
+				readFormat( header, uiPos );
+		}
+
+		m_uiPos = sizeof(m_header);
+
+		return true;
+	}
+
+
+	/**
+	 * @brief	Reconstructs the next message.
+	 *
+	 * @param [out]	strLine	The message with time and error level like in a text log.
+	 * @param	bWithSource	true to append the file and line the message was logged in.
+	 *
+	 * @return	true if it succeeds, false if there are no more messages.
+	 */
+	bool BinaryLogReader::next( std::string& strLine, bool bWithSource )
+	{
+		BinaryLogFile::RecordHeader header;
+		while( readRecord( m_uiPos, header ) && header.uiFormatID == BLF_FORMAT_RECORD )
+			m_uiPos += header.uiLength;
+
+		if( !readRecord( m_uiPos, header ) )
+			return false;
+
+		const char* pcArguments = &m_vData[m_uiPos + sizeof(header)];
+		m_uiPos += header.uiLength;
+
+		// time since the file was opened
+		long long llTicks = header.llTicks - m_header.llStartTicks;
+		long long llMicroseconds = m_header.llStartMicroseconds + (llTicks / m_header.llTicksPerSecond) * 1000000
+								 + (llTicks % m_header.llTicksPerSecond) * 1000000 / m_header.llTicksPerSecond;
+		time_t timeval = (time_t)(m_header.llStartSeconds + llMicroseconds / 1000000);
+
+		char acTime[32];
+		size_t uiTimeLength = strftime( acTime, sizeof(acTime), "%H:%M:%S", gmtime( &timeval ) );
+		sprintf( acTime + uiTimeLength, ".%06d", (int)(llMicroseconds % 1000000) );
+
+		std::map<unsigned int, LogFormat*>::const_iterator it = m_mapFormats.find( header.uiFormatID );
+		if( it == m_mapFormats.end() )
+		{
+			char acUnknown[64];
+			sprintf( acUnknown, " ?          : <unknown format %u>", header.uiFormatID );
+			strLine = std::string( acTime ) + acUnknown;
+			return true;
+		}
+
+		const LogFormat* pFormat = it->second;
+		strLine = acTime + Log::sm_astrLogLevelToPrefix[pFormat->getErrorLevel()] + pFormat->decode( pcArguments, header.uiLength - sizeof(header) );
+
+		if( bWithSource )
+		{
+			char acLine[16];
+			sprintf( acLine, ":%u)", pFormat->getLine() );
+			strLine += std::string( "  (" ) + pFormat->getFile() + acLine;
+		}
+
+		return true;
+	}
+
+
+	/**
+	 * @brief	Reads the header of a record and checks that the whole record is inside the file.
+	 *
+	 * @param	uiPos		  	Position of the record.
+	 * @param [out]	header	The header.
+	 *
+	 * @return	true if there is a complete record, false at the end of the file.
+	 */
+	bool BinaryLogReader::readRecord( unsigned int uiPos, BinaryLogFile::RecordHeader& header ) const
+	{
+		if( uiPos + sizeof(header) > m_vData.size() )
+			return false;
+
+		memcpy( &header, &m_vData[uiPos], sizeof(header) );
+
+		// the unused rest of a file that was not closed is zero
+		return header.uiLength >= sizeof(header) && header.uiLength % 8 == 0 && header.uiLength <= m_vData.size() - uiPos;
+	}
+
+
+	/**
+	 * @brief	Creates the format described by a format record.
+	 *
+	 * @param	header	The header of the record.
+	 * @param	uiPos 	Position of the record.
+	 */
+	void BinaryLogReader::readFormat( const BinaryLogFile::RecordHeader& header, unsigned int uiPos )
+	{
+		unsigned int auiValues[3];
+		if( header.uiLength < sizeof(header) + sizeof(auiValues) )
+			return;
+
+		const char* pcRecord = &m_vData[uiPos];
+		memcpy( auiValues, pcRecord + sizeof(header), sizeof(auiValues) );
+
+		// both strings have to be terminated inside the record
+		const char* pcFile = pcRecord + sizeof(header) + sizeof(auiValues);
+		const char* pcEnd = pcRecord + header.uiLength;
+		const char* pcFileEnd = (const char*)memchr( pcFile, '\0', pcEnd - pcFile );
+		if( !pcFileEnd )
+			return;
+
+		const char* pcFormat = pcFileEnd + 1;
+		if( !memchr( pcFormat, '\0', pcEnd - pcFormat ) || auiValues[1] > Log::sm_uiMaxLogLevel )
+			return;
+
+		// every file repeats the formats registered before it was opened, a format is only kept once
+		if( m_mapFormats.count( auiValues[0] ) )
+			return;
+
+		m_mapFormats[auiValues[0]] = new LogFormat( auiValues[0], pcFile, auiValues[2], (Log::EErrorLevel)auiValues[1], pcFormat );
+	}
+
+}
@@ -0,0 +1,133 @@
+/*
+Object Oriented Communication Library
+Copyright (c) 2011 Jürgen Lorenz and Jörn Teuber
+
+This software is provided 'as-is', without any express or implied warranty.
+In no event will the authors be held liable for any damages arising from the use of this software.
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it freely,
+subject to the following restrictions:
+
+1. The origin of this software must not be misrepresented; you must not claim that you wrote the original software. If you use this software in a product, an acknowledgment in the product documentation would be appreciated but is not required.
+2. Altered source versions must be plainly marked as such, and must not be misrepresented as being the original software.
+3. This notice may not be removed or altered from any source distribution.
+*/
+// This file was written by Jörn Teuber
+
+#include <cstring>
+
+#include "ChunkWriter.h"
+#include "Thread.h"
+
+namespace oocl
+{
+	/**
+	 * @brief	Constructor.
+	 *
+	 * @param	uiChunkSize	Messages longer than this are sent in chunks of this size, 0 sends every message at once.
+	 */
+	ChunkWriter::ChunkWriter( unsigned int uiChunkSize )
+		: m_uiChunkSize( 0 )
+		, m_uiNextStream( 0 )
+		, m_uiWaitingWriters( 0 )
+	{
+		setChunkSize( uiChunkSize );
+	}
+
+
+	/**
+	 * @brief	Set the size of the chunks.
+	 *
+	 * @note	A chunk has to fit the 2 byte length of a normal header, larger values are reduced.
+	 *
+	 * @param	uiChunkSize	Messages longer than this are sent in chunks of this size, 0 sends every message at once.
+	 */
+	void ChunkWriter::setChunkSize( unsigned int uiChunkSize )
+	{
+		if( uiChunkSize > MSG_EXTENDED_LENGTH - 3 )
+			uiChunkSize = MSG_EXTENDED_LENGTH - 3;
+		else if( uiChunkSize > 0 && uiChunkSize < MSG_MAX_HEADER_LENGTH )
+			uiChunkSize = MSG_MAX_HEADER_LENGTH;
+
+		m_uiChunkSize = uiChunkSize;
+	}
+
+
+	/**
+	 * @brief	Checks whether the message has to be sent in chunks.
+	 *
+	 * @param	pMessage	The message.
+	 *
+	 * @return	true if it is a tcp message that is longer than the chunk size.
+	 */
+	bool ChunkWriter::needsChunks( Message const * pMessage ) const
+	{
+		if( m_uiChunkSize == 0 || pMessage->getProtocoll() != SOCK_STREAM )
+			return false;
+
+		unsigned int uiBodyLength = pMessage->getBodyLength();
+
+		return Message::getHeaderLength( uiBodyLength ) + uiBodyLength > m_uiChunkSize;
+	}
+
+
+	/**
+	 * @brief	Get a new stream ID for a large message.
+	 *
+	 * @return	The stream ID, to be passed to every appendChunk() of this message.
+	 */
+	unsigned short ChunkWriter::beginStream()
+	{
+		return (unsigned short)m_uiNextStream.fetchAdd( 1 );
+	}
+
+
+	/**
+	 * @brief	Appends the next chunk of a message to the buffer.
+	 *
+	 * @param [in,out]	buffer		The buffer to append the chunk frame to.
+	 * @param	usStream			The stream ID returned by beginStream().
+	 * @param	pcFrame				The serialized message.
+	 * @param	uiFrameLength		The length of the serialized message.
+	 * @param [in,out]	uiOffset	The number of bytes that were already sent, advanced by the length of the chunk.
+	 */
+	void ChunkWriter::appendChunk( WriteBuffer& buffer, unsigned short usStream, const char* pcFrame, unsigned int uiFrameLength, unsigned int& uiOffset ) const
+	{
+		unsigned int uiPiece = uiFrameLength - uiOffset;
+		if( uiPiece > m_uiChunkSize )
+			uiPiece = m_uiChunkSize;
+
+		char* pcOut = buffer.grow( 6 + uiPiece );
+		Message::writeHeader( pcOut, MT_ChunkFrame, 2 + uiPiece );
+		std::memcpy( pcOut + 4, &usStream, sizeof(unsigned short) );
+		std::memcpy( pcOut + 6, pcFrame + uiOffset, uiPiece );
+
+		uiOffset += uiPiece;
+	}
+
+
+	/**
+	 * @brief	Locks the connection for a single message, before any waiting chunk.
+	 *
+	 * @param [in,out]	mxConnection	The mutex that guards the connection.
+	 */
+	void ChunkWriter::lock( Mutex& mxConnection )
+	{
+		m_uiWaitingWriters.fetchAdd( 1 );
+		mxConnection.lock();
+		m_uiWaitingWriters.fetchAdd( (unsigned int)-1 );
+	}
+
+
+	/**
+	 * @brief	Called between two chunks without holding the lock, lets the threads in lock() go first.
+	 *
+	 * @note	Gives up after a while, so that a steady flow of small messages can not stall a large one forever.
+	 */
+	void ChunkWriter::yield()
+	{
+		for( int i = 0; i < 100 && m_uiWaitingWriters.load() > 0; i++ )
+			Thread::sleep( 0 );
+	}
+
+}
@@ -0,0 +1,505 @@
+/*
+Object Oriented Communication Library
+Copyright (c) 2011 Jürgen Lorenz and Jörn Teuber
+
+This software is provided 'as-is', without any express or implied warranty.
+In no event will the authors be held liable for any damages arising from the use of this software.
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it freely,
+subject to the following restrictions:
+
+1. The origin of this software must not be misrepresented; you must not claim that you wrote the original software. If you use this software in a product, an acknowledgment in the product documentation would be appreciated but is not required.
+2. Altered source versions must be plainly marked as such, and must not be misrepresented as being the original software.
+3. This notice may not be removed or altered from any source distribution.
+*/
+// This file was written by Jörn Teuber
+
+#include <cstring>
+
+#ifdef OOCL_USE_ZLIB
+#	include <zlib.h>
+#endif
+
+#include "Codec.h"
+#include "Message.h"
+
+namespace oocl
+{
+
+	// ******************** Codec *********************
+
+	Codec* Codec::sm_apCodecs[CODEC_MaxID+1] = { NULL };
+	std::vector<unsigned char> Codec::sm_vucTypeCodecs;
+	std::vector<unsigned int> Codec::sm_vuiTypeThresholds;
+
+
+	/**
+	 * @brief	Makes a codec available under the given ID, or replaces a built-in one.
+	 *
+	 * @note	Has to be called on both sides before connecting, the codec is not deleted.
+	 *
+	 * @param	ucID			The ID, 1 to CODEC_MaxID.
+	 * @param [in]	pCodec	The codec.
+	 */
+	void Codec::registerCodec( unsigned char ucID, Codec* pCodec )
+	{
+		if( ucID == CODEC_None || ucID > CODEC_MaxID )
+		{
+			OOCL_LOG_ERROR( "oocl", "Codec ID " << (unsigned int)ucID << " is not valid" );
+			return;
+		}
+
+		sm_apCodecs[ucID] = pCodec;
+	}
+
+
+	/**
+	 * @brief	Get the codec with the given ID.
+	 *
+	 * @param	ucID	The ID.
+	 *
+	 * @return	The codec or NULL if there is none with this ID.
+	 */
+	Codec* Codec::getCodec( unsigned char ucID )
+	{
+		static LZCodec lzCodec;
+#ifdef OOCL_USE_ZLIB
+		static ZlibCodec zlibCodec;
+#endif
+
+		if( ucID == CODEC_None || ucID > CODEC_MaxID )
+			return NULL;
+
+		if( sm_apCodecs[ucID] != NULL )
+			return sm_apCodecs[ucID];
+
+		switch( ucID )
+		{
+		case CODEC_LZ:
+			return &lzCodec;
+#ifdef OOCL_USE_ZLIB
+		case CODEC_Zlib:
+			return &zlibCodec;
+#endif
+		default:
+			return NULL;
+		}
+	}
+
+
+	/**
+	 * @brief	Get all codecs this process can decompress, sent to the other side in the ConnectMessage.
+	 *
+	 * @return	A bit mask with the bit (1 << ID) set for every available codec.
+	 */
+	unsigned int Codec::getSupportedCodecs()
+	{
+		unsigned int uiCodecs = 0;
+		for( unsigned int i = 1; i <= CODEC_MaxID; i++ )
+		{
+			if( getCodec( (unsigned char)i ) != NULL )
+				uiCodecs |= 1u << i;
+		}
+
+		return uiCodecs;
+	}
+
+
+	/**
+	 * @brief	Sets the codec for the messages of one type, called by Message::registerMsg().
+	 *
+	 * @param	usType		The message type.
+	 * @param	ucCodec		The codec ID, CODEC_None to send the messages uncompressed.
+	 * @param	uiThreshold	Messages shorter than this are sent uncompressed.
+	 */
+	void Codec::useFor( unsigned short usType, unsigned char ucCodec, unsigned int uiThreshold )
+	{
+		if( usType >= sm_vucTypeCodecs.size() )
+		{
+			sm_vucTypeCodecs.resize( usType+1, CODEC_None );
+			sm_vuiTypeThresholds.resize( usType+1, 0 );
+		}
+
+		sm_vucTypeCodecs[usType] = ucCodec;
+		sm_vuiTypeThresholds[usType] = uiThreshold;
+	}
+
+
+	/**
+	 * @brief	Compresses a serialized message if its type has a codec that the receiver supports.
+	 *
+	 * @note	Messages that would not get shorter are left as they are.
+	 *
+	 * @param [in,out]	wbFrame  	The serialized message, replaced by the compressed frame.
+	 * @param	uiCodecs		 	The codecs the receiver supports, see getSupportedCodecs().
+	 * @param [in,out]	wbScratch	Memory for the compression, holds the uncompressed message afterwards.
+	 *
+	 * @return	true if the message was compressed.
+	 */
+	bool Codec::compressFrame( WriteBuffer& wbFrame, unsigned int uiCodecs, WriteBuffer& wbScratch )
+	{
+		if( uiCodecs == 0 || wbFrame.size() < 4 )
+			return false;
+
+		unsigned short usType = 0;
+		std::memcpy( &usType, wbFrame.data(), sizeof(unsigned short) );
+
+		if( usType >= sm_vucTypeCodecs.size() || sm_vucTypeCodecs[usType] == CODEC_None || wbFrame.size() < sm_vuiTypeThresholds[usType] )
+			return false;
+
+		unsigned char ucCodec = sm_vucTypeCodecs[usType];
+		Codec* pCodec = getCodec( ucCodec );
+		if( pCodec == NULL || ( uiCodecs & ( 1u << ucCodec ) ) == 0 )
+			return false;
+
+		// the compressed frame is only kept if it is shorter, so its header is never longer than the original one
+		unsigned int uiHeaderLength = Message::getHeaderLength( wbFrame.size() );
+		unsigned int uiOriginalLength = wbFrame.size();
+
+		wbScratch.clear();
+		wbScratch.grow( uiHeaderLength + 5 );
+		pCodec->compress( wbFrame.data(), uiOriginalLength, wbScratch );
+
+		if( wbScratch.size() >= uiOriginalLength )
+			return false;
+
+		char* pcOut = const_cast<char*>( wbScratch.data() );
+		unsigned short usFrameType = MT_CompressedFrame;
+		unsigned int uiBodyLength = wbScratch.size() - uiHeaderLength;
+
+		std::memcpy( pcOut, &usFrameType, sizeof(unsigned short) );
+		if( uiHeaderLength == 4 )
+		{
+			unsigned short usBodyLength = (unsigned short)uiBodyLength;
+			std::memcpy( pcOut + 2, &usBodyLength, sizeof(unsigned short) );
+		}
+		else
+		{
+			// the extended header is also valid for shorter bodies
+			unsigned short usExtended = MSG_EXTENDED_LENGTH;
+			std::memcpy( pcOut + 2, &usExtended, sizeof(unsigned short) );
+			std::memcpy( pcOut + 4, &uiBodyLength, sizeof(unsigned int) );
+		}
+
+		pcOut[uiHeaderLength] = (char)ucCodec;
+		std::memcpy( pcOut + uiHeaderLength + 1, &uiOriginalLength, sizeof(unsigned int) );
+
+		wbFrame.swap( wbScratch );
+
+		return true;
+	}
+
+
+	/**
+	 * @brief	Restores the message of a compressed frame.
+	 *
+	 * @param	pcFrame			The compressed frame, including its header.
+	 * @param	uiLength		The length of the frame.
+	 * @param [out]	strOut	The original message.
+	 *
+	 * @return	false if the codec is unknown or the frame is corrupt.
+	 */
+	bool Codec::decompressFrame( const char* pcFrame, unsigned int uiLength, std::string& strOut )
+	{
+		unsigned int uiBodyLength = 0;
+		unsigned int uiHeaderLength = Message::readHeader( pcFrame, uiBodyLength );
+		if( uiBodyLength < 5 || uiHeaderLength + uiBodyLength > uiLength )
+			return false;
+
+		const char* pcBody = pcFrame + uiHeaderLength;
+		Codec* pCodec = getCodec( (unsigned char)pcBody[0] );
+
+		unsigned int uiOriginalLength = 0;
+		std::memcpy( &uiOriginalLength, pcBody + 1, sizeof(unsigned int) );
+
+		// no codec shrinks data by more than about 1:1000, so a bigger original length is corrupt
+		if( pCodec == NULL || uiOriginalLength < 4 || uiOriginalLength / 1100 > uiBodyLength )
+			return false;
+
+		strOut.resize( uiOriginalLength );
+		if( !pCodec->decompress( pcBody + 5, uiBodyLength - 5, &strOut[0], uiOriginalLength ) )
+			return false;
+
+		// the original message has to fill the decompressed bytes exactly
+		unsigned short usInnerLength = 0;
+		std::memcpy( &usInnerLength, strOut.data() + 2, sizeof(unsigned short) );
+		if( usInnerLength == MSG_EXTENDED_LENGTH && uiOriginalLength < MSG_MAX_HEADER_LENGTH )
+			return false;
+
+		unsigned int uiInnerLength = 0;
+		unsigned int uiInnerHeaderLength = Message::readHeader( strOut.data(), uiInnerLength );
+
+		return uiInnerLength <= uiOriginalLength && uiInnerHeaderLength + uiInnerLength == uiOriginalLength;
+	}
+
+
+	// ******************** LZCodec *********************
+
+	namespace
+	{
+		const unsigned int LZ_HASH_BITS = 12;
+		const unsigned int LZ_MIN_MATCH = 4;
+		const unsigned int LZ_MAX_OFFSET = 65535;
+
+		inline unsigned int read32( const unsigned char* p )
+		{
+			unsigned int ui;
+			std::memcpy( &ui, p, sizeof(unsigned int) );
+			return ui;
+		}
+
+		inline unsigned int hash32( unsigned int ui )
+		{
+			return ( ui * 2654435761u ) >> ( 32 - LZ_HASH_BITS );
+		}
+
+		/**
+		 * @brief	Writes a length that did not fit into its 4 bits of the token, in steps of 255.
+		 */
+		inline unsigned char* writeLength( unsigned char* pOut, unsigned int uiLength )
+		{
+			while( uiLength >= 255 )
+			{
+				*pOut++ = 255;
+				uiLength -= 255;
+			}
+			*pOut++ = (unsigned char)uiLength;
+			return pOut;
+		}
+
+		/**
+		 * @brief	Reads a length written by writeLength() and adds it to uiLength.
+		 */
+		inline bool readLength( const unsigned char*& pIn, const unsigned char* pEnd, unsigned int& uiLength )
+		{
+			unsigned char ucByte;
+			do
+			{
+				if( pIn >= pEnd )
+					return false;
+				ucByte = *pIn++;
+				uiLength += ucByte;
+			} while( ucByte == 255 );
+
+			return true;
+		}
+
+		/**
+		 * @brief	Writes one sequence: the token, the literals and, if uiMatchLength > 0, the match.
+		 */
+		unsigned char* writeSequence( unsigned char* pOut, const unsigned char* pLiterals, unsigned int uiLiterals, unsigned int uiOffset, unsigned int uiMatchLength )
+		{
+			unsigned int uiMatchCode = uiMatchLength > 0 ? uiMatchLength - LZ_MIN_MATCH : 0;
+
+			unsigned char* pToken = pOut++;
+			*pToken = (unsigned char)( ( uiLiterals < 15 ? uiLiterals : 15 ) << 4 );
+			if( uiLiterals >= 15 )
+				pOut = writeLength( pOut, uiLiterals - 15 );
+
+			std::memcpy( pOut, pLiterals, uiLiterals );
+			pOut += uiLiterals;
+
+			if( uiMatchLength > 0 )
+			{
+				unsigned short usOffset = (unsigned short)uiOffset;
+				std::memcpy( pOut, &usOffset, sizeof(unsigned short) );
+				pOut += 2;
+
+				*pToken |= (unsigned char)( uiMatchCode < 15 ? uiMatchCode : 15 );
+				if( uiMatchCode >= 15 )
+					pOut = writeLength( pOut, uiMatchCode - 15 );
+			}
+
+			return pOut;
+		}
+	}
+
+
+	/**
+	 * @brief	Appends the compressed bytes to the buffer.
+	 *
+	 * @param	pcIn		The bytes to compress.
+	 * @param	uiLength	The number of bytes.
+	 * @param [in,out]	out	The buffer to append to.
+	 */
+	void LZCodec::compress( const char* pcIn, unsigned int uiLength, WriteBuffer& out ) const
+	{
+		unsigned int uiStart = out.size();
+		unsigned char* pOut = (unsigned char*)out.grow( uiLength + uiLength / 255 + 16 );
+		unsigned char* pOutStart = pOut;
+
+		const unsigned char* pIn = (const unsigned char*)pcIn;
+		const unsigned char* pEnd = pIn + uiLength;
+		const unsigned char* pAnchor = pIn;
+		const unsigned char* p = pIn;
+
+		// positions of the last occurrence of each hashed 4 byte sequence, relative to pIn
+		unsigned int auiTable[1 << LZ_HASH_BITS];
+		std::memset( auiTable, 0, sizeof(auiTable) );
+
+		if( uiLength > LZ_MIN_MATCH + 8 )
+		{
+			// the last bytes are always literals, so matches never read past the end
+			const unsigned char* pMatchLimit = pEnd - LZ_MIN_MATCH;
+
+			while( p < pMatchLimit )
+			{
+				unsigned int uiSequence = read32( p );
+				unsigned int uiHash = hash32( uiSequence );
+				const unsigned char* pCandidate = pIn + auiTable[uiHash];
+				auiTable[uiHash] = (unsigned int)( p - pIn );
+
+				if( pCandidate >= p || p - pCandidate > (int)LZ_MAX_OFFSET || read32( pCandidate ) != uiSequence )
+				{
+					// skip faster through data that does not compress
+					p += 1 + ( ( p - pAnchor ) >> 6 );
+					continue;
+				}
+
+				unsigned int uiMatchLength = LZ_MIN_MATCH;
+				while( p + uiMatchLength < pEnd && pCandidate[uiMatchLength] == p[uiMatchLength] )
+					uiMatchLength++;
+
+				pOut = writeSequence( pOut, pAnchor, (unsigned int)( p - pAnchor ), (unsigned int)( p - pCandidate ), uiMatchLength );
+
+				p += uiMatchLength;
+				pAnchor = p;
+			}
+		}
+
+		pOut = writeSequence( pOut, pAnchor, (unsigned int)( pEnd - pAnchor ), 0, 0 );
+
+		out.truncate( uiStart + (unsigned int)( pOut - pOutStart ) );
+	}
+
+
+	/**
+	 * @brief	Decompresses exactly uiOutLength bytes.
+	 *
+	 * @param	pcIn		The compressed bytes.
+	 * @param	uiLength	The number of compressed bytes.
+	 * @param [out]	pcOut	Where to write the decompressed bytes.
+	 * @param	uiOutLength	The length of the original bytes.
+	 *
+	 * @return	false if the input is corrupt or does not decompress to uiOutLength bytes.
+	 */
+	bool LZCodec::decompress( const char* pcIn, unsigned int uiLength, char* pcOut, unsigned int uiOutLength ) const
+	{
+		const unsigned char* pIn = (const unsigned char*)pcIn;
+		const unsigned char* pInEnd = pIn + uiLength;
+		unsigned char* pOut = (unsigned char*)pcOut;
+		unsigned char* pOutEnd = pOut + uiOutLength;
+
+		while( pIn < pInEnd )
+		{
+			unsigned char ucToken = *pIn++;
+
+			unsigned int uiLiterals = ucToken >> 4;
+			if( uiLiterals == 15 && !readLength( pIn, pInEnd, uiLiterals ) )
+				return false;
+
+			if( uiLiterals > (unsigned int)( pInEnd - pIn ) || uiLiterals > (unsigned int)( pOutEnd - pOut ) )
+				return false;
+
+			std::memcpy( pOut, pIn, uiLiterals );
+			pIn += uiLiterals;
+			pOut += uiLiterals;
+
+			// the last sequence has no match
+			if( pIn == pInEnd )
+				break;
+
+			if( pInEnd - pIn < 2 )
+				return false;
+
+			unsigned short usOffset = 0;
+			std::memcpy( &usOffset, pIn, sizeof(unsigned short) );
+			pIn += 2;
+
+			if( usOffset == 0 || usOffset > pOut - (unsigned char*)pcOut )
+				return false;
+
+			unsigned int uiMatchLength = ucToken & 15;
+			if( uiMatchLength == 15 && !readLength( pIn, pInEnd, uiMatchLength ) )
+				return false;
+			uiMatchLength += LZ_MIN_MATCH;
+
+			if( uiMatchLength > (unsigned int)( pOutEnd - pOut ) )
+				return false;
+
+			// the match may overlap the bytes it produces, e.g. a run of one byte has offset 1
+			const unsigned char* pMatch = pOut - usOffset;
+			if( usOffset >= uiMatchLength )
+			{
+				std::memcpy( pOut, pMatch, uiMatchLength );
+				pOut += uiMatchLength;
+			}
+			else
+			{
+				for( unsigned int i = 0; i < uiMatchLength; i++ )
+					*pOut++ = *pMatch++;
+			}
+		}
+
+		return pOut == pOutEnd;
+	}
+
+
+#ifdef OOCL_USE_ZLIB
+	// ******************** ZlibCodec *********************
+
+	/**
+	 * @brief	Constructor.
+	 *
+	 * @param	iLevel	The zlib compression level, 1 is fastest and 9 compresses best.
+	 */
+	ZlibCodec::ZlibCodec( int iLevel )
+		: m_iLevel( iLevel )
+	{
+	}
+
+
+	/**
+	 * @brief	Appends the compressed bytes to the buffer.
+	 *
+	 * @param	pcIn		The bytes to compress.
+	 * @param	uiLength	The number of bytes.
+	 * @param [in,out]	out	The buffer to append to.
+	 */
+	void ZlibCodec::compress( const char* pcIn, unsigned int uiLength, WriteBuffer& out ) const
+	{
+		unsigned int uiStart = out.size();
+		uLongf ulOutLength = compressBound( uiLength );
+		Bytef* pOut = (Bytef*)out.grow( (unsigned int)ulOutLength );
+
+		if( compress2( pOut, &ulOutLength, (const Bytef*)pcIn, uiLength, m_iLevel ) != Z_OK )
+		{
+			// leave the message uncompressed, compressFrame() only keeps shorter results
+			out.truncate( uiStart );
+			out.append( pcIn, uiLength );
+			return;
+		}
+
+		out.truncate( uiStart + (unsigned int)ulOutLength );
+	}
+
+
+	/**
+	 * @brief	Decompresses exactly uiOutLength bytes.
+	 *
+	 * @param	pcIn		The compressed bytes.
+	 * @param	uiLength	The number of compressed bytes.
+	 * @param [out]	pcOut	Where to write the decompressed bytes.
+	 * @param	uiOutLength	The length of the original bytes.
+	 *
+	 * @return	false if the input is corrupt or does not decompress to uiOutLength bytes.
+	 */
+	bool ZlibCodec::decompress( const char* pcIn, unsigned int uiLength, char* pcOut, unsigned int uiOutLength ) const
+	{
+		uLongf ulOutLength = uiOutLength;
+
+		return uncompress( (Bytef*)pcOut, &ulOutLength, (const Bytef*)pcIn, uiLength ) == Z_OK && ulOutLength == uiOutLength;
+	}
+#endif
+
+}
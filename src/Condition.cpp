@@ -0,0 +1,132 @@
+/*
+Object Oriented Communication Library
+Copyright (c) 2011 Jürgen Lorenz and Jörn Teuber
+
+This software is provided 'as-is', without any express or implied warranty.
+In no event will the authors be held liable for any damages arising from the use of this software.
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it freely,
+subject to the following restrictions:
+
+1. The origin of this software must not be misrepresented; you must not claim that you wrote the original software. If you use this software in a product, an acknowledgment in the product documentation would be appreciated but is not required.
+2. Altered source versions must be plainly marked as such, and must not be misrepresented as being the original software.
+3. This notice may not be removed or altered from any source distribution.
+*/
+// This file was written by Jörn Teuber
+
+#include "Condition.h"
+
+namespace oocl
+{
+	/**
+	 * @brief	Constructor.
+	 */
+	Condition::Condition()
+	{
+#if defined USE_PTHREADS
+		// timed waits must not be stretched or cut short when the wall clock is changed
+		pthread_condattr_t attr;
+		pthread_condattr_init( &attr );
+		pthread_condattr_setclock( &attr, CLOCK_MONOTONIC );
+		pthread_cond_init( &m_condition, &attr );
+		pthread_condattr_destroy( &attr );
+#elif defined USE_WINTHREADS
+		InitializeConditionVariable( &m_condition );
+#endif
+	}
+
+
+	/**
+	 * @brief	Destructor.
+	 */
+	Condition::~Condition()
+	{
+#if defined USE_PTHREADS
+		pthread_cond_destroy( &m_condition );
+#endif
+	}
+
+
+	/**
+	 * @brief	Unlocks the mutex, sleeps until the condition is signaled and locks the mutex again.
+	 *
+	 * @param [in]	mutex	The mutex protecting the predicate, has to be locked by the calling thread.
+	 */
+	void Condition::wait( Mutex& mutex )
+	{
+#if defined USE_CPP11
+		std::unique_lock<std::mutex> lock( mutex.m_mutex, std::adopt_lock );
+		m_condition.wait( lock );
+		lock.release();
+#elif defined USE_PTHREADS
+		pthread_cond_wait( &m_condition, &mutex.m_mutex );
+#elif defined USE_WINTHREADS
+		SleepConditionVariableCS( &m_condition, &mutex.m_csMutex, INFINITE );
+#endif
+		mutex.m_bLocked = true;
+	}
+
+	/**
+	 * @brief	Like wait(), but returns after the given time even if the condition was not signaled.
+	 *
+	 * @param [in]	mutex			The mutex protecting the predicate, has to be locked by the calling thread.
+	 * @param	iMilliseconds	The maximum time to sleep.
+	 *
+	 * @return	false if the time ran out, true if the condition was signaled (or woke up spuriously).
+	 */
+	bool Condition::wait( Mutex& mutex, int iMilliseconds )
+	{
+		bool bSignaled = true;
+#if defined USE_CPP11
+		std::unique_lock<std::mutex> lock( mutex.m_mutex, std::adopt_lock );
+		bSignaled = m_condition.wait_for( lock, std::chrono::milliseconds( iMilliseconds ) ) == std::cv_status::no_timeout;
+		lock.release();
+#elif defined USE_PTHREADS
+		struct timespec ts;
+		clock_gettime( CLOCK_MONOTONIC, &ts );
+		ts.tv_sec += iMilliseconds / 1000;
+		ts.tv_nsec += (iMilliseconds % 1000) * 1000000;
+		if( ts.tv_nsec >= 1000000000 )
+		{
+			ts.tv_sec++;
+			ts.tv_nsec -= 1000000000;
+		}
+
+		bSignaled = pthread_cond_timedwait( &m_condition, &mutex.m_mutex, &ts ) == 0;
+#elif defined USE_WINTHREADS
+		bSignaled = SleepConditionVariableCS( &m_condition, &mutex.m_csMutex, iMilliseconds ) != 0;
+#endif
+		mutex.m_bLocked = true;
+
+		return bSignaled;
+	}
+
+	/**
+	 * @brief	Wakes up one thread that waits for this condition.
+	 */
+	void Condition::signal()
+	{
+#if defined USE_CPP11
+		m_condition.notify_one();
+#elif defined USE_PTHREADS
+		pthread_cond_signal( &m_condition );
+#elif defined USE_WINTHREADS
+		WakeConditionVariable( &m_condition );
+#endif
+	}
+
+	/**
+	 * @brief	Wakes up all threads that wait for this condition.
+	 */
+	void Condition::broadcast()
+	{
+#if defined USE_CPP11
+		m_condition.notify_all();
+#elif defined USE_PTHREADS
+		pthread_cond_broadcast( &m_condition );
+#elif defined USE_WINTHREADS
+		WakeAllConditionVariable( &m_condition );
+#endif
+	}
+
+} /* namespace oocl */
@@ -0,0 +1,256 @@
+/*
+Object Oriented Communication Library
+Copyright (c) 2011 Jürgen Lorenz and Jörn Teuber
+
+This software is provided 'as-is', without any express or implied warranty.
+In no event will the authors be held liable for any damages arising from the use of this software.
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it freely,
+subject to the following restrictions:
+
+1. The origin of this software must not be misrepresented; you must not claim that you wrote the original software. If you use this software in a product, an acknowledgment in the product documentation would be appreciated but is not required.
+2. Altered source versions must be plainly marked as such, and must not be misrepresented as being the original software.
+3. This notice may not be removed or altered from any source distribution.
+*/
+// This file was written by Jörn Teuber
+
+
+#include <cstring>
+#include <algorithm>
+
+#include "DatagramFragmenter.h"
+#include "DatagramSlab.h"
+#include "BerkeleySocket.h"
+
+namespace oocl
+{
+	/**
+	 * @brief	Constructor.
+	 *
+	 * @param	uiTrailerLength	The number of bytes at the end of every datagram that are not part of the message.
+	 */
+	DatagramFragmenter::DatagramFragmenter( unsigned int uiTrailerLength )
+		: m_uiTrailerLength( uiTrailerLength )
+		, m_uiPathMTU( 0 )
+		, m_uiPayloadSize( 0 )
+		, m_uiNextID( 0 )
+		, m_wbFragment( DS_DEFAULT_DATAGRAM_SIZE )
+	{
+	}
+
+
+	/**
+	 * @brief	Set the path MTU the datagrams are sized for, the caller has to hold the lock of the socket.
+	 *
+	 * @param	uiMTU	The largest ip packet that reaches the other side unfragmented, 0 asks the socket.
+	 */
+	void DatagramFragmenter::setPathMTU( unsigned int uiMTU )
+	{
+		m_uiPathMTU = uiMTU;
+		m_uiPayloadSize = 0;
+	}
+
+
+	/**
+	 * @brief	Sends a datagram, in fragments if it is longer than the path MTU allows.
+	 *
+	 * @note	The message ID is counted by the fragmenter.
+	 *
+	 * @param [in]	pSocket	The connected udp socket.
+	 * @param	pcDatagram	The datagram, a message frame followed by the trailer.
+	 * @param	uiLength	The length of the datagram.
+	 *
+	 * @return	true if it succeeds, false if it fails.
+	 */
+	bool DatagramFragmenter::write( Socket* pSocket, const char* pcDatagram, unsigned int uiLength )
+	{
+		return write( pSocket, pcDatagram, uiLength, m_uiNextID++ & ~DF_FIXED_ID );
+	}
+
+
+	/**
+	 * @brief	Sends a datagram with a given message ID, in fragments if it is longer than the path MTU allows.
+	 *
+	 * @param [in]	pSocket		The connected udp socket.
+	 * @param	pcDatagram		The datagram, a message frame followed by the trailer.
+	 * @param	uiLength		The length of the datagram.
+	 * @param	uiMessageID		The ID of the fragments, DF_FIXED_ID has to be set. Use the same ID for a datagram that is sent again.
+	 *
+	 * @return	true if it succeeds, false if it fails.
+	 */
+	bool DatagramFragmenter::write( Socket* pSocket, const char* pcDatagram, unsigned int uiLength, unsigned int uiMessageID )
+	{
+		if( m_uiPayloadSize == 0 )
+			updatePayloadSize( pSocket );
+
+		if( uiLength <= m_uiPayloadSize )
+			return pSocket->write( pcDatagram, uiLength );
+
+		// all pieces get the same length, so that the receiver can compute where each one goes
+		unsigned int uiFrameLength = uiLength - m_uiTrailerLength;
+		unsigned int uiMaxPiece = m_uiPayloadSize - 4 - DF_FRAGMENT_HEADER - m_uiTrailerLength;
+		unsigned int uiCount = (uiFrameLength + uiMaxPiece - 1) / uiMaxPiece;
+
+		if( uiCount > DF_MAX_FRAGMENTS )
+		{
+			OOCL_LOG_WARNING( "oocl", "a message of " << uiFrameLength << " bytes is too long to be sent over udp" );
+			return false;
+		}
+
+		unsigned int uiPiece = (uiFrameLength + uiCount - 1) / uiCount;
+		bool bReturn = true;
+
+		for( unsigned int i = 0; i < uiCount; i++ )
+		{
+			unsigned int uiOffset = i * uiPiece;
+			unsigned int uiPieceLength = std::min( uiPiece, uiFrameLength - uiOffset );
+			unsigned short usIndex = (unsigned short)i, usCount = (unsigned short)uiCount;
+
+			m_wbFragment.clear();
+			char* pcHeader = m_wbFragment.grow( 4 + DF_FRAGMENT_HEADER );
+			Message::writeHeader( pcHeader, MT_FragmentFrame, DF_FRAGMENT_HEADER + uiPieceLength );
+			std::memcpy( pcHeader + 4, &uiMessageID, sizeof(unsigned int) );
+			std::memcpy( pcHeader + 8, &usIndex, sizeof(unsigned short) );
+			std::memcpy( pcHeader + 10, &usCount, sizeof(unsigned short) );
+			std::memcpy( pcHeader + 12, &uiFrameLength, sizeof(unsigned int) );
+
+			m_wbFragment.append( pcDatagram + uiOffset, uiPieceLength );
+			m_wbFragment.append( pcDatagram + uiFrameLength, m_uiTrailerLength );
+
+			bReturn &= pSocket->write( m_wbFragment.data(), m_wbFragment.size() );
+		}
+
+		return bReturn;
+	}
+
+
+	/**
+	 * @brief	Processes a received MT_FragmentFrame.
+	 *
+	 * @param	pcFragment			The fragment, starting with its header, without the trailer.
+	 * @param	uiLength			The length of the fragment.
+	 * @param [out]	pcFrame			The complete message, valid until the next call.
+	 * @param [out]	uiFrameLength	The length of the message.
+	 *
+	 * @return	true if the message is complete now, false if fragments are missing or the fragment was invalid.
+	 */
+	bool DatagramFragmenter::receive( const char* pcFragment, unsigned int uiLength, const char*& pcFrame, unsigned int& uiFrameLength )
+	{
+		unsigned int uiBodyLength = 0;
+		unsigned int uiHeaderLength = Message::readHeader( pcFragment, uiBodyLength );
+
+		if( uiHeaderLength != 4 || uiBodyLength + 4 != uiLength || uiBodyLength <= DF_FRAGMENT_HEADER )
+			return false;
+
+		unsigned int uiID = 0, uiTotal = 0;
+		unsigned short usIndex = 0, usCount = 0;
+		std::memcpy( &uiID, pcFragment + 4, sizeof(unsigned int) );
+		std::memcpy( &usIndex, pcFragment + 8, sizeof(unsigned short) );
+		std::memcpy( &usCount, pcFragment + 10, sizeof(unsigned short) );
+		std::memcpy( &uiTotal, pcFragment + 12, sizeof(unsigned int) );
+
+		// no sender makes pieces larger than a datagram, so a forged total can not allocate much
+		if( usCount == 0 || usCount > DF_MAX_FRAGMENTS || usIndex >= usCount || uiTotal < usCount || uiTotal > usCount * DS_DEFAULT_DATAGRAM_SIZE )
+			return false;
+
+		unsigned int uiPiece = (uiTotal + usCount - 1) / usCount;
+		unsigned int uiOffset = usIndex * uiPiece;
+		unsigned int uiPieceLength = uiBodyLength - DF_FRAGMENT_HEADER;
+
+		if( uiOffset >= uiTotal || uiPieceLength != std::min( uiPiece, uiTotal - uiOffset ) )
+			return false;
+
+		std::map<unsigned int, Reassembly>::iterator it = m_mapPending.find( uiID );
+		if( it == m_mapPending.end() || it->second.strFrame.size() != uiTotal || it->second.vbReceived.size() != usCount )
+		{
+			unsigned long long ullNow = BerkeleySocket::getMicroseconds();
+
+			if( it != m_mapPending.end() )
+				m_mapPending.erase( it );
+			dropIncomplete( ullNow );
+
+			Reassembly& reassembly = m_mapPending[uiID];
+			reassembly.strFrame.resize( uiTotal );
+			reassembly.vbReceived.assign( usCount, false );
+			reassembly.uiMissing = usCount;
+			reassembly.ullStartTime = ullNow;
+
+			it = m_mapPending.find( uiID );
+		}
+
+		Reassembly& reassembly = it->second;
+		if( reassembly.vbReceived[usIndex] )
+			return false;
+
+		std::memcpy( &reassembly.strFrame[uiOffset], pcFragment + 4 + DF_FRAGMENT_HEADER, uiPieceLength );
+		reassembly.vbReceived[usIndex] = true;
+
+		if( --reassembly.uiMissing > 0 )
+			return false;
+
+		m_strComplete.swap( reassembly.strFrame );
+		m_mapPending.erase( it );
+
+		// the message has to fill the reassembled frame and must not be another fragment
+		unsigned short usType = 0;
+		unsigned int uiInnerBodyLength = 0;
+		std::memcpy( &usType, m_strComplete.data(), sizeof(unsigned short) );
+
+		if( uiTotal < MSG_MAX_HEADER_LENGTH || usType == MT_FragmentFrame
+			|| Message::readHeader( m_strComplete.data(), uiInnerBodyLength ) + uiInnerBodyLength != uiTotal )
+			return false;
+
+		pcFrame = m_strComplete.data();
+		uiFrameLength = uiTotal;
+		return true;
+	}
+
+
+	/**
+	 * @brief	Computes the largest datagram from the configured or the probed path MTU.
+	 *
+	 * @note	The receiver does not accept datagrams larger than DS_DEFAULT_DATAGRAM_SIZE, e.g. on the loopback interface.
+	 *
+	 * @param [in]	pSocket	The connected udp socket.
+	 */
+	void DatagramFragmenter::updatePayloadSize( Socket* pSocket )
+	{
+		unsigned int uiMTU = m_uiPathMTU > 0 ? m_uiPathMTU : pSocket->getPathMTU();
+		if( uiMTU == 0 )
+			uiMTU = DF_DEFAULT_MTU;
+
+		uiMTU = std::max( uiMTU, (unsigned int)DF_MIN_MTU );
+		m_uiPayloadSize = std::min( uiMTU - DF_IP_UDP_OVERHEAD, (unsigned int)DS_DEFAULT_DATAGRAM_SIZE );
+	}
+
+
+	/**
+	 * @brief	Drops the incomplete messages that waited too long and makes room for a new one.
+	 *
+	 * @param	ullNow	The current time.
+	 */
+	void DatagramFragmenter::dropIncomplete( unsigned long long ullNow )
+	{
+		std::map<unsigned int, Reassembly>::iterator itOldest = m_mapPending.end();
+
+		for( std::map<unsigned int, Reassembly>::iterator it = m_mapPending.begin(); it != m_mapPending.end(); )
+		{
+			if( ullNow - it->second.ullStartTime > DF_TIMEOUT )
+			{
+				m_mapPending.erase( it++ );
+				continue;
+			}
+
+			if( itOldest == m_mapPending.end() || it->second.ullStartTime < itOldest->second.ullStartTime )
+				itOldest = it;
+			++it;
+		}
+
+		if( m_mapPending.size() >= DF_MAX_PENDING && itOldest != m_mapPending.end() )
+		{
+			OOCL_LOG_WARNING( "oocl", "an incomplete udp message was dropped to make room for a new one" );
+			m_mapPending.erase( itOldest );
+		}
+	}
+
+}
@@ -0,0 +1,71 @@
+/*
+Object Oriented Communication Library
+Copyright (c) 2011 Jürgen Lorenz and Jörn Teuber
+
+This software is provided 'as-is', without any express or implied warranty.
+In no event will the authors be held liable for any damages arising from the use of this software.
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it freely,
+subject to the following restrictions:
+
+1. The origin of this software must not be misrepresented; you must not claim that you wrote the original software. If you use this software in a product, an acknowledgment in the product documentation would be appreciated but is not required.
+2. Altered source versions must be plainly marked as such, and must not be misrepresented as being the original software.
+3. This notice may not be removed or altered from any source distribution.
+*/
+// This file was written by Jörn Teuber
+
+#include "DatagramSlab.h"
+
+namespace oocl
+{
+	/**
+	 * @brief	Constructor.
+	 *
+	 * @param	uiMaxDatagrams	The maximum number of datagrams received at once.
+	 * @param	uiDatagramSize	The size of the buffer for each datagram, bigger datagrams are truncated.
+	 */
+	DatagramSlab::DatagramSlab( unsigned int uiMaxDatagrams, unsigned int uiDatagramSize )
+		: m_pcData( new char[uiMaxDatagrams * uiDatagramSize] )
+		, m_puiLengths( new unsigned int[uiMaxDatagrams] )
+		, m_pbTruncated( new bool[uiMaxDatagrams] )
+		, m_uiMaxDatagrams( uiMaxDatagrams )
+		, m_uiDatagramSize( uiDatagramSize )
+		, m_uiCount( 0 )
+	{
+		std::memset( m_puiLengths, 0, uiMaxDatagrams * sizeof(unsigned int) );
+		std::memset( m_pbTruncated, 0, uiMaxDatagrams * sizeof(bool) );
+
+#ifdef linux
+		m_pHeaders = new struct mmsghdr[uiMaxDatagrams];
+		m_pVectors = new struct iovec[uiMaxDatagrams];
+
+		std::memset( m_pHeaders, 0, uiMaxDatagrams * sizeof(struct mmsghdr) );
+
+		for( unsigned int i = 0; i < uiMaxDatagrams; i++ )
+		{
+			m_pVectors[i].iov_base = getBuffer( i );
+			m_pVectors[i].iov_len = uiDatagramSize;
+
+			m_pHeaders[i].msg_hdr.msg_iov = &m_pVectors[i];
+			m_pHeaders[i].msg_hdr.msg_iovlen = 1;
+		}
+#endif
+	}
+
+
+	/**
+	 * @brief	Destructor.
+	 */
+	DatagramSlab::~DatagramSlab()
+	{
+		delete[] m_pcData;
+		delete[] m_puiLengths;
+		delete[] m_pbTruncated;
+
+#ifdef linux
+		delete[] m_pHeaders;
+		delete[] m_pVectors;
+#endif
+	}
+
+}
@@ -22,10 +22,15 @@ namespace oocl
 	 * @brief	Default constructor.
 	 */
 	DirectConNetwork::DirectConNetwork() :
+		m_uiCodecs(0),
+		m_eFlushPolicy(Socket::FP_Immediate),
+		m_uiFlushThreshold(0),
 		m_bConnected(false)
 	{
 		oocl::ConnectMessage::registerMsg();
 		oocl::DisconnectMessage::registerMsg();
+
+		m_reliable.setReactor( &m_reactor );
 	}
 
 	/**
@@ -34,6 +39,7 @@ namespace oocl
 	DirectConNetwork::~DirectConNetwork()
 	{
 		disconnect();
+		join();
 
 		delete m_pSocketUDPIn;
 		m_pSocketUDPIn = NULL;
@@ -72,7 +78,8 @@ namespace oocl
 
 			if( m_bConnected )
 			{
-				sendMessage( new ConnectMessage( m_usListeningPort ) );
+				sendMessage( new ConnectMessage( m_usListeningPort, 0, Codec::getSupportedCodecs() ) );
+				applyBatching();
 				start();
 			}
 
@@ -105,23 +112,8 @@ namespace oocl
 
 			if( bBlocking )
 			{
-				m_pSocketTCP = m_pServerSocket->accept();
-
-				std::string strMsg;
-				m_pSocketTCP->read( strMsg );
-
-				Message* pMsg = Message::createFromString( strMsg.c_str() );
-
-				if( pMsg->getType() != MT_ConnectMessage )
-				{
-					Log::getLog("oocl")->logError("the first received message was not a connectMessage!" );
+				if( !acceptConnection() )
 					return false;
-				}
-
-				m_usHostPort = ((ConnectMessage*)pMsg)->getPort();
-				m_pSocketUDPOut->connect( ((BerkeleySocket*)m_pSocketTCP)->getConnectedIP(), m_usHostPort );
-
-				sendMessage( new ConnectMessage( m_usListeningPort ) );
 
 				m_bConnected = true;
 			}
@@ -143,40 +135,69 @@ namespace oocl
 	{
 		sendMessage( new DisconnectMessage() );
 
+		m_reactor.unregisterSocket( m_pSocketUDPIn );
+		m_reactor.unregisterSocket( m_pSocketTCP );
+
 		m_pSocketUDPIn->close();
 		m_pSocketUDPOut->close();
 		m_pSocketTCP->close();
 		
 		m_bConnected = false;
 
+		// wake up the receiving thread so that it notices the disconnect
+		m_reactor.interrupt();
+
 		return true;
 	}
 
 	/**
 	 * @brief	Sends a message to the connected process either over the standard protocoll or the protocoll specified in the message.
 	 *
+	 * @note	A message that nobody retained is deleted afterwards.
+	 *
 	 * @param [in]	pMessage	The message that you want to send.
 	 *
 	 * @return	true if it succeeds, false if it fails.
 	 */
 	bool DirectConNetwork::sendMessage( Message const * const pMessage )
 	{
+		MessagePtr ptrMessage( pMessage );
+
 		if( pMessage && m_bConnected )
 		{
+			if( m_chunkWriter.needsChunks( pMessage ) )
+			{
+				sendChunked( pMessage );
+				return true;
+			}
+
+			m_chunkWriter.lock( m_mxSendBuffer );
+			m_wbSendBuffer.clear();
+
 			if( pMessage->getProtocoll() == SOCK_DGRAM )
 			{
-				m_pSocketUDPOut->write( pMessage->getMsgString() );
+				pMessage->serializeInto( m_wbSendBuffer );
+				m_fragmenter.write( m_pSocketUDPOut, m_wbSendBuffer.data(), m_wbSendBuffer.size() );
+			}
+			else if( ReliableChannel::isReliable( pMessage->getProtocoll() ) )
+			{
+				if( m_reliable.send( pMessage, m_wbSendBuffer ) )
+					m_fragmenter.write( m_pSocketUDPOut, m_wbSendBuffer.data(), m_wbSendBuffer.size(), ReliableChannel::getFragmentID( m_wbSendBuffer.data() ) );
 			}
 			else if( pMessage->getProtocoll() == SOCK_STREAM )
 			{
 //				int flag = 0;
 //				setsockopt(m_pSocketTCP->getCSocket(), IPPROTO_TCP, TCP_NODELAY, (char *) &flag, sizeof(int));
-				m_pSocketTCP->write( pMessage->getMsgString() );
+				pMessage->serializeInto( m_wbSendBuffer );
+				Codec::compressFrame( m_wbSendBuffer, m_uiCodecs, m_wbCompressBuffer );
+				m_pSocketTCP->write( m_wbSendBuffer.data(), m_wbSendBuffer.size() );
 //				flag = 1;
 //				setsockopt(m_pSocketTCP->getCSocket(), IPPROTO_TCP, TCP_NODELAY, (char *) &flag, sizeof(int));
 			}
 			else
-				Log::getLog("oocl")->logWarning("You tried to send a message over network that was not intended for that" );
+				OOCL_LOG_WARNING( "oocl", "You tried to send a message over network that was not intended for that" );
+
+			m_mxSendBuffer.unlock();
 			
 			return true;
 		}
@@ -184,6 +205,103 @@ namespace oocl
 		return false;
 	}
 
+	/**
+	 * @brief	Sends a large message over tcp in chunks, other messages may be sent between them.
+	 *
+	 * @param [in]	pMessage	The message to send.
+	 */
+	void DirectConNetwork::sendChunked( Message const * const pMessage )
+	{
+		// serialized without the lock, it is only held for one chunk at a time
+		WriteBuffer wbMessage( pMessage->getBodyLength() + MSG_MAX_HEADER_LENGTH );
+		pMessage->serializeInto( wbMessage );
+
+		WriteBuffer wbScratch( 0 );
+		Codec::compressFrame( wbMessage, m_uiCodecs, wbScratch );
+
+		unsigned short usStream = m_chunkWriter.beginStream();
+		unsigned int uiOffset = 0;
+
+		while( m_bConnected && uiOffset < wbMessage.size() )
+		{
+			if( uiOffset > 0 )
+				m_chunkWriter.yield();
+
+			m_mxSendBuffer.lock();
+			m_wbSendBuffer.clear();
+			m_chunkWriter.appendChunk( m_wbSendBuffer, usStream, wbMessage.data(), wbMessage.size(), uiOffset );
+			m_pSocketTCP->write( m_wbSendBuffer.data(), m_wbSendBuffer.size() );
+			m_mxSendBuffer.unlock();
+		}
+	}
+
+	/**
+	 * @brief	Sets the size of the chunks that large tcp messages are split into, see ChunkWriter.
+	 *
+	 * @note	Chunks of different messages are interleaved, so a large message only delays the others by one chunk.
+	 *
+	 * @param	uiChunkSize	Messages longer than this are sent in chunks of this size, 0 sends every message at once.
+	 */
+	void DirectConNetwork::setChunkSize( unsigned int uiChunkSize )
+	{
+		m_mxSendBuffer.lock();
+		m_chunkWriter.setChunkSize( uiChunkSize );
+		m_mxSendBuffer.unlock();
+	}
+
+	/**
+	 * @brief	Sets the path MTU that udp messages are split for, see DatagramFragmenter.
+	 *
+	 * @param	uiMTU	The largest ip packet that reaches the other side unfragmented, 0 asks the socket.
+	 */
+	void DirectConNetwork::setPathMTU( unsigned int uiMTU )
+	{
+		m_mxSendBuffer.lock();
+		m_fragmenter.setPathMTU( uiMTU );
+		m_mxSendBuffer.unlock();
+	}
+
+	/**
+	 * @brief	Sets when messages are sent, see Socket::setBatching().
+	 *
+	 * @note	With FP_SizeThreshold call flush() after a burst of messages, with FP_Deadline the receiving thread flushes on time.
+	 *
+	 * @param	ePolicy		The flush policy.
+	 * @param	uiThreshold	The number of bytes for FP_SizeThreshold or the number of microseconds for FP_Deadline.
+	 */
+	void DirectConNetwork::setBatching( Socket::EFlushPolicy ePolicy, unsigned int uiThreshold )
+	{
+		m_mxSendBuffer.lock();
+		m_eFlushPolicy = ePolicy;
+		m_uiFlushThreshold = uiThreshold;
+		m_mxSendBuffer.unlock();
+
+		if( m_bConnected )
+		{
+			applyBatching();
+
+			// the receiving thread has to pick up the new timeout
+			m_reactor.interrupt();
+		}
+	}
+
+	/**
+	 * @brief	Sends all messages that are queued because of the flush policy.
+	 *
+	 * @return	true if it succeeds, false if it fails.
+	 */
+	bool DirectConNetwork::flush()
+	{
+		if( !m_bConnected )
+			return false;
+
+		m_mxSendBuffer.lock();
+		bool bReturn = m_pSocketTCP->flush() & m_pSocketUDPOut->flush();
+		m_mxSendBuffer.unlock();
+
+		return bReturn;
+	}
+
 	/**
 	 * @brief	Registers the listener described by pListener to this network so that the listener will receive all further messages.
 	 *
@@ -246,114 +364,268 @@ namespace oocl
 		// if the listen call was not blocking, call accept here
 		if( !m_bConnected )
 		{
-			m_pSocketTCP = m_pServerSocket->accept();
+			if( !acceptConnection() )
+				return;
 
-			std::string strMsg;
-			m_pSocketTCP->read( strMsg );
+			m_bConnected = true;
+		}
 
-			Message* pMsg = Message::createFromString( strMsg.c_str() );
+		m_reactor.registerSocket( m_pSocketTCP, this );
+		m_reactor.registerSocket( m_pSocketUDPIn, this );
 
-			if( pMsg->getType() != MT_ConnectMessage )
-			{
-				Log::getLog("oocl")->logError("the first received message was not a connectMessage!" );
-				return;
-			}
+		// the reactor blocks until a socket is ready or disconnect() interrupts it
+		while( m_bConnected )
+		{
+			// with the deadline flush policy wake up in time to send the messages that were queued last
+			int iTimeoutMS = -1;
+			if( m_eFlushPolicy == Socket::FP_Deadline )
+				iTimeoutMS = std::max( 1u, (m_uiFlushThreshold+999) / 1000 );
 
-			m_usHostPort = ((ConnectMessage*)pMsg)->getPort();
-			m_pSocketUDPOut->connect( m_pSocketTCP->getConnectedIP(), m_usHostPort );
+			// and in time to retransmit the reliable udp messages that were not acknowledged
+			m_mxSendBuffer.lock();
+			int iResendMS = m_reliable.resendDue( m_bConnected ? m_pSocketUDPOut : NULL, m_fragmenter );
+			m_mxSendBuffer.unlock();
 
-			sendMessage( new ConnectMessage( m_usListeningPort ) );
+			if( iResendMS >= 0 && ( iTimeoutMS < 0 || iResendMS < iTimeoutMS ) )
+				iTimeoutMS = iResendMS;
 
-			m_bConnected = true;
+			if( m_reactor.dispatch( iTimeoutMS ) < 0 && !m_reactor.isValid() )
+				break;
+
+			if( m_eFlushPolicy == Socket::FP_Deadline && m_bConnected )
+			{
+				m_mxSendBuffer.lock();
+				m_pSocketTCP->flushIfDue();
+				m_pSocketUDPOut->flushIfDue();
+				m_mxSendBuffer.unlock();
+			}
 		}
+	}
 
-		// substitution of std::max / max as it is defined different in msvc and gnucc
-		int iBiggestSocket = m_pSocketUDPIn->getCSocket();
-		if( iBiggestSocket < m_pSocketTCP->getCSocket() )
-			iBiggestSocket = m_pSocketTCP->getCSocket();
 
-		fd_set selectSet;
+	/**
+	 * @brief	Waits for the other process to connect and receives its ConnectMessage, used by listen() and run().
+	 *
+	 * @return	true if it succeeds, false if it fails.
+	 */
+	bool DirectConNetwork::acceptConnection()
+	{
+		m_pSocketTCP = m_pServerSocket->accept();
+		if( m_pSocketTCP == NULL )
+			return false;
 
-		while( m_bConnected )
+		// wait for the ConnectMessage, everything sent after it stays in the decoder
+		const char* pcFrame = NULL;
+		unsigned int uiFrameLength = 0;
+		while( !m_frameDecoder.nextFrame( pcFrame, uiFrameLength ) )
 		{
-			FD_ZERO( &selectSet );
-			FD_SET( m_pSocketUDPIn->getCSocket(), &selectSet );
-			FD_SET( m_pSocketTCP->getCSocket(), &selectSet );
-
-			timeval tv;
-			tv.tv_sec = 0;
-			tv.tv_usec = 500000;
-
-			int iRet = select( iBiggestSocket+1, &selectSet, NULL, NULL, &tv );
-#ifdef _MSC_VER
-			if( iRet == SOCKET_ERROR )
-#else
-			if( iRet < 0 )
-#endif
+			if( m_frameDecoder.receive( m_pSocketTCP ) == 0 )
 			{
-				Log::getLog("oocl")->logError( "Selecting failed" );
-				continue;
+				OOCL_LOG_ERROR( "oocl", "the connection was closed before a connectMessage was received!" );
+				return false;
 			}
-			else if( iRet == 0 )
-				continue;
+		}
 
-			if( FD_ISSET( m_pSocketTCP->getCSocket(), &selectSet ) )
-			{
-				std::string strMsg;
-				m_pSocketTCP->read( strMsg );
+		Message* pMsg = Message::createFromString( pcFrame );
+		MessagePtr ptrMsg( pMsg );
 
-				while( !strMsg.empty() )
-				{
-					Message* pMsg = Message::createFromString( strMsg.c_str() );
-					if( pMsg == NULL )
-						break;
+		if( pMsg == NULL || pMsg->getType() != MT_ConnectMessage )
+		{
+			OOCL_LOG_ERROR( "oocl", "the first received message was not a connectMessage!" );
+			return false;
+		}
+
+		m_usHostPort = ((ConnectMessage*)pMsg)->getPort();
+		m_uiCodecs = ((ConnectMessage*)pMsg)->getCodecs() & Codec::getSupportedCodecs();
+		m_pSocketUDPOut->connect( m_pSocketTCP->getConnectedIP(), m_usHostPort );
+
+		sendMessage( new ConnectMessage( m_usListeningPort, 0, Codec::getSupportedCodecs() ) );
+		applyBatching();
 
-					if( strMsg.length() < pMsg->getBodyLength() + 4 )
-						Log::getLogRef("oocl") << Log::EL_WARNING << "read " << (int)strMsg.length() << " bytes while expected message is " << pMsg->getBodyLength() + 4 << " bytes long" << oocl::endl;
+		return true;
+	}
 
-					strMsg = strMsg.substr( pMsg->getBodyLength() +4 );
 
-					if( pMsg->getType() == MT_DisconnectMessage )
-					{
-						m_bConnected = false;
+	/**
+	 * @brief	Called by the reactor whenever the tcp or the udp socket is readable.
+	 *
+	 * @param [in]	pSocket 	The socket that is ready.
+	 * @param [in]	pContext	Unused.
+	 */
+	void DirectConNetwork::cbReadable( SocketStub* pSocket, void* /*pContext*/ )
+	{
+		if( pSocket == m_pSocketTCP )
+			receiveFromTCP();
+		else if( pSocket == m_pSocketUDPIn )
+			receiveFromUDP();
+	}
+
+
+	/**
+	 * @brief	Receives everything that is available on the tcp socket and delivers all complete messages.
+	 *
+	 * @note	An incomplete message stays in the receive buffer until the rest arrives.
+	 */
+	void DirectConNetwork::receiveFromTCP()
+	{
+		const char* pcFrame = NULL;
+		unsigned int uiFrameLength = 0;
+
+		// the notification is edge-triggered, so receive until nothing is left; messages that are
+		// not complete yet stay in the decoder until the next notification
+		do
+		{
+			while( m_bConnected && m_frameDecoder.nextFrame( pcFrame, uiFrameLength ) )
+			{
+				MessageView view( pcFrame );
 
-						m_pSocketUDPIn->close();
-						m_pSocketUDPOut->close();
-						m_pSocketTCP->close();
-					}
+				// the answer to our ConnectMessage tells which codecs we may use
+				if( view.getType() == MT_ConnectMessage )
+					m_uiCodecs = view.getField<unsigned int>( ConnectMessage::Offset2 ) & Codec::getSupportedCodecs();
 
-					std::list< MessageListener* > lWaitList( m_lListeners );
+				if( view.getType() == MT_DisconnectMessage )
+				{
+					m_bConnected = false;
 
-					for( std::list<MessageListener*>::iterator it = lWaitList.begin(); it != lWaitList.end(); it = lWaitList.erase( it ) )
-					{
-						if( !(*it)->cbMessage( pMsg ) )
-							lWaitList.push_back( (*it) );
-					}
+					m_reactor.unregisterSocket( m_pSocketUDPIn );
+					m_reactor.unregisterSocket( m_pSocketTCP );
 
-					MessageBroker::getBrokerFor(pMsg->getType())->pumpMessage( pMsg );
+					m_pSocketUDPIn->close();
+					m_pSocketUDPOut->close();
+					m_pSocketTCP->close();
 				}
+
+				deliverMessage( view );
 			}
+		} while( m_bConnected && m_frameDecoder.receive( m_pSocketTCP ) > 0 );
+
+		if( m_bConnected && !m_pSocketTCP->isConnected() )
+		{
+			OOCL_LOG_WARNING( "oocl", "the connection was lost" );
+			m_bConnected = false;
+		}
+	}
+
 
-			if( FD_ISSET( m_pSocketUDPIn->getCSocket(), &selectSet ) )
+	/**
+	 * @brief	Receives and delivers all pending datagrams on the udp socket.
+	 */
+	void DirectConNetwork::receiveFromUDP()
+	{
+		while( m_bConnected && m_pSocketUDPIn->readDatagrams( m_dsReceiveSlab ) > 0 )
+		{
+			for( unsigned int i = 0; i < m_dsReceiveSlab.size(); i++ )
 			{
-				std::string strMsg;
-				m_pSocketUDPIn->read( strMsg );
+				if( m_dsReceiveSlab.getLength( i ) < 4 || m_dsReceiveSlab.isTruncated( i ) )
+				{
+					OOCL_LOG_WARNING( "oocl", "an invalid message was received on udp" );
+					continue;
+				}
 
-				Message* pMsg = Message::createFromString( strMsg.c_str() );
-				if( pMsg == NULL )
+				MessageView view( m_dsReceiveSlab.getDatagram( i ) );
+				if( view.getBodyLength() > m_dsReceiveSlab.getLength( i ) || view.getHeaderLength() + view.getBodyLength() > m_dsReceiveSlab.getLength( i ) )
+				{
+					OOCL_LOG_WARNING( "oocl", "an invalid message was received on udp" );
 					continue;
+				}
+
+				receiveFrame( view );
+			}
 
-				MessageBroker::getBrokerFor(pMsg->getType())->pumpMessage( pMsg );
+			// one acknowledgement for the whole batch
+			if( m_reliable.isAckPending() )
+			{
+				m_mxSendBuffer.lock();
+				m_wbSendBuffer.clear();
+				m_reliable.appendAck( m_wbSendBuffer );
+				m_pSocketUDPOut->write( m_wbSendBuffer.data(), m_wbSendBuffer.size() );
+				m_pSocketUDPOut->flush();
+				m_mxSendBuffer.unlock();
+			}
+		}
+	}
 
-				std::list< MessageListener* > lWaitList( m_lListeners );
 
-				for( std::list<MessageListener*>::iterator it = lWaitList.begin(); it != lWaitList.end(); it = lWaitList.erase( it ) )
-				{
-					if( !(*it)->cbMessage( pMsg ) )
-						lWaitList.push_back( (*it) );
-				}
+	/**
+	 * @brief	Delivers a frame received on udp or passes it on to the reliable channel or the fragmenter.
+	 *
+	 * @param [in]	view	The received frame.
+	 */
+	void DirectConNetwork::receiveFrame( const MessageView& view )
+	{
+		switch( view.getType() )
+		{
+		case MT_ReliableFrame:
+		case MT_AckFrame:
+			receiveReliable( view );
+			break;
+		case MT_FragmentFrame:
+			{
+				const char* pcFrame = NULL;
+				unsigned int uiFrameLength = 0;
+
+				if( m_fragmenter.receive( view.getFrame(), view.getHeaderLength() + view.getBodyLength(), pcFrame, uiFrameLength ) )
+					receiveFrame( MessageView( pcFrame ) );
+				break;
 			}
+		default:
+			deliverMessage( view );
+			break;
+		}
+	}
+
+
+	/**
+	 * @brief	Passes a frame of the reliable udp channel to it and delivers the messages that are complete now.
+	 *
+	 * @param [in]	view	The MT_ReliableFrame or MT_AckFrame.
+	 */
+	void DirectConNetwork::receiveReliable( const MessageView& view )
+	{
+		if( !m_reliable.receive( view.getFrame(), view.getHeaderLength() + view.getBodyLength() ) )
+		{
+			OOCL_LOG_WARNING( "oocl", "an invalid reliable frame was received on udp" );
+			return;
 		}
+
+		const char* pcFrame = NULL;
+		unsigned int uiFrameLength = 0;
+		while( m_reliable.nextMessage( pcFrame, uiFrameLength ) )
+			deliverMessage( MessageView( pcFrame ) );
+	}
+
+
+	/**
+	 * @brief	Applies the flush policy to the outgoing sockets once they are connected.
+	 */
+	void DirectConNetwork::applyBatching()
+	{
+		m_mxSendBuffer.lock();
+		m_pSocketTCP->setBatching( m_eFlushPolicy, m_uiFlushThreshold );
+		m_pSocketUDPOut->setBatching( m_eFlushPolicy, m_uiFlushThreshold );
+		m_mxSendBuffer.unlock();
+	}
+
+
+	/**
+	 * @brief	Delivers a received message to the registered listeners and to the MessageBroker of its type.
+	 *
+	 * @note	The message is only created if a listener or the broker needs it, they share it then.
+	 *
+	 * @param [in]	view	The received message, still in the receive buffer.
+	 */
+	void DirectConNetwork::deliverMessage( const MessageView& view )
+	{
+		std::list< MessageListener* > lWaitList( m_lListeners );
+
+		for( std::list<MessageListener*>::iterator it = lWaitList.begin(); it != lWaitList.end(); it = lWaitList.erase( it ) )
+		{
+			if( !(*it)->cbMessageView( view ) )
+				lWaitList.push_back( (*it) );
+		}
+
+		if( MessageBroker::hasListenersFor( view.getType() ) )
+			MessageBroker::getBrokerFor( view.getType() )->pumpMessage( view );
 	}
 
 }
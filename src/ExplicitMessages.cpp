@@ -22,69 +22,33 @@ namespace oocl
 	// ******************** StandardMessage *********************
 
 	/**
-	 * @brief	Constructor for c-style strings.
-	 *
-	 * @param	cMsgBody	The message body.
-	 * @param	length  	Length of the body.
-	 */
-	StandardMessage::StandardMessage( const char * cMsgBody, unsigned short length  ) :
-		m_strMsgBody( std::string(cMsgBody, length) )
-	{
-		m_iProtocoll = SOCK_STREAM;
-		m_type = MT_StandardMessage;
-	}
-
-
-	/**
-	 * @brief	Constructor for c++ strings.
-	 *
-	 * @param	strMsgBody	The message body.
+	 * @brief	Default constructor, used for received messages.
 	 */
-	StandardMessage::StandardMessage( std::string strMsgBody  ) :
-		m_strMsgBody( strMsgBody )
+	StandardMessage::StandardMessage()
 	{
-		m_iProtocoll = SOCK_STREAM;
-		m_type = MT_StandardMessage;
 	}
 
 
 	/**
-	 * @brief	Returns the message as string.
-	 *
-	 * @return	The message string.
-	 */
-	std::string StandardMessage::getMsgString() const
-	{
-		unsigned short usTemp[2];
-		usTemp[0] = m_type;
-		usTemp[1] = getBodyLength();
-		std::string strHeader( (char*)usTemp, 4 );
-
-		return strHeader + m_strMsgBody;
-	}
-
-
-	/**
-	 * @brief	Returns the size in bytes of the message body (message without header).
+	 * @brief	Constructor for c-style strings.
 	 *
-	 * @return	The body length in byte.
+	 * @param	cMsgBody	The message body.
+	 * @param	length  	Length of the body.
 	 */
-	unsigned short StandardMessage::getBodyLength() const
+	StandardMessage::StandardMessage( const char * cMsgBody, unsigned int length  )
 	{
-		return m_strMsgBody.length();
+		m_value0.assign( cMsgBody, length );
 	}
 
 
 	/**
-	 * @brief	Creates this message out of the received byte array.
-	 *
-	 * @param	in	The incoming byte buffer.
+	 * @brief	Constructor for c++ strings.
 	 *
-	 * @return	a new StandardMessage built from in.
+	 * @param	strMsgBody	The message body.
 	 */
-	Message* StandardMessage::create(const char * in)
+	StandardMessage::StandardMessage( std::string strMsgBody  )
 	{
-		return new StandardMessage( &(in[4]), ((unsigned short*)in)[1] );
+		m_value0 = strMsgBody;
 	}
 	
 
@@ -95,51 +59,9 @@ namespace oocl
 	 *
 	 * @param	usTypeToSubscribe	The type to subscribe.
 	 */
-	SubscribeMessage::SubscribeMessage( unsigned short usTypeToSubscribe ) :
-		m_usTypeToSubscribe( usTypeToSubscribe )
+	SubscribeMessage::SubscribeMessage( unsigned short usTypeToSubscribe )
 	{
-		m_iProtocoll = SOCK_STREAM;
-		m_type = MT_SubscribeMessage;
-	}
-
-
-	/**
-	 * @brief	Returns the message as string.
-	 *
-	 * @return	The message as string.
-	 */
-	std::string SubscribeMessage::getMsgString() const
-	{
-		unsigned short usMsg[3];
-		usMsg[0] = MT_SubscribeMessage;
-		usMsg[1] = getBodyLength();
-		usMsg[2] = m_usTypeToSubscribe;
-
-		return std::string( (char*)usMsg, 6 );
-	}
-
-
-	/**
-	 * @brief	Returns the size in bytes of the message body (message without header).
-	 *
-	 * @return	The body length in byte.
-	 */
-	unsigned short SubscribeMessage::getBodyLength() const
-	{
-		return sizeof(unsigned short);
-	}
-
-
-	/**
-	 * @brief	Creates this message out of the received byte array.
-	 *
-	 * @param	in	The incoming byte buffer.
-	 *
-	 * @return	a new SubscribeMessage built from in.
-	 */
-	Message* SubscribeMessage::create(const char * in)
-	{
-		return new SubscribeMessage( ((unsigned short*)in)[2] );
+		m_value0 = usTypeToSubscribe;
 	}
 	
 
@@ -150,56 +72,13 @@ namespace oocl
 	 *
 	 * @param	usMyPort	my port.
 	 * @param	uiPeerID	Identifier for the peer.
+	 * @param	uiCodecs	The codecs this process can decompress.
 	 */
-	ConnectMessage::ConnectMessage( unsigned short usMyPort, unsigned int uiPeerID ) :
-		m_usPort( usMyPort ),
-		m_uiPeerID( uiPeerID )
-	{
-		m_iProtocoll = SOCK_STREAM;
-		m_type = MT_ConnectMessage;
-	}
-
-
-	/**
-	 * @brief	Returns the message as string.
-	 *
-	 * @return	The message as string.
-	 */
-	std::string ConnectMessage::getMsgString() const
-	{
-		unsigned short usMsg[3];
-		usMsg[0] = MT_ConnectMessage;
-		usMsg[1] = getBodyLength();
-		usMsg[2] = m_usPort;
-
-		return std::string( (char*)usMsg, 6 ) + std::string( (char*)&m_uiPeerID, sizeof(int) );
-	}
-
-
-	/**
-	 * @brief	Returns the size in bytes of the message body (message without header).
-	 *
-	 * @return	The body length in byte.
-	 */
-	unsigned short ConnectMessage::getBodyLength() const
-	{
-		return sizeof(short)+sizeof(int);
-	}
-
-
-	/**
-	 * @brief	Creates this message out of the received byte array.
-	 *
-	 * @param	in	The incoming byte buffer.
-	 *
-	 * @return	a new ConnectMessage built from in.
-	 */
-	Message* ConnectMessage::create(const char * in)
+	ConnectMessage::ConnectMessage( unsigned short usMyPort, unsigned int uiPeerID, unsigned int uiCodecs )
 	{
-		unsigned short usMyPort = ((unsigned short*)in)[2];
-		unsigned int uiPeerID = *((unsigned int*)&in[6]);
-
-		return new ConnectMessage( usMyPort, uiPeerID );
+		m_value0 = usMyPort;
+		m_value1 = uiPeerID;
+		m_value2 = uiCodecs;
 	}
 
 
@@ -211,47 +90,6 @@ namespace oocl
 	 */
 	DisconnectMessage::DisconnectMessage()
 	{
-		m_iProtocoll = SOCK_STREAM;
-		m_type = MT_DisconnectMessage;
-	}
-
-
-	/**
-	 * @brief	Returns the message as string.
-	 *
-	 * @return	The message as string.
-	 */
-	std::string DisconnectMessage::getMsgString() const
-	{
-		unsigned short usMsg[2];
-		usMsg[0] = MT_DisconnectMessage;
-		usMsg[1] = getBodyLength();
-
-		return std::string( (char*)usMsg, 4 );
-	}
-
-
-	/**
-	 * @brief	Returns the size in bytes of the message body (message without header).
-	 *
-	 * @return	The body length in byte.
-	 */
-	unsigned short DisconnectMessage::getBodyLength() const
-	{
-		return 0;
-	}
-
-
-	/**
-	 * @brief	Creates this message out of the received byte array.
-	 *
-	 * @param	in	The incoming byte buffer.
-	 *
-	 * @return	a new DisconnectMessage built from in.
-	 */
-	Message* DisconnectMessage::create(const char * in)
-	{
-		return new DisconnectMessage();
 	}
 
 
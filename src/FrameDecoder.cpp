@@ -0,0 +1,195 @@
+/*
+Object Oriented Communication Library
+Copyright (c) 2011 Jürgen Lorenz and Jörn Teuber
+
+This software is provided 'as-is', without any express or implied warranty.
+In no event will the authors be held liable for any damages arising from the use of this software.
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it freely,
+subject to the following restrictions:
+
+1. The origin of this software must not be misrepresented; you must not claim that you wrote the original software. If you use this software in a product, an acknowledgment in the product documentation would be appreciated but is not required.
+2. Altered source versions must be plainly marked as such, and must not be misrepresented as being the original software.
+3. This notice may not be removed or altered from any source distribution.
+*/
+// This file was written by Jörn Teuber
+
+#include "FrameDecoder.h"
+#include "Message.h"
+
+namespace oocl
+{
+	/**
+	 * @brief	Constructor.
+	 *
+	 * @param	uiCapacity	The initial size of the receive buffer, it grows if a single message does not fit.
+	 */
+	FrameDecoder::FrameDecoder( unsigned int uiCapacity )
+		: m_rbBuffer( uiCapacity )
+	{
+	}
+
+
+	/**
+	 * @brief	Receives once from the socket directly into the receive buffer.
+	 *
+	 * @note	On a blocking socket this blocks until some data arrived.
+	 *
+	 * @param [in]	pSocket	The socket to receive from.
+	 *
+	 * @return	The number of received bytes, 0 if nothing was available or the socket failed.
+	 */
+	int FrameDecoder::receive( Socket* pSocket )
+	{
+		if( m_rbBuffer.space() == 0 )
+			m_rbBuffer.reserve( m_rbBuffer.capacity() * 2 );
+
+		unsigned int uiLength = 0;
+		char* pcRegion = m_rbBuffer.writeRegion( uiLength );
+
+		int iCount = (int)uiLength;
+		if( !pSocket->read( pcRegion, iCount ) || iCount <= 0 )
+			return 0;
+
+		m_rbBuffer.commit( iCount );
+
+		return iCount;
+	}
+
+
+	/**
+	 * @brief	Get the next complete message from the receive buffer and remove it from the buffer.
+	 *
+	 * @note	The returned frame points into the receive buffer and stays valid until the next call of any method of this decoder.
+	 *
+	 * @param [out]	pcFrame 	The complete message including its header, ready for Message::createFromString().
+	 * @param [out]	uiLength	The length of the message including its header.
+	 *
+	 * @return	true if a complete message was available, false if more data has to be received first.
+	 */
+	bool FrameDecoder::nextFrame( const char*& pcFrame, unsigned int& uiLength )
+	{
+		for(;;)
+		{
+			if( m_rbBuffer.size() < 4 )
+				return false;
+
+			// | Type  |Length | Messagebody
+			// |2 byte |2 byte |   |   ....
+			// or with the extended header
+			// | Type  | 0xFFFF |Length | Messagebody
+			// |2 byte | 2 byte |4 byte |   |   ....
+			char acHeader[MSG_MAX_HEADER_LENGTH];
+			unsigned int uiHeaderLength = m_rbBuffer.size() < MSG_MAX_HEADER_LENGTH ? m_rbBuffer.size() : MSG_MAX_HEADER_LENGTH;
+			m_rbBuffer.peek( acHeader, uiHeaderLength );
+
+			unsigned short usBodyLength = 0;
+			std::memcpy( &usBodyLength, acHeader + 2, sizeof(unsigned short) );
+			if( usBodyLength == MSG_EXTENDED_LENGTH && uiHeaderLength < MSG_MAX_HEADER_LENGTH )
+				return false;
+
+			unsigned int uiBodyLength = 0;
+			uiHeaderLength = Message::readHeader( acHeader, uiBodyLength );
+
+			unsigned int uiFrameLength = uiHeaderLength + uiBodyLength;
+			if( m_rbBuffer.size() < uiFrameLength )
+			{
+				// make room for the rest of the message
+				m_rbBuffer.reserve( uiFrameLength );
+				return false;
+			}
+
+			const char* pcBuffered = m_rbBuffer.linearize( uiFrameLength );
+
+			// the bytes stay untouched until the buffer is written to again
+			m_rbBuffer.consume( uiFrameLength );
+
+			unsigned short usType = 0;
+			std::memcpy( &usType, acHeader, sizeof(unsigned short) );
+
+			if( usType != MT_ChunkFrame )
+			{
+				pcFrame = pcBuffered;
+				uiLength = uiFrameLength;
+			}
+			else if( !appendChunk( pcBuffered + uiHeaderLength, uiBodyLength, pcFrame, uiLength ) )
+				continue;
+
+			std::memcpy( &usType, pcFrame, sizeof(unsigned short) );
+			if( usType != MT_CompressedFrame )
+				return true;
+
+			if( Codec::decompressFrame( pcFrame, uiLength, m_strInflated ) )
+			{
+				pcFrame = m_strInflated.data();
+				uiLength = m_strInflated.size();
+				return true;
+			}
+
+			OOCL_LOG_WARNING( "oocl", "a compressed message could not be decompressed" );
+		}
+	}
+
+
+	/**
+	 * @brief	Adds a received chunk to its stream.
+	 *
+	 * @param	pcBody				The body of the chunk frame: the stream ID and a piece of the message.
+	 * @param	uiBodyLength		The length of the body.
+	 * @param [out]	pcFrame 		The message, if this was its last chunk.
+	 * @param [out]	uiLength		The length of the message including its header.
+	 *
+	 * @return	true if the message of the stream is complete now.
+	 */
+	bool FrameDecoder::appendChunk( const char* pcBody, unsigned int uiBodyLength, const char*& pcFrame, unsigned int& uiLength )
+	{
+		if( uiBodyLength < 2 )
+			return false;
+
+		unsigned short usStream = 0;
+		std::memcpy( &usStream, pcBody, sizeof(unsigned short) );
+
+		std::string& strStream = m_mapStreams[usStream];
+		strStream.append( pcBody + 2, uiBodyLength - 2 );
+
+		// the first chunk starts with the header of the message, which tells when the stream is complete
+		if( strStream.size() < MSG_MAX_HEADER_LENGTH )
+			return false;
+
+		unsigned int uiMessageLength = 0;
+		unsigned int uiHeaderLength = Message::readHeader( strStream.data(), uiMessageLength );
+		if( strStream.size() < uiHeaderLength + uiMessageLength )
+			return false;
+
+		m_strComplete.swap( strStream );
+		m_mapStreams.erase( usStream );
+
+		pcFrame = m_strComplete.data();
+		uiLength = m_strComplete.size();
+
+		return true;
+	}
+
+
+	/**
+	 * @brief	Exchanges the buffered bytes of two decoders, e.g. when a connection is handed over to a new owner.
+	 *
+	 * @param [in,out]	other	The decoder to swap with.
+	 */
+	void FrameDecoder::swap( FrameDecoder& other )
+	{
+		m_rbBuffer.swap( other.m_rbBuffer );
+		m_mapStreams.swap( other.m_mapStreams );
+	}
+
+
+	/**
+	 * @brief	Discards all buffered bytes.
+	 */
+	void FrameDecoder::clear()
+	{
+		m_rbBuffer.clear();
+		m_mapStreams.clear();
+	}
+
+}
@@ -14,7 +14,14 @@ subject to the following restrictions:
 */
 // This file was written by Jörn Teuber
 
+#include <stdio.h>
+#include <stdarg.h>
+#include <string.h>
+
 #include "Log.h"
+#include "LogWriter.h"
+#include "BinaryLogFile.h"
+#include "Mutex.h"
 
 namespace oocl
 {
@@ -24,6 +31,17 @@ namespace oocl
 	std::string Log::sm_astrLogLevelToPrefix[] = { " INFO       : ", " WARNING    : ", " ERROR      : ", " FATAL ERROR: " };
 
 
+	/**
+	 * @brief	Get the mutex that protects Log::sm_mapLogs, it is created on first use as a log might be requested
+	 * 			during static initialization.
+	 */
+	static Mutex& getLogsMutex()
+	{
+		static Mutex s_mxLogs;
+		return s_mxLogs;
+	}
+
+
 	/**
 	 * @brief	Constructor.
 	 *
@@ -32,8 +50,22 @@ namespace oocl
 	Log::Log( std::string strLogName ) 
 		: m_elLowestLoggedLevel( EL_INFO )
 		, m_elLastStreamLogLvl( EL_INFO )
+		, m_strLogName( strLogName )
 		, m_bFlushing( false )
+		, m_bAsync( false )
+		, m_bBinary( false )
+		, m_pmxWrite( new Mutex() )
+		, m_pBinaryFile( NULL )
+		, m_bLimited( false )
+		, m_uiDroppedRecords( 0 )
 	{
+		for( unsigned int i = 0; i <= sm_uiMaxLogLevel; i++ )
+		{
+			m_allInterval[i] = 0;
+			m_allBurst[i] = 0;
+			m_auiSampling[i] = 1;
+		}
+
 		m_fsLogFile.open( std::string(strLogName+std::string(".log")).c_str() );
 	}
 
@@ -45,27 +77,39 @@ namespace oocl
 	{
 		flush();
 		m_fsLogFile.close();
+
+		delete m_pmxWrite;
+		delete m_pBinaryFile;
 	}
 
 
 	/**
 	 * @brief	get the log with the given name.
 	 *
+	 * @note	Logs are never deleted, so the returned pointer can be kept instead of calling this method again.
+	 *
 	 * @param	strLogName	Name of the log.
 	 *
 	 * @return	null if it fails, else the log.
 	 */
-	Log* Log::getLog( std::string strLogName )
+	Log* Log::getLog( const std::string& strLogName )
 	{
+		Log* pLog = NULL;
+
+		getLogsMutex().lock();
+
 		std::map< std::string, Log* >::iterator it = sm_mapLogs.find( strLogName );
 		if( it == sm_mapLogs.end() )
 		{
-			Log* pLog = new Log(strLogName);
+			pLog = new Log(strLogName);
 			sm_mapLogs.insert( std::pair<std::string, Log* >( strLogName, pLog ) );
-			return pLog;
 		}
 		else
-			return it->second;
+			pLog = it->second;
+
+		getLogsMutex().unlock();
+
+		return pLog;
 	}
 	
 	/**
@@ -75,7 +119,7 @@ namespace oocl
 	 *
 	 * @return	null if it fails, else the log.
 	 */
-	Log& Log::getLogRef( std::string strLogName )
+	Log& Log::getLogRef( const std::string& strLogName )
 	{	
 		return *getLog( strLogName );
 	}
@@ -116,7 +160,7 @@ namespace oocl
 	/**
 	 * @brief	Logs a message as info if no second parameter is given.
 	 * 			
-	 * @note	in debug mode every message will be written to the standard output and directly to the logfile.
+	 * @note	The message is written as a whole by write(), so this can be called from any thread.
 	 *
 	 * @param	strMessage 		Message to log
 	 * @param	elErrorLevel	(optional) error level.
@@ -128,14 +172,7 @@ namespace oocl
 		if( elErrorLevel < m_elLowestLoggedLevel || elErrorLevel > sm_uiMaxLogLevel )
 			return false;
 
-		std::string strPrefix = sm_astrLogLevelToPrefix[elErrorLevel];
-
-		m_strLogText += strPrefix + strMessage + "\n";
-
-		std::cout << m_strLogText;
-		flush();
-
-		return true;
+		return write( elErrorLevel, strMessage.data(), strMessage.size() );
 	}
 
 
@@ -151,12 +188,7 @@ namespace oocl
 		if( m_elLowestLoggedLevel > EL_INFO )
 			return false;
 
-		m_strLogText += getTime() + " INFO       : " + strInfo + "\n";
-
-		std::cout << m_strLogText;
-		flush();
-
-		return true;
+		return write( EL_INFO, strInfo.data(), strInfo.size() );
 	}
 
 
@@ -172,12 +204,7 @@ namespace oocl
 		if( m_elLowestLoggedLevel > EL_WARNING )
 			return false;
 
-		m_strLogText += getTime() + " WARNING    : " + strWarning + "\n";
-
-		std::cout << m_strLogText;
-		flush();
-
-		return true;
+		return write( EL_WARNING, strWarning.data(), strWarning.size() );
 	}
 	
 
@@ -193,12 +220,7 @@ namespace oocl
 		if( m_elLowestLoggedLevel > EL_ERROR )
 			return false;
 
-		m_strLogText += getTime() + " ERROR      : " + strError + "\n";
-
-		std::cout << m_strLogText;
-		flush();
-
-		return true;
+		return write( EL_ERROR, strError.data(), strError.size() );
 	}
 	
 
@@ -214,26 +236,86 @@ namespace oocl
 		if( m_elLowestLoggedLevel > EL_FATAL_ERROR )
 			return false;
 
-		m_strLogText += getTime() + " FATAL ERROR: " + strError + "\n";
+		return write( EL_FATAL_ERROR, strError.data(), strError.size() );
+	}
 
-		std::cout << m_strLogText;
-		flush();
 
-		return true;
+	/**
+	 * @brief	Logs a message of the OOCL_LOGF macros.
+	 *
+	 * @note	In binary mode only the raw arguments are written, otherwise the message is formatted into a
+	 * 			LOG_LINE_LENGTH buffer, longer messages are cut.
+	 *
+	 * @param	format  	The format of the call site.
+	 * @param	pcFormat	The printf format, the same as the one of format.
+	 *
+	 * @return	true if the message was logged, false if not.
+	 */
+	bool Log::logFormat( const LogFormat& format, const char* pcFormat, ... )
+	{
+		if( !isLogged( format.getErrorLevel() ) )
+			return false;
+
+		bool bLogged = false;
+
+		va_list args;
+		va_start( args, pcFormat );
+
+		if( m_bBinary && format.isValid() )
+		{
+			char acRecord[BLF_MAX_RECORD_LENGTH];
+			unsigned int uiLength = format.encode( acRecord, sizeof(acRecord), args );
+			bLogged = m_pBinaryFile->write( acRecord, uiLength );
+		}
+		else
+		{
+			char acText[LOG_LINE_LENGTH];
+			int iLength = vsnprintf( acText, sizeof(acText), pcFormat, args );
+
+			// vsnprintf returns the length the text would have had, but always terminates it
+			if( iLength >= (int)sizeof(acText) )
+				iLength = sizeof(acText) - 1;
+
+			if( iLength >= 0 )
+				bLogged = write( format.getErrorLevel(), acText, iLength );
+		}
+
+		va_end( args );
+
+		return bLogged;
 	}
 
 
 	/**
 	 * @brief	writes the current log to the file so that it is safe.
+	 *
+	 * @note	In asynchronous mode this blocks until the LogWriter wrote all messages that were logged before.
+	 * 			In binary mode this writes the current file to the disk.
 	 */
 	void Log::flush()
 	{
+		if( m_bBinary )
+		{
+			m_pBinaryFile->flush();
+			return;
+		}
+
+		if( m_bAsync )
+		{
+			LogWriter::getInstance()->flush();
+			return;
+		}
+
+		m_pmxWrite->lock();
+
 		std::cout.flush();
 
 		m_fsLogFile << m_strLogText;
 		m_fsLogFile.flush();
 
 		m_strLogText.clear();
+
+		m_pmxWrite->unlock();
 	}
 
 
@@ -249,6 +331,106 @@ namespace oocl
 	{
 		m_elLowestLoggedLevel = elLowestLoggedLevel; 
 	}
+
+
+	/**
+	 * @brief	Switches between synchronous and asynchronous mode.
+	 *
+	 * @note	In asynchronous mode the logging methods only copy the message into a lock-free buffer, and a background
+	 * 			LogWriter writes all buffered messages in batches. This is much faster, but a message is written
+	 * 			up to LOG_WRITE_INTERVAL milliseconds later, and messages are dropped if the writer can not keep up.
+	 * 			Messages longer than LOG_RECORD_TEXT_LENGTH are cut. Call flush() to wait until everything logged
+	 * 			so far is written.
+	 *
+	 * @param	bAsync	true to log asynchronously, false to write every message before the logging method returns.
+	 */
+	void Log::setAsync( bool bAsync )
+	{
+		if( bAsync == m_bAsync )
+			return;
+
+		flush();
+		m_bAsync = bAsync;
+
+		// write the messages that were queued right before the switch
+		if( !bAsync )
+			LogWriter::getInstance()->flush();
+	}
+
+
+	/**
+	 * @brief	Switches between text and binary mode.
+	 *
+	 * @note	In binary mode all messages are written to the memory-mapped files "<log name>.<n>.blog", see
+	 * 			BinaryLogFile, instead of the standard output and the text log. A message of the OOCL_LOGF macros
+	 * 			then only costs a copy of its raw arguments, all other messages are stored as text.
+	 * 			Use oocl_logdump to read the files. Binary mode takes precedence over asynchronous mode.
+	 *
+	 * @param	bBinary	true to log in binary mode, false to log text.
+	 *
+	 * @return	true if it succeeds, false if the binary log file could not be created.
+	 */
+	bool Log::setBinary( bool bBinary )
+	{
+		// the file is kept when switching back, as other threads might still be writing to it
+		if( bBinary && !m_pBinaryFile )
+			m_pBinaryFile = new BinaryLogFile( m_strLogName );
+
+		if( bBinary && !m_pBinaryFile->isOpen() )
+			return false;
+
+		if( bBinary != m_bBinary )
+		{
+			flush();
+			m_bBinary = bBinary;
+		}
+
+		return true;
+	}
+
+
+	/**
+	 * @brief	Limits how many messages every call site of the OOCL_LOG macros may log with the given error level.
+	 *
+	 * @note	Each call site may log uiBurst messages at once and then uiMessagesPerSecond messages per second, the
+	 * 			others are dropped. The next message of a call site that is logged is preceded by the number of
+	 * 			messages it dropped. The other logging methods are not limited.
+	 *
+	 * @param	elErrorLevel	   	The error level.
+	 * @param	uiMessagesPerSecond	The messages per second, 0 to remove the limit.
+	 * @param	uiBurst			   	(optional) the messages that may be logged at once.
+	 */
+	void Log::setRateLimit( EErrorLevel elErrorLevel, unsigned int uiMessagesPerSecond, unsigned int uiBurst )
+	{
+		if( elErrorLevel > sm_uiMaxLogLevel )
+			return;
+
+		long long llInterval = uiMessagesPerSecond > 0 ? BinaryLogFile::getTicksPerSecond() / uiMessagesPerSecond : 0;
+
+		m_allInterval[elErrorLevel] = llInterval;
+		m_allBurst[elErrorLevel] = llInterval * (uiBurst > 0 ? uiBurst : 1);
+
+		updateLimited();
+	}
+
+
+	/**
+	 * @brief	Logs only one in uiOneIn messages of every call site of the OOCL_LOG macros with the given error level.
+	 *
+	 * @note	The messages that are left out are counted like those dropped by the rate limit, see setRateLimit().
+	 *
+	 * @param	elErrorLevel	The error level.
+	 * @param	uiOneIn			Log every uiOneIn-th message, 0 or 1 to log all of them.
+	 */
+	void Log::setSampling( EErrorLevel elErrorLevel, unsigned int uiOneIn )
+	{
+		if( elErrorLevel > sm_uiMaxLogLevel )
+			return;
+
+		m_auiSampling[elErrorLevel] = uiOneIn > 0 ? uiOneIn : 1;
+
+		updateLimited();
+	}
 	
 	/**
 	 * @brief	Inserts the error level prefix into the log "stream"
@@ -259,7 +441,8 @@ namespace oocl
      */
 	Log& Log::operator << (const EErrorLevel eLvl)
 	{
-		if( eLvl <= sm_uiMaxLogLevel )
+		// in asynchronous and binary mode time and level are added when the message is written
+		if( eLvl <= sm_uiMaxLogLevel && !m_bAsync && !m_bBinary )
 		{
 			m_ssLogStream << getTime() + sm_astrLogLevelToPrefix[eLvl];
 		}
@@ -454,6 +637,152 @@ namespace oocl
 	}
 
 
+	/**
+	 * @brief	Get the format binary logs store text messages with.
+	 *
+	 * @param	elErrorLevel	The error level of the message.
+	 */
+	static const LogFormat& getTextFormat( Log::EErrorLevel elErrorLevel )
+	{
+		static const LogFormat s_lfInfo( __FILE__, __LINE__, Log::EL_INFO, "%s" );
+		static const LogFormat s_lfWarning( __FILE__, __LINE__, Log::EL_WARNING, "%s" );
+		static const LogFormat s_lfError( __FILE__, __LINE__, Log::EL_ERROR, "%s" );
+		static const LogFormat s_lfFatalError( __FILE__, __LINE__, Log::EL_FATAL_ERROR, "%s" );
+
+		switch( elErrorLevel )
+		{
+		case Log::EL_INFO:		return s_lfInfo;
+		case Log::EL_WARNING:	return s_lfWarning;
+		case Log::EL_ERROR:		return s_lfError;
+		default:				return s_lfFatalError;
+		}
+	}
+
+
+	/**
+	 * @brief	Checks whether any error level is rate limited or sampled.
+	 */
+	void Log::updateLimited()
+	{
+		bool bLimited = false;
+		for( unsigned int i = 0; i <= sm_uiMaxLogLevel; i++ )
+			bLimited = bLimited || m_allInterval[i] > 0 || m_auiSampling[i] > 1;
+
+		m_bLimited = bLimited;
+	}
+
+
+	/**
+	 * @brief	Applies sampling and the rate limit to a message of a call site, see admit().
+	 *
+	 * @param [in,out]	site	The call site.
+	 * @param	elErrorLevel	The error level of the message.
+	 *
+	 * @return	true if the message may be logged, false if it was dropped.
+	 */
+	bool Log::admitLimited( LogSite& site, EErrorLevel elErrorLevel )
+	{
+		bool bAdmitted = true;
+
+		unsigned int uiSampling = m_auiSampling[elErrorLevel];
+		if( uiSampling > 1 && site.m_uiMessages.fetchAdd( 1 ) % uiSampling != 0 )
+			bAdmitted = false;
+
+		long long llInterval = m_allInterval[elErrorLevel];
+		if( bAdmitted && llInterval > 0 )
+		{
+			long long llNow = BinaryLogFile::getTicks();
+			long long llFull = site.m_llFull.load();
+
+			for(;;)
+			{
+				// every message pushes the time the bucket is full again one interval further, the bucket is empty
+				// when that time is more than a whole burst ahead
+				long long llNextFull = (llFull > llNow ? llFull : llNow) + llInterval;
+				if( llNextFull - llNow > m_allBurst[elErrorLevel] )
+				{
+					bAdmitted = false;
+					break;
+				}
+
+				if( site.m_llFull.compareExchange( llFull, llNextFull ) )
+					break;
+			}
+		}
+
+		if( !bAdmitted )
+		{
+			site.m_uiSuppressed.fetchAdd( 1 );
+			return false;
+		}
+
+		if( site.m_uiSuppressed.load() > 0 )
+		{
+			unsigned int uiSuppressed = site.m_uiSuppressed.exchange( 0 );
+
+			// only the name of the source file
+			const char* pcFile = site.m_pcFile;
+			for( const char* pc = site.m_pcFile; *pc; pc++ )
+			{
+				if( *pc == '/' || *pc == '\\' )
+					pcFile = pc + 1;
+			}
+
+			LogLine line( this, elErrorLevel );
+			line << "suppressed " << uiSuppressed << " similar messages from " << pcFile << ':' << site.m_uiLine;
+		}
+
+		return true;
+	}
+
+
+	/**
+	 * @brief	Writes a whole message, can be called from any thread.
+	 *
+	 * @param	elErrorLevel	The error level of the message.
+	 * @param	pcText			The message, without time and level prefix.
+	 * @param	uiLength		Length of the message.
+	 *
+	 * @return	true if the message was written, false if it was dropped.
+	 */
+	bool Log::write( EErrorLevel elErrorLevel, const char* pcText, unsigned int uiLength )
+	{
+		if( m_bBinary )
+		{
+			char acRecord[BLF_MAX_RECORD_LENGTH];
+			unsigned int uiRecordLength = getTextFormat( elErrorLevel ).encodeText( acRecord, sizeof(acRecord), pcText, uiLength );
+			return m_pBinaryFile->write( acRecord, uiRecordLength );
+		}
+
+		if( m_bAsync )
+		{
+			bool bPushed = LogWriter::getInstance()->push( this, elErrorLevel, pcText, uiLength );
+
+			// the program is likely to end soon, so do not leave the message in the buffer
+			if( elErrorLevel == EL_FATAL_ERROR )
+				flush();
+
+			return bPushed;
+		}
+
+		m_pmxWrite->lock();
+
+		std::string strTime = getTime();
+
+		std::cout << strTime << sm_astrLogLevelToPrefix[elErrorLevel];
+		std::cout.write( pcText, uiLength ) << '\n';
+		std::cout.flush();
+
+		m_fsLogFile << strTime << sm_astrLogLevelToPrefix[elErrorLevel];
+		m_fsLogFile.write( pcText, uiLength ) << '\n';
+		m_fsLogFile.flush();
+
+		m_pmxWrite->unlock();
+
+		return true;
+	}
+
+
 	/**
 	 * @brief	Inserts a new-line into the current log stream and flushes it.
 	 *
@@ -466,20 +795,714 @@ namespace oocl
 		while( log.m_bFlushing );
 		log.m_bFlushing = true;
 
-		if( log.m_elLastStreamLogLvl >= log.m_elLowestLoggedLevel )
+		if( (log.m_bAsync || log.m_bBinary) && log.isLogged( log.m_elLastStreamLogLvl ) )
+		{
+			std::string strMessage = log.m_ssLogStream.str();
+			log.write( log.m_elLastStreamLogLvl, strMessage.data(), strMessage.size() );
+
+			log.m_ssLogStream.str("");
+			log.m_ssLogStream.clear();
+		}
+		else if( log.m_elLastStreamLogLvl >= log.m_elLowestLoggedLevel )
 		{
 			log.m_ssLogStream << '\n';
+
+			// the stream belongs to this thread while m_bFlushing is set, the output is shared with write()
+			log.m_pmxWrite->lock();
 			std::cout << log.m_ssLogStream.str();
 			log.m_strLogText += log.m_ssLogStream.str();
+			log.m_pmxWrite->unlock();
 
 			log.m_ssLogStream.str("");
 			log.m_ssLogStream.clear();
 
 			log.flush();
 		}
+		else
+		{
+			// drop the filtered message, instead of writing it together with the next one
+			log.m_ssLogStream.str("");
+			log.m_ssLogStream.clear();
+		}
 
 		log.m_bFlushing = false;
 		
 		return log; 
 	}
+
+
+	// ******************** LogSite *********************
+
+	/**
+	 * @brief	Constructor, use the OOCL_LOG macros instead of creating call sites yourself.
+	 *
+	 * @param	pcFile	The source file of the call site, must stay valid.
+	 * @param	uiLine	The line of the call site.
+	 */
+	LogSite::LogSite( const char* pcFile, unsigned int uiLine )
+		: m_pcFile( pcFile )
+		, m_uiLine( uiLine )
+		, m_llFull( 0 )
+		, m_uiMessages( 0 )
+		, m_uiSuppressed( 0 )
+	{
+	}
+
+
+	// ******************** LogFormat *********************
+
+	/**
+	 * @brief	Constructor, use the OOCL_LOGF macros instead of creating formats yourself.
+	 *
+	 * @param	pcFile			The source file of the call site, must stay valid.
+	 * @param	uiLine			The line of the call site.
+	 * @param	elErrorLevel	The error level of the messages.
+	 * @param	pcFormat		The printf format of the messages, must stay valid.
+	 */
+	LogFormat::LogFormat( const char* pcFile, unsigned int uiLine, Log::EErrorLevel elErrorLevel, const char* pcFormat )
+		: m_uiID( 0 )
+		, m_pcFile( pcFile )
+		, m_uiLine( uiLine )
+		, m_elErrorLevel( elErrorLevel )
+		, m_pcFormat( pcFormat )
+	{
+		init();
+		m_uiID = BinaryLogFile::registerFormat( *this );
+	}
+
+
+	/**
+	 * @brief	Constructor for formats read from a binary log file, they are not registered.
+	 *
+	 * @param	uiID			The ID the format was registered with.
+	 * @param	pcFile			The source file of the call site, must stay valid.
+	 * @param	uiLine			The line of the call site.
+	 * @param	elErrorLevel	The error level of the messages.
+	 * @param	pcFormat		The printf format of the messages, must stay valid.
+	 */
+	LogFormat::LogFormat( unsigned int uiID, const char* pcFile, unsigned int uiLine, Log::EErrorLevel elErrorLevel, const char* pcFormat )
+		: m_uiID( uiID )
+		, m_pcFile( pcFile )
+		, m_uiLine( uiLine )
+		, m_elErrorLevel( elErrorLevel )
+		, m_pcFormat( pcFormat )
+	{
+		init();
+	}
+
+
+	/**
+	 * @brief	Parses the format and computes the length of its records without strings.
+	 */
+	void LogFormat::init()
+	{
+		m_bValid = parse( m_pcFormat, m_vArguments );
+		m_uiFixedLength = sizeof(BinaryLogFile::RecordHeader);
+
+		// strings are stored as length and characters, everything else as 8 bytes
+		for( std::vector<Argument>::const_iterator it = m_vArguments.begin(); it != m_vArguments.end(); ++it )
+			m_uiFixedLength += it->eType == AT_String ? sizeof(unsigned int) : 8;
+
+		if( m_uiFixedLength > BLF_MAX_RECORD_LENGTH )
+			m_bValid = false;
+	}
+
+
+	/**
+	 * @brief	Appends a string with its length to a record, whatever does not fit before uiEnd is cut.
+	 *
+	 * @param [out]	pcRecord	The record.
+	 * @param	uiPos			Position of the string in the record.
+	 * @param	uiEnd			Position the string must end before.
+	 * @param	pcText			The string, its end is either the terminating zero or uiLength.
+	 * @param	uiLength		Length of the string, or the maximum length if it is null-terminated.
+	 * @param	bTerminated		true if the string is null-terminated.
+	 *
+	 * @return	Position after the string.
+	 */
+	static unsigned int appendString( char* pcRecord, unsigned int uiPos, unsigned int uiEnd, const char* pcText, unsigned int uiLength, bool bTerminated )
+	{
+		unsigned int uiMaxLength = uiEnd - uiPos - sizeof(unsigned int);
+		if( uiLength > uiMaxLength )
+			uiLength = uiMaxLength;
+
+		if( bTerminated )
+		{
+			const char* pcZero = (const char*)memchr( pcText, '\0', uiLength );
+			if( pcZero )
+				uiLength = pcZero - pcText;
+		}
+
+		memcpy( pcRecord + uiPos, &uiLength, sizeof(unsigned int) );
+		memcpy( pcRecord + uiPos + sizeof(unsigned int), pcText, uiLength );
+
+		return uiPos + sizeof(unsigned int) + uiLength;
+	}
+
+
+	/**
+	 * @brief	Writes the header of a record and pads it to a multiple of 8.
+	 *
+	 * @param [out]	pcRecord	The record.
+	 * @param	uiID			The ID of the format.
+	 * @param	llTicks			The time stamp of the message.
+	 * @param	uiPos			Position after the last argument.
+	 *
+	 * @return	The length of the record.
+	 */
+	static unsigned int finishRecord( char* pcRecord, unsigned int uiID, long long llTicks, unsigned int uiPos )
+	{
+		unsigned int uiLength = (uiPos + 7) & ~7u;
+		memset( pcRecord + uiPos, 0, uiLength - uiPos );
+
+		BinaryLogFile::RecordHeader header = { uiID, uiLength, llTicks };
+		memcpy( pcRecord, &header, sizeof(header) );
+
+		return uiLength;
+	}
+
+
+	/**
+	 * @brief	Writes the record of a message.
+	 *
+	 * @param [out]	pcRecord	Buffer for the record.
+	 * @param	uiCapacity  	Size of the buffer, longer strings are cut.
+	 * @param	args			The arguments of the message, as they were passed for this format.
+	 *
+	 * @return	The length of the record, 0 without touching args if the format can not be recorded.
+	 */
+	unsigned int LogFormat::encode( char* pcRecord, unsigned int uiCapacity, va_list args ) const
+	{
+		// records are padded to 8 bytes, so their end must be aligned as well
+		uiCapacity &= ~7u;
+		if( !m_bValid || m_uiFixedLength > uiCapacity )
+			return 0;
+
+		long long llTicks = BinaryLogFile::getTicks();
+
+		unsigned int uiPos = sizeof(BinaryLogFile::RecordHeader);
+		unsigned int uiReserved = m_uiFixedLength - uiPos;	// room the remaining arguments need at least
+
+		for( std::vector<Argument>::const_iterator it = m_vArguments.begin(); it != m_vArguments.end(); ++it )
+		{
+			long long llValue = 0;
+			double dValue = 0.0;
+
+			switch( it->eType )
+			{
+			case AT_Int:				llValue = va_arg( args, int ); break;
+			case AT_UnsignedInt:		llValue = va_arg( args, unsigned int ); break;
+			case AT_Long:				llValue = va_arg( args, long ); break;
+			case AT_UnsignedLong:		llValue = (long long)va_arg( args, unsigned long ); break;
+			case AT_LongLong:			llValue = va_arg( args, long long ); break;
+			case AT_UnsignedLongLong:	llValue = (long long)va_arg( args, unsigned long long ); break;
+			case AT_Pointer:			llValue = (long long)(size_t)va_arg( args, void* ); break;
+
+			case AT_Double:
+				dValue = va_arg( args, double );
+				memcpy( &llValue, &dValue, sizeof(llValue) );
+				break;
+
+			case AT_LongDouble:
+				dValue = (double)va_arg( args, long double );
+				memcpy( &llValue, &dValue, sizeof(llValue) );
+				break;
+
+			case AT_String:
+				{
+					const char* pcText = va_arg( args, const char* );
+					if( !pcText )
+						pcText = "(null)";
+
+					uiReserved -= sizeof(unsigned int);
+					uiPos = appendString( pcRecord, uiPos, uiCapacity - uiReserved, pcText, uiCapacity, true );
+				}
+				continue;
+			}
+
+			uiReserved -= 8;
+			memcpy( pcRecord + uiPos, &llValue, 8 );
+			uiPos += 8;
+		}
+
+		return finishRecord( pcRecord, m_uiID, llTicks, uiPos );
+	}
+
+
+	/**
+	 * @brief	Writes the record of a message that is already formatted, for formats that consist of a single "%s".
+	 *
+	 * @param [out]	pcRecord	Buffer for the record.
+	 * @param	uiCapacity  	Size of the buffer, a longer text is cut.
+	 * @param	pcText			The text, does not need to be null-terminated.
+	 * @param	uiLength		Length of the text.
+	 *
+	 * @return	The length of the record, 0 if the format is not a single string.
+	 */
+	unsigned int LogFormat::encodeText( char* pcRecord, unsigned int uiCapacity, const char* pcText, unsigned int uiLength ) const
+	{
+		uiCapacity &= ~7u;
+		if( !m_bValid || m_vArguments.size() != 1 || m_vArguments[0].eType != AT_String || m_uiFixedLength > uiCapacity )
+			return 0;
+
+		long long llTicks = BinaryLogFile::getTicks();
+		unsigned int uiPos = appendString( pcRecord, sizeof(BinaryLogFile::RecordHeader), uiCapacity, pcText, uiLength, false );
+
+		return finishRecord( pcRecord, m_uiID, llTicks, uiPos );
+	}
+
+
+	/**
+	 * @brief	Appends a printf formatted value to a string.
+	 *
+	 * @param [in,out]	strText	The string.
+	 * @param	uiSize		   	Maximum length of the value, whatever is longer is cut.
+	 * @param	pcFormat	   	The printf format.
+	 */
+	static void appendFormatted( std::string& strText, unsigned int uiSize, const char* pcFormat, ... )
+	{
+		std::vector<char> vBuffer( uiSize + 1 );
+
+		va_list args;
+		va_start( args, pcFormat );
+		int iLength = vsnprintf( &vBuffer[0], vBuffer.size(), pcFormat, args );
+		va_end( args );
+
+		if( iLength > 0 )
+			strText.append( &vBuffer[0], (unsigned int)iLength < uiSize ? iLength : uiSize );
+	}
+
+
+	/**
+	 * @brief	Appends a part of a format without conversions to a string, "%%" becomes "%".
+	 */
+	static void appendLiteral( std::string& strText, const char* pcBegin, const char* pcEnd )
+	{
+		for( const char* pc = pcBegin; pc < pcEnd; pc++ )
+		{
+			strText += *pc;
+			if( *pc == '%' && pc + 1 < pcEnd && pc[1] == '%' )
+				pc++;
+		}
+	}
+
+
+	/**
+	 * @brief	Reconstructs the text of a message from the arguments in its record.
+	 *
+	 * @param	pcArguments	The arguments, they follow the header of the record.
+	 * @param	uiLength   	Length of the arguments including the padding.
+	 *
+	 * @return	The text of the message.
+	 */
+	std::string LogFormat::decode( const char* pcArguments, unsigned int uiLength ) const
+	{
+		std::string strText;
+		unsigned int uiFormatPos = 0;
+		unsigned int uiPos = 0;
+
+		for( std::vector<Argument>::const_iterator it = m_vArguments.begin(); it != m_vArguments.end(); ++it )
+		{
+			appendLiteral( strText, m_pcFormat + uiFormatPos, m_pcFormat + it->uiStart );
+			uiFormatPos = it->uiStart + it->uiLength;
+
+			std::string strConversion( m_pcFormat + it->uiStart, it->uiLength );
+
+			if( it->eType == AT_String )
+			{
+				unsigned int uiStringLength = 0;
+				if( uiPos + sizeof(unsigned int) <= uiLength )
+					memcpy( &uiStringLength, pcArguments + uiPos, sizeof(unsigned int) );
+
+				if( uiPos + sizeof(unsigned int) > uiLength || uiStringLength > uiLength - uiPos - sizeof(unsigned int) )
+				{
+					strText += "<truncated record>";
+					return strText;
+				}
+
+				std::string strValue( pcArguments + uiPos + sizeof(unsigned int), uiStringLength );
+				uiPos += sizeof(unsigned int) + uiStringLength;
+
+				if( strConversion == "%s" )
+					strText += strValue;
+				else
+					appendFormatted( strText, uiStringLength + 256, strConversion.c_str(), strValue.c_str() );
+
+				continue;
+			}
+
+			if( uiPos + 8 > uiLength )
+			{
+				strText += "<truncated record>";
+				return strText;
+			}
+
+			long long llValue = 0;
+			double dValue = 0.0;
+			memcpy( &llValue, pcArguments + uiPos, 8 );
+			memcpy( &dValue, pcArguments + uiPos, 8 );
+			uiPos += 8;
+
+			switch( it->eType )
+			{
+			case AT_Int:				appendFormatted( strText, 256, strConversion.c_str(), (int)llValue ); break;
+			case AT_UnsignedInt:		appendFormatted( strText, 256, strConversion.c_str(), (unsigned int)llValue ); break;
+			case AT_Long:				appendFormatted( strText, 256, strConversion.c_str(), (long)llValue ); break;
+			case AT_UnsignedLong:		appendFormatted( strText, 256, strConversion.c_str(), (unsigned long)llValue ); break;
+			case AT_LongLong:			appendFormatted( strText, 256, strConversion.c_str(), llValue ); break;
+			case AT_UnsignedLongLong:	appendFormatted( strText, 256, strConversion.c_str(), (unsigned long long)llValue ); break;
+			case AT_Pointer:			appendFormatted( strText, 256, strConversion.c_str(), (void*)(size_t)llValue ); break;
+			case AT_Double:				appendFormatted( strText, 256, strConversion.c_str(), dValue ); break;
+			case AT_LongDouble:			appendFormatted( strText, 256, strConversion.c_str(), (long double)dValue ); break;
+			default: break;
+			}
+		}
+
+		appendLiteral( strText, m_pcFormat + uiFormatPos, m_pcFormat + strlen( m_pcFormat ) );
+
+		return strText;
+	}
+
+
+	/**
+	 * @brief	Finds the conversions of a printf format.
+	 *
+	 * @param	pcFormat		  	The format.
+	 * @param [out]	vArguments	The conversions in the order of their arguments.
+	 *
+	 * @return	true if it succeeds, false if the format has a '*' width or precision, a %n or an unknown conversion.
+	 */
+	bool LogFormat::parse( const char* pcFormat, std::vector<Argument>& vArguments )
+	{
+		vArguments.clear();
+
+		for( const char* pc = pcFormat; *pc; pc++ )
+		{
+			if( *pc != '%' )
+				continue;
+
+			const char* pcStart = pc++;
+			if( *pc == '%' )
+				continue;
+
+			// flags, width and precision
+			while( *pc && strchr( "-+ #0'123456789.", *pc ) )
+				pc++;
+
+			if( *pc == '*' )
+				return false;
+
+			// length modifiers, 0 for int, 1 for long and 2 for long long
+			int iLong = 0;
+			bool bLongDouble = false;
+			for( ;; pc++ )
+			{
+				if( *pc == 'l' )
+					iLong++;
+				else if( *pc == 'q' || *pc == 'j' )
+					iLong = 2;
+				else if( *pc == 'z' || *pc == 't' )
+					iLong = sizeof(size_t) == sizeof(long) ? 1 : 2;
+				else if( *pc == 'L' )
+					bLongDouble = true;
+				else if( *pc != 'h' )
+					break;
+			}
+
+			Argument argument;
+			switch( *pc )
+			{
+			case 'd': case 'i': case 'c':
+				argument.eType = iLong == 0 ? AT_Int : iLong == 1 ? AT_Long : AT_LongLong;
+				break;
+
+			case 'u': case 'o': case 'x': case 'X':
+				argument.eType = iLong == 0 ? AT_UnsignedInt : iLong == 1 ? AT_UnsignedLong : AT_UnsignedLongLong;
+				break;
+
+			case 'f': case 'F': case 'e': case 'E': case 'g': case 'G': case 'a': case 'A':
+				argument.eType = bLongDouble ? AT_LongDouble : AT_Double;
+				break;
+
+			case 'p':
+				argument.eType = AT_Pointer;
+				break;
+
+			case 's':
+				// wide strings are not supported
+				if( iLong > 0 )
+					return false;
+				argument.eType = AT_String;
+				break;
+
+			default:
+				return false;
+			}
+
+			argument.uiStart = pcStart - pcFormat;
+			argument.uiLength = pc - pcStart + 1;
+			vArguments.push_back( argument );
+		}
+
+		return true;
+	}
+
+
+	// ******************** LogLine *********************
+
+	/**
+	 * @brief	Constructor, use the OOCL_LOG macros instead of creating lines yourself.
+	 *
+	 * @param [in]	pLog		The log to write the line to.
+	 * @param	elErrorLevel	The error level of the line.
+	 */
+	LogLine::LogLine( Log* pLog, Log::EErrorLevel elErrorLevel )
+		: m_pLog( pLog )
+		, m_elErrorLevel( elErrorLevel )
+		, m_uiLength( 0 )
+	{
+	}
+
+
+	/**
+	 * @brief	Destructor, writes the line to its log.
+	 */
+	LogLine::~LogLine()
+	{
+		m_pLog->write( m_elErrorLevel, m_acText, m_uiLength );
+	}
+
+
+	/**
+	 * @brief	Stream operator for inserting char arrays into the line.
+	 *
+	 * @param	pc	pointer to a null-terminated char array.
+	 *
+	 * @return	a reference to this line.
+	 */
+	LogLine& LogLine::operator << (const char* pc)
+	{
+		append( pc, strlen( pc ) );
+		return *this;
+	}
+
+	/**
+	 * @brief	Stream operator for inserting strings into the line.
+	 *
+	 * @param	str	a string.
+	 *
+	 * @return	a reference to this line.
+	 */
+	LogLine& LogLine::operator << (const std::string& str)
+	{
+		append( str.data(), str.size() );
+		return *this;
+	}
+
+	/**
+	 * @brief	Stream operator for inserting a single character into the line.
+	 *
+	 * @param	c	a character.
+	 *
+	 * @return	a reference to this line.
+	 */
+	LogLine& LogLine::operator << (const char c)
+	{
+		append( &c, 1 );
+		return *this;
+	}
+
+	/**
+	 * @brief	Stream operator for inserting boolean values into the line, they are written as 1 or 0 like std::ostream does.
+	 *
+	 * @param	b	a bool.
+	 *
+	 * @return	a reference to this line.
+	 */
+	LogLine& LogLine::operator << (const bool b)
+	{
+		append( b ? "1" : "0", 1 );
+		return *this;
+	}
+
+	/**
+	 * @brief	Stream operator for inserting floating point values into the line.
+	 *
+	 * @param	f	a float.
+	 *
+	 * @return	a reference to this line.
+	 */
+	LogLine& LogLine::operator << (const float f)
+	{
+		format( "%g", (double)f );
+		return *this;
+	}
+
+	/**
+	 * @brief	Stream operator for inserting double precision floats into the line.
+	 *
+	 * @param	d	a double.
+	 *
+	 * @return	a reference to this line.
+	 */
+	LogLine& LogLine::operator << (const double d)
+	{
+		format( "%g", d );
+		return *this;
+	}
+
+	/**
+	 * @brief	Stream operator for inserting short integers into the line.
+	 *
+	 * @param	i	a short int.
+	 *
+	 * @return	a reference to this line.
+	 */
+	LogLine& LogLine::operator << (const short int i)
+	{
+		format( "%d", (int)i );
+		return *this;
+	}
+
+	/**
+	 * @brief	Stream operator for inserting short unsigned integers into the line.
+	 *
+	 * @param	i	a short unsigned int.
+	 *
+	 * @return	a reference to this line.
+	 */
+	LogLine& LogLine::operator << (const unsigned short int i)
+	{
+		format( "%u", (unsigned int)i );
+		return *this;
+	}
+
+	/**
+	 * @brief	Stream operator for inserting signed integers into the line.
+	 *
+	 * @param	i	a signed integer.
+	 *
+	 * @return	a reference to this line.
+	 */
+	LogLine& LogLine::operator << (const int i)
+	{
+		format( "%d", i );
+		return *this;
+	}
+
+	/**
+	 * @brief	Stream operator for inserting unsigned integers into the line.
+	 *
+	 * @param	i	an unsigned integer.
+	 *
+	 * @return	a reference to this line.
+	 */
+	LogLine& LogLine::operator << (const unsigned int i)
+	{
+		format( "%u", i );
+		return *this;
+	}
+
+	/**
+	 * @brief	Stream operator for inserting long integers into the line.
+	 *
+	 * @param	i	a long integer.
+	 *
+	 * @return	a reference to this line.
+	 */
+	LogLine& LogLine::operator << (const long i)
+	{
+		format( "%ld", i );
+		return *this;
+	}
+
+	/**
+	 * @brief	Stream operator for inserting long unsigned integers into the line, e.g. a size_t.
+	 *
+	 * @param	i	a long unsigned integer.
+	 *
+	 * @return	a reference to this line.
+	 */
+	LogLine& LogLine::operator << (const unsigned long i)
+	{
+		format( "%lu", i );
+		return *this;
+	}
+
+	/**
+	 * @brief	Stream operator for inserting 64bit integers into the line.
+	 *
+	 * @param	i	a long long integer.
+	 *
+	 * @return	a reference to this line.
+	 */
+	LogLine& LogLine::operator << (const long long i)
+	{
+		format( "%lld", i );
+		return *this;
+	}
+
+	/**
+	 * @brief	Stream operator for inserting unsigned 64bit integers into the line.
+	 *
+	 * @param	i	a long long unsigned integer.
+	 *
+	 * @return	a reference to this line.
+	 */
+	LogLine& LogLine::operator << (const unsigned long long i)
+	{
+		format( "%llu", i );
+		return *this;
+	}
+
+	/**
+	 * @brief	Stream operator for inserting addresses into the line.
+	 *
+	 * @param	p	a pointer.
+	 *
+	 * @return	a reference to this line.
+	 */
+	LogLine& LogLine::operator << (const void* p)
+	{
+		format( "%p", p );
+		return *this;
+	}
+
+
+	/**
+	 * @brief	Appends text to the line, whatever does not fit into LOG_LINE_LENGTH is cut.
+	 *
+	 * @param	pcText  	The text.
+	 * @param	uiLength	Length of the text.
+	 */
+	void LogLine::append( const char* pcText, unsigned int uiLength )
+	{
+		if( uiLength > LOG_LINE_LENGTH - m_uiLength )
+			uiLength = LOG_LINE_LENGTH - m_uiLength;
+
+		memcpy( m_acText + m_uiLength, pcText, uiLength );
+		m_uiLength += uiLength;
+	}
+
+
+	/**
+	 * @brief	Appends a printf formatted value to the line, whatever does not fit into LOG_LINE_LENGTH is cut.
+	 *
+	 * @param	pcFormat	The printf format.
+	 */
+	void LogLine::format( const char* pcFormat, ... )
+	{
+		unsigned int uiFree = LOG_LINE_LENGTH - m_uiLength;
+		if( uiFree == 0 )
+			return;
+
+		va_list args;
+		va_start( args, pcFormat );
+		int iLength = vsnprintf( m_acText + m_uiLength, uiFree, pcFormat, args );
+		va_end( args );
+
+		// vsnprintf returns the length the text would have had, but always terminates it
+		if( iLength > 0 )
+			m_uiLength += (unsigned int)iLength < uiFree ? iLength : uiFree - 1;
+	}
 }
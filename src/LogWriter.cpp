@@ -0,0 +1,226 @@
+/*
+Object Oriented Communication Library
+Copyright (c) 2011 Jürgen Lorenz and Jörn Teuber
+
+This software is provided 'as-is', without any express or implied warranty.
+In no event will the authors be held liable for any damages arising from the use of this software.
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it freely,
+subject to the following restrictions:
+
+1. The origin of this software must not be misrepresented; you must not claim that you wrote the original software. If you use this software in a product, an acknowledgment in the product documentation would be appreciated but is not required.
+2. Altered source versions must be plainly marked as such, and must not be misrepresented as being the original software.
+3. This notice may not be removed or altered from any source distribution.
+*/
+// This file was written by Jörn Teuber
+
+#include <string.h>
+
+#include "LogWriter.h"
+
+namespace oocl
+{
+	Atomic<LogWriter*> LogWriter::sm_pInstance( NULL );
+
+	/// the buffer the current thread pushes its records into, plus one so that 0 means none was picked yet
+	static OOCL_THREAD_LOCAL unsigned int tl_uiBuffer = 0;
+	/// the number of records the current thread pushed
+	static OOCL_THREAD_LOCAL unsigned int tl_uiPushed = 0;
+
+	/**
+	 * @brief	Stops the writer when the library is unloaded, so that no buffered record gets lost.
+	 */
+	static struct LogWriterShutdown
+	{
+		~LogWriterShutdown() { LogWriter::shutdown(); }
+	} s_logWriterShutdown;
+
+
+	/**
+	 * @brief	Constructor.
+	 */
+	LogWriter::LogWriter()
+		: m_uiNextBuffer( 0 )
+		, m_bRunning( true )
+	{
+		for( unsigned int i = 0; i < LOG_NUM_BUFFERS; i++ )
+			m_apBuffers[i] = new MPSCQueue<Record>( LOG_BUFFER_CAPACITY );
+	}
+
+
+	/**
+	 * @brief	Destructor, stops the writer thread after it wrote all buffered records.
+	 */
+	LogWriter::~LogWriter()
+	{
+		m_mxDrain.lock();
+		m_bRunning = false;
+		m_condWakeUp.signal();
+		m_mxDrain.unlock();
+
+		join();
+
+		for( unsigned int i = 0; i < LOG_NUM_BUFFERS; i++ )
+			delete m_apBuffers[i];
+	}
+
+
+	/**
+	 * @brief	Get the writer, it is created and started by the first call.
+	 *
+	 * @return	The writer.
+	 */
+	LogWriter* LogWriter::getInstance()
+	{
+		LogWriter* pWriter = sm_pInstance.load();
+		if( pWriter != NULL )
+			return pWriter;
+
+		pWriter = new LogWriter();
+
+		LogWriter* pExpected = NULL;
+		if( !sm_pInstance.compareExchange( pExpected, pWriter ) )
+		{
+			// another thread was faster
+			delete pWriter;
+			return pExpected;
+		}
+
+		pWriter->start();
+		return pWriter;
+	}
+
+
+	/**
+	 * @brief	Writes all buffered records and stops the writer. Logs that are still asynchronous start a new one.
+	 */
+	void LogWriter::shutdown()
+	{
+		delete sm_pInstance.exchange( NULL );
+	}
+
+
+	/**
+	 * @brief	Queues a message for the writer, can be called from any thread.
+	 *
+	 * @param [in]	pLog			The log the message belongs to.
+	 * @param	elErrorLevel		The error level of the message.
+	 * @param	pcText				The message, without time and level prefix.
+	 * @param	uiLength			Length of the message, anything beyond LOG_RECORD_TEXT_LENGTH is cut.
+	 *
+	 * @return	true if the message was queued, false if it was dropped because the buffer is full.
+	 */
+	bool LogWriter::push( Log* pLog, Log::EErrorLevel elErrorLevel, const char* pcText, unsigned int uiLength )
+	{
+		if( tl_uiBuffer == 0 )
+			tl_uiBuffer = m_uiNextBuffer.fetchAdd( 1 ) % LOG_NUM_BUFFERS + 1;
+
+		Record record;
+		record.pLog = pLog;
+		record.time = time( NULL );
+		record.usErrorLevel = elErrorLevel;
+		record.usLength = uiLength < LOG_RECORD_TEXT_LENGTH ? uiLength : LOG_RECORD_TEXT_LENGTH;
+		memcpy( record.acText, pcText, record.usLength );
+
+		bool bQueued = m_apBuffers[tl_uiBuffer-1]->tryPush( record );
+		if( !bQueued )
+			pLog->m_uiDroppedRecords.fetchAdd( 1 );
+
+		// a thread that logs a burst wakes the writer before its buffer is full, a missed signal only costs a delay
+		if( !bQueued || ++tl_uiPushed % (LOG_BUFFER_CAPACITY / 4) == 0 )
+			m_condWakeUp.signal();
+
+		return bQueued;
+	}
+
+
+	/**
+	 * @brief	Writes all records that were pushed before this call, blocks until they are written.
+	 */
+	void LogWriter::flush()
+	{
+		m_mxDrain.lock();
+		drain();
+		m_mxDrain.unlock();
+	}
+
+
+	/**
+	 * @brief	The writer thread, writes a batch every LOG_WRITE_INTERVAL milliseconds.
+	 */
+	void LogWriter::run()
+	{
+		m_mxDrain.lock();
+
+		while( m_bRunning )
+		{
+			drain();
+			m_condWakeUp.wait( m_mxDrain, LOG_WRITE_INTERVAL );
+		}
+
+		drain();
+
+		m_mxDrain.unlock();
+	}
+
+
+	/**
+	 * @brief	Pops all buffered records and writes them to their logs. m_mxDrain has to be locked.
+	 */
+	void LogWriter::drain()
+	{
+		Record record;
+		time_t lastTime = 0;
+		char acTime[9] = "";
+
+		for( unsigned int i = 0; i < LOG_NUM_BUFFERS; i++ )
+		{
+			while( m_apBuffers[i]->pop( record ) )
+			{
+				// most records of a batch were logged in the same second
+				if( record.time != lastTime )
+				{
+					lastTime = record.time;
+					strftime( acTime, 9, "%H:%M:%S", gmtime( &lastTime ) );
+				}
+
+				std::string& strText = m_mapPendingText[record.pLog];
+				strText += acTime;
+				strText += Log::sm_astrLogLevelToPrefix[record.usErrorLevel];
+				strText.append( record.acText, record.usLength );
+				strText += '\n';
+			}
+		}
+
+		for( std::map<Log*, std::string>::iterator it = m_mapPendingText.begin(); it != m_mapPendingText.end(); ++it )
+		{
+			Log* pLog = it->first;
+			std::string& strText = it->second;
+
+			unsigned int uiDropped = pLog->m_uiDroppedRecords.exchange( 0 );
+			if( uiDropped > 0 )
+			{
+				time_t now = time( NULL );
+				char acNow[9];
+				strftime( acNow, 9, "%H:%M:%S", gmtime( &now ) );
+
+				std::stringstream ss;
+				ss << acNow << Log::sm_astrLogLevelToPrefix[Log::EL_WARNING] << uiDropped << " log messages were dropped because the log writer fell behind\n";
+				strText += ss.str();
+			}
+
+			if( strText.empty() )
+				continue;
+
+			std::cout << strText;
+			std::cout.flush();
+
+			pLog->m_fsLogFile << strText;
+			pLog->m_fsLogFile.flush();
+
+			// keeps the capacity for the next batch
+			strText.clear();
+		}
+	}
+
+}
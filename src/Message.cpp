@@ -14,14 +14,21 @@ subject to the following restrictions:
 */
 // This file was written by Jürgen Lorenz and Jörn Teuber
 
+#include <cstring>
+
 #include "Message.h"
+#include "MessagePool.h"
+#include "Thread.h"
 
 namespace oocl
 {
+	/// the message whose serializeInto() asks getMsgString() whether a subclass overrides it, see Message::serializeInto()
+	static OOCL_THREAD_LOCAL Message const * tl_pProbedMessage = NULL;
 
 	// ******************** Message *********************
 	
 	std::vector<Message* (*)(const char*)> Message::sm_msgTypeList;
+	std::vector<MessagePool*> Message::sm_vpPools;
 
 
 	Message::Message()
@@ -29,21 +36,146 @@ namespace oocl
 		, m_iProtocoll( 0 )
 		, m_uiSenderID( 0 )
 		, m_bIncoming( false )
+		, m_uiRefCount( 0 )
+		, m_bPooled( false )
+	{
+	}
+
+
+	/**
+	 * @brief	Adds a reference to this message, it will not be deleted before release() was called as often.
+	 */
+	void Message::retain() const
+	{
+		m_uiRefCount.fetchAdd( 1 );
+	}
+
+	/**
+	 * @brief	Removes a reference to this message and deletes it if it was the last one.
+	 *
+	 * @note	Received messages of a type with a pool go back to the pool instead, if it is not full.
+	 */
+	void Message::release() const
+	{
+		if( m_uiRefCount.fetchAdd( (unsigned int)-1 ) == 1 )
+		{
+			if( m_bPooled && sm_vpPools[getType()]->recycle( const_cast<Message*>( this ) ) )
+				return;
+
+			delete this;
+		}
+	}
+
+	/**
+	 * @brief	Get the number of references to this message.
+	 *
+	 * @return	The reference count, 0 for a message nobody retained yet.
+	 */
+	unsigned int Message::getRefCount() const
+	{
+		return m_uiRefCount.load();
+	}
+
+
+	/**
+	 * @brief	Writes the header of a message, the extended header if the body does not fit the 2 byte length.
+	 *
+	 * @param [out]	pcOut		 	Where to write the header, needs room for getHeaderLength( uiBodyLength ) bytes.
+	 * @param	usType			 	The message type.
+	 * @param	uiBodyLength	 	The length of the body.
+	 *
+	 * @return	The length of the written header, 4 or 8.
+	 */
+	unsigned int Message::writeHeader( char* pcOut, unsigned short usType, unsigned int uiBodyLength )
+	{
+		std::memcpy( pcOut, &usType, sizeof(unsigned short) );
+
+		if( uiBodyLength < MSG_EXTENDED_LENGTH )
+		{
+			unsigned short usBodyLength = (unsigned short)uiBodyLength;
+			std::memcpy( pcOut + 2, &usBodyLength, sizeof(unsigned short) );
+			return 4;
+		}
+
+		unsigned short usExtended = MSG_EXTENDED_LENGTH;
+		std::memcpy( pcOut + 2, &usExtended, sizeof(unsigned short) );
+		std::memcpy( pcOut + 4, &uiBodyLength, sizeof(unsigned int) );
+		return 8;
+	}
+
+	/**
+	 * @brief	Reads the body length from the header of a message.
+	 *
+	 * @note	The frame has to hold at least 4 bytes, and 8 if the length field is MSG_EXTENDED_LENGTH.
+	 *
+	 * @param	pcFrame				The message, starting with the header.
+	 * @param [out]	uiBodyLength	The length of the body.
+	 *
+	 * @return	The length of the header, the body starts behind it.
+	 */
+	unsigned int Message::readHeader( const char* pcFrame, unsigned int& uiBodyLength )
 	{
+		unsigned short usBodyLength = 0;
+		std::memcpy( &usBodyLength, pcFrame + 2, sizeof(unsigned short) );
+
+		if( usBodyLength != MSG_EXTENDED_LENGTH )
+		{
+			uiBodyLength = usBodyLength;
+			return 4;
+		}
+
+		std::memcpy( &uiBodyLength, pcFrame + 4, sizeof(unsigned int) );
+		return 8;
 	}
 
 
 	/**
-	 * @brief return a ready-to-send string representation of the message.
+	 * @brief	Appends a ready-to-send representation of the message to the buffer.
 	 *  | Type  |Length | Messagebody
 	 *  |2 byte |2 byte |   |   ....
 	 * => Length = length of the messageBody in bytes (as returned by getBodyLength() )
 	 *
-	 * @return	Empty string, as this is not meant to be sent directly.
+	 * @note	This writes the header of messages without a body. A message class written before serializeInto()
+	 * 			existed only overrides getMsgString(), its string holds the whole message and is appended instead.
+	 *
+	 * @param [in,out]	buffer	The buffer to append the message to.
+	 */
+	void Message::serializeInto( WriteBuffer& buffer ) const
+	{
+		// Message::getMsgString() returns an empty string for the probed message, an override returns the message
+		Message const * pPrevious = tl_pProbedMessage;
+		tl_pProbedMessage = this;
+		std::string strMsg = getMsgString();
+		tl_pProbedMessage = pPrevious;
+
+		if( !strMsg.empty() )
+		{
+			buffer.append( strMsg );
+			return;
+		}
+
+		unsigned int uiBodyLength = getBodyLength();
+		char* pcOut = buffer.grow( getHeaderLength( uiBodyLength ) );
+		writeHeader( pcOut, getType(), uiBodyLength );
+	}
+
+	/**
+	 * @brief	Returns the message as string, as written by serializeInto().
+	 *
+	 * @note	This allocates on every call, the networks serialize directly into their send buffers instead.
+	 * 			Overriding it is deprecated, override serializeInto() instead.
+	 *
+	 * @return	The message string.
 	 */
 	std::string	Message::getMsgString() const
 	{
-		return std::string();
+		if( tl_pProbedMessage == this )
+			return std::string();
+
+		WriteBuffer buffer( getBodyLength() + MSG_MAX_HEADER_LENGTH );
+		serializeInto( buffer );
+
+		return std::string( buffer.data(), buffer.size() );
 	}
 
 	/**
@@ -51,7 +183,7 @@ namespace oocl
 	 *
 	 * @return	0, as this message has no body.
 	 */
-	unsigned short Message::getBodyLength() const
+	unsigned int Message::getBodyLength() const
 	{
 		return 0;
 	}
@@ -69,7 +201,8 @@ namespace oocl
 	/**
 	 * @brief	Set the protocol used to send this message over the network.
 	 *
-	 * @param iProtocol	The protocol to use (SOCK_STREAM, SOCK_DGRAM or 0).
+	 * @param iProtocol	The protocol to use (SOCK_STREAM, SOCK_DGRAM, SOCK_RDM, SOCK_SEQPACKET or 0).
+	 * 					SOCK_RDM and SOCK_SEQPACKET send over udp with retransmission, see ReliableChannel.
 	 */
 	void Message::setProtocoll( int iProtocol )
 	{
@@ -89,7 +222,7 @@ namespace oocl
 	/**
 	 * @brief 	Get the protocol that will be used if sending this message over the network.
 	 *
-	 * @return	The protocol (SOCK_STREAM, SOCK_DGRAM or 0).
+	 * @return	The protocol (SOCK_STREAM, SOCK_DGRAM, SOCK_RDM, SOCK_SEQPACKET or 0).
 	 */
 	int Message::getProtocoll() const
 	{
@@ -117,26 +250,64 @@ namespace oocl
 	}
 
 
+	/**
+	 * @brief	Refills a message taken from the pool of its type with a received byte buffer.
+	 *
+	 * @note	Overwrite this in message types that are registered with a pool. Reuse the memory of the members where
+	 * 			possible, e.g. assign() to strings instead of creating new ones.
+	 *
+	 * @param	cMsg	The message as byte buffer, starting with the header.
+	 *
+	 * @return	true if the message was refilled, false if the type can not be refilled. The default returns false.
+	 */
+	bool Message::readFrom( const char* /*cMsg*/ )
+	{
+		return false;
+	}
+
+
 	/**
 	 * @brief	Creates an object of an implementation of message from a received byte buffer.
 	 *
+	 * @note	If the type was registered with a pool, a released message is refilled instead of creating a new one.
+	 *
 	 * @param	cMsg	The message as byte buffer.
 	 *
 	 * @return	null if it fails, else a pointer to the created message object.
 	 */
 	Message* Message::createFromString( const char* cMsg )
 	{
-		unsigned short usType = ((unsigned short*)cMsg)[0];
+		unsigned short usType = 0;
+		std::memcpy( &usType, cMsg, sizeof(unsigned short) );
 		Message* pReturn = NULL;
 
 		if( usType < sm_msgTypeList.size() && sm_msgTypeList[usType] != NULL )
 		{
-			pReturn = sm_msgTypeList[usType]( cMsg );
-			pReturn->m_bIncoming = true;
+			MessagePool* pPool = sm_vpPools[usType];
+			if( pPool != NULL )
+			{
+				pReturn = pPool->acquire();
+				if( pReturn != NULL && pReturn->readFrom( cMsg ) )
+					pReturn->m_uiSenderID = 0;
+				else
+				{
+					delete pReturn;
+					pReturn = NULL;
+				}
+			}
+
+			if( pReturn == NULL )
+				pReturn = sm_msgTypeList[usType]( cMsg );
+
+			if( pReturn != NULL )
+			{
+				pReturn->m_bIncoming = true;
+				pReturn->m_bPooled = pPool != NULL;
+			}
 		}
 		else
 		{
-			Log::getLogRef("oocl") << Log::EL_ERROR << "No message class for message type " << usType << " registered" << oocl::endl;
+			OOCL_LOG_ERROR( "oocl", "No message class for message type " << usType << " registered" );
 		}
 
 		return pReturn;
@@ -151,31 +322,40 @@ namespace oocl
 	 *
 	 * @param	usType		  	The type.
 	 * @param	create [in]		a pointer to a function that receives a byte buffer and returns a pointer to a newly created object of your message implementation.
+	 * @param	uiPoolSize		number of released messages that are kept for reuse by received messages, 0 for no pool.
+	 * 							The message implementation has to overwrite readFrom() for the pool to work.
+	 * @param	ucCodec			the codec messages of this type are compressed with when sent over tcp, e.g. CODEC_LZ.
+	 * 							Only used if the receiver supports it, see Codec.
+	 * @param	uiCompressThreshold	messages shorter than this, including the header, are never compressed.
 	 */
-	void Message::registerMsg( unsigned short usType, Message* (*create)(const char*)  )
+	void Message::registerMsg( unsigned short usType, Message* (*create)(const char*), unsigned int uiPoolSize,
+							   unsigned char ucCodec, unsigned int uiCompressThreshold )
 	{
 		if( usType >= sm_msgTypeList.size() )
 		{
-			std::ostringstream os;
-			os << "The message with ID " << usType << " was successfully registered.";
-			Log::getLog("oocl")->logInfo( os.str() );
+			OOCL_LOG_INFO( "oocl", "The message with ID " << usType << " was successfully registered." );
 
 			sm_msgTypeList.resize( usType+1, NULL );
+			sm_vpPools.resize( usType+1, NULL );
 			sm_msgTypeList[usType] = create;
+			if( uiPoolSize > 0 )
+				sm_vpPools[usType] = new MessagePool( uiPoolSize );
+			if( ucCodec != CODEC_None )
+				Codec::useFor( usType, ucCodec, uiCompressThreshold );
 		}
 		else if( sm_msgTypeList[usType] == NULL )
 		{
-			std::ostringstream os;
-			os << "The message with ID " << usType << " was successfully registered.";
-			Log::getLog("oocl")->logInfo( os.str() );
+			OOCL_LOG_INFO( "oocl", "The message with ID " << usType << " was successfully registered." );
 
 			sm_msgTypeList[usType] = create;
+			if( uiPoolSize > 0 )
+				sm_vpPools[usType] = new MessagePool( uiPoolSize );
+			if( ucCodec != CODEC_None )
+				Codec::useFor( usType, ucCodec, uiCompressThreshold );
 		}
 		else
 		{
-			std::ostringstream os;
-			os << "You tried to register the message with ID " << usType << ", but it is already registered";
-			Log::getLog("oocl")->logInfo( os.str() );
+			OOCL_LOG_INFO( "oocl", "You tried to register the message with ID " << usType << ", but it is already registered" );
 		}
 	}
 
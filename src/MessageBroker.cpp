@@ -14,6 +14,8 @@ subject to the following restrictions:
 */
 // This file was written by Jürgen Lorenz and Jörn Teuber
 
+#include <algorithm>
+
 #include "MessageBroker.h"
 
 namespace oocl
@@ -22,15 +24,24 @@ namespace oocl
 	///< The list of all registered MessageBroker
 	std::map< unsigned int, MessageBroker* > MessageBroker::sm_vBroker;
 
+	///< The pool that delivers the messages of all brokers, NULL if every broker uses its own thread
+	ThreadPool* MessageBroker::sm_pThreadPool = NULL;
+
 
 	/**
 	 * @brief	Default constructor.
 	 */
 	MessageBroker::MessageBroker(void)
 		: m_pExclusiveListener( NULL )
-		, m_bRunThread( false )
+		, m_pListeners( new ListenerArray() )
+		, m_uiNumListeners( 0 )
+		, m_uiReaderEpoch( 0 )
+		, m_uiRunThread( 0 )
+		, m_uiSleeping( 0 )
 		, m_bRunContinuously( false )
 		, m_bSynchronous( false )
+		, m_uiSpinCount( 0 )
+		, m_uiMaxBatchSize( 64 )
 	{
 	}
 
@@ -40,7 +51,16 @@ namespace oocl
 	 */
 	MessageBroker::~MessageBroker(void)
 	{
-		m_bRunThread = false;
+		m_mxQueue.lock();
+		m_uiRunThread.store( 0 );
+		m_cvQueue.broadcast();
+		m_mxQueue.unlock();
+
+		join();
+
+		for( unsigned int i = 0; i < m_vpRetiredListeners.size(); i++ )
+			delete m_vpRetiredListeners[i];
+		delete m_pListeners.load();
 	}
 
 
@@ -64,9 +84,44 @@ namespace oocl
 	}
 
 
+	/**
+	 * @brief	Checks whether a listener is registered for the given message type, without creating a broker.
+	 *
+	 * @param	usMessageType	The message type.
+	 *
+	 * @return	true if messages of this type would be delivered to someone.
+	 */
+	bool MessageBroker::hasListenersFor( unsigned short usMessageType )
+	{
+		std::map< unsigned int, MessageBroker* >::iterator it = sm_vBroker.find( usMessageType );
+
+		return it != sm_vBroker.end() && it->second->m_uiNumListeners.load() > 0;
+	}
+
+
+	/**
+	 * @brief	Lets the threads of the given pool deliver the messages of all brokers instead of one thread per broker.
+	 *
+	 * @note	The messages of one broker are still delivered one after another in the order they were pumped,
+	 * 			but listeners of different message types may be called from the same thread. Continuous processing
+	 * 			and spin waiting have no effect while a pool is set, the pool threads sleep when there is nothing to do.
+	 * 			Call this before messages are pumped, the pool has to outlive all brokers. When the pool is shut down
+	 * 			the brokers fall back to their own threads.
+	 *
+	 * @param [in]	pPool	The pool to use, e.g. ThreadPool::getDefault() to share one thread per core with the rest of
+	 * 						the application, or NULL to go back to one thread per broker.
+	 */
+	void MessageBroker::setThreadPool( ThreadPool* pPool )
+	{
+		sm_pThreadPool = pPool;
+	}
+
+
 	/**
 	 * @brief	Registers the listener described by pListener.
 	 *
+	 * @note	Does not wait for messages that are currently delivered, the listener gets the messages delivered after this call.
+	 *
 	 * @param [in]	pListener	The listener to register with this brocker.
 	 */
 	void MessageBroker::registerListener( MessageListener* pListener )
@@ -74,7 +129,15 @@ namespace oocl
 		if( pListener != NULL )
 		{
 			m_mxListener.lock();
-			m_lListeners.push_back( pListener );
+
+			ListenerArray* pListeners = new ListenerArray( *m_pListeners.load() );
+			pListeners->push_back( pListener );
+			publishListeners( pListeners );
+
+			// the replaced array is only freed here if no one reads it anymore, else by the next unregisterListener()
+			if( m_auiReaders[0].load() == 0 && m_auiReaders[1].load() == 0 )
+				reclaimListeners();
+
 			m_mxListener.unlock();
 		}
 	}
@@ -83,6 +146,9 @@ namespace oocl
 	/**
 	 * @brief	Unregisters the listener given by pListener.
 	 *
+	 * @note	Blocks until deliveries that might still call the listener have finished, so the listener can be deleted
+	 * 			afterwards. Therefore do not call this from the callback of a listener of this broker.
+	 *
 	 * @param [in]	pListener	The listener to unregister.
 	 */
 	void MessageBroker::unregisterListener( MessageListener* pListener )
@@ -90,7 +156,14 @@ namespace oocl
 		if( pListener != NULL )
 		{
 			m_mxListener.lock();
-			m_lListeners.remove( pListener );
+
+			ListenerArray* pListeners = new ListenerArray( *m_pListeners.load() );
+			pListeners->erase( std::remove( pListeners->begin(), pListeners->end(), pListener ), pListeners->end() );
+			publishListeners( pListeners );
+
+			waitForReaders();
+			reclaimListeners();
+
 			m_mxListener.unlock();
 		}
 	}
@@ -99,32 +172,66 @@ namespace oocl
 	/**
 	 * @brief	Send a message to all registered listeners.
 	 *
+	 * @note	The broker holds a reference to the message until it was delivered, a message that nobody else
+	 * 			retained is deleted afterwards.
+	 *
 	 * @param [in]	pMessage	If non-null, the message to send.
 	 */
 	void MessageBroker::pumpMessage( Message* pMessage )
 	{
-		if( !m_lListeners.empty() && pMessage != NULL )
+		if( pMessage == NULL )
+			return;
+
+		if( m_uiNumListeners.load() == 0 || m_bSynchronous )
 		{
-			if( m_bSynchronous )
+			// without the queue the reference only lasts for the delivery
+			MessagePtr ptrMessage( pMessage );
+
+			if( m_uiNumListeners.load() > 0 )
+				deliverMessages( &pMessage, 1 );
+		}
+		else
+		{
+			// producers never wait for each other or for the listeners, the reference is released after delivery
+			pMessage->retain();
+			m_qMessages.push( pMessage );
+
+			// start a new thread if the last one quit because the queue was empty, or wake up the sleeping one
+			unsigned int uiNotRunning = 0;
+			if( m_uiRunThread.compareExchange( uiNotRunning, 1 ) )
 			{
-				deliverMessage( pMessage );
+				schedule();
 			}
-			else
+			else if( m_uiSleeping.load() )
 			{
 				m_mxQueue.lock();
-				m_lMessageQueue.push( pMessage );
+				m_cvQueue.signal();
 				m_mxQueue.unlock();
-		
-				if( !m_bRunThread )
-				{
-					m_bRunThread = true;
-					start();
-				}
 			}
 		}
 	}
 
 
+	/**
+	 * @brief	Send a received message that is still in the receive buffer to all registered listeners.
+	 *
+	 * @note	Nothing is allocated if there are no listeners. A synchronous broker passes the view on to
+	 * 			MessageListener::cbMessageView(), else the message is created and queued like any other.
+	 *
+	 * @param	view	The received message.
+	 */
+	void MessageBroker::pumpMessage( const MessageView& view )
+	{
+		if( m_uiNumListeners.load() == 0 )
+			return;
+
+		if( m_bSynchronous )
+			deliverMessages( NULL, 1, &view );
+		else
+			pumpMessage( view.getMessage() );
+	}
+
+
 	/**
 	 * @brief	Request exclusive messaging, so that only the given MessageListener gets messages until discarded.
 	 *
@@ -211,74 +318,343 @@ namespace oocl
 	}
 
 
+	/**
+	 * @brief	Enables polling the message queue for a while before the message passing thread goes to sleep.
+	 *
+	 * @note	This lowers the latency for message types that arrive in quick succession at the cost of cpu time,
+	 * 			without it the thread sleeps until pumpMessage() wakes it up. Only useful with continuous processing
+	 * 			and if there are more cores than busy threads.
+	 *
+	 * @param	uiSpinCount	The number of times the queue is checked before sleeping.
+	 */
+	void MessageBroker::enableSpinWaiting( unsigned int uiSpinCount )
+	{
+		m_uiSpinCount = uiSpinCount;
+	}
+
+
+	/**
+	 * @brief	Disables spin waiting, the message passing thread goes to sleep as soon as the queue is empty.
+	 */
+	void MessageBroker::disableSpinWaiting()
+	{
+		m_uiSpinCount = 0;
+	}
+
+
+	/**
+	 * @brief	Sets how many queued messages are delivered to the listeners at once.
+	 *
+	 * @note	Only messages that are already queued are batched, the broker never waits for a batch to fill up.
+	 * 			The listeners get the whole batch with one call to MessageListener::cbMessages().
+	 *
+	 * @param	uiMaxBatchSize	The maximum number of messages per batch, 1 to deliver every message on its own.
+	 */
+	void MessageBroker::setMaxBatchSize( unsigned int uiMaxBatchSize )
+	{
+		m_uiMaxBatchSize = uiMaxBatchSize > 0 ? uiMaxBatchSize : 1;
+	}
+
+
 	/**
 	 * @brief	Distributes the messages in the message queue of this broker.
 	 */
 	void MessageBroker::run()
 	{
-		m_bRunThread = true;
+		while( m_uiRunThread.load() )
+		{
+			unsigned int uiCount = popMessages();
+			if( uiCount == 0 )
+			{
+				if( m_bRunContinuously )
+				{
+					waitForMessage();
+					continue;
+				}
+
+				// when the thread is not set to run the whole time, quit the thread if the message queue is empty
+				m_uiRunThread.store( 0 );
+
+				// a message that was pushed just before did not start a new thread, so take care of it if no one else does
+				unsigned int uiNotRunning = 0;
+				if( !m_qMessages.empty() && m_uiRunThread.compareExchange( uiNotRunning, 1 ) )
+					continue;
+
+				break;
+			}
+
+			deliverMessages( &m_vpBatch[0], uiCount );
+
+			releaseMessages( uiCount );
+		}
+	}
+
+
+	/**
+	 * @brief	Delivers a limited number of messages when the broker is executed by the thread pool.
+	 */
+	void MessageBroker::execute()
+	{
+		for( unsigned int uiDelivered = 0; uiDelivered < sm_uiMessagesPerTask; )
+		{
+			unsigned int uiCount = popMessages();
+			if( uiCount == 0 )
+			{
+				// same as in run(), the task ends and the next pumped message schedules a new one
+				m_uiRunThread.store( 0 );
+
+				unsigned int uiNotRunning = 0;
+				if( !m_qMessages.empty() && m_uiRunThread.compareExchange( uiNotRunning, 1 ) )
+					continue;
+
+				return;
+			}
+
+			deliverMessages( &m_vpBatch[0], uiCount );
+
+			releaseMessages( uiCount );
+			uiDelivered += uiCount;
+		}
+
+		// there are more messages, queue the broker again so the pool threads are shared fairly between the brokers
+		schedule();
+	}
+
+
+	/**
+	 * @brief	Called by the thread pool when it was shut down before the broker was executed.
+	 *
+	 * @note	m_uiRunThread is still set, so the queued messages are delivered by an own thread instead.
+	 */
+	void MessageBroker::cancel()
+	{
+		start();
+	}
+
+
+	/**
+	 * @brief	Starts the delivery of the queued messages, either in the thread pool or in a new thread.
+	 *
+	 * @note	Only called by whoever set m_uiRunThread to 1, so the messages of this broker are never delivered
+	 * 			by two threads at once. If the pool was shut down a new thread is used as well.
+	 */
+	void MessageBroker::schedule()
+	{
+		ThreadPool* pPool = sm_pThreadPool;
+		if( !pPool || !pPool->submit( this ) )
+			start();
+	}
+
+
+	/**
+	 * @brief	Blocks until a message is queued or the broker is destroyed, used by run().
+	 */
+	void MessageBroker::waitForMessage()
+	{
+		if( m_uiSpinCount > 0 && spinForMessage() )
+			return;
+
+		m_mxQueue.lock();
+
+		// pumpMessage() checks m_uiSleeping after pushing, so either it sees the flag or the queue is not empty here
+		m_uiSleeping.store( 1 );
+
+		while( m_qMessages.empty() && m_uiRunThread.load() )
+			m_cvQueue.wait( m_mxQueue );
+
+		m_uiSleeping.store( 0 );
+
+		m_mxQueue.unlock();
+	}
 
-		while( m_bRunThread )
+
+	/**
+	 * @brief	Polls the message queue up to m_uiSpinCount times, used before the thread goes to sleep.
+	 *
+	 * @return	true if a message arrived, false if the thread should go to sleep.
+	 */
+	bool MessageBroker::spinForMessage()
+	{
+		for( unsigned int i = 0; i < m_uiSpinCount; i++ )
 		{
-			// wait for a new message
-			while( m_lMessageQueue.empty() && m_bRunThread )
-				Thread::sleep(0);
-
-			// get the queues first element and instantly remove it from the queue so that it is not used twice
-			m_mxQueue.lock();
-			Message* pMessage = m_lMessageQueue.front();
-
-			deliverMessage( pMessage );
-			
-			m_lMessageQueue.pop();
-			m_mxQueue.unlock();
-
-			// delete the message to prevent memory holes, the listeners should have finished processing the data
-			delete pMessage;
-			
-			// when the thread is not set to run the whole time, quit the thread if the message queue is empty
-			if( !m_bRunContinuously )
-				m_bRunThread = !m_lMessageQueue.empty();
+			if( !m_qMessages.empty() )
+				return true;
+
+#if defined(__i386__) || defined(__x86_64__)
+			__builtin_ia32_pause();
+#endif
 		}
+
+		return false;
+	}
+
+
+	/**
+	 * @brief	Takes up to m_uiMaxBatchSize messages from the queue and puts them into m_vpBatch.
+	 *
+	 * @return	The number of messages taken, 0 if the queue is empty.
+	 */
+	unsigned int MessageBroker::popMessages()
+	{
+		if( m_vpBatch.size() != m_uiMaxBatchSize )
+			m_vpBatch.resize( m_uiMaxBatchSize );
+
+		unsigned int uiCount = 0;
+		while( uiCount < m_vpBatch.size() && m_qMessages.pop( m_vpBatch[uiCount] ) )
+			uiCount++;
+
+		return uiCount;
 	}
 
 
 	/**
-	 * @brief 	Helper methods to deliver the given message to all listeners.
+	 * @brief 	Helper methods to deliver the given messages to all listeners.
 	 *
-	 * @param pMessage	The message to deliver.
+	 * @param ppMessages	The messages to deliver, in the order they were pumped.
+	 * @param uiCount		The number of messages.
+	 * @param pView			If non-null, the only message to deliver, ppMessages is ignored then.
 	 */
-	void MessageBroker::deliverMessage( Message* pMessage )
+	void MessageBroker::deliverMessages( Message const * const * ppMessages, size_t uiCount, const MessageView* pView )
 	{
-		// if no listener requested exclusive delivery, deliver the message to all listeners
-		if( m_pExclusiveListener == NULL && !m_lListeners.empty() )
+		// if no listener requested exclusive delivery, deliver the messages to all listeners
+		if( m_pExclusiveListener == NULL )
 		{
-			m_mxListener.lock();
+			unsigned int uiReaderSlot;
+			ListenerArray const * pListeners = beginRead( uiReaderSlot );
+
+			// the number of messages every listener took, kept on the stack for the usual number of listeners
+			size_t auiStackProgress[16];
+			std::vector< size_t > vuiHeapProgress;
+			size_t* puiProgress = auiStackProgress;
+			if( pListeners->size() > 16 )
+			{
+				vuiHeapProgress.resize( pListeners->size() );
+				puiProgress = &vuiHeapProgress[0];
+			}
 
-			// build a stack of listeners that have not received the message yet
-			std::list< MessageListener* > lWaitList( m_lListeners.begin(), m_lListeners.end() );
+			for( size_t i = 0; i < pListeners->size(); i++ )
+				puiProgress[i] = 0;
 
-			for( std::list< MessageListener* >::iterator it = lWaitList.begin(); it != lWaitList.end(); it = lWaitList.erase( it ) )
+			// if not all messages can be dealt with now, the listener will be called again after all the others
+			size_t uiWaiting = pListeners->size();
+			while( uiWaiting > 0 )
 			{
-				// if the message can not be dealt with now, the listener should return false and will be pushed to the end of the listener stack
-				if( !(*it)->cbMessage( pMessage ) )
-					lWaitList.push_back( (*it) );
+				for( size_t i = 0; i < pListeners->size(); i++ )
+				{
+					if( puiProgress[i] < uiCount )
+					{
+						if( pView != NULL )
+							puiProgress[i] += (*pListeners)[i]->cbMessageView( *pView ) ? 1 : 0;
+						else
+							puiProgress[i] += (*pListeners)[i]->cbMessages( ppMessages + puiProgress[i], uiCount - puiProgress[i] );
+						if( puiProgress[i] >= uiCount )
+							uiWaiting--;
+					}
+				}
 			}
 
-			m_mxListener.unlock();
+			endRead( uiReaderSlot );
 		}
-		// else deliver the message only to the current exclusive listener
+		// else deliver the messages only to the current exclusive listener
 		else if( m_pExclusiveListener != NULL )
 		{
 			m_mxExclusiveListener.lock();
 
-			bool bRet = false;
+			size_t uiDelivered = 0;
 			do {
-				bRet = m_pExclusiveListener->cbMessage( pMessage );
-			} while( !bRet );
+				if( pView != NULL )
+					uiDelivered += m_pExclusiveListener->cbMessageView( *pView ) ? 1 : 0;
+				else
+					uiDelivered += m_pExclusiveListener->cbMessages( ppMessages + uiDelivered, uiCount - uiDelivered );
+			} while( uiDelivered < uiCount );
 
 			m_mxExclusiveListener.unlock();
 		}
 	}
 
+
+	/**
+	 * @brief	Releases the references of the queue to the first uiCount messages of m_vpBatch after they were delivered.
+	 *
+	 * @note	Messages that no listener retained are deleted, this prevents memory holes.
+	 *
+	 * @param	uiCount	The number of messages to release.
+	 */
+	void MessageBroker::releaseMessages( unsigned int uiCount )
+	{
+		for( unsigned int i = 0; i < uiCount; i++ )
+			m_vpBatch[i]->release();
+	}
+
+
+
+	/**
+	 * @brief	Starts reading the listener array, the array stays valid until endRead() is called.
+	 *
+	 * @param [out]	uiReaderSlot	Receives the slot that has to be passed to endRead().
+	 *
+	 * @return	The current listener array.
+	 */
+	MessageBroker::ListenerArray const * MessageBroker::beginRead( unsigned int& uiReaderSlot )
+	{
+		// count this reader before loading the array, so a writer that replaced the array either waits for it or it gets the new array
+		uiReaderSlot = m_uiReaderEpoch.load() & 1;
+		m_auiReaders[uiReaderSlot].fetchAdd( 1 );
+
+		return m_pListeners.load();
+	}
+
+
+	/**
+	 * @brief	Ends reading the listener array.
+	 *
+	 * @param	uiReaderSlot	The slot returned by beginRead().
+	 */
+	void MessageBroker::endRead( unsigned int uiReaderSlot )
+	{
+		m_auiReaders[uiReaderSlot].fetchAdd( (unsigned int)-1 );
+	}
+
+
+	/**
+	 * @brief	Replaces the listener array, the old one is retired until no one reads it. m_mxListener has to be locked.
+	 *
+	 * @param [in]	pListeners	The new listener array.
+	 */
+	void MessageBroker::publishListeners( ListenerArray* pListeners )
+	{
+		m_vpRetiredListeners.push_back( m_pListeners.exchange( pListeners ) );
+		m_uiNumListeners.store( pListeners->size() );
+	}
+
+
+	/**
+	 * @brief	Blocks until all readers that might still use a retired listener array are done. m_mxListener has to be locked.
+	 *
+	 * @note	New readers count themselves in the other slot, so they can not keep the writer waiting. A reader might
+	 * 			have read the epoch before the previous writer switched it, hence both slots are waited for.
+	 */
+	void MessageBroker::waitForReaders()
+	{
+		for( unsigned int i = 0; i < 2; i++ )
+		{
+			unsigned int uiOldSlot = m_uiReaderEpoch.fetchAdd( 1 ) & 1;
+
+			while( m_auiReaders[uiOldSlot].load() != 0 )
+				Thread::sleep( 0 );
+		}
+	}
+
+
+	/**
+	 * @brief	Frees the retired listener arrays. m_mxListener has to be locked and no reader may use them anymore.
+	 */
+	void MessageBroker::reclaimListeners()
+	{
+		for( unsigned int i = 0; i < m_vpRetiredListeners.size(); i++ )
+			delete m_vpRetiredListeners[i];
+
+		m_vpRetiredListeners.clear();
+	}
+
 }
@@ -15,8 +15,53 @@ subject to the following restrictions:
 /// This file was written by Jürgen Lorenz and Jörn Teuber
 
 #include "MessageListener.h"
+#include "MessageView.h"
 
 namespace oocl
 {
+	/**
+	 * @brief	This is the callback method for a batch of messages of the same type.
+	 *
+	 * @note	The broker hands over all messages that were queued at once, so overwrite this if you can process
+	 * 			several messages cheaper than one by one. The default calls cbMessage() for every message.
+	 * 			The messages of the batch are only valid during this call unless you keep a MessagePtr to them.
+	 *
+	 * @param [in]	ppMessages	the messages in the order they were pumped.
+	 * @param	uiCount			the number of messages.
+	 *
+	 * @return	the number of messages you have processed, starting with the first one. The remaining messages
+	 * 			will be delivered to you again later.
+	 */
+	size_t MessageListener::cbMessages( Message const * const * ppMessages, size_t uiCount )
+	{
+		for( size_t i = 0; i < uiCount; i++ )
+		{
+			if( !cbMessage( ppMessages[i] ) )
+				return i;
+		}
+
+		return uiCount;
+	}
+
+
+	/**
+	 * @brief	This is the callback method for received messages that are delivered while they are still in the receive buffer.
+	 *
+	 * @note	Called instead of cbMessage() by the DirectConNetwork and by synchronous brokers for received messages.
+	 * 			Overwrite this to read the fields you need without creating a message object. The default creates
+	 * 			the message and calls cbMessage().
+	 *
+	 * @param	view	the received message, only valid during this call.
+	 *
+	 * @return	return true if you have processed the data, false if you want to be called later with the same message.
+	 */
+	bool MessageListener::cbMessageView( const MessageView& view )
+	{
+		Message* pMessage = view.getMessage();
+		if( pMessage == NULL )
+			return true;
+
+		return cbMessage( pMessage );
+	}
 
 }
\ No newline at end of file
@@ -0,0 +1,79 @@
+/*
+Object Oriented Communication Library
+Copyright (c) 2011 Jürgen Lorenz and Jörn Teuber
+
+This software is provided 'as-is', without any express or implied warranty.
+In no event will the authors be held liable for any damages arising from the use of this software.
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it freely,
+subject to the following restrictions:
+
+1. The origin of this software must not be misrepresented; you must not claim that you wrote the original software. If you use this software in a product, an acknowledgment in the product documentation would be appreciated but is not required.
+2. Altered source versions must be plainly marked as such, and must not be misrepresented as being the original software.
+3. This notice may not be removed or altered from any source distribution.
+*/
+// This file was written by Jörn Teuber
+
+#include "MessagePool.h"
+#include "Message.h"
+
+namespace oocl
+{
+	/**
+	 * @brief	Constructor.
+	 *
+	 * @param	uiCapacity	The maximum number of kept messages, will be rounded up to the next power of two.
+	 */
+	MessagePool::MessagePool( unsigned int uiCapacity )
+		: m_qFree( uiCapacity )
+	{
+	}
+
+
+	/**
+	 * @brief	Destructor, deletes the kept messages.
+	 */
+	MessagePool::~MessagePool()
+	{
+		Message* pMessage = NULL;
+		while( m_qFree.pop( pMessage ) )
+			delete pMessage;
+	}
+
+
+	/**
+	 * @brief	Takes a message out of the pool.
+	 *
+	 * @note	Does not wait if another thread is taking a message at the same time, the caller allocates one instead.
+	 *
+	 * @return	A released message or NULL if there is none.
+	 */
+	Message* MessagePool::acquire()
+	{
+		Message* pMessage = NULL;
+
+		if( m_mxAcquire.try_lock() )
+		{
+			if( !m_qFree.pop( pMessage ) )
+				pMessage = NULL;
+
+			m_mxAcquire.unlock();
+		}
+
+		return pMessage;
+	}
+
+
+	/**
+	 * @brief	Puts a released message into the pool, can be called from any thread.
+	 *
+	 * @param [in]	pMessage	The message, it must not be referenced anymore.
+	 *
+	 * @return	true if the pool took the message, false if it is full and the caller has to delete the message.
+	 */
+	bool MessagePool::recycle( Message* pMessage )
+	{
+		return m_qFree.tryPush( pMessage );
+	}
+
+} /* namespace oocl */
@@ -0,0 +1,109 @@
+/*
+Object Oriented Communication Library
+Copyright (c) 2011 Jürgen Lorenz and Jörn Teuber
+
+This software is provided 'as-is', without any express or implied warranty.
+In no event will the authors be held liable for any damages arising from the use of this software.
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it freely,
+subject to the following restrictions:
+
+1. The origin of this software must not be misrepresented; you must not claim that you wrote the original software. If you use this software in a product, an acknowledgment in the product documentation would be appreciated but is not required.
+2. Altered source versions must be plainly marked as such, and must not be misrepresented as being the original software.
+3. This notice may not be removed or altered from any source distribution.
+*/
+// This file was written by Jörn Teuber
+
+#include "MessageView.h"
+
+namespace oocl
+{
+	/**
+	 * @brief	Constructor.
+	 *
+	 * @param	pcFrame	A complete message including its header, has to stay valid as long as the view.
+	 */
+	MessageView::MessageView( const char* pcFrame )
+		: m_pcFrame( pcFrame )
+		, m_uiHeaderLength( 0 )
+		, m_uiBodyLength( 0 )
+		, m_uiSenderID( 0 )
+		, m_pMessage( NULL )
+	{
+		m_uiHeaderLength = Message::readHeader( pcFrame, m_uiBodyLength );
+	}
+
+
+	/**
+	 * @brief	Destructor, releases the created message.
+	 */
+	MessageView::~MessageView()
+	{
+		if( m_pMessage != NULL )
+			m_pMessage->release();
+	}
+
+
+	/**
+	 * @brief	Set the PeerID of the sender, it is passed on to the message created by getMessage().
+	 *
+	 * @param	uiSenderID	The PeerID of the sender.
+	 */
+	void MessageView::setSenderID( unsigned int uiSenderID )
+	{
+		m_uiSenderID = uiSenderID;
+
+		if( m_pMessage != NULL )
+			m_pMessage->setSenderID( uiSenderID );
+	}
+
+
+	/**
+	 * @brief	Return the type ID of the message.
+	 *
+	 * @return	The message's type.
+	 */
+	unsigned short MessageView::getType() const
+	{
+		unsigned short usType = 0;
+		std::memcpy( &usType, m_pcFrame, sizeof(unsigned short) );
+
+		return usType;
+	}
+
+
+	/**
+	 * @brief	Creates the message from the frame on the first call.
+	 *
+	 * @note	The message lives as long as the view, retain it to keep it longer.
+	 *
+	 * @return	The message or NULL if the type is not registered or the frame is invalid.
+	 */
+	Message* MessageView::getMessage() const
+	{
+		if( m_pMessage == NULL )
+		{
+			m_pMessage = Message::createFromString( m_pcFrame );
+			if( m_pMessage == NULL )
+				return NULL;
+
+			m_pMessage->retain();
+			if( m_uiSenderID != 0 )
+				m_pMessage->setSenderID( m_uiSenderID );
+		}
+
+		return m_pMessage;
+	}
+
+
+	/**
+	 * @brief	Keeps the message beyond the lifetime of the view.
+	 *
+	 * @return	A reference to the message, empty if the message could not be created.
+	 */
+	MessagePtr MessageView::retain() const
+	{
+		return MessagePtr( getMessage() );
+	}
+
+} /* namespace oocl */
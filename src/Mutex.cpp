@@ -27,7 +27,7 @@ namespace oocl
 #if defined USE_PTHREADS
 		m_mutex = PTHREAD_MUTEX_INITIALIZER;
 #elif defined USE_WINTHREADS
-		m_hMutex = CreateMutex( NULL, FALSE, NULL);
+		InitializeCriticalSection( &m_csMutex );
 #endif
 	}
 
@@ -38,7 +38,11 @@ namespace oocl
 	Mutex::~Mutex()
 	{
 		m_bLocked = false;
+#if defined USE_WINTHREADS
+		DeleteCriticalSection( &m_csMutex );
+#else
 		unlock();
+#endif
 	}
 
 
@@ -52,7 +56,7 @@ namespace oocl
 #elif defined USE_PTHREADS
 		pthread_mutex_lock( &m_mutex );
 #elif defined USE_WINTHREADS
-		WaitForSingleObject( m_hMutex, 0 );
+		EnterCriticalSection( &m_csMutex );
 #endif
 		m_bLocked = true;
 	}
@@ -71,7 +75,7 @@ namespace oocl
 #elif defined USE_PTHREADS
 		return pthread_mutex_trylock( &m_mutex ) == 0;
 #elif defined USE_WINTHREADS
-		return WaitForSingleObject( m_hMutex, 0 ) == WAIT_OBJECT_0;
+		return TryEnterCriticalSection( &m_csMutex ) != 0;
 #endif
 	}
 
@@ -85,7 +89,7 @@ namespace oocl
 #elif defined USE_PTHREADS
 		pthread_mutex_unlock( &m_mutex );
 #elif defined USE_WINTHREADS
-		ReleaseMutex( m_hMutex );
+		LeaveCriticalSection( &m_csMutex );
 #endif
 		m_bLocked = false;
 	}
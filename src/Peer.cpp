@@ -15,6 +15,7 @@ subject to the following restrictions:
 // This file was written by Jörn Teuber
 
 #include "Peer.h"
+#include "RoutingTable.h"
 
 namespace oocl
 {
@@ -30,12 +31,20 @@ namespace oocl
 		m_ucConnectStatus( 0 ),
 		m_pSocketTCP( NULL ),
 		m_pSocketUDPOut( NULL ),
+		m_uiCodecs( 0 ),
+		m_fragmenter( sizeof(PeerID) ),
+		m_pRoutingTable( NULL ),
+		m_uiSlot( 0 ),
+		m_uiRoutings( 0 ),
+		m_writer( this ),
 		m_strHostname( strHostname ),
 		m_uiIP( 0 ),
 		m_usPort( usPeerPort ),
 		m_uiPeerID( ++sm_uiNumPeers ),
 		m_uiUserID( 0 ),
-		m_bActive( true )
+		m_bActive( true ),
+		m_eFlushPolicy( Socket::FP_Immediate ),
+		m_uiFlushThreshold( 0 )
 	{
 	}
 
@@ -50,12 +59,20 @@ namespace oocl
 		m_ucConnectStatus( 0 ),
 		m_pSocketTCP( NULL ),
 		m_pSocketUDPOut( NULL ),
+		m_uiCodecs( 0 ),
+		m_fragmenter( sizeof(PeerID) ),
+		m_pRoutingTable( NULL ),
+		m_uiSlot( 0 ),
+		m_uiRoutings( 0 ),
+		m_writer( this ),
 		m_strHostname(),
 		m_uiIP( uiIP ),
 		m_usPort( usPeerPort ),
 		m_uiPeerID( ++sm_uiNumPeers ),
 		m_uiUserID( 0 ),
-		m_bActive( true )
+		m_bActive( true ),
+		m_eFlushPolicy( Socket::FP_Immediate ),
+		m_uiFlushThreshold( 0 )
 	{
 	}
 
@@ -67,6 +84,13 @@ namespace oocl
 	{
 		if( m_ucConnectStatus > 0 )
 			disconnect();
+		else
+		{
+			m_sendQueue.close( false );
+			if( m_pRoutingTable != NULL )
+				m_pRoutingTable->removePeer( this );
+			stopWriter( false );
+		}
 
 		m_mxSockets.lock();
 		if( m_pSocketTCP != NULL )
@@ -97,17 +121,23 @@ namespace oocl
 			if( !connectSockets() )
 				return false;
 
-			ConnectMessage* pMsg = new ConnectMessage( usListeningPort, uiUserID );
+			ConnectMessage* pMsg = new ConnectMessage( usListeningPort, uiUserID, Codec::getSupportedCodecs() );
+			MessagePtr ptrMsg( pMsg );
 
 			m_mxSockets.lock();
 
+			m_wbSendBuffer.clear();
+			pMsg->serializeInto( m_wbSendBuffer );
+
 			// try to contact the peer twice
-			if( !m_pSocketTCP->write( pMsg->getMsgString() ) )
+			if( !m_pSocketTCP->write( m_wbSendBuffer.data(), m_wbSendBuffer.size() ) )
 			{
-				if( !m_pSocketTCP->write( pMsg->getMsgString() ) )
+				if( !m_pSocketTCP->write( m_wbSendBuffer.data(), m_wbSendBuffer.size() ) )
 				{
 					delete m_pSocketTCP;
+					m_pSocketTCP = NULL;
 					delete m_pSocketUDPOut;
+					m_pSocketUDPOut = NULL;
 
 					m_mxSockets.unlock();
 					return false;
@@ -115,29 +145,48 @@ namespace oocl
 			}
 
 			m_ucConnectStatus = 1;
-			
-			std::string strMsg;
-			m_pSocketTCP->read( strMsg );
-			Message* pMsg2 = Message::createFromString( strMsg.c_str() );
 
-			if( pMsg2->getType() == MT_ConnectMessage )
+			// wait for the answer, everything the peer sends after it stays in the decoder
+			const char* pcFrame = NULL;
+			unsigned int uiFrameLength = 0;
+			while( !m_frameDecoder.nextFrame( pcFrame, uiFrameLength ) )
+			{
+				if( m_frameDecoder.receive( m_pSocketTCP ) == 0 )
+				{
+					OOCL_LOG_ERROR( "oocl", "The peer did not answer the ConnectMessage" );
+
+					m_mxSockets.unlock();
+					return false;
+				}
+			}
+
+			Message* pMsg2 = Message::createFromString( pcFrame );
+			MessagePtr ptrMsg2( pMsg2 );
+
+			if( pMsg2 != NULL && pMsg2->getType() == MT_ConnectMessage )
 			{
 				if( ((ConnectMessage*)pMsg2)->getPeerID() > 0 )
 					m_uiPeerID = ((ConnectMessage*)pMsg2)->getPeerID();
 				m_usPort = ((ConnectMessage*)pMsg2)->getPort();
+				m_uiCodecs = ((ConnectMessage*)pMsg2)->getCodecs() & Codec::getSupportedCodecs();
 				m_ucConnectStatus = 2;
+
+				applyBatching();
 			}
 			else
 			{
-				Log::getLog("oocl")->logError( "The first message from a peer was not a ConnectMessage" );
+				OOCL_LOG_ERROR( "oocl", "The first message from a peer was not a ConnectMessage" );
 			}
 
 			m_mxSockets.unlock();
 
+			// the writer thread only exists while the peer is connected, disconnect() stops it
+			m_writer.start();
+
 			return true;
 		}
 
-		Log::getLog("oocl")->logWarning( "You tried to connect to a peer that is already connected" );
+		OOCL_LOG_WARNING( "oocl", "You tried to connect to a peer that is already connected" );
 
 		return false;
 	}
@@ -159,7 +208,7 @@ namespace oocl
 		{
 			if( !pTCPSocket->isValid() || !pTCPSocket->isConnected() ) // this would be very very strange, but better be safe
 			{
-				Log::getLog("oocl")->logError( "A peer connected but the tcp socket is not connected or invalid" );
+				OOCL_LOG_ERROR( "oocl", "A peer connected but the tcp socket is not connected or invalid" );
 				return false;
 			}
 
@@ -169,34 +218,45 @@ namespace oocl
 
 			if( pMsg->getPeerID() > 0 )
 				m_uiPeerID = pMsg->getPeerID();
+			m_uiCodecs = pMsg->getCodecs() & Codec::getSupportedCodecs();
 			m_pSocketTCP = pTCPSocket;
 
 			m_pSocketUDPOut = new BerkeleySocket( SOCK_DGRAM );
 			m_pSocketUDPOut->connect( m_uiIP, m_usPort );
 
-			ConnectMessage* pMsg = new ConnectMessage( usListeningPort, uiUserID );
+			ConnectMessage* pMsg = new ConnectMessage( usListeningPort, uiUserID, Codec::getSupportedCodecs() );
+			MessagePtr ptrMsg( pMsg );
+
+			m_wbSendBuffer.clear();
+			pMsg->serializeInto( m_wbSendBuffer );
 
 			// try to contact the peer twice
-			if( !m_pSocketTCP->write( pMsg->getMsgString() ) )
+			if( !m_pSocketTCP->write( m_wbSendBuffer.data(), m_wbSendBuffer.size() ) )
 			{
-				if( !m_pSocketTCP->write( pMsg->getMsgString() ) )
+				if( !m_pSocketTCP->write( m_wbSendBuffer.data(), m_wbSendBuffer.size() ) )
 				{
 					delete m_pSocketTCP;
+					m_pSocketTCP = NULL;
 					delete m_pSocketUDPOut;
+					m_pSocketUDPOut = NULL;
 
 					m_mxSockets.unlock();
 					return false;
 				}
 			}
 
+			applyBatching();
+
 			m_mxSockets.unlock();
 
 			m_ucConnectStatus = 2;
 
+			m_writer.start();
+
 			return true;
 		}
 
-		Log::getLog("oocl")->logWarning( "A peer tried to connect to you but you are already connected to each other" );
+		OOCL_LOG_WARNING( "oocl", "A peer tried to connect to you but you are already connected to each other" );
 
 		return false;
 	}
@@ -209,11 +269,19 @@ namespace oocl
 	 */
 	bool Peer::disconnect( bool bSendMessage )
 	{
+		// no more messages are routed to this peer, closing the queue first wakes a broker that waits for room in it
+		m_sendQueue.close( false );
+		if( m_pRoutingTable != NULL )
+			m_pRoutingTable->removePeer( this );
+
+		// the queued messages go out before the goodbye, unless the peer stopped receiving them
 		if( bSendMessage && m_ucConnectStatus > 0 )
+		{
+			stopWriter( true );
 			sendMessage( new DisconnectMessage() );
+		}
 
-		for( std::list<unsigned short>::iterator it = m_lusSubscribedMsgTypes.begin(); it != m_lusSubscribedMsgTypes.end(); ++it )
-			MessageBroker::getBrokerFor( (*it) )->unregisterListener( this );
+		stopWriter( false );
 
 		m_mxSockets.lock();
 
@@ -260,7 +328,7 @@ namespace oocl
 
 		if( !bUDPConnected || !bTCPConnected )
 		{
-			Log::getLogRef("oocl") << Log::EL_WARNING << "tried to connectSockets to peer " << m_uiPeerID << " but failed" << endl;
+			OOCL_LOG_WARNING( "oocl", "tried to connectSockets to peer " << m_uiPeerID << " but failed" );
 			m_ucConnectStatus = 0;
 			return false;
 		}
@@ -270,9 +338,11 @@ namespace oocl
 
 
 	/**
-	 * @brief	Gets the messages to which the peer has subscribed.
+	 * @brief	Queues a message for the writer thread, so that it can be used as listener of a MessageBroker.
+	 *
+	 * @note	The subscriptions of the peer do not need this, the RoutingTable of the network queues them.
 	 *
-	 * @param	pMessage [in]	The incoming message.
+	 * @param	pMessage [in]	The message to send.
 	 *
 	 * @return	true if it succeeds, false if it fails.
 	 */
@@ -280,25 +350,87 @@ namespace oocl
 	{
 		if( pMessage->isIncoming() || !m_bActive )
 		{
-//			Log::getLog("oocl")->logWarning("stopped incoming message from being sent back into the network");
+//			OOCL_LOG_WARNING( "oocl", "stopped incoming message from being sent back into the network" );
 			return true;
 		}
 
-		sendMessage( pMessage );
+		SerializedMessage* pSerialized = new SerializedMessage( pMessage );
+		pSerialized->retain();
+		queueMessage( pSerialized );
+		pSerialized->release();
 
 		return true;
 	}
 
 
+	/**
+	 * @brief	Puts a message into the send queue, called by the RoutingTable for every message the peer subscribed.
+	 *
+	 * @note	If the queue is full the overflow policy decides, see setSendQueue(). With OP_Disconnect the connection
+	 * 			is shut down here and the Peer2PeerNetwork removes the peer.
+	 *
+	 * @param	pMessage [in]	The serialized message, it is retained while it is queued.
+	 */
+	void Peer::queueMessage( SerializedMessage const * pMessage )
+	{
+		if( !m_bActive )
+			return;
+
+		switch( m_sendQueue.push( pMessage ) )
+		{
+		case SendQueue::PR_DroppedOldest:
+		case SendQueue::PR_DroppedNewest:
+			{
+				// only warn at powers of two, a peer that is too slow would flood the log otherwise
+				unsigned int uiDropped = m_sendQueue.getDroppedCount();
+				if( (uiDropped & (uiDropped - 1)) == 0 )
+					OOCL_LOG_WARNING( "oocl", "dropped " << uiDropped << " messages to peer " << m_uiPeerID << " because its send queue is full" );
+				break;
+			}
+		case SendQueue::PR_Overflow:
+			{
+				OOCL_LOG_WARNING( "oocl", "disconnecting peer " << m_uiPeerID << " because its send queue is full" );
+
+				// the writer may wait for the socket while holding m_mxSockets, the sockets are not deleted before
+				// disconnect() removed the peer from the routing table, which waits for this call to return
+				m_bActive = false;
+				if( m_pSocketTCP != NULL )
+					m_pSocketTCP->interrupt();
+				break;
+			}
+		default:
+			break;
+		}
+	}
+
+
 	/**
 	 * @brief	Sends a message to the connected peer.
 	 *
+	 * @note	A message that nobody retained is deleted afterwards.
+	 *
 	 * @param	pMessage [in]	The message to send.
 	 *
 	 * @return	true if it succeeds, false if it fails.
 	 */
 	bool Peer::sendMessage( Message const * const pMessage )
 	{
+		return send( pMessage, NULL );
+	}
+
+
+	/**
+	 * @brief	Sends a message to the connected peer, used by sendMessage() and the writer thread.
+	 *
+	 * @param	pMessage [in]		The message to send.
+	 * @param	pSerialized [in]	The message serialized already, NULL to serialize it here.
+	 *
+	 * @return	true if it succeeds, false if it fails.
+	 */
+	bool Peer::send( Message const * const pMessage, SerializedMessage const * pSerialized )
+	{
+		MessagePtr ptrMessage( pMessage );
+
 		if( !m_bActive )
 			return false;
 
@@ -314,20 +446,54 @@ namespace oocl
 				return true;
 			}
 
-			m_mxSockets.lock();
+			if( m_chunkWriter.needsChunks( pMessage ) )
+				return sendChunked( pMessage, pSerialized );
+
+			m_chunkWriter.lock( m_mxSockets );
 			if( !m_bActive )
+			{
+				m_mxSockets.unlock();
 				return false;
+			}
+
+			m_wbSendBuffer.clear();
 
 			bool bReturn = false;
 			if( pMessage->getProtocoll() == SOCK_DGRAM && m_pSocketUDPOut != NULL )
-				bReturn = m_pSocketUDPOut->write( pMessage->getMsgString()+std::string( (char*)&m_uiUserID, 4 ) );
+			{
+				// udp messages carry the PeerID of the sender behind the message
+				if( pSerialized != NULL )
+					m_wbSendBuffer.append( pSerialized->getFrame(), pSerialized->getFrameLength() );
+				else
+					pMessage->serializeInto( m_wbSendBuffer );
+				m_wbSendBuffer.appendInt( m_uiUserID );
+				bReturn = m_fragmenter.write( m_pSocketUDPOut, m_wbSendBuffer.data(), m_wbSendBuffer.size() );
+			}
+			else if( ReliableChannel::isReliable( pMessage->getProtocoll() ) && m_pSocketUDPOut != NULL )
+			{
+				if( pSerialized != NULL )
+					bReturn = m_reliable.send( pMessage->getProtocoll(), pSerialized->getFrame(), pSerialized->getFrameLength(), m_wbSendBuffer, &m_uiUserID, sizeof(PeerID) );
+				else
+					bReturn = m_reliable.send( pMessage, m_wbSendBuffer, &m_uiUserID, sizeof(PeerID) );
+
+				bReturn = bReturn && m_fragmenter.write( m_pSocketUDPOut, m_wbSendBuffer.data(), m_wbSendBuffer.size(), ReliableChannel::getFragmentID( m_wbSendBuffer.data() ) );
+			}
 			else if( pMessage->getProtocoll() == SOCK_STREAM && m_pSocketTCP != NULL )
-				bReturn = m_pSocketTCP->write( pMessage->getMsgString() );
+			{
+				if( pSerialized != NULL )
+					pSerialized->appendFrame( m_wbSendBuffer, m_uiCodecs, m_wbCompressBuffer );
+				else
+				{
+					pMessage->serializeInto( m_wbSendBuffer );
+					Codec::compressFrame( m_wbSendBuffer, m_uiCodecs, m_wbCompressBuffer );
+				}
+				bReturn = m_pSocketTCP->write( m_wbSendBuffer.data(), m_wbSendBuffer.size() );
+			}
 			else
-				Log::getLog("oocl")->logWarning("attempted to send a message over the network that was not intended for that (protocol 0)" );
+				OOCL_LOG_WARNING( "oocl", "attempted to send a message over the network that was not intended for that (protocol 0)" );
 
 			if( !bReturn )
-				Log::getLogRef("oocl") << Log::EL_ERROR << "failed to send a message to peer " << m_uiPeerID << endl;
+				OOCL_LOGF_ERROR( "oocl", "failed to send a message to peer %u", m_uiPeerID );
 
 			m_mxSockets.unlock();
 
@@ -335,17 +501,69 @@ namespace oocl
 		}
 		else if( m_ucConnectStatus == 1 )
 		{
-			Log::getLogRef("oocl") << Log::EL_WARNING << "Message was dropped because peer " << m_uiPeerID << " is not fully connected" << endl;
+			OOCL_LOGF_WARNING( "oocl", "Message was dropped because peer %u is not fully connected", m_uiPeerID );
 		}
 		else
 		{
-			Log::getLogRef("oocl") << Log::EL_WARNING << "Message was dropped because peer " << m_uiPeerID << " is not connected" << endl;
+			OOCL_LOGF_WARNING( "oocl", "Message was dropped because peer %u is not connected", m_uiPeerID );
 		}
 
 		return false;
 	}
 
 
+	/**
+	 * @brief	Sends a large message over tcp in chunks, other messages to the peer may be sent between them.
+	 *
+	 * @param	pMessage [in]		The message to send.
+	 * @param	pSerialized [in]	The message serialized already, NULL to serialize it here.
+	 *
+	 * @return	true if it succeeds, false if it fails.
+	 */
+	bool Peer::sendChunked( Message const * const pMessage, SerializedMessage const * pSerialized )
+	{
+		// serialized without the lock, it is only held for one chunk at a time
+		WriteBuffer wbMessage( pMessage->getBodyLength() + MSG_MAX_HEADER_LENGTH );
+		WriteBuffer wbScratch( 0 );
+
+		if( pSerialized != NULL )
+			pSerialized->appendFrame( wbMessage, m_uiCodecs, wbScratch );
+		else
+		{
+			pMessage->serializeInto( wbMessage );
+			Codec::compressFrame( wbMessage, m_uiCodecs, wbScratch );
+		}
+
+		unsigned short usStream = m_chunkWriter.beginStream();
+		unsigned int uiOffset = 0;
+		bool bReturn = true;
+
+		while( bReturn && uiOffset < wbMessage.size() )
+		{
+			if( uiOffset > 0 )
+				m_chunkWriter.yield();
+
+			m_mxSockets.lock();
+			if( !m_bActive || m_pSocketTCP == NULL )
+			{
+				m_mxSockets.unlock();
+				return false;
+			}
+
+			m_wbSendBuffer.clear();
+			m_chunkWriter.appendChunk( m_wbSendBuffer, usStream, wbMessage.data(), wbMessage.size(), uiOffset );
+			bReturn = m_pSocketTCP->write( m_wbSendBuffer.data(), m_wbSendBuffer.size() );
+
+			m_mxSockets.unlock();
+		}
+
+		if( !bReturn )
+			OOCL_LOGF_ERROR( "oocl", "failed to send a message to peer %u", m_uiPeerID );
+
+		return bReturn;
+	}
+
+
 	/**
 	 * @brief	Subscribe a message type at the connected peer.
 	 *
@@ -355,42 +573,51 @@ namespace oocl
 	 */
 	bool Peer::subscribe( unsigned short usType )
 	{
-		return sendMessage( new SubscribeMessage( usType ) );
+		// the subscription must not wait for the flush policy, the peer does not send anything before it arrived
+		return sendMessage( new SubscribeMessage( usType ) ) && flush();
 	}
 
 
 	/**
 	 * @brief	Called when a message of the connected peer was received.
 	 *
-	 * @param	pMessage [in]	The received message.
+	 * @note	The message is only created if someone listens for its type.
+	 *
+	 * @param	view [in]	The received message, still in the receive buffer.
 	 *
 	 * @return	true if it succeeds, false if it fails.
 	 */
-	bool Peer::receiveMessage( Message* pMessage )
+	bool Peer::receiveMessage( MessageView& view )
 	{
 		if( !m_bActive )
 			return false;
 
-		pMessage->setSenderID( m_uiPeerID );
+		view.setSenderID( m_uiPeerID );
 
-		switch( pMessage->getType() )
+		switch( view.getType() )
 		{
+		case MT_ReliableFrame:
+		case MT_AckFrame:
+			return receiveReliable( view );
+		case MT_FragmentFrame:
+			return receiveFragment( view );
 		case MT_SubscribeMessage:
 			{
-				unsigned short usType = ((SubscribeMessage*)pMessage)->getTypeToSubscribe();
-				MessageBroker::getBrokerFor( usType )->registerListener( this );
-				m_lusSubscribedMsgTypes.push_back( usType );
+				unsigned short usType = view.getField<unsigned short>( 0 );
+				if( m_pRoutingTable != NULL )
+					m_pRoutingTable->subscribe( this, usType );
 
-				Log::getLogRef( "oocl" ) << Log::EL_INFO << "Peer " << m_uiPeerID << " subscribed message " << usType << endl;
+				OOCL_LOG_INFO( "oocl", "Peer " << m_uiPeerID << " subscribed message " << usType );
 
 				break;
 			}
 		case MT_DisconnectMessage:
 			{
 #ifdef SIM_DELAY
-				MessageDelayer* pMD = new MessageDelayer( pMessage );
+				if( view.getMessage() != NULL )
+					new MessageDelayer( view.getMessage() );
 #else
-				MessageBroker::getBrokerFor( MT_DisconnectMessage )->pumpMessage( pMessage );
+				MessageBroker::getBrokerFor( MT_DisconnectMessage )->pumpMessage( view );
 #endif
 
 				disconnect( false );
@@ -398,10 +625,15 @@ namespace oocl
 				break;
 			}
 		default:
+			// frames nobody subscribed are dropped without creating a message or a broker
+			if( !MessageBroker::hasListenersFor( view.getType() ) )
+				break;
+
 #ifdef SIM_DELAY
-			MessageDelayer* pMD = new MessageDelayer( pMessage );
+			if( view.getMessage() != NULL )
+				new MessageDelayer( view.getMessage() );
 #else
-			MessageBroker::getBrokerFor( pMessage->getType() )->pumpMessage( pMessage );
+			MessageBroker::getBrokerFor( view.getType() )->pumpMessage( view );
 #endif
 			break;
 		}
@@ -409,6 +641,92 @@ namespace oocl
 		return true;
 	}
 
+	/**
+	 * @brief	Called when a frame of the reliable udp channel was received, delivers the messages that are complete now.
+	 *
+	 * @note	The acknowledgement is not sent here but by sendAck(), so that one answers a whole batch of datagrams.
+	 *
+	 * @param	view [in]	The MT_ReliableFrame or MT_AckFrame.
+	 *
+	 * @return	true if it succeeds, false if the frame is invalid.
+	 */
+	bool Peer::receiveReliable( MessageView& view )
+	{
+		if( !m_reliable.receive( view.getFrame(), view.getHeaderLength() + view.getBodyLength() ) )
+		{
+			OOCL_LOG_WARNING( "oocl", "received an invalid reliable udp frame from peer " << m_uiPeerID );
+			return false;
+		}
+
+		const char* pcFrame = NULL;
+		unsigned int uiFrameLength = 0;
+		while( m_reliable.nextMessage( pcFrame, uiFrameLength ) )
+		{
+			MessageView viewInner( pcFrame );
+			receiveMessage( viewInner );
+		}
+
+		return true;
+	}
+
+	/**
+	 * @brief	Called when a fragment of a large udp message was received, delivers the message once it is complete.
+	 *
+	 * @param	view [in]	The MT_FragmentFrame.
+	 *
+	 * @return	true if it succeeds, false if the message is not complete yet or the fragment is invalid.
+	 */
+	bool Peer::receiveFragment( MessageView& view )
+	{
+		const char* pcFrame = NULL;
+		unsigned int uiFrameLength = 0;
+
+		if( !m_fragmenter.receive( view.getFrame(), view.getHeaderLength() + view.getBodyLength(), pcFrame, uiFrameLength ) )
+			return false;
+
+		MessageView viewMessage( pcFrame );
+		return receiveMessage( viewMessage );
+	}
+
+	/**
+	 * @brief	Acknowledges the reliable udp messages that were received since the last call.
+	 *
+	 * @return	true if it succeeds, false if it fails.
+	 */
+	bool Peer::sendAck()
+	{
+		if( !m_reliable.isAckPending() )
+			return true;
+
+		bool bReturn = false;
+
+		m_mxSockets.lock();
+		if( m_bActive && m_pSocketUDPOut != NULL )
+		{
+			m_wbSendBuffer.clear();
+			m_reliable.appendAck( m_wbSendBuffer );
+			m_wbSendBuffer.appendInt( m_uiUserID );
+			bReturn = m_pSocketUDPOut->write( m_wbSendBuffer.data(), m_wbSendBuffer.size() ) && m_pSocketUDPOut->flush();
+		}
+		m_mxSockets.unlock();
+
+		return bReturn;
+	}
+
+	/**
+	 * @brief	Sends the reliable udp messages again that were not acknowledged in time, called regularly by the Peer2PeerNetwork.
+	 *
+	 * @return	The number of milliseconds until this has to be called again, -1 if nothing waits for an acknowledgement.
+	 */
+	int Peer::resendDue()
+	{
+		m_mxSockets.lock();
+		int iTimeoutMS = m_reliable.resendDue( m_bActive ? m_pSocketUDPOut : NULL, m_fragmenter );
+		m_mxSockets.unlock();
+
+		return iTimeoutMS;
+	}
+
 	/**
 	 * @brief	Checks whether the peer is truly connected and returns the status.
 	 *
@@ -462,6 +780,124 @@ namespace oocl
 		return m_usPort;
 	}
 
+	/**
+	 * @brief	Get the number of messages to this peer that were dropped because its send queue was full.
+	 *
+	 * @return	The number of dropped messages.
+	 */
+	unsigned int Peer::getDroppedCount()
+	{
+		return m_sendQueue.getDroppedCount();
+	}
+
+
+	/**
+	 * @brief	Sets when messages to this peer are sent, see Socket::setBatching().
+	 *
+	 * @note	The policy is applied to the sockets as soon as the handshake with the peer is done.
+	 *
+	 * @param	ePolicy		The flush policy.
+	 * @param	uiThreshold	The number of bytes for FP_SizeThreshold or the number of microseconds for FP_Deadline.
+	 */
+	void Peer::setBatching( Socket::EFlushPolicy ePolicy, unsigned int uiThreshold )
+	{
+		m_mxSockets.lock();
+
+		m_eFlushPolicy = ePolicy;
+		m_uiFlushThreshold = uiThreshold;
+
+		if( m_ucConnectStatus == 2 )
+			applyBatching();
+
+		m_mxSockets.unlock();
+	}
+
+	/**
+	 * @brief	Sets the size of the chunks that large tcp messages to this peer are split into, see ChunkWriter.
+	 *
+	 * @param	uiChunkSize	Messages longer than this are sent in chunks of this size, 0 sends every message at once.
+	 */
+	void Peer::setChunkSize( unsigned int uiChunkSize )
+	{
+		m_mxSockets.lock();
+		m_chunkWriter.setChunkSize( uiChunkSize );
+		m_mxSockets.unlock();
+	}
+
+	/**
+	 * @brief	Sets the path MTU that udp messages to this peer are split for, see DatagramFragmenter.
+	 *
+	 * @param	uiMTU	The largest ip packet that reaches the peer unfragmented, 0 asks the socket.
+	 */
+	void Peer::setPathMTU( unsigned int uiMTU )
+	{
+		m_mxSockets.lock();
+		m_fragmenter.setPathMTU( uiMTU );
+		m_mxSockets.unlock();
+	}
+
+	/**
+	 * @brief	Sets how many messages may wait for the writer thread and what happens to those that do not fit anymore.
+	 *
+	 * @note	Only the messages that are delivered by a MessageBroker are queued, sendMessage() sends right away.
+	 *
+	 * @param	uiCapacity	The number of messages that may wait.
+	 * @param	ePolicy		What to do when the queue is full, see SendQueue::EOverflowPolicy.
+	 */
+	void Peer::setSendQueue( unsigned int uiCapacity, SendQueue::EOverflowPolicy ePolicy )
+	{
+		m_sendQueue.setCapacity( uiCapacity, ePolicy );
+	}
+
+	/**
+	 * @brief	Sends all messages that are queued because of the flush policy.
+	 *
+	 * @return	true if it succeeds, false if it fails.
+	 */
+	bool Peer::flush()
+	{
+		bool bReturn = true;
+
+		m_mxSockets.lock();
+		if( m_pSocketTCP != NULL )
+			bReturn &= m_pSocketTCP->flush();
+		if( m_pSocketUDPOut != NULL )
+			bReturn &= m_pSocketUDPOut->flush();
+		m_mxSockets.unlock();
+
+		return bReturn;
+	}
+
+	/**
+	 * @brief	Sends the queued messages whose deadline has passed, called regularly by the Peer2PeerNetwork.
+	 *
+	 * @return	true if it succeeds, false if it fails.
+	 */
+	bool Peer::flushIfDue()
+	{
+		bool bReturn = true;
+
+		m_mxSockets.lock();
+		if( m_pSocketTCP != NULL )
+			bReturn &= m_pSocketTCP->flushIfDue();
+		if( m_pSocketUDPOut != NULL )
+			bReturn &= m_pSocketUDPOut->flushIfDue();
+		m_mxSockets.unlock();
+
+		return bReturn;
+	}
+
+	/**
+	 * @brief	Applies the flush policy to the sockets, m_mxSockets has to be locked.
+	 */
+	void Peer::applyBatching()
+	{
+		if( m_pSocketTCP != NULL )
+			m_pSocketTCP->setBatching( m_eFlushPolicy, m_uiFlushThreshold );
+		if( m_pSocketUDPOut != NULL )
+			m_pSocketUDPOut->setBatching( m_eFlushPolicy, m_uiFlushThreshold );
+	}
+
 
 	/**
 	 * @brief	Deactivate this peer and prevent it from sending and receiving messages.
@@ -473,11 +909,56 @@ namespace oocl
 		m_mxSockets.unlock();
 	}
 
+	/**
+	 * @brief	Closes the send queue and waits for the writer thread to finish.
+	 *
+	 * @param	bDrain	true to send the queued messages first, false to drop them and wake a writer that waits for the socket.
+	 * 					Draining gives up if the peer does not receive a message for PEER_DRAIN_TIMEOUT milliseconds.
+	 */
+	void Peer::stopWriter( bool bDrain )
+	{
+		m_sendQueue.close( !bDrain );
+
+		if( !bDrain || !m_sendQueue.waitUntilSent( PEER_DRAIN_TIMEOUT ) )
+		{
+			m_bActive = false;
+			if( m_pSocketTCP != NULL )
+				m_pSocketTCP->interrupt();
+		}
+
+		m_writer.join();
+	}
+
+
+	/**
+	 * @brief	Constructor.
+	 *
+	 * @param [in]	pPeer	The peer whose messages are sent.
+	 */
+	Peer::Writer::Writer( Peer* pPeer )
+		: m_pPeer( pPeer )
+	{
+	}
+
+	/**
+	 * @brief	Sends the queued messages until the queue is closed and empty.
+	 */
+	void Peer::Writer::run()
+	{
+		SerializedMessage const * pMessage = NULL;
+		while( m_pPeer->m_sendQueue.pop( pMessage ) )
+		{
+			m_pPeer->send( pMessage->getMessage(), pMessage );
+			pMessage->release();
+		}
+	}
+
 	
 #ifdef SIM_DELAY
 	Peer::MessageDelayer::MessageDelayer( Message* pMessage )
 		: m_pMessage( pMessage )
 	{
+		m_pMessage->retain();
 		start();
 	}
 
@@ -486,6 +967,7 @@ namespace oocl
 		srand( clock() );
 		Thread::sleep( 100 + rand() % 100 );
 		MessageBroker::getBrokerFor( m_pMessage->getType() )->pumpMessage( m_pMessage );
+		m_pMessage->release();
 	}
 #endif
 }
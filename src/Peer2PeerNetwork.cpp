@@ -27,6 +27,12 @@ namespace oocl
 	Peer2PeerNetwork::Peer2PeerNetwork( unsigned short usListeningPort, unsigned int uiUserID )
 		: m_pServerSocketUDP( NULL )
 		, m_pServerSocketTCP( NULL )
+		, m_eFlushPolicy( Socket::FP_Immediate )
+		, m_uiFlushThreshold( 0 )
+		, m_uiChunkSize( 16384 )
+		, m_uiPathMTU( 0 )
+		, m_uiSendQueueCapacity( 1024 )
+		, m_eOverflowPolicy( SendQueue::OP_Block )
 		, m_bActive( true )
 		, m_usListeningPort( usListeningPort )
 		, m_uiUserID( uiUserID )
@@ -48,15 +54,22 @@ namespace oocl
 	Peer2PeerNetwork::~Peer2PeerNetwork(void)
 	{
 		m_bActive = false;
+		m_reactor.interrupt();
 		join();
 
 		disconnect();
 
-		for( std::list<Peer*>::iterator it = m_lpPeers.begin(); it != m_lpPeers.end(); ++it )
-			delete (*it);
+		// the network thread is stopped, so nothing refers to the removed peers anymore
+		m_mxPeers.lock();
+		reclaimPeers();
+		m_mxPeers.unlock();
 
-		m_lpPeers.clear();
-		m_lpSocketsWithoutPeers.clear();
+		for( std::map<Socket*, FrameDecoder*>::iterator it = m_mapSocketsWithoutPeers.begin(); it != m_mapSocketsWithoutPeers.end(); ++it )
+		{
+			delete it->first;
+			delete it->second;
+		}
+		m_mapSocketsWithoutPeers.clear();
 	}
 
 
@@ -101,23 +114,33 @@ namespace oocl
 	/**
 	 * @brief	Disconnects a peer and removes it from the network.
 	 *
+	 * @note	The peer object is freed by the network thread, as the reactor might be about to call it.
+	 *
 	 * @param [in]	uiPeerID	The PeerID of the peer to remove.
 	 */
 	void Peer2PeerNetwork::subPeer( PeerID uiPeerID )
 	{
+		m_mxPeers.lock();
+
 		Peer* pPeer = getPeerByID( uiPeerID );
 		if( pPeer != NULL )
 		{
 			m_mapPeersByID.erase( uiPeerID );
 			m_lpPeers.remove( pPeer );
 
-			delete pPeer;
+			m_reactor.unregisterSocket( pPeer->m_pSocketTCP );
+			pPeer->disconnect();
+			m_vpRetiredPeers.push_back( pPeer );
 		}
+
+		m_mxPeers.unlock();
 	}
 
 
 	/**
 	 * @brief	Disconnects from all peers currently in the network and stops accepting incoming messages.
+	 *
+	 * @note	The peer objects are freed by the network thread, as the reactor might be about to call them.
 	 */
 	void Peer2PeerNetwork::disconnect()
 	{
@@ -127,7 +150,9 @@ namespace oocl
 		{
 			if( (*it) != NULL )
 			{
-				delete (*it);
+				m_reactor.unregisterSocket( (*it)->m_pSocketTCP );
+				(*it)->disconnect();
+				m_vpRetiredPeers.push_back( *it );
 				(*it) = NULL;
 			}
 		}
@@ -139,6 +164,110 @@ namespace oocl
 	}
 
 
+	/**
+	 * @brief	Sets when messages to the peers are sent, applies to all current and future peers.
+	 *
+	 * @note	Batching trades latency for fewer system calls, see Socket::setBatching(). With FP_SizeThreshold
+	 * 			call flush() after a burst of messages, with FP_Deadline the network thread flushes on time.
+	 *
+	 * @param	ePolicy		The flush policy.
+	 * @param	uiThreshold	The number of bytes for FP_SizeThreshold or the number of microseconds for FP_Deadline.
+	 */
+	void Peer2PeerNetwork::setBatching( Socket::EFlushPolicy ePolicy, unsigned int uiThreshold )
+	{
+		m_mxPeers.lock();
+
+		m_eFlushPolicy = ePolicy;
+		m_uiFlushThreshold = uiThreshold;
+
+		for( std::list<Peer*>::iterator it = m_lpPeers.begin(); it != m_lpPeers.end(); ++it )
+			(*it)->setBatching( ePolicy, uiThreshold );
+
+		m_mxPeers.unlock();
+
+		// the network thread has to pick up the new timeout
+		m_reactor.interrupt();
+	}
+
+
+	/**
+	 * @brief	Sets the size of the chunks that large tcp messages are split into, applies to all current and future peers.
+	 *
+	 * @note	Chunks of different messages are interleaved, so a large message only delays the others by one chunk.
+	 * 			Smaller chunks mean less delay for the other messages but more overhead for the large one.
+	 *
+	 * @param	uiChunkSize	Messages longer than this are sent in chunks of this size, 0 sends every message at once.
+	 */
+	void Peer2PeerNetwork::setChunkSize( unsigned int uiChunkSize )
+	{
+		m_mxPeers.lock();
+
+		m_uiChunkSize = uiChunkSize;
+
+		for( std::list<Peer*>::iterator it = m_lpPeers.begin(); it != m_lpPeers.end(); ++it )
+			(*it)->setChunkSize( uiChunkSize );
+
+		m_mxPeers.unlock();
+	}
+
+
+	/**
+	 * @brief	Sets the path MTU that udp messages are split for, applies to all current and future peers.
+	 *
+	 * @note	By default every peer asks its socket, which knows the MTU of the route on linux and falls back to
+	 * 			DF_DEFAULT_MTU elsewhere. Set it lower if the network between the peers has a smaller MTU, e.g. for tunnels.
+	 *
+	 * @param	uiMTU	The largest ip packet that reaches the peers unfragmented, 0 asks the sockets.
+	 */
+	void Peer2PeerNetwork::setPathMTU( unsigned int uiMTU )
+	{
+		m_mxPeers.lock();
+
+		m_uiPathMTU = uiMTU;
+
+		for( std::list<Peer*>::iterator it = m_lpPeers.begin(); it != m_lpPeers.end(); ++it )
+			(*it)->setPathMTU( uiMTU );
+
+		m_mxPeers.unlock();
+	}
+
+
+	/**
+	 * @brief	Sets the send queue of every peer, applies to all current and future peers.
+	 *
+	 * @note	Messages to a peer wait in its queue until its writer thread sent them, so a slow peer only delays its own
+	 * 			messages. When the queue of a peer is full, ePolicy decides between stalling the broker (OP_Block, the
+	 * 			default), losing messages (OP_DropOldest, OP_DropNewest) and removing the peer (OP_Disconnect).
+	 *
+	 * @param	uiCapacity	The number of messages that may wait for one peer, 1024 by default.
+	 * @param	ePolicy		What to do when the queue of a peer is full.
+	 */
+	void Peer2PeerNetwork::setSendQueue( unsigned int uiCapacity, SendQueue::EOverflowPolicy ePolicy )
+	{
+		m_mxPeers.lock();
+
+		m_uiSendQueueCapacity = uiCapacity;
+		m_eOverflowPolicy = ePolicy;
+
+		for( std::list<Peer*>::iterator it = m_lpPeers.begin(); it != m_lpPeers.end(); ++it )
+			(*it)->setSendQueue( uiCapacity, ePolicy );
+
+		m_mxPeers.unlock();
+	}
+
+
+	/**
+	 * @brief	Sends all messages that are queued because of the flush policy.
+	 */
+	void Peer2PeerNetwork::flush()
+	{
+		m_mxPeers.lock();
+		for( std::list<Peer*>::iterator it = m_lpPeers.begin(); it != m_lpPeers.end(); ++it )
+			(*it)->flush();
+		m_mxPeers.unlock();
+	}
+
+
 	/**
 	 * @brief	Connects an and insert peer, used by the addPeer methods.
 	 *
@@ -156,10 +285,22 @@ namespace oocl
 		m_lpPeers.push_back( pPeer );
 		m_mapPeersByID.insert( std::pair<unsigned int, Peer*>( pPeer->getPeerID(), pPeer ) );
 
+		pPeer->setBatching( m_eFlushPolicy, m_uiFlushThreshold );
+		pPeer->setChunkSize( m_uiChunkSize );
+		pPeer->setPathMTU( m_uiPathMTU );
+		pPeer->setSendQueue( m_uiSendQueueCapacity, m_eOverflowPolicy );
+		pPeer->m_reliable.setReactor( &m_reactor );
+		m_routingTable.addPeer( pPeer );
+		m_reactor.registerSocket( pPeer->m_pSocketTCP, this, pPeer );
+
 		m_mxPeers.unlock();
 
 		MessageBroker::getBrokerFor( MT_NewPeerMessage )->pumpMessage( new NewPeerMessage( pPeer ) );
 
+		// the peer may have sent its first messages, e.g. its subscriptions, right behind the answer to the handshake
+		if( pPeer->m_frameDecoder.getBufferedBytes() > 0 )
+			receiveFromPeer( pPeer );
+
 		return true;
 	}
 
@@ -219,6 +360,25 @@ namespace oocl
 	}
 
 
+	/**
+	 * @brief	Called by the reactor whenever one of the sockets of this network is readable.
+	 *
+	 * @param [in]	pSocket 	The socket that is ready.
+	 * @param [in]	pContext	The peer the socket belongs to or NULL if it is a listening socket or was not assigned to a peer yet.
+	 */
+	void Peer2PeerNetwork::cbReadable( SocketStub* pSocket, void* pContext )
+	{
+		if( pSocket == m_pServerSocketTCP )
+			acceptConnections();
+		else if( pSocket == m_pServerSocketUDP )
+			receiveFromUDP();
+		else if( pContext != NULL )
+			receiveFromPeer( (Peer*)pContext );
+		else
+			receiveFromUnknown( (Socket*)pSocket );
+	}
+
+
 	/**
 	 * @brief	Thread for managing incoming messages and connections.
 	 */
@@ -234,227 +394,294 @@ namespace oocl
 		m_pServerSocketTCP->bind( m_usListeningPort );
 		m_pServerSocketUDP->bind( m_usListeningPort );
 
-		fd_set selectSet;
+		m_reactor.registerSocket( m_pServerSocketTCP, this );
+		m_reactor.registerSocket( m_pServerSocketUDP, this );
 
-		// start 
+		// the reactor blocks until a socket is ready or the destructor interrupts it
 		while( m_bActive )
 		{
-			// substitution of std::max / max as it is defined different in msvc and gnucc
-			int iBiggestSocket = m_pServerSocketTCP->getCSocket();
-			if( iBiggestSocket < m_pServerSocketUDP->getCSocket() )
-				iBiggestSocket = m_pServerSocketUDP->getCSocket();
-			
-			// prepare the fd_set
-			FD_ZERO( &selectSet );
-			
-			// add UDP and TCP listening sockets to the set
-			FD_SET( m_pServerSocketTCP->getCSocket(), &selectSet );
-			FD_SET( m_pServerSocketUDP->getCSocket(), &selectSet );
+			// with the deadline flush policy wake up in time to send the messages that were queued last
+			int iTimeoutMS = -1;
+			if( m_eFlushPolicy == Socket::FP_Deadline )
+				iTimeoutMS = std::max( 1u, (m_uiFlushThreshold+999) / 1000 );
 
+			// and in time to retransmit the reliable udp messages that were not acknowledged
 			m_mxPeers.lock();
-			// add all peer tcp sockets to the set
+			reclaimPeers();
+			for( std::list<Peer*>::iterator it = m_lpPeers.begin(); it != m_lpPeers.end(); ++it )
 			{
-				std::list<Peer*>::iterator it = m_lpPeers.begin();
-				while( it != m_lpPeers.end() )
-				{
-					if( (*it)->isConnected() && (*it)->m_pSocketTCP != NULL )
-					{
-						int iTCP = (*it)->m_pSocketTCP->getCSocket();
-						if( iTCP > iBiggestSocket )
-							iBiggestSocket = iTCP;
-						FD_SET( iTCP, &selectSet );
-					}
-					else
-					{
-						delete (*it);
-						it = m_lpPeers.erase( it );
-					}
-
-					++it;
-				}
+				int iResendMS = (*it)->resendDue();
+				if( iResendMS >= 0 && ( iTimeoutMS < 0 || iResendMS < iTimeoutMS ) )
+					iTimeoutMS = iResendMS;
 			}
 			m_mxPeers.unlock();
 
-			// add all tcp sockets to the set that have not yet been assigned to a peer
+			if( m_reactor.dispatch( iTimeoutMS ) < 0 && !m_reactor.isValid() )
+				break;
+
+			if( m_eFlushPolicy == Socket::FP_Deadline )
 			{
-				std::list<Socket*>::iterator it = m_lpSocketsWithoutPeers.begin();
-				while( it != m_lpSocketsWithoutPeers.end() )
+				m_mxPeers.lock();
+				for( std::list<Peer*>::iterator it = m_lpPeers.begin(); it != m_lpPeers.end(); ++it )
+					(*it)->flushIfDue();
+				m_mxPeers.unlock();
+			}
+		}
+
+		m_reactor.unregisterSocket( m_pServerSocketTCP );
+		m_reactor.unregisterSocket( m_pServerSocketUDP );
+	}
+
+
+	/**
+	 * @brief	Accepts all pending connections, the new sockets wait for a ConnectMessage before they get a peer.
+	 */
+	void Peer2PeerNetwork::acceptConnections()
+	{
+		Socket* pSocket = NULL;
+		while( (pSocket = m_pServerSocketTCP->accept()) != NULL )
+		{
+			OOCL_LOG_INFO( "oocl", "new half connection" );
+
+			m_mapSocketsWithoutPeers.insert( std::pair<Socket*, FrameDecoder*>( pSocket, new FrameDecoder( 64 ) ) );
+			m_reactor.registerSocket( pSocket, this );
+		}
+	}
+
+
+	/**
+	 * @brief	Receives all pending datagrams on the udp socket and hands them to the peers that sent them.
+	 */
+	void Peer2PeerNetwork::receiveFromUDP()
+	{
+		// receive all pending datagrams with as few calls as possible and decode them where they were received
+		while( m_pServerSocketUDP->readDatagrams( m_dsReceiveSlab ) > 0 )
+		{
+			m_mxPeers.lock();
+
+			for( unsigned int i = 0; i < m_dsReceiveSlab.size(); i++ )
+			{
+				const char* pcDatagram = m_dsReceiveSlab.getDatagram( i );
+				unsigned int uiLength = m_dsReceiveSlab.getLength( i );
+
+				if( m_dsReceiveSlab.isTruncated( i ) )
 				{
-					if( (*it)->isConnected() )
-					{
-						if( (*it)->getCSocket() > iBiggestSocket )
-							iBiggestSocket = (*it)->getCSocket();
-						FD_SET( (*it)->getCSocket(), &selectSet );
-					}
-					else
-					{
-						delete (*it);
-						it = m_lpSocketsWithoutPeers.erase( it );
-					}
+					OOCL_LOG_WARNING( "oocl", "a message from a peer on udp was too long and got truncated" );
+					continue;
+				}
 
-					++it;
+				// | Message                          | PeerID |
+				// | Type  |Length | Messagebody      | 4 byte |
+				if( uiLength < 8 )
+				{
+					OOCL_LOGF_WARNING( "oocl", "a message of %u bytes from a peer on udp was too short", uiLength );
+					continue;
 				}
-			}
 
-			timeval tv;
-			tv.tv_sec = 0;
-			tv.tv_usec = 500000;
-
-			// select!
-			int iRet = select( iBiggestSocket+1, &selectSet, NULL, NULL, &tv );
-#ifdef _MSC_VER
-			if( iRet == SOCKET_ERROR )
-#else	
-			if( iRet < 0 )
-#endif
-			{
-				Log::getLog("oocl")->logError( "Selecting in the peernetwork failed" );
-				continue;
-			}
-			else if( iRet == 0 )
-				continue;
-			
-			// messages from the udp receiving socket will be pushed on the appropriate MessageBroker
-			if( FD_ISSET( m_pServerSocketUDP->getCSocket(), &selectSet ) )
-			{
-				std::string strMsg;
-				if( !m_pServerSocketUDP->read( strMsg ) )
+				MessageView view( pcDatagram );
+				if( view.getBodyLength() > uiLength || view.getHeaderLength() + view.getBodyLength() + 4u != uiLength )
 				{
-					Log::getLog("oocl")->logWarning( "a message from a peer on udp could not be received" );
+					OOCL_LOGF_WARNING( "oocl", "a message of %u bytes from a peer on udp was too short", uiLength );
+					continue;
 				}
-				else
+
+				// messages that come from other peers must have the sender peerID at the end of the message
+				unsigned int uiPeerID = 0;
+				std::memcpy( &uiPeerID, pcDatagram + uiLength - 4, sizeof(unsigned int) );
+
+				Peer* pPeer = getPeerByID( uiPeerID );
+				if( pPeer != NULL && pPeer->isConnected() )
 				{
-					// messages that come from other peers must have the sender peerID at the end of the message
-					unsigned int uiPeerID = *((unsigned int*)strMsg.substr( strMsg.length()-4 ).c_str());
-					Message* pMsg = Message::createFromString( strMsg.substr(0,strMsg.length()-4).c_str() );
-
-					Peer* pPeer = getPeerByID( uiPeerID );
-					if( pPeer != NULL && pPeer->isConnected() )
-						pPeer->receiveMessage( pMsg );
-					else
-						Log::getLog("oocl")->logWarning( "received udp-message from a no longer connected peer" );
+					pPeer->receiveMessage( view );
+
+					if( pPeer->m_reliable.isAckPending() && ( m_vpAckPending.empty() || m_vpAckPending.back() != pPeer ) )
+						m_vpAckPending.push_back( pPeer );
 				}
+				else
+					OOCL_LOGF_WARNING( "oocl", "received udp-message from the no longer connected peer %u", uiPeerID );
 			}
 
-			m_mxPeers.lock();
+			// one acknowledgement per peer for the whole batch
+			for( std::vector<Peer*>::iterator it = m_vpAckPending.begin(); it != m_vpAckPending.end(); ++it )
+				(*it)->sendAck();
+			m_vpAckPending.clear();
+
+			m_mxPeers.unlock();
+		}
+
+		if( !m_pServerSocketUDP->isConnected() )
+			OOCL_LOG_WARNING( "oocl", "a message from a peer on udp could not be received" );
+	}
+
+
+	/**
+	 * @brief	Receives everything a peer sent on its tcp socket and passes all complete messages to the peer.
+	 *
+	 * @note	An incomplete message stays in the peers receive buffer until the rest arrives.
+	 *
+	 * @param [in]	pPeer	The peer whose socket is readable.
+	 */
+	void Peer2PeerNetwork::receiveFromPeer( Peer* pPeer )
+	{
+		m_mxPeers.lock();
 
-			// walk through the peer list and check for messages
-			std::list<Peer*>::iterator itPeers = m_lpPeers.begin();
-			while( itPeers != m_lpPeers.end() )
+		if( pPeer->m_pSocketTCP == NULL )
+		{
+			m_mxPeers.unlock();
+			return;
+		}
+
+		// the socket may be deleted while processing a DisconnectMessage, so remember the C socket for unregistering
+		Socket* pSocket = pPeer->m_pSocketTCP;
+		int iSocket = pSocket->getCSocket();
+
+		bool bPeerDisconnected = false;
+		const char* pcFrame = NULL;
+		unsigned int uiFrameLength = 0;
+
+		// the notification is edge-triggered, so receive until nothing is left; messages that are
+		// not complete yet stay in the decoder until the next notification
+		do
+		{
+			while( pPeer->m_frameDecoder.nextFrame( pcFrame, uiFrameLength ) )
 			{
-				bool bPeerDisconnected = false;
-				Peer* pPeer = *itPeers;
+				MessageView view( pcFrame );
 
-				if( pPeer->isConnected() && FD_ISSET( pPeer->m_pSocketTCP->getCSocket(), &selectSet ) )
-				{
-					std::string strMsg;
-					if( !pPeer->m_pSocketTCP->read( strMsg ) )
-					{
-						if( !pPeer->isConnected() && !pPeer->connectSockets() )
-						{
-							Log::getLogRef("oocl") << Log::EL_WARNING << "removed peer " << pPeer->getPeerID() << " after error on socket" << oocl::endl;
-							delete pPeer;
-
-							itPeers = m_lpPeers.erase( itPeers );
-							continue;
-						}
-					}
+				bool bDisconnect = view.getType() == MT_DisconnectMessage;
 
-					while( !strMsg.empty() )
-					{
-//						Log::getLogRef("oocl") << Log::EL_INFO << "received message from peer " << pPeer->getPeerID() << oocl::endl;
-						Message* pMsg = Message::createFromString( strMsg.c_str() );
-						if( pMsg == NULL )
-						{
-							Log::getLogRef("oocl") << Log::EL_WARNING << "reading incoming message from peer " << pPeer->getPeerID() << " failed" << oocl::endl;
-							break;
-						}
-
-						if( strMsg.length() < pMsg->getBodyLength() + 4 )
-						{
-							Log::getLogRef("oocl") << Log::EL_WARNING << "read " << (int)strMsg.length() << " bytes while expected message is " << pMsg->getBodyLength() + 4 << " bytes long" << oocl::endl;
-							std::string strMsg2;
-							pPeer->m_pSocketTCP->read( strMsg2 );
-							strMsg += strMsg2;
-						}
-						else
-						{
-							strMsg = strMsg.substr( pMsg->getBodyLength() +4 );
-
-							pPeer->receiveMessage( pMsg );
-						}
-
-						// some messages need special attention here
-						if( pMsg->getType() == MT_DisconnectMessage ) // remove the peer from the lists when he disconnected
-						{
-							m_mapPeersByID.erase( pPeer->getPeerID() );
-							itPeers = m_lpPeers.erase( itPeers );
-
-							bPeerDisconnected = true;
-							break;
-						}
-					}
+				pPeer->receiveMessage( view );
+
+				// remove the peer from the lists when he disconnected
+				if( bDisconnect )
+				{
+					bPeerDisconnected = true;
+					break;
 				}
+			}
+		} while( !bPeerDisconnected && pPeer->m_frameDecoder.receive( pSocket ) > 0 );
+
+		if( bPeerDisconnected )
+		{
+			m_reactor.unregisterSocket( iSocket );
+
+			m_mapPeersByID.erase( pPeer->getPeerID() );
+			m_lpPeers.remove( pPeer );
+		}
+		else
+		{
+			// a peer is deactivated when its send queue overflowed with OP_Disconnect
+			if( !pPeer->m_bActive || ( !pPeer->isConnected() && !pPeer->connectSockets() ) )
+			{
+				OOCL_LOG_WARNING( "oocl", "removed peer " << pPeer->getPeerID() << " after error on socket" );
 
-				if( !bPeerDisconnected )
-					++itPeers;
+				m_reactor.unregisterSocket( iSocket );
+
+				m_mapPeersByID.erase( pPeer->getPeerID() );
+				m_lpPeers.remove( pPeer );
+				delete pPeer;
 			}
+		}
+
+		m_mxPeers.unlock();
+	}
 
-			m_mxPeers.unlock();
 
-			// check for connect messages on the sockets without peers
-			std::list<Socket*>::iterator it = m_lpSocketsWithoutPeers.begin();
-			while(  it != m_lpSocketsWithoutPeers.end() )
+	/**
+	 * @brief	Receives on a socket that has no peer yet and creates the peer when its ConnectMessage is complete.
+	 *
+	 * @param [in]	pSocket	The socket that is readable.
+	 */
+	void Peer2PeerNetwork::receiveFromUnknown( Socket* pSocket )
+	{
+		std::map<Socket*, FrameDecoder*>::iterator itSocket = m_mapSocketsWithoutPeers.find( pSocket );
+		if( itSocket == m_mapSocketsWithoutPeers.end() )
+			return;
+
+		FrameDecoder* pDecoder = itSocket->second;
+		const char* pcFrame = NULL;
+		unsigned int uiFrameLength = 0;
+
+		do
+		{
+			while( pDecoder->nextFrame( pcFrame, uiFrameLength ) )
 			{
-				if( FD_ISSET( (*it)->getCSocket(), &selectSet ) )
+				Message* pMsg = Message::createFromString( pcFrame );
+				MessagePtr ptrMsg( pMsg );
+
+				if( pMsg != NULL && pMsg->getType() == MT_ConnectMessage )
 				{
-					std::string strMsg;
-					if( (*it)->read( strMsg ) )
+					OOCL_LOG_INFO( "oocl", "received connect message" );
+
+					int iSocket = pSocket->getCSocket();
+
+					Peer* pPeer = new Peer( pSocket->getConnectedIP(), ((ConnectMessage*)pMsg)->getPort() );
+					bool bConnected = pPeer->connected( pSocket, (ConnectMessage*)pMsg, m_usListeningPort, m_uiUserID );
+
+					// the socket now belongs to the peer, so it has to be registered with the peer as context
+					m_reactor.unregisterSocket( iSocket );
+					m_mapSocketsWithoutPeers.erase( itSocket );
+
+					// whatever the peer sent after connecting is already the beginning of its first messages
+					pPeer->m_frameDecoder.swap( *pDecoder );
+					delete pDecoder;
+
+					if( !bConnected )
 					{
-						Message* pMsg = Message::createFromString( strMsg.c_str() );
-						if( pMsg != NULL )
-						{
-							if( strMsg.length() > pMsg->getBodyLength() + 4 )
-								Log::getLog("oocl")->logError("ConnectMessage too long" );
-
-							if( pMsg->getType() == MT_ConnectMessage )
-							{
-								Log::getLog("oocl")->logInfo( "received connect message" );
-
-								Peer* pPeer = new Peer( (*it)->getConnectedIP(), ((ConnectMessage*)pMsg)->getPort() );
-								pPeer->connected( (*it), (ConnectMessage*)pMsg, m_usListeningPort, m_uiUserID );
-
-								m_lpPeers.push_back( pPeer );
-								m_mapPeersByID.insert( std::pair<PeerID,Peer*>( pPeer->getPeerID(), pPeer ) );
-
-								Message* pMsg = new NewPeerMessage( pPeer );
-								pMsg->setSenderID( pPeer->getPeerID() );
-								MessageBroker::getBrokerFor( MT_NewPeerMessage )->pumpMessage( pMsg );
-
-								it = m_lpSocketsWithoutPeers.erase( it );
-								continue;
-							}
-							else
-							{
-								Log::getLog("oocl")->logInfo("A message from an unknown peer was received" );
-							}
-						}
+						delete pPeer;
+						return;
 					}
 
-				}
+					m_mxPeers.lock();
 
-				++it;
-			}
+					m_lpPeers.push_back( pPeer );
+					m_mapPeersByID.insert( std::pair<PeerID,Peer*>( pPeer->getPeerID(), pPeer ) );
 
-			// if the tcp server socket got a connection, push the tcp socket on the list
-			if( FD_ISSET( m_pServerSocketTCP->getCSocket(), &selectSet ) )
-			{
-				Log::getLog("oocl")->logInfo( "new half connection" );
-				Socket* pSocket = m_pServerSocketTCP->accept();
+					pPeer->setBatching( m_eFlushPolicy, m_uiFlushThreshold );
+					pPeer->setChunkSize( m_uiChunkSize );
+					pPeer->setPathMTU( m_uiPathMTU );
+					pPeer->setSendQueue( m_uiSendQueueCapacity, m_eOverflowPolicy );
+					pPeer->m_reliable.setReactor( &m_reactor );
+					m_routingTable.addPeer( pPeer );
+					m_reactor.registerSocket( pSocket, this, pPeer );
+
+					m_mxPeers.unlock();
 
-				if( pSocket )
-					m_lpSocketsWithoutPeers.push_back( pSocket );
+					Message* pNewPeerMsg = new NewPeerMessage( pPeer );
+					pNewPeerMsg->setSenderID( pPeer->getPeerID() );
+					MessageBroker::getBrokerFor( MT_NewPeerMessage )->pumpMessage( pNewPeerMsg );
+
+					if( pPeer->m_frameDecoder.getBufferedBytes() > 0 )
+						receiveFromPeer( pPeer );
+
+					return;
+				}
+				else if( pMsg != NULL )
+				{
+					OOCL_LOG_INFO( "oocl", "A message from an unknown peer was received" );
+				}
 			}
+		} while( pDecoder->receive( pSocket ) > 0 );
+
+		if( !pSocket->isConnected() )
+		{
+			m_reactor.unregisterSocket( pSocket );
+			m_mapSocketsWithoutPeers.erase( itSocket );
+			delete pSocket;
+			delete pDecoder;
 		}
 	}
+
+
+	/**
+	 * @brief	Frees the peers that were removed by other threads, called by the network thread between two dispatches.
+	 *
+	 * @note	m_mxPeers has to be locked by the caller.
+	 */
+	void Peer2PeerNetwork::reclaimPeers()
+	{
+		for( unsigned int i = 0; i < m_vpRetiredPeers.size(); i++ )
+			delete m_vpRetiredPeers[i];
+		m_vpRetiredPeers.clear();
+	}
+
 }
@@ -0,0 +1,128 @@
+/*
+Object Oriented Communication Library
+Copyright (c) 2011 Jürgen Lorenz and Jörn Teuber
+
+This software is provided 'as-is', without any express or implied warranty.
+In no event will the authors be held liable for any damages arising from the use of this software.
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it freely,
+subject to the following restrictions:
+
+1. The origin of this software must not be misrepresented; you must not claim that you wrote the original software. If you use this software in a product, an acknowledgment in the product documentation would be appreciated but is not required.
+2. Altered source versions must be plainly marked as such, and must not be misrepresented as being the original software.
+3. This notice may not be removed or altered from any source distribution.
+*/
+// This file was written by Jörn Teuber
+
+#include "PeerSet.h"
+
+namespace oocl
+{
+	/**
+	 * @brief	Default constructor, creates an empty set.
+	 */
+	PeerSet::PeerSet()
+		: m_uiCount( 0 )
+	{
+	}
+
+
+	/**
+	 * @brief	Adds a peer to the set.
+	 *
+	 * @param	uiSlot	The slot of the peer.
+	 */
+	void PeerSet::insert( unsigned int uiSlot )
+	{
+		unsigned int uiWord = uiSlot / 32;
+		if( uiWord >= m_vuiWords.size() )
+			m_vuiWords.resize( uiWord + 1, 0 );
+
+		unsigned int uiBit = 1u << (uiSlot % 32);
+		if( (m_vuiWords[uiWord] & uiBit) == 0 )
+		{
+			m_vuiWords[uiWord] |= uiBit;
+			m_uiCount++;
+		}
+	}
+
+
+	/**
+	 * @brief	Removes a peer from the set.
+	 *
+	 * @param	uiSlot	The slot of the peer.
+	 */
+	void PeerSet::erase( unsigned int uiSlot )
+	{
+		unsigned int uiWord = uiSlot / 32;
+		unsigned int uiBit = 1u << (uiSlot % 32);
+
+		if( uiWord < m_vuiWords.size() && (m_vuiWords[uiWord] & uiBit) != 0 )
+		{
+			m_vuiWords[uiWord] &= ~uiBit;
+			m_uiCount--;
+		}
+	}
+
+
+	/**
+	 * @brief	Check whether a peer is in the set.
+	 *
+	 * @param	uiSlot	The slot of the peer.
+	 *
+	 * @return	true if the peer is in the set, false if not.
+	 */
+	bool PeerSet::contains( unsigned int uiSlot ) const
+	{
+		unsigned int uiWord = uiSlot / 32;
+		return uiWord < m_vuiWords.size() && (m_vuiWords[uiWord] & (1u << (uiSlot % 32))) != 0;
+	}
+
+
+	/**
+	 * @brief	Check whether the set is empty.
+	 *
+	 * @return	true if no peer is in the set, false if not.
+	 */
+	bool PeerSet::empty() const
+	{
+		return m_uiCount == 0;
+	}
+
+
+	/**
+	 * @brief	Finds the first peer in the set whose slot is not lower than the given one.
+	 *
+	 * @param	uiSlot	The slot to start with.
+	 *
+	 * @return	The slot of the peer or -1 if there is none.
+	 */
+	int PeerSet::next( unsigned int uiSlot ) const
+	{
+		unsigned int uiWord = uiSlot / 32;
+		if( uiWord >= m_vuiWords.size() )
+			return -1;
+
+		// the bits below uiSlot are masked out of the first word
+		unsigned int uiBits = m_vuiWords[uiWord] & (~0u << (uiSlot % 32));
+
+		while( uiBits == 0 )
+		{
+			if( ++uiWord >= m_vuiWords.size() )
+				return -1;
+
+			uiBits = m_vuiWords[uiWord];
+		}
+
+#if defined __GNUC__
+		return uiWord * 32 + __builtin_ctz( uiBits );
+#else
+		unsigned int uiBit = 0;
+		while( (uiBits & (1u << uiBit)) == 0 )
+			uiBit++;
+
+		return uiWord * 32 + uiBit;
+#endif
+	}
+
+}
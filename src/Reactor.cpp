@@ -0,0 +1,317 @@
+/*
+Object Oriented Communication Library
+Copyright (c) 2011 Jürgen Lorenz and Jörn Teuber
+
+This software is provided 'as-is', without any express or implied warranty.
+In no event will the authors be held liable for any damages arising from the use of this software.
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it freely,
+subject to the following restrictions:
+
+1. The origin of this software must not be misrepresented; you must not claim that you wrote the original software. If you use this software in a product, an acknowledgment in the product documentation would be appreciated but is not required.
+2. Altered source versions must be plainly marked as such, and must not be misrepresented as being the original software.
+3. This notice may not be removed or altered from any source distribution.
+*/
+// This file was written by Jörn Teuber
+
+#include "Reactor.h"
+
+namespace oocl
+{
+	/**
+	 * @brief	Default constructor.
+	 */
+	Reactor::Reactor()
+		: m_bValid( true )
+	{
+#ifdef linux
+		m_iEpollFD = epoll_create( sm_iMaxEventsPerDispatch );
+		m_iWakeupFD = eventfd( 0, EFD_NONBLOCK );
+
+		if( m_iEpollFD < 0 || m_iWakeupFD < 0 )
+		{
+			OOCL_LOG_ERROR( "oocl", "Creating the reactor failed" );
+			m_bValid = false;
+			return;
+		}
+
+		// the wakeup descriptor is the only one registered without a registration
+		struct epoll_event event;
+		event.events = EPOLLIN;
+		event.data.ptr = NULL;
+		epoll_ctl( m_iEpollFD, EPOLL_CTL_ADD, m_iWakeupFD, &event );
+#endif
+	}
+
+
+	/**
+	 * @brief	Destructor.
+	 */
+	Reactor::~Reactor()
+	{
+#ifdef linux
+		if( m_iEpollFD >= 0 )
+			close( m_iEpollFD );
+		if( m_iWakeupFD >= 0 )
+			close( m_iWakeupFD );
+#endif
+
+		m_mxRegistrations.lock();
+
+		for( std::map< int, Registration* >::iterator it = m_mapRegistrations.begin(); it != m_mapRegistrations.end(); ++it )
+			delete it->second;
+		m_mapRegistrations.clear();
+
+		m_mxRegistrations.unlock();
+
+		reclaimRegistrations();
+	}
+
+
+	/**
+	 * @brief	Registers a socket, so that the listener gets called whenever the socket is readable.
+	 *
+	 * @note	The socket will be switched to non-blocking mode.
+	 *
+	 * @param [in]	pSocket  	The socket to watch.
+	 * @param [in]	pListener	The listener that will be called when the socket is ready.
+	 * @param [in]	pContext 	Pointer that is handed to the listener unchanged, e.g. the object the socket belongs to.
+	 *
+	 * @return	true if it succeeds, false if it fails or the socket is already registered.
+	 */
+	bool Reactor::registerSocket( SocketStub* pSocket, ReactorListener* pListener, void* pContext )
+	{
+		if( !m_bValid || pSocket == NULL || pListener == NULL )
+			return false;
+
+		int iSocket = pSocket->getCSocket();
+
+		m_mxRegistrations.lock();
+
+		if( m_mapRegistrations.find( iSocket ) != m_mapRegistrations.end() )
+		{
+			m_mxRegistrations.unlock();
+			OOCL_LOG_WARNING( "oocl", "socket " << iSocket << " is already registered with the reactor" );
+			return false;
+		}
+
+		pSocket->setBlocking( false );
+
+		Registration* pReg = new Registration;
+		pReg->pSocket = pSocket;
+		pReg->pListener = pListener;
+		pReg->pContext = pContext;
+		pReg->iSocket = iSocket;
+		pReg->bRemoved = false;
+
+#ifdef linux
+		struct epoll_event event;
+		event.events = EPOLLIN | EPOLLRDHUP | EPOLLET;
+		event.data.ptr = pReg;
+
+		if( epoll_ctl( m_iEpollFD, EPOLL_CTL_ADD, iSocket, &event ) < 0 )
+		{
+			m_mxRegistrations.unlock();
+			OOCL_LOG_ERROR( "oocl", "registering socket " << iSocket << " with the reactor failed" );
+
+			delete pReg;
+			return false;
+		}
+#endif
+
+		m_mapRegistrations[iSocket] = pReg;
+
+		m_mxRegistrations.unlock();
+
+		return true;
+	}
+
+
+	/**
+	 * @brief	Stops watching the given socket.
+	 *
+	 * @param [in]	pSocket	The socket to unregister.
+	 *
+	 * @return	true if it succeeds, false if the socket was not registered.
+	 */
+	bool Reactor::unregisterSocket( SocketStub* pSocket )
+	{
+		if( pSocket == NULL )
+			return false;
+
+		return unregisterSocket( pSocket->getCSocket() );
+	}
+
+
+	/**
+	 * @brief	Stops watching the given C socket.
+	 *
+	 * @note	Use this if the socket object might already be deleted.
+	 *
+	 * @param	iSocket	The C socket to unregister.
+	 *
+	 * @return	true if it succeeds, false if the socket was not registered.
+	 */
+	bool Reactor::unregisterSocket( int iSocket )
+	{
+		m_mxRegistrations.lock();
+
+		std::map< int, Registration* >::iterator it = m_mapRegistrations.find( iSocket );
+		if( it == m_mapRegistrations.end() )
+		{
+			m_mxRegistrations.unlock();
+			return false;
+		}
+
+#ifdef linux
+		// this may fail if the socket was closed already, in which case the kernel removed it for us
+		epoll_ctl( m_iEpollFD, EPOLL_CTL_DEL, iSocket, NULL );
+#endif
+
+		// the registration could still be referenced by an event of the current dispatch, so free it on the next one
+		it->second->bRemoved = true;
+		m_lpRetiredRegistrations.push_back( it->second );
+		m_mapRegistrations.erase( it );
+
+		m_mxRegistrations.unlock();
+
+		return true;
+	}
+
+
+	/**
+	 * @brief	Waits until at least one socket is ready or the timeout expired and calls the listeners of all ready sockets.
+	 *
+	 * @note	Must only be called by one thread at a time.
+	 * 			On platforms without epoll, the timeout is capped at 500ms so that interrupt() is noticed.
+	 *
+	 * @param	iTimeoutMS	The maximum time to wait in milliseconds, -1 to wait until something happens.
+	 *
+	 * @return	The number of dispatched callbacks or -1 if waiting failed.
+	 */
+	int Reactor::dispatch( int iTimeoutMS )
+	{
+		if( !m_bValid )
+			return -1;
+
+		reclaimRegistrations();
+
+		int iDispatched = 0;
+
+#ifdef linux
+		struct epoll_event aEvents[sm_iMaxEventsPerDispatch];
+
+		int iRet = epoll_wait( m_iEpollFD, aEvents, sm_iMaxEventsPerDispatch, iTimeoutMS );
+		if( iRet < 0 )
+		{
+			if( errno == EINTR )
+				return 0;
+
+			OOCL_LOG_ERROR( "oocl", "Waiting for events in the reactor failed" );
+			return -1;
+		}
+
+		for( int i = 0; i < iRet; i++ )
+		{
+			Registration* pReg = (Registration*)aEvents[i].data.ptr;
+
+			// reset the wakeup descriptor
+			if( pReg == NULL )
+			{
+				uint64_t ulValue;
+				if( read( m_iWakeupFD, &ulValue, sizeof(ulValue) ) < 0 )
+					OOCL_LOG_WARNING( "oocl", "Resetting the reactor wakeup failed" );
+				continue;
+			}
+
+			if( pReg->bRemoved )
+				continue;
+
+			pReg->pListener->cbReadable( pReg->pSocket, pReg->pContext );
+			iDispatched++;
+		}
+#else
+		if( iTimeoutMS < 0 || iTimeoutMS > 500 )
+			iTimeoutMS = 500;
+
+		fd_set selectSet;
+		FD_ZERO( &selectSet );
+
+		// take a snapshot of the registrations, so that listeners are free to (un)register sockets
+		std::list< Registration* > lpRegistrations;
+		int iBiggestSocket = 0;
+
+		m_mxRegistrations.lock();
+		for( std::map< int, Registration* >::iterator it = m_mapRegistrations.begin(); it != m_mapRegistrations.end(); ++it )
+		{
+			FD_SET( it->first, &selectSet );
+			if( it->first > iBiggestSocket )
+				iBiggestSocket = it->first;
+			lpRegistrations.push_back( it->second );
+		}
+		m_mxRegistrations.unlock();
+
+		timeval tv;
+		tv.tv_sec = iTimeoutMS / 1000;
+		tv.tv_usec = (iTimeoutMS % 1000) * 1000;
+
+		int iRet = select( iBiggestSocket+1, &selectSet, NULL, NULL, &tv );
+		if( iRet == SOCKET_ERROR )
+		{
+			OOCL_LOG_ERROR( "oocl", "Selecting in the reactor failed" );
+			return -1;
+		}
+
+		for( std::list< Registration* >::iterator it = lpRegistrations.begin(); it != lpRegistrations.end() && iRet > 0; ++it )
+		{
+			if( !(*it)->bRemoved && FD_ISSET( (*it)->iSocket, &selectSet ) )
+			{
+				(*it)->pListener->cbReadable( (*it)->pSocket, (*it)->pContext );
+				iDispatched++;
+			}
+		}
+#endif
+
+		return iDispatched;
+	}
+
+
+	/**
+	 * @brief	Wakes up a thread that is blocked in dispatch(), e.g. to let it check whether it should stop.
+	 */
+	void Reactor::interrupt()
+	{
+#ifdef linux
+		uint64_t ulValue = 1;
+		if( write( m_iWakeupFD, &ulValue, sizeof(ulValue) ) < 0 )
+			OOCL_LOG_WARNING( "oocl", "Interrupting the reactor failed" );
+#endif
+	}
+
+
+	/**
+	 * @brief	Check whether the reactor was created successfully.
+	 *
+	 * @return	true if valid, false if not.
+	 */
+	bool Reactor::isValid()
+	{
+		return m_bValid;
+	}
+
+
+	/**
+	 * @brief	Frees all registrations that were unregistered before the current dispatch.
+	 */
+	void Reactor::reclaimRegistrations()
+	{
+		m_mxRegistrations.lock();
+
+		for( std::list< Registration* >::iterator it = m_lpRetiredRegistrations.begin(); it != m_lpRetiredRegistrations.end(); ++it )
+			delete (*it);
+		m_lpRetiredRegistrations.clear();
+
+		m_mxRegistrations.unlock();
+	}
+
+}
@@ -0,0 +1,636 @@
+/*
+Object Oriented Communication Library
+Copyright (c) 2011 Jürgen Lorenz and Jörn Teuber
+
+This software is provided 'as-is', without any express or implied warranty.
+In no event will the authors be held liable for any damages arising from the use of this software.
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it freely,
+subject to the following restrictions:
+
+1. The origin of this software must not be misrepresented; you must not claim that you wrote the original software. If you use this software in a product, an acknowledgment in the product documentation would be appreciated but is not required.
+2. Altered source versions must be plainly marked as such, and must not be misrepresented as being the original software.
+3. This notice may not be removed or altered from any source distribution.
+*/
+// This file was written by Jörn Teuber
+
+
+#include <cstring>
+#include <algorithm>
+
+#include "ReliableChannel.h"
+#include "BerkeleySocket.h"
+#include "Reactor.h"
+
+#define RC_NO_DEADLINE ((unsigned long long)-1)
+
+namespace oocl
+{
+	/**
+	 * @brief	Constructor.
+	 */
+	ReliableChannel::ReliableChannel()
+		: m_ullNextDue( RC_NO_DEADLINE )
+		, m_ullSRTT( 0 )
+		, m_ullRTTVar( 0 )
+		, m_ullRTO( RC_INITIAL_RTO )
+		, m_uiDropped( 0 )
+		, m_pcDirect( NULL )
+		, m_uiDirectLength( 0 )
+		, m_pReactor( NULL )
+	{
+		for( unsigned int i = 0; i < 2; i++ )
+		{
+			m_aSenders[i].uiNextSequence = 0;
+			m_aReceivers[i].uiNextExpected = 0;
+			m_aReceivers[i].bAckPending = false;
+		}
+	}
+
+
+	/**
+	 * @brief	Get the ID a datagram of a reliable channel is fragmented with, see DatagramFragmenter.
+	 *
+	 * @note	Every copy of a datagram gets the same ID, so that the receiver can combine the fragments of all of them.
+	 *
+	 * @param	pcDatagram	The datagram as written by send().
+	 *
+	 * @return	The message ID for DatagramFragmenter::write().
+	 */
+	unsigned int ReliableChannel::getFragmentID( const char* pcDatagram )
+	{
+		unsigned int uiSequence = 0;
+		std::memcpy( &uiSequence, pcDatagram + 5, sizeof(unsigned int) );
+
+		return DF_FIXED_ID | ( (unsigned int)pcDatagram[4] << 30 ) | ( uiSequence & 0x3FFFFFFF );
+	}
+
+
+	/**
+	 * @brief	Serializes a message into a datagram and keeps a copy of it until it is acknowledged.
+	 *
+	 * @note	The caller has to write the datagram to the socket with a DatagramFragmenter before it sends the next
+	 * 			reliable message on this channel, so that they leave in the order of their sequences.
+	 *
+	 * @param	pMessage			The message, its protocol selects the unordered or the ordered channel.
+	 * @param [out]	wbDatagram		The datagram to send.
+	 * @param	pTrailer			Bytes that are appended behind the frame, may be NULL.
+	 * @param	uiTrailerLength		The number of bytes in pTrailer.
+	 *
+	 * @return	true if it succeeds, false if the message does not fit into a datagram.
+	 */
+	bool ReliableChannel::send( Message const * pMessage, WriteBuffer& wbDatagram, const void* pTrailer, unsigned int uiTrailerLength )
+	{
+		unsigned int uiBodyLength = pMessage->getBodyLength();
+
+		if( !beginDatagram( pMessage->getProtocoll(), Message::getHeaderLength( uiBodyLength ) + uiBodyLength, wbDatagram ) )
+			return false;
+
+		pMessage->serializeInto( wbDatagram );
+		finishDatagram( wbDatagram, pTrailer, uiTrailerLength );
+
+		return true;
+	}
+
+
+	/**
+	 * @brief	Like the other send(), but with a message that was already serialized, see SerializedMessage.
+	 *
+	 * @param	iProtocol			The protocol of the message, selects the unordered or the ordered channel.
+	 * @param	pcFrame				The serialized message.
+	 * @param	uiFrameLength		The length of the frame.
+	 * @param [out]	wbDatagram		The datagram to send.
+	 * @param	pTrailer			Bytes that are appended behind the frame, may be NULL.
+	 * @param	uiTrailerLength		The number of bytes in pTrailer.
+	 *
+	 * @return	true if it succeeds, false if the message does not fit into a datagram.
+	 */
+	bool ReliableChannel::send( int iProtocol, const char* pcFrame, unsigned int uiFrameLength, WriteBuffer& wbDatagram, const void* pTrailer, unsigned int uiTrailerLength )
+	{
+		if( !beginDatagram( iProtocol, uiFrameLength, wbDatagram ) )
+			return false;
+
+		wbDatagram.append( pcFrame, uiFrameLength );
+		finishDatagram( wbDatagram, pTrailer, uiTrailerLength );
+
+		return true;
+	}
+
+
+	/**
+	 * @brief	Writes the header of the next datagram on a channel, used by send().
+	 *
+	 * @note	If it succeeds m_mxSender stays locked until finishDatagram() was called.
+	 *
+	 * @param	iProtocol			The protocol of the message, selects the unordered or the ordered channel.
+	 * @param	uiMessageLength		The length of the serialized message.
+	 * @param [out]	wbDatagram		The buffer for the datagram.
+	 *
+	 * @return	true if it succeeds, false if the message does not fit into a datagram.
+	 */
+	bool ReliableChannel::beginDatagram( int iProtocol, unsigned int uiMessageLength, WriteBuffer& wbDatagram )
+	{
+		if( uiMessageLength + RC_FRAME_HEADER >= MSG_EXTENDED_LENGTH )
+		{
+			OOCL_LOG_WARNING( "oocl", "a message of " << uiMessageLength << " bytes is too long for a reliable udp channel" );
+			return false;
+		}
+
+		unsigned int uiChannel = iProtocol == SOCK_SEQPACKET ? 1 : 0;
+
+		m_mxSender.lock();
+
+		Sender& sender = m_aSenders[uiChannel];
+		unsigned int uiSequence = sender.uiNextSequence++;
+		unsigned int uiOldest = sender.mapUnacked.empty() ? uiSequence : sender.mapUnacked.begin()->first;
+
+		wbDatagram.clear();
+		char* pcHeader = wbDatagram.grow( 4 + RC_FRAME_HEADER );
+		Message::writeHeader( pcHeader, MT_ReliableFrame, uiMessageLength + RC_FRAME_HEADER );
+		pcHeader[4] = (char)uiChannel;
+		std::memcpy( pcHeader + 5, &uiSequence, sizeof(unsigned int) );
+		std::memcpy( pcHeader + 9, &uiOldest, sizeof(unsigned int) );
+
+		return true;
+	}
+
+
+	/**
+	 * @brief	Appends the trailer to a datagram that got its message and keeps a copy until it is acknowledged, used by send().
+	 *
+	 * @param [in,out]	wbDatagram	The datagram that was started by beginDatagram().
+	 * @param	pTrailer			Bytes that are appended behind the frame, may be NULL.
+	 * @param	uiTrailerLength		The number of bytes in pTrailer.
+	 */
+	void ReliableChannel::finishDatagram( WriteBuffer& wbDatagram, const void* pTrailer, unsigned int uiTrailerLength )
+	{
+		if( pTrailer != NULL )
+			wbDatagram.append( pTrailer, uiTrailerLength );
+
+		unsigned int uiSequence = 0;
+		std::memcpy( &uiSequence, wbDatagram.data() + 5, sizeof(unsigned int) );
+		Sender& sender = m_aSenders[(unsigned char)wbDatagram.data()[4]];
+
+		unsigned long long ullNow = BerkeleySocket::getMicroseconds();
+
+		Pending& pending = sender.mapUnacked[uiSequence];
+		pending.strDatagram.assign( wbDatagram.data(), wbDatagram.size() );
+		pending.ullSentTime = ullNow;
+		pending.ullDueTime = ullNow + m_ullRTO;
+		pending.uiRetries = 0;
+
+		bool bWakeUp = pending.ullDueTime < m_ullNextDue;
+		if( bWakeUp )
+			m_ullNextDue = pending.ullDueTime;
+
+		m_mxSender.unlock();
+
+		// the network thread might sleep without a timeout or with a later one
+		if( bWakeUp && m_pReactor != NULL )
+			m_pReactor->interrupt();
+	}
+
+
+	/**
+	 * @brief	Sends all datagrams again whose retransmission timeout expired or that were reported as lost.
+	 *
+	 * @param [in]	pSocket		The socket to send with, the caller has to hold its lock. NULL if nothing can be sent right now.
+	 * @param	fragmenter		Splits datagrams that are larger than the path MTU.
+	 *
+	 * @return	The number of milliseconds until the next retransmission is due, -1 if nothing waits for an acknowledgement.
+	 */
+	int ReliableChannel::resendDue( Socket* pSocket, DatagramFragmenter& fragmenter )
+	{
+		unsigned long long ullNow = BerkeleySocket::getMicroseconds();
+
+		m_mxSender.lock();
+
+		if( pSocket == NULL )
+		{
+			m_mxSender.unlock();
+			return -1;
+		}
+
+		// most calls come before anything is due, they do not need to look at the datagrams
+		if( ullNow < m_ullNextDue )
+		{
+			int iTimeoutMS = m_ullNextDue == RC_NO_DEADLINE ? -1 : (int)( (m_ullNextDue - ullNow + 999) / 1000 );
+			m_mxSender.unlock();
+			return iTimeoutMS;
+		}
+
+		bool bSent = false;
+		m_ullNextDue = RC_NO_DEADLINE;
+
+		for( unsigned int i = 0; i < 2; i++ )
+		{
+			std::map<unsigned int, Pending, SequenceLess>& mapUnacked = m_aSenders[i].mapUnacked;
+
+			for( std::map<unsigned int, Pending, SequenceLess>::iterator it = mapUnacked.begin(); it != mapUnacked.end(); )
+			{
+				Pending& pending = it->second;
+
+				if( pending.ullDueTime <= ullNow )
+				{
+					if( pending.uiRetries >= RC_MAX_RETRIES )
+					{
+						OOCL_LOG_WARNING( "oocl", "a reliable udp message was dropped after " << RC_MAX_RETRIES << " retransmissions" );
+						m_uiDropped++;
+						mapUnacked.erase( it++ );
+						continue;
+					}
+
+					fragmenter.write( pSocket, pending.strDatagram.data(), pending.strDatagram.size(), getFragmentID( pending.strDatagram.data() ) );
+					bSent = true;
+
+					// exponential backoff, the timeout of the channel is only changed by new measurements
+					pending.uiRetries++;
+					pending.ullSentTime = ullNow;
+					pending.ullDueTime = ullNow + std::min( m_ullRTO << std::min( pending.uiRetries, 16u ), (unsigned long long)RC_MAX_RTO );
+				}
+
+				m_ullNextDue = std::min( m_ullNextDue, pending.ullDueTime );
+				++it;
+			}
+		}
+
+		int iTimeoutMS = m_ullNextDue == RC_NO_DEADLINE ? -1 : (int)( (m_ullNextDue - ullNow + 999) / 1000 );
+
+		m_mxSender.unlock();
+
+		if( bSent )
+			pSocket->flush();
+
+		return iTimeoutMS;
+	}
+
+
+	/**
+	 * @brief	Processes a received MT_ReliableFrame or MT_AckFrame.
+	 *
+	 * @note	Call nextMessage() until it returns false before the next call, the first message may point into pcFrame.
+	 *
+	 * @param	pcFrame			The frame, starting with its header.
+	 * @param	uiFrameLength	The length of the frame.
+	 *
+	 * @return	true if the frame is valid, false if not.
+	 */
+	bool ReliableChannel::receive( const char* pcFrame, unsigned int uiFrameLength )
+	{
+		unsigned short usType = 0;
+		unsigned int uiBodyLength = 0;
+
+		if( uiFrameLength < 4 )
+			return false;
+
+		std::memcpy( &usType, pcFrame, sizeof(unsigned short) );
+		unsigned int uiHeaderLength = Message::readHeader( pcFrame, uiBodyLength );
+		if( uiHeaderLength > uiFrameLength || uiBodyLength != uiFrameLength - uiHeaderLength )
+			return false;
+
+		const char* pcBody = pcFrame + uiHeaderLength;
+
+		if( usType == MT_AckFrame )
+		{
+			unsigned long long ullNow = BerkeleySocket::getMicroseconds();
+			unsigned int auiRanges[2 * RC_MAX_RANGES];
+			unsigned int uiOffset = 0;
+
+			m_mxSender.lock();
+
+			for( unsigned int i = 0; i < 2; i++ )
+			{
+				unsigned int uiNext = 0, uiRangeCount = 0;
+
+				// | Next | Count | First | Last | ...
+				if( uiOffset + 5 > uiBodyLength )
+					break;
+				std::memcpy( &uiNext, pcBody + uiOffset, sizeof(unsigned int) );
+				uiRangeCount = (unsigned char)pcBody[uiOffset + 4];
+				uiOffset += 5;
+
+				if( uiRangeCount > RC_MAX_RANGES || uiOffset + uiRangeCount * 8 > uiBodyLength )
+					break;
+				std::memcpy( auiRanges, pcBody + uiOffset, uiRangeCount * 8 );
+				uiOffset += uiRangeCount * 8;
+
+				processAck( i, uiNext, auiRanges, uiRangeCount, ullNow );
+			}
+
+			m_mxSender.unlock();
+
+			return uiOffset == uiBodyLength;
+		}
+
+		// | Channel | Sequence | Oldest unacknowledged | Message
+		if( usType != MT_ReliableFrame || uiBodyLength < RC_FRAME_HEADER + 4 || (unsigned char)pcBody[0] > 1 )
+			return false;
+
+		unsigned int uiChannel = (unsigned char)pcBody[0];
+		unsigned int uiSequence = 0, uiOldest = 0;
+		std::memcpy( &uiSequence, pcBody + 1, sizeof(unsigned int) );
+		std::memcpy( &uiOldest, pcBody + 5, sizeof(unsigned int) );
+
+		const char* pcMessage = pcBody + RC_FRAME_HEADER;
+		unsigned int uiMessageLength = uiBodyLength - RC_FRAME_HEADER;
+		unsigned int uiInnerBodyLength = 0;
+		unsigned short usInnerType = 0, usInnerLength = 0;
+
+		// a message in a datagram never needs the extended header
+		std::memcpy( &usInnerType, pcMessage, sizeof(unsigned short) );
+		std::memcpy( &usInnerLength, pcMessage + 2, sizeof(unsigned short) );
+		if( usInnerLength == MSG_EXTENDED_LENGTH )
+			return false;
+
+		unsigned int uiInnerHeaderLength = Message::readHeader( pcMessage, uiInnerBodyLength );
+		if( uiInnerHeaderLength > uiMessageLength || uiInnerBodyLength != uiMessageLength - uiInnerHeaderLength
+			|| usInnerType == MT_ReliableFrame || usInnerType == MT_AckFrame )
+			return false;
+
+		Receiver& receiver = m_aReceivers[uiChannel];
+
+		// duplicates are acknowledged again, the last acknowledgement might have been lost
+		receiver.bAckPending = true;
+
+		// the sender gave up on everything before its oldest unacknowledged sequence that did not arrive
+		if( SequenceLess()( receiver.uiNextExpected, uiOldest ) && !SequenceLess()( uiSequence, uiOldest ) )
+			skipTo( uiChannel, uiOldest );
+
+		int iAhead = (int)(uiSequence - receiver.uiNextExpected);
+		if( iAhead < 0 || iAhead >= RC_WINDOW )
+			return true;
+
+		if( uiChannel == 0 )
+		{
+			if( iAhead > 0 )
+			{
+				if( !receiver.setReceived.insert( uiSequence ).second )
+					return true;
+			}
+			else
+			{
+				receiver.uiNextExpected++;
+				advance( uiChannel );
+			}
+		}
+		else
+		{
+			// the ordered channel keeps messages that are early until the gap in front of them is closed
+			if( iAhead > 0 )
+			{
+				if( receiver.mapOutOfOrder.find( uiSequence ) == receiver.mapOutOfOrder.end() )
+					receiver.mapOutOfOrder[uiSequence].assign( pcMessage, uiMessageLength );
+				return true;
+			}
+
+			// messages released by skipTo() have to be delivered first
+			bool bQueued = !m_dqReady.empty();
+			if( bQueued )
+				m_dqReady.push_back( std::string( pcMessage, uiMessageLength ) );
+
+			receiver.uiNextExpected++;
+			advance( uiChannel );
+
+			if( bQueued )
+				return true;
+		}
+
+		m_pcDirect = pcMessage;
+		m_uiDirectLength = uiMessageLength;
+
+		return true;
+	}
+
+
+	/**
+	 * @brief	Stops waiting for the sequences before the given one, the sender dropped them.
+	 *
+	 * @note	Messages of the ordered channel that waited for the dropped ones are released in order.
+	 *
+	 * @param	uiChannel	The channel.
+	 * @param	uiSequence	The oldest sequence the sender still waits for.
+	 */
+	void ReliableChannel::skipTo( unsigned int uiChannel, unsigned int uiSequence )
+	{
+		Receiver& receiver = m_aReceivers[uiChannel];
+
+		OOCL_LOG_WARNING( "oocl", "stopped waiting for reliable udp messages the sender dropped" );
+
+		while( !receiver.setReceived.empty() && SequenceLess()( *receiver.setReceived.begin(), uiSequence ) )
+			receiver.setReceived.erase( receiver.setReceived.begin() );
+
+		while( !receiver.mapOutOfOrder.empty() && SequenceLess()( receiver.mapOutOfOrder.begin()->first, uiSequence ) )
+		{
+			m_dqReady.push_back( std::string() );
+			m_dqReady.back().swap( receiver.mapOutOfOrder.begin()->second );
+			receiver.mapOutOfOrder.erase( receiver.mapOutOfOrder.begin() );
+		}
+
+		receiver.uiNextExpected = uiSequence;
+		advance( uiChannel );
+	}
+
+
+	/**
+	 * @brief	Moves the next expected sequence of a channel behind all sequences that arrived without a gap.
+	 *
+	 * @param	uiChannel	The channel.
+	 */
+	void ReliableChannel::advance( unsigned int uiChannel )
+	{
+		Receiver& receiver = m_aReceivers[uiChannel];
+
+		while( !receiver.setReceived.empty() && *receiver.setReceived.begin() == receiver.uiNextExpected )
+		{
+			receiver.setReceived.erase( receiver.setReceived.begin() );
+			receiver.uiNextExpected++;
+		}
+
+		while( !receiver.mapOutOfOrder.empty() && receiver.mapOutOfOrder.begin()->first == receiver.uiNextExpected )
+		{
+			m_dqReady.push_back( std::string() );
+			m_dqReady.back().swap( receiver.mapOutOfOrder.begin()->second );
+			receiver.mapOutOfOrder.erase( receiver.mapOutOfOrder.begin() );
+			receiver.uiNextExpected++;
+		}
+	}
+
+
+	/**
+	 * @brief	Get the next message that can be delivered after a call to receive().
+	 *
+	 * @param [out]	pcFrame			The message, starting with its header, valid until the next call.
+	 * @param [out]	uiFrameLength	The length of the message.
+	 *
+	 * @return	true if there was a message, false if not.
+	 */
+	bool ReliableChannel::nextMessage( const char*& pcFrame, unsigned int& uiFrameLength )
+	{
+		if( m_pcDirect != NULL )
+		{
+			pcFrame = m_pcDirect;
+			uiFrameLength = m_uiDirectLength;
+			m_pcDirect = NULL;
+			return true;
+		}
+
+		if( m_dqReady.empty() )
+			return false;
+
+		m_strCurrent.swap( m_dqReady.front() );
+		m_dqReady.pop_front();
+
+		pcFrame = m_strCurrent.data();
+		uiFrameLength = m_strCurrent.size();
+		return true;
+	}
+
+
+	/**
+	 * @brief	Appends an acknowledgement for everything received so far, if there is something new to acknowledge.
+	 *
+	 * @param [out]	wbDatagram	The buffer to append the MT_AckFrame to.
+	 *
+	 * @return	true if an acknowledgement was appended, false if not.
+	 */
+	bool ReliableChannel::appendAck( WriteBuffer& wbDatagram )
+	{
+		if( !isAckPending() )
+			return false;
+
+		unsigned int auiRanges[2][2 * RC_MAX_RANGES];
+		unsigned int auiRangeCount[2] = { 0, 0 };
+
+		for( unsigned int i = 0; i < 2; i++ )
+		{
+			Receiver& receiver = m_aReceivers[i];
+			unsigned int* puiRanges = auiRanges[i];
+			unsigned int& uiRangeCount = auiRangeCount[i];
+
+			// only sequences after the next expected one are stored, in order
+			if( i == 0 )
+			{
+				for( std::set<unsigned int, SequenceLess>::iterator it = receiver.setReceived.begin(); it != receiver.setReceived.end(); ++it )
+				{
+					if( uiRangeCount > 0 && puiRanges[2*uiRangeCount - 1] + 1 == *it )
+						puiRanges[2*uiRangeCount - 1] = *it;
+					else if( uiRangeCount < RC_MAX_RANGES )
+					{
+						puiRanges[2*uiRangeCount] = puiRanges[2*uiRangeCount + 1] = *it;
+						uiRangeCount++;
+					}
+					else
+						break;
+				}
+			}
+			else
+			{
+				for( std::map<unsigned int, std::string, SequenceLess>::iterator it = receiver.mapOutOfOrder.begin(); it != receiver.mapOutOfOrder.end(); ++it )
+				{
+					if( uiRangeCount > 0 && puiRanges[2*uiRangeCount - 1] + 1 == it->first )
+						puiRanges[2*uiRangeCount - 1] = it->first;
+					else if( uiRangeCount < RC_MAX_RANGES )
+					{
+						puiRanges[2*uiRangeCount] = puiRanges[2*uiRangeCount + 1] = it->first;
+						uiRangeCount++;
+					}
+					else
+						break;
+				}
+			}
+
+			receiver.bAckPending = false;
+		}
+
+		unsigned int uiBodyLength = 10 + ( auiRangeCount[0] + auiRangeCount[1] ) * 8;
+		char* pcFrame = wbDatagram.grow( 4 + uiBodyLength );
+		pcFrame += Message::writeHeader( pcFrame, MT_AckFrame, uiBodyLength );
+
+		for( unsigned int i = 0; i < 2; i++ )
+		{
+			std::memcpy( pcFrame, &m_aReceivers[i].uiNextExpected, sizeof(unsigned int) );
+			pcFrame[4] = (char)auiRangeCount[i];
+			std::memcpy( pcFrame + 5, auiRanges[i], auiRangeCount[i] * 8 );
+			pcFrame += 5 + auiRangeCount[i] * 8;
+		}
+
+		return true;
+	}
+
+
+	/**
+	 * @brief	Removes the acknowledged datagrams of a channel and schedules the ones reported as lost, m_mxSender has to be locked.
+	 *
+	 * @param	uiChannel		The channel.
+	 * @param	uiNext			The next sequence the receiver expects.
+	 * @param	puiRanges		First and last sequence of each range of later sequences that arrived, in order.
+	 * @param	uiRangeCount	The number of ranges.
+	 * @param	ullNow			The current time.
+	 */
+	void ReliableChannel::processAck( unsigned int uiChannel, unsigned int uiNext, const unsigned int* puiRanges, unsigned int uiRangeCount, unsigned long long ullNow )
+	{
+		std::map<unsigned int, Pending, SequenceLess>& mapUnacked = m_aSenders[uiChannel].mapUnacked;
+		unsigned long long ullSample = 0;
+
+		// only datagrams that were sent once give a valid round trip time (Karn's algorithm)
+		while( !mapUnacked.empty() && SequenceLess()( mapUnacked.begin()->first, uiNext ) )
+		{
+			if( mapUnacked.begin()->second.uiRetries == 0 )
+				ullSample = std::max( (unsigned long long)1, ullNow - mapUnacked.begin()->second.ullSentTime );
+			mapUnacked.erase( mapUnacked.begin() );
+		}
+
+		for( unsigned int i = 0; i < uiRangeCount && !mapUnacked.empty(); i++ )
+		{
+			std::map<unsigned int, Pending, SequenceLess>::iterator it = mapUnacked.lower_bound( puiRanges[2*i] );
+			while( it != mapUnacked.end() && !SequenceLess()( puiRanges[2*i + 1], it->first ) )
+			{
+				if( it->second.uiRetries == 0 )
+					ullSample = std::max( (unsigned long long)1, ullNow - it->second.ullSentTime );
+				mapUnacked.erase( it++ );
+			}
+		}
+
+		if( ullSample > 0 )
+			updateRTO( ullSample );
+
+		if( uiRangeCount == 0 )
+			return;
+
+		// datagrams in front of an acknowledged one are lost, they are sent again at once but only the first time,
+		// later acknowledgements would report the same gap until the retransmission arrived
+		unsigned int uiHighest = puiRanges[2*uiRangeCount - 1];
+		for( std::map<unsigned int, Pending, SequenceLess>::iterator it = mapUnacked.begin(); it != mapUnacked.end() && SequenceLess()( it->first, uiHighest ); ++it )
+		{
+			if( it->second.uiRetries == 0 && it->second.ullDueTime > ullNow )
+			{
+				it->second.ullDueTime = ullNow;
+				m_ullNextDue = ullNow;
+			}
+		}
+	}
+
+
+	/**
+	 * @brief	Updates the retransmission timeout with a new round trip time like tcp does (RFC 6298), m_mxSender has to be locked.
+	 *
+	 * @param	ullSample	The measured round trip time in microseconds.
+	 */
+	void ReliableChannel::updateRTO( unsigned long long ullSample )
+	{
+		if( m_ullSRTT == 0 )
+		{
+			m_ullSRTT = ullSample;
+			m_ullRTTVar = ullSample / 2;
+		}
+		else
+		{
+			unsigned long long ullDiff = m_ullSRTT > ullSample ? m_ullSRTT - ullSample : ullSample - m_ullSRTT;
+			m_ullRTTVar = ( 3 * m_ullRTTVar + ullDiff ) / 4;
+			m_ullSRTT = ( 7 * m_ullSRTT + ullSample ) / 8;
+		}
+
+		m_ullRTO = std::max( (unsigned long long)RC_MIN_RTO, std::min( m_ullSRTT + 4 * m_ullRTTVar, (unsigned long long)RC_MAX_RTO ) );
+	}
+
+}
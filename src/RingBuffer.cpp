@@ -0,0 +1,208 @@
+/*
+Object Oriented Communication Library
+Copyright (c) 2011 Jürgen Lorenz and Jörn Teuber
+
+This software is provided 'as-is', without any express or implied warranty.
+In no event will the authors be held liable for any damages arising from the use of this software.
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it freely,
+subject to the following restrictions:
+
+1. The origin of this software must not be misrepresented; you must not claim that you wrote the original software. If you use this software in a product, an acknowledgment in the product documentation would be appreciated but is not required.
+2. Altered source versions must be plainly marked as such, and must not be misrepresented as being the original software.
+3. This notice may not be removed or altered from any source distribution.
+*/
+// This file was written by Jörn Teuber
+
+#include "RingBuffer.h"
+
+namespace oocl
+{
+	/**
+	 * @brief	Constructor.
+	 *
+	 * @param	uiCapacity	The initial capacity in bytes, will be rounded up to the next power of two.
+	 */
+	RingBuffer::RingBuffer( unsigned int uiCapacity )
+		: m_pcData( NULL )
+		, m_uiCapacity( 0 )
+		, m_uiReadPos( 0 )
+		, m_uiWritePos( 0 )
+	{
+		reserve( uiCapacity );
+	}
+
+
+	/**
+	 * @brief	Destructor.
+	 */
+	RingBuffer::~RingBuffer()
+	{
+		delete[] m_pcData;
+	}
+
+
+	/**
+	 * @brief	Get the largest contiguous free region, e.g. to receive directly into the buffer.
+	 *
+	 * @param [out]	uiLength	The number of bytes that can be written to the returned pointer.
+	 *
+	 * @return	Pointer to the free region.
+	 */
+	char* RingBuffer::writeRegion( unsigned int& uiLength )
+	{
+		unsigned int uiIndex = m_uiWritePos & (m_uiCapacity-1);
+
+		uiLength = m_uiCapacity - uiIndex;
+		if( uiLength > space() )
+			uiLength = space();
+
+		return m_pcData + uiIndex;
+	}
+
+
+	/**
+	 * @brief	Marks bytes written to the region returned by writeRegion() as used.
+	 *
+	 * @param	uiLength	The number of written bytes.
+	 */
+	void RingBuffer::commit( unsigned int uiLength )
+	{
+		m_uiWritePos += uiLength;
+	}
+
+
+	/**
+	 * @brief	Get the largest contiguous region of used bytes.
+	 *
+	 * @param [out]	uiLength	The number of bytes that can be read from the returned pointer.
+	 *
+	 * @return	Pointer to the first unread byte.
+	 */
+	const char* RingBuffer::readRegion( unsigned int& uiLength )
+	{
+		unsigned int uiIndex = m_uiReadPos & (m_uiCapacity-1);
+
+		uiLength = m_uiCapacity - uiIndex;
+		if( uiLength > size() )
+			uiLength = size();
+
+		return m_pcData + uiIndex;
+	}
+
+
+	/**
+	 * @brief	Removes bytes from the front of the buffer.
+	 *
+	 * @param	uiLength	The number of bytes to remove.
+	 */
+	void RingBuffer::consume( unsigned int uiLength )
+	{
+		if( uiLength > size() )
+			uiLength = size();
+
+		m_uiReadPos += uiLength;
+
+		// start at the beginning again when the buffer runs empty, so that the next message does not wrap
+		if( m_uiReadPos == m_uiWritePos )
+			m_uiReadPos = m_uiWritePos = 0;
+	}
+
+
+	/**
+	 * @brief	Copies bytes from the front of the buffer without removing them.
+	 *
+	 * @param [out]	pcDest  	The destination, at least uiLength bytes big.
+	 * @param	uiLength		The number of bytes to copy, must not be bigger than size().
+	 */
+	void RingBuffer::peek( char* pcDest, unsigned int uiLength ) const
+	{
+		unsigned int uiIndex = m_uiReadPos & (m_uiCapacity-1);
+		unsigned int uiFirst = std::min( uiLength, m_uiCapacity - uiIndex );
+
+		std::memcpy( pcDest, m_pcData + uiIndex, uiFirst );
+		std::memcpy( pcDest + uiFirst, m_pcData, uiLength - uiFirst );
+	}
+
+
+	/**
+	 * @brief	Makes sure the first uiLength bytes are stored contiguously and returns a pointer to them.
+	 *
+	 * @note	This only moves memory if the requested bytes wrap around the end of the buffer.
+	 *
+	 * @param	uiLength	The number of bytes that have to be contiguous, must not be bigger than size().
+	 *
+	 * @return	Pointer to the first unread byte.
+	 */
+	const char* RingBuffer::linearize( unsigned int uiLength )
+	{
+		unsigned int uiIndex = m_uiReadPos & (m_uiCapacity-1);
+
+		if( uiIndex + uiLength > m_uiCapacity )
+		{
+			// rotate the whole buffer so that the unread bytes start at the beginning
+			unsigned int uiSize = size();
+			std::rotate( m_pcData, m_pcData + uiIndex, m_pcData + m_uiCapacity );
+
+			m_uiReadPos = 0;
+			m_uiWritePos = uiSize;
+			uiIndex = 0;
+		}
+
+		return m_pcData + uiIndex;
+	}
+
+
+	/**
+	 * @brief	Makes sure the buffer can hold at least uiCapacity bytes.
+	 *
+	 * @param	uiCapacity	The needed capacity, will be rounded up to the next power of two.
+	 */
+	void RingBuffer::reserve( unsigned int uiCapacity )
+	{
+		if( uiCapacity <= m_uiCapacity )
+			return;
+
+		unsigned int uiNewCapacity = 16;
+		while( uiNewCapacity < uiCapacity )
+			uiNewCapacity <<= 1;
+
+		char* pcNewData = new char[uiNewCapacity];
+		unsigned int uiSize = size();
+
+		if( m_pcData != NULL )
+		{
+			peek( pcNewData, uiSize );
+			delete[] m_pcData;
+		}
+
+		m_pcData = pcNewData;
+		m_uiCapacity = uiNewCapacity;
+		m_uiReadPos = 0;
+		m_uiWritePos = uiSize;
+	}
+
+
+	/**
+	 * @brief	Exchanges the content of two buffers without copying.
+	 *
+	 * @param [in,out]	other	The buffer to swap with.
+	 */
+	void RingBuffer::swap( RingBuffer& other )
+	{
+		std::swap( m_pcData, other.m_pcData );
+		std::swap( m_uiCapacity, other.m_uiCapacity );
+		std::swap( m_uiReadPos, other.m_uiReadPos );
+		std::swap( m_uiWritePos, other.m_uiWritePos );
+	}
+
+
+	/**
+	 * @brief	Removes all bytes, the capacity stays the same.
+	 */
+	void RingBuffer::clear()
+	{
+		m_uiReadPos = m_uiWritePos = 0;
+	}
+
+}
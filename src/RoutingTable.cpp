@@ -0,0 +1,211 @@
+/*
+Object Oriented Communication Library
+Copyright (c) 2011 Jürgen Lorenz and Jörn Teuber
+
+This software is provided 'as-is', without any express or implied warranty.
+In no event will the authors be held liable for any damages arising from the use of this software.
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it freely,
+subject to the following restrictions:
+
+1. The origin of this software must not be misrepresented; you must not claim that you wrote the original software. If you use this software in a product, an acknowledgment in the product documentation would be appreciated but is not required.
+2. Altered source versions must be plainly marked as such, and must not be misrepresented as being the original software.
+3. This notice may not be removed or altered from any source distribution.
+*/
+// This file was written by Jörn Teuber
+
+#include "RoutingTable.h"
+#include "Peer.h"
+
+namespace oocl
+{
+	/**
+	 * @brief	Default constructor.
+	 */
+	RoutingTable::RoutingTable()
+	{
+	}
+
+
+	/**
+	 * @brief	Destructor, unregisters all routes from their brokers.
+	 *
+	 * @note	Remove all peers first, a broker that waits for room in the send queue of a peer would block this.
+	 */
+	RoutingTable::~RoutingTable()
+	{
+		for( std::map<unsigned short, Route*>::iterator it = m_mapRoutes.begin(); it != m_mapRoutes.end(); ++it )
+		{
+			MessageBroker::getBrokerFor( it->first )->unregisterListener( it->second );
+			delete it->second;
+		}
+
+		m_mapRoutes.clear();
+	}
+
+
+	/**
+	 * @brief	Gives a peer the first free slot, so that it can subscribe message types.
+	 *
+	 * @param [in]	pPeer	The peer.
+	 */
+	void RoutingTable::addPeer( Peer* pPeer )
+	{
+		m_mxRoutes.lock();
+
+		unsigned int uiSlot = 0;
+		while( uiSlot < m_vpPeers.size() && m_vpPeers[uiSlot] != NULL )
+			uiSlot++;
+
+		if( uiSlot == m_vpPeers.size() )
+			m_vpPeers.push_back( pPeer );
+		else
+			m_vpPeers[uiSlot] = pPeer;
+
+		pPeer->m_uiSlot = uiSlot;
+		pPeer->m_pRoutingTable = this;
+
+		m_mxRoutes.unlock();
+	}
+
+
+	/**
+	 * @brief	Removes a peer from all routes and frees its slot, has to be called before the peer is deleted.
+	 *
+	 * @note	Close the send queue of the peer first, so that a broker waiting for room in it returns. This waits
+	 * 			until no broker is queueing a message for the peer anymore.
+	 *
+	 * @param [in]	pPeer	The peer.
+	 */
+	void RoutingTable::removePeer( Peer* pPeer )
+	{
+		m_mxRoutes.lock();
+
+		unsigned int uiSlot = pPeer->m_uiSlot;
+		if( pPeer->m_pRoutingTable == this && uiSlot < m_vpPeers.size() && m_vpPeers[uiSlot] == pPeer )
+		{
+			for( std::map<unsigned short, Route*>::iterator it = m_mapRoutes.begin(); it != m_mapRoutes.end(); ++it )
+				it->second->m_setPeers.erase( uiSlot );
+
+			m_vpPeers[uiSlot] = NULL;
+			pPeer->m_pRoutingTable = NULL;
+		}
+
+		while( pPeer->m_uiRoutings > 0 )
+			m_condRouted.wait( m_mxRoutes );
+
+		m_mxRoutes.unlock();
+	}
+
+
+	/**
+	 * @brief	Sends all messages of a type to a peer from now on.
+	 *
+	 * @param [in]	pPeer	The peer that subscribed.
+	 * @param	usType		The subscribed message type.
+	 */
+	void RoutingTable::subscribe( Peer* pPeer, unsigned short usType )
+	{
+		Route* pNewRoute = NULL;
+
+		m_mxRoutes.lock();
+
+		unsigned int uiSlot = pPeer->m_uiSlot;
+		if( uiSlot >= m_vpPeers.size() || m_vpPeers[uiSlot] != pPeer )
+		{
+			m_mxRoutes.unlock();
+			return;
+		}
+
+		std::map<unsigned short, Route*>::iterator it = m_mapRoutes.find( usType );
+		if( it == m_mapRoutes.end() )
+		{
+			pNewRoute = new Route( this );
+			it = m_mapRoutes.insert( std::pair<unsigned short, Route*>( usType, pNewRoute ) ).first;
+		}
+
+		it->second->m_setPeers.insert( uiSlot );
+
+		m_mxRoutes.unlock();
+
+		// the route stays registered when its last subscriber is removed, it is cheap and most likely needed again
+		if( pNewRoute != NULL )
+			MessageBroker::getBrokerFor( usType )->registerListener( pNewRoute );
+	}
+
+
+	/**
+	 * @brief	Queues a message for all peers of a route, called by the broker of its type.
+	 *
+	 * @param [in]	pMessage	The message.
+	 * @param [in]	pRoute		The route of its type.
+	 */
+	void RoutingTable::route( Message const * pMessage, const Route* pRoute )
+	{
+		// messages that were received from the network are not sent back into it
+		if( pMessage->isIncoming() )
+			return;
+
+		if( pMessage->getProtocoll() == 0 )
+		{
+			OOCL_LOG_WARNING( "oocl", "attempted to send a message over the network that was not intended for that (protocol 0)" );
+			return;
+		}
+
+		// the peers are only collected under the lock, a full send queue blocks the broker in queueMessage() and must
+		// not block the other routes or the peer that is removed, removePeer() waits until m_uiRoutings is back to 0
+		std::vector<Peer*> vpPeers;
+
+		m_mxRoutes.lock();
+
+		for( int i = pRoute->m_setPeers.next( 0 ); i >= 0; i = pRoute->m_setPeers.next( i + 1 ) )
+		{
+			m_vpPeers[i]->m_uiRoutings++;
+			vpPeers.push_back( m_vpPeers[i] );
+		}
+
+		m_mxRoutes.unlock();
+
+		if( vpPeers.empty() )
+			return;
+
+		// serialized once, all peers share it
+		SerializedMessage* pSerialized = new SerializedMessage( pMessage );
+		pSerialized->retain();
+
+		for( std::vector<Peer*>::iterator it = vpPeers.begin(); it != vpPeers.end(); ++it )
+			(*it)->queueMessage( pSerialized );
+
+		pSerialized->release();
+
+		m_mxRoutes.lock();
+
+		bool bRemoving = false;
+		for( std::vector<Peer*>::iterator it = vpPeers.begin(); it != vpPeers.end(); ++it )
+		{
+			(*it)->m_uiRoutings--;
+			if( (*it)->m_uiRoutings == 0 && (*it)->m_pRoutingTable != this )
+				bRemoving = true;
+		}
+
+		if( bRemoving )
+			m_condRouted.broadcast();
+
+		m_mxRoutes.unlock();
+	}
+
+
+	/**
+	 * @brief	Hands a message to the routing table.
+	 *
+	 * @param [in]	pMessage	The message.
+	 *
+	 * @return	true, the message is always processed.
+	 */
+	bool RoutingTable::Route::cbMessage( Message const * const pMessage )
+	{
+		m_pTable->route( pMessage, this );
+		return true;
+	}
+
+}
@@ -43,7 +43,7 @@ namespace oocl
 			{
 				/* Handle failed load here */
 				sm_pCTX = NULL;
-				Log::getLog( "oocl" )->logFatalError( "OpenSSL TrustStore could not be loaded!" );
+				OOCL_LOG_FATAL_ERROR( "oocl", "OpenSSL TrustStore could not be loaded!" );
 			}
 		}
 		sm_uiSocketCounter++;
@@ -74,7 +74,7 @@ namespace oocl
 		char* cp = (char*) &uiHostIP;
 		ss << cp[0] << "." << cp[1] << "." << cp[2] << "." << cp[3] << ":" << usPort;
 
-		Log::getLog( "oocl" )->logInfo( "SecureSocket: built address string out of IP: " + ss.str() );
+		OOCL_LOG_INFO( "oocl", "SecureSocket: built address string out of IP: " + ss.str() );
 
 		return connect( ss.str() );
 	}
@@ -110,8 +110,8 @@ namespace oocl
 		if( m_pBio == NULL )
 		{
 			/* Handle the failure */
-			Log::getLog( "oocl" )->logError( "connecting failed!" );
-			Log::getLog( "oocl" )->logError( ERR_error_string( ERR_get_error(), NULL ) );
+			OOCL_LOG_ERROR( "oocl", "connecting failed!" );
+			OOCL_LOG_ERROR( "oocl", ERR_error_string( ERR_get_error(), NULL ) );
 			m_bValid = false;
 			return false;
 		}
@@ -119,8 +119,8 @@ namespace oocl
 		if( BIO_do_connect(m_pBio) <= 0 )
 		{
 			/* Handle failed connection */
-			Log::getLog( "oocl" )->logError( "connecting failed!" );
-			Log::getLog( "oocl" )->logError( ERR_error_string( ERR_get_error(), NULL ) );
+			OOCL_LOG_ERROR( "oocl", "connecting failed!" );
+			OOCL_LOG_ERROR( "oocl", ERR_error_string( ERR_get_error(), NULL ) );
 			m_bValid = false;
 			return false;
 		}
@@ -129,13 +129,13 @@ namespace oocl
 		{
 			if( BIO_do_handshake(m_pBio) <= 0 )
 			{
-				Log::getLog( "oocl" )->logError( "Error establishing SSL connection" );
+				OOCL_LOG_ERROR( "oocl", "Error establishing SSL connection" );
 				return false;
 			}
 			if( SSL_get_verify_result( m_pSSL ) != X509_V_OK )
 			{
 				/* Handle the failed verification */
-				Log::getLog( "oocl" )->logError( "SSL certificate verification failed!" );
+				OOCL_LOG_ERROR( "oocl", "SSL certificate verification failed!" );
 			}
 		}
 
@@ -205,7 +205,7 @@ namespace oocl
 			}
 			catch( ... )
 			{
-				Log::getLog( "oocl" )->logWarning( "read failed, aborting" );
+				OOCL_LOG_WARNING( "oocl", "read failed, aborting" );
 				return false;
 			}
 
@@ -330,7 +330,7 @@ namespace oocl
 		}
 		catch( ... )
 		{
-			Log::getLog( "oocl" )->logWarning( "OpenSSL reset threw an exception" );
+			OOCL_LOG_WARNING( "oocl", "OpenSSL reset threw an exception" );
 		}
 		m_bConnected = false;
 	}
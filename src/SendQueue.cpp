@@ -0,0 +1,267 @@
+/*
+Object Oriented Communication Library
+Copyright (c) 2011 Jürgen Lorenz and Jörn Teuber
+
+This software is provided 'as-is', without any express or implied warranty.
+In no event will the authors be held liable for any damages arising from the use of this software.
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it freely,
+subject to the following restrictions:
+
+1. The origin of this software must not be misrepresented; you must not claim that you wrote the original software. If you use this software in a product, an acknowledgment in the product documentation would be appreciated but is not required.
+2. Altered source versions must be plainly marked as such, and must not be misrepresented as being the original software.
+3. This notice may not be removed or altered from any source distribution.
+*/
+// This file was written by Jörn Teuber
+
+#include "SendQueue.h"
+
+namespace oocl
+{
+	/**
+	 * @brief	Constructor.
+	 *
+	 * @param	uiCapacity	The number of messages that may wait, at least 1.
+	 * @param	ePolicy		What to do with a message that does not fit anymore.
+	 */
+	SendQueue::SendQueue( unsigned int uiCapacity, EOverflowPolicy ePolicy )
+		: m_uiCapacity( uiCapacity > 0 ? uiCapacity : 1 )
+		, m_ePolicy( ePolicy )
+		, m_uiDropped( 0 )
+		, m_bClosed( false )
+		, m_bSending( false )
+	{
+	}
+
+
+	/**
+	 * @brief	Destructor, releases the messages that were not sent.
+	 */
+	SendQueue::~SendQueue()
+	{
+		discard();
+	}
+
+
+	/**
+	 * @brief	Sets how many messages may wait and what happens when there are more.
+	 *
+	 * @note	Messages that are already queued stay even if there are more than the new capacity.
+	 *
+	 * @param	uiCapacity	The number of messages that may wait, at least 1.
+	 * @param	ePolicy		What to do with a message that does not fit anymore.
+	 */
+	void SendQueue::setCapacity( unsigned int uiCapacity, EOverflowPolicy ePolicy )
+	{
+		m_mxQueue.lock();
+
+		m_uiCapacity = uiCapacity > 0 ? uiCapacity : 1;
+		m_ePolicy = ePolicy;
+
+		// threads that wait with OP_Block might fit now or have to decide again
+		m_condNotFull.broadcast();
+
+		m_mxQueue.unlock();
+	}
+
+
+	/**
+	 * @brief	Appends a message for the writer, can be called from any thread.
+	 *
+	 * @note	With OP_Block this waits while the queue is full.
+	 *
+	 * @param [in]	pMessage	The message, it is retained while it is queued.
+	 *
+	 * @return	Whether the message was queued and what was dropped, see EPushResult.
+	 */
+	SendQueue::EPushResult SendQueue::push( SerializedMessage const * pMessage )
+	{
+		m_mxQueue.lock();
+
+		while( !m_bClosed && m_dqMessages.size() >= m_uiCapacity && m_ePolicy == OP_Block )
+			m_condNotFull.wait( m_mxQueue );
+
+		if( m_bClosed )
+		{
+			m_mxQueue.unlock();
+			return PR_Closed;
+		}
+
+		EPushResult eResult = PR_Queued;
+
+		if( m_dqMessages.size() >= m_uiCapacity )
+		{
+			m_uiDropped++;
+
+			if( m_ePolicy == OP_DropNewest )
+			{
+				m_mxQueue.unlock();
+				return PR_DroppedNewest;
+			}
+			else if( m_ePolicy == OP_Disconnect )
+			{
+				m_mxQueue.unlock();
+				close( true );
+				return PR_Overflow;
+			}
+
+			m_dqMessages.front()->release();
+			m_dqMessages.pop_front();
+			eResult = PR_DroppedOldest;
+		}
+
+		pMessage->retain();
+		m_dqMessages.push_back( pMessage );
+
+		m_condNotEmpty.signal();
+
+		m_mxQueue.unlock();
+
+		return eResult;
+	}
+
+
+	/**
+	 * @brief	Removes the oldest message, waits until there is one, only called by the writer thread.
+	 *
+	 * @param [out]	pMessage	The removed message, the caller has to release it.
+	 *
+	 * @return	true if a message was removed, false if the queue was closed and nothing is left.
+	 */
+	bool SendQueue::pop( SerializedMessage const *& pMessage )
+	{
+		m_mxQueue.lock();
+
+		// the writer comes back here when it sent the last message
+		m_bSending = false;
+		if( m_dqMessages.empty() )
+			m_condNotFull.broadcast();
+
+		while( !m_bClosed && m_dqMessages.empty() )
+			m_condNotEmpty.wait( m_mxQueue );
+
+		if( m_dqMessages.empty() )
+		{
+			m_mxQueue.unlock();
+			return false;
+		}
+
+		// the reference of the queue is handed over to the caller
+		pMessage = m_dqMessages.front();
+		m_dqMessages.pop_front();
+		m_bSending = true;
+
+		m_condNotFull.broadcast();
+
+		m_mxQueue.unlock();
+
+		return true;
+	}
+
+
+	/**
+	 * @brief	Closes the queue, new messages are dropped and waiting threads return.
+	 *
+	 * @param	bDiscard	true to drop the queued messages as well, false to let the writer send them first.
+	 */
+	void SendQueue::close( bool bDiscard )
+	{
+		m_mxQueue.lock();
+		m_bClosed = true;
+		m_condNotEmpty.broadcast();
+		m_condNotFull.broadcast();
+		m_mxQueue.unlock();
+
+		if( bDiscard )
+			discard();
+	}
+
+
+	/**
+	 * @brief	Waits until the writer sent all queued messages.
+	 *
+	 * @note	The time limit applies to each message, a writer that keeps sending is waited for.
+	 *
+	 * @param	iMilliseconds	The time the writer may take without sending a message.
+	 *
+	 * @return	true if everything was sent, false if the writer did not make progress in time.
+	 */
+	bool SendQueue::waitUntilSent( int iMilliseconds )
+	{
+		m_mxQueue.lock();
+
+		while( !m_dqMessages.empty() || m_bSending )
+		{
+			if( !m_condNotFull.wait( m_mxQueue, iMilliseconds ) )
+			{
+				m_mxQueue.unlock();
+				return false;
+			}
+		}
+
+		m_mxQueue.unlock();
+
+		return true;
+	}
+
+
+	/**
+	 * @brief	Releases all queued messages.
+	 */
+	void SendQueue::discard()
+	{
+		m_mxQueue.lock();
+
+		for( std::deque<SerializedMessage const *>::iterator it = m_dqMessages.begin(); it != m_dqMessages.end(); ++it )
+			(*it)->release();
+		m_dqMessages.clear();
+
+		m_mxQueue.unlock();
+	}
+
+
+	/**
+	 * @brief	Get the number of queued messages.
+	 *
+	 * @return	The number of messages that wait for the writer.
+	 */
+	unsigned int SendQueue::size()
+	{
+		m_mxQueue.lock();
+		unsigned int uiSize = m_dqMessages.size();
+		m_mxQueue.unlock();
+
+		return uiSize;
+	}
+
+
+	/**
+	 * @brief	Get the number of messages that were dropped because the queue was full.
+	 *
+	 * @return	The number of dropped messages.
+	 */
+	unsigned int SendQueue::getDroppedCount()
+	{
+		m_mxQueue.lock();
+		unsigned int uiDropped = m_uiDropped;
+		m_mxQueue.unlock();
+
+		return uiDropped;
+	}
+
+
+	/**
+	 * @brief	Check whether the queue was closed.
+	 *
+	 * @return	true if it is closed, false if not.
+	 */
+	bool SendQueue::isClosed()
+	{
+		m_mxQueue.lock();
+		bool bClosed = m_bClosed;
+		m_mxQueue.unlock();
+
+		return bClosed;
+	}
+
+}
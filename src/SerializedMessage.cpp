@@ -0,0 +1,97 @@
+/*
+Object Oriented Communication Library
+Copyright (c) 2011 Jürgen Lorenz and Jörn Teuber
+
+This software is provided 'as-is', without any express or implied warranty.
+In no event will the authors be held liable for any damages arising from the use of this software.
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it freely,
+subject to the following restrictions:
+
+1. The origin of this software must not be misrepresented; you must not claim that you wrote the original software. If you use this software in a product, an acknowledgment in the product documentation would be appreciated but is not required.
+2. Altered source versions must be plainly marked as such, and must not be misrepresented as being the original software.
+3. This notice may not be removed or altered from any source distribution.
+*/
+// This file was written by Jörn Teuber
+
+#include "SerializedMessage.h"
+#include "Codec.h"
+
+namespace oocl
+{
+	/**
+	 * @brief	Constructor, serializes the message.
+	 *
+	 * @param [in]	pMessage	The message, it is retained as long as this exists.
+	 */
+	SerializedMessage::SerializedMessage( Message const * pMessage )
+		: m_ptrMessage( pMessage )
+		, m_wbFrame( pMessage->getBodyLength() + MSG_MAX_HEADER_LENGTH )
+		, m_wbCompressed( 0 )
+		, m_uiCompressedCodecs( 0 )
+		, m_bCompressed( false )
+		, m_uiRefCount( 0 )
+	{
+		pMessage->serializeInto( m_wbFrame );
+	}
+
+
+	/**
+	 * @brief	Appends the frame, compressed with the codecs of the receiver if its type asks for it, see Codec::compressFrame().
+	 *
+	 * @param [out]	wbOut		The buffer to append to, it has to be empty if uiCodecs is not 0.
+	 * @param	uiCodecs		The codecs the receiver can decompress.
+	 * @param [in]	wbScratch	Scratch buffer for compressing with other codecs than the cached ones.
+	 */
+	void SerializedMessage::appendFrame( WriteBuffer& wbOut, unsigned int uiCodecs, WriteBuffer& wbScratch ) const
+	{
+		if( uiCodecs != 0 )
+		{
+			m_mxCompressed.lock();
+
+			if( !m_bCompressed )
+			{
+				m_wbCompressed.append( m_wbFrame.data(), m_wbFrame.size() );
+				Codec::compressFrame( m_wbCompressed, uiCodecs, wbScratch );
+				m_uiCompressedCodecs = uiCodecs;
+				m_bCompressed = true;
+			}
+
+			bool bCached = uiCodecs == m_uiCompressedCodecs;
+
+			m_mxCompressed.unlock();
+
+			// the cached frame is not changed anymore once it was filled
+			if( bCached )
+			{
+				wbOut.append( m_wbCompressed.data(), m_wbCompressed.size() );
+				return;
+			}
+		}
+
+		wbOut.append( m_wbFrame.data(), m_wbFrame.size() );
+
+		if( uiCodecs != 0 )
+			Codec::compressFrame( wbOut, uiCodecs, wbScratch );
+	}
+
+
+	/**
+	 * @brief	Adds a reference.
+	 */
+	void SerializedMessage::retain() const
+	{
+		m_uiRefCount.fetchAdd( 1 );
+	}
+
+
+	/**
+	 * @brief	Removes a reference and deletes this if it was the last one.
+	 */
+	void SerializedMessage::release() const
+	{
+		if( m_uiRefCount.fetchAdd( (unsigned int)-1 ) == 1 )
+			delete this;
+	}
+
+}
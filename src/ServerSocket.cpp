@@ -30,14 +30,12 @@ namespace oocl
 		m_iSockFD = socket(AF_INET, SOCK_STREAM, 0);
 #ifdef linux
 		if(m_iSockFD < 0) {
-			Log::getLog("oocl")->logError("ERROR opening socket");
+			OOCL_LOG_ERROR( "oocl", "ERROR opening socket" );
 			m_bValid = false;
 		}
 #else
 		if(m_iSockFD == INVALID_SOCKET) {
-			std::ostringstream os;
-			os << "ERROR opening socket! Error code: " << WSAGetLastError();
-			Log::getLog("oocl")->logError( os.str() );
+			OOCL_LOG_ERROR( "oocl", "ERROR opening socket! Error code: " << WSAGetLastError() );
 			m_bValid = false;
 		}
 #endif
@@ -63,15 +61,13 @@ namespace oocl
 			int result = ::bind( m_iSockFD, (struct sockaddr *) &m_sSockAddr, sizeof(m_sSockAddr) );
 #ifdef linux
 			if( result < 0 ){
-				Log::getLog("oocl")->logError("ERROR on binding");
+				OOCL_LOG_ERROR( "oocl", "ERROR on binding" );
 				return false;
 			}
 #else
 			if( result == SOCKET_ERROR )
 			{
-				std::ostringstream os;
-				os << "ERROR on binding! Error code: " << WSAGetLastError();
-				Log::getLog("oocl")->logError( os.str() );
+				OOCL_LOG_ERROR( "oocl", "ERROR on binding! Error code: " << WSAGetLastError() );
 				return false;
 			}
 #endif
@@ -79,6 +75,8 @@ namespace oocl
 			// start listening
 			listen(m_iSockFD,10);
 
+			m_bBound = true;
+
 			return true;
 		}
 
@@ -119,14 +117,17 @@ namespace oocl
 			int newsockfd = ::accept(m_iSockFD, (struct sockaddr *) &cli_addr, &clilen);
 #ifdef linux
 			if(newsockfd < 0) {
-				Log::getLog("oocl")->logError("ERROR on accept");
+				// a non-blocking server socket has no more pending connections
+				if( errno != EAGAIN && errno != EWOULDBLOCK )
+					OOCL_LOG_ERROR( "oocl", "ERROR on accept" );
 				return NULL;
 			}
 #else
 			if(newsockfd == INVALID_SOCKET) {
-				std::ostringstream os;
-				os << "ERROR on accept! Error code: " << WSAGetLastError();
-				Log::getLog("oocl")->logError( os.str() );
+				if( WSAGetLastError() == WSAEWOULDBLOCK )
+					return NULL;
+
+				OOCL_LOG_ERROR( "oocl", "ERROR on accept! Error code: " << WSAGetLastError() );
 				return NULL;
 			}
 #endif
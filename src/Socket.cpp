@@ -25,4 +25,92 @@ namespace oocl
 		: SocketStub()
 	{
 	}
+
+	/**
+	 * @brief	Receives as many pending packages as fit into the slab, each into its own buffer.
+	 *
+	 * @note	This implementation calls read() once per package, sockets that can receive many packages
+	 * 			with one system call override it.
+	 *
+	 * @param [in,out]	slab	The slab to receive into, the packages in it are replaced.
+	 *
+	 * @return	The number of received packages, 0 if nothing was pending or the socket failed.
+	 */
+	int Socket::readDatagrams( DatagramSlab& slab )
+	{
+		slab.m_uiCount = 0;
+
+		while( slab.m_uiCount < slab.m_uiMaxDatagrams )
+		{
+			int iCount = slab.m_uiDatagramSize;
+			if( !read( slab.getBuffer( slab.m_uiCount ), iCount ) )
+				break;
+
+			slab.m_puiLengths[slab.m_uiCount] = iCount;
+			slab.m_pbTruncated[slab.m_uiCount] = false;
+			slab.m_uiCount++;
+		}
+
+		return slab.m_uiCount;
+	}
+
+	/**
+	 * @brief	Sets when written packages are sent, so that many small writes can be sent with one system call.
+	 *
+	 * @note	This socket does not support batching, every write is sent immediately.
+	 *
+	 * @param	ePolicy		The flush policy.
+	 * @param	uiThreshold	The number of bytes for FP_SizeThreshold or the number of microseconds for FP_Deadline.
+	 *
+	 * @return	true if the policy is supported, false if not.
+	 */
+	bool Socket::setBatching( EFlushPolicy ePolicy, unsigned int /*uiThreshold*/ )
+	{
+		return ePolicy == FP_Immediate;
+	}
+
+	/**
+	 * @brief	Sends all queued packages.
+	 *
+	 * @return	true if it succeeds, false if it fails.
+	 */
+	bool Socket::flush()
+	{
+		return true;
+	}
+
+	/**
+	 * @brief	Sends all queued packages if the deadline of the FP_Deadline policy has passed.
+	 *
+	 * @note	Call this regularly when using FP_Deadline, as the deadline is otherwise only checked on the next write.
+	 *
+	 * @return	true if it succeeds or nothing had to be sent, false if it fails.
+	 */
+	bool Socket::flushIfDue()
+	{
+		return true;
+	}
+
+	/**
+	 * @brief	Get the largest ip packet that reaches the connected host without being fragmented.
+	 *
+	 * @note	This socket does not know the path, the caller has to assume a value.
+	 *
+	 * @return	The path MTU in bytes or 0 if it is unknown.
+	 */
+	unsigned int Socket::getPathMTU()
+	{
+		return 0;
+	}
+
+	/**
+	 * @brief	Shuts the connection down without closing the socket, so that a thread waiting in write() returns.
+	 *
+	 * @note	Unlike close() this may be called from another thread while the socket is in use, all further reads and
+	 * 			writes fail. The socket still has to be closed and deleted by its owner.
+	 */
+	void Socket::interrupt()
+	{
+		::shutdown( getCSocket(), 2 );
+	}
 }
@@ -35,9 +35,7 @@ namespace oocl
 			WSADATA wsaData;
 			int iResult = WSAStartup(MAKEWORD(2, 2), &wsaData);
 			if (iResult != 0) {
-				std::ostringstream os;
-				os << "WSAStartup failed: " << WSAGetLastError();
-				Log::getLog("oocl")->logError( os.str() );
+				OOCL_LOG_ERROR( "oocl", "WSAStartup failed: " << WSAGetLastError() );
 			}
 		}
 	#endif
@@ -59,4 +57,34 @@ namespace oocl
 	#endif
 	}
 
-}
\ No newline at end of file
+
+
+	/**
+	 * @brief	Switches the underlying C socket between blocking and non-blocking mode.
+	 *
+	 * @note	Sockets that are registered with a Reactor are non-blocking, so a read or accept on them returns immediately if there is nothing to receive.
+	 *
+	 * @param	bBlocking	If true, calls on the socket will block, else they return immediately.
+	 *
+	 * @return	true if it succeeds, false if it fails.
+	 */
+	bool SocketStub::setBlocking( bool bBlocking )
+	{
+#ifdef linux
+		int iFlags = fcntl( getCSocket(), F_GETFL, 0 );
+		if( iFlags < 0 )
+			return false;
+
+		if( bBlocking )
+			iFlags &= ~O_NONBLOCK;
+		else
+			iFlags |= O_NONBLOCK;
+
+		return fcntl( getCSocket(), F_SETFL, iFlags ) == 0;
+#else
+		u_long ulNonBlocking = bBlocking ? 0 : 1;
+		return ioctlsocket( getCSocket(), FIONBIO, &ulNonBlocking ) == 0;
+#endif
+	}
+
+}
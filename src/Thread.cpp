@@ -14,7 +14,15 @@ subject to the following restrictions:
 */
 // This file was written by Jürgen Lorenz and Jörn Teuber
 
+#include <deque>
+#ifdef linux
+#	include <time.h>
+#	include <unistd.h>
+#endif
+
 #include "Thread.h"
+#include "Mutex.h"
+#include "Condition.h"
 
 namespace oocl
 {
@@ -24,39 +32,69 @@ namespace oocl
 	 * @brief	Default constructor.
 	 */
 	Thread::Thread()
-		: m_iThreadPriority( TP_Normal )
-		, m_bActive( false )
 #ifdef USE_CPP11
-		, m_pThread( NULL )
+		: m_pThread( NULL )
+		, m_iThreadPriority( TP_Normal )
+#else
+		: m_iThreadPriority( TP_Normal )
 #endif
+		, m_uiActive( 0 )
+		, m_bJoinable( false )
+		, m_pmxHandle( new Mutex() )
 	{
 	}
 
 
+	/**
+	 * @brief	Destructor, a thread that was not joined is detached.
+	 */
 	Thread::~Thread()
 	{
+		if( m_bJoinable )
+		{
 #if defined USE_CPP11
-		delete m_pThread;
-#elif defined USE_WINTHREADS
-		CloseHandle(m_hThread);
+			m_pThread->detach();
+			delete m_pThread;
+#elif defined linux
+			pthread_detach(m_iThreadID);
+#else
+			CloseHandle(m_hThread);
 #endif
+		}
+
+		delete m_pmxHandle;
 	}
 
 
 	/**
-	 * @brief	blocks until the thread has finished.
+	 * @brief	blocks until the thread has finished and releases it.
 	 */
 	void Thread::join()
 	{
-		if( m_bActive )
+		m_pmxHandle->lock();
+		joinLocked();
+		m_pmxHandle->unlock();
+	}
+
+
+	/**
+	 * @brief	Joins the thread if it was started and not joined yet, m_pmxHandle has to be locked.
+	 */
+	void Thread::joinLocked()
+	{
+		if( m_bJoinable )
 		{
 #if defined USE_CPP11
 			m_pThread->join();
+			delete m_pThread;
+			m_pThread = NULL;
 #elif defined linux
 			pthread_join(m_iThreadID, NULL);
 #else
 			WaitForSingleObject(m_hThread,INFINITE);
+			CloseHandle(m_hThread);
 #endif
+			m_bJoinable = false;
 		}
 	}
 
@@ -96,33 +134,55 @@ namespace oocl
 	 */
 	bool Thread::isAlive()
 	{
-		return m_bActive;
+		return m_uiActive.load() != 0;
 	}
 
 
 	/**
 	 * @brief	Starts the thread.
 	 *
+	 * @note	The thread counts as alive from here on, so a join() right after start() waits for it
+	 * 			even if it was not scheduled yet. If the object was started before, the previous thread is joined
+	 * 			first, so start() must not be called from inside run(). Another thread may call start() as soon as
+	 * 			run() is done, e.g. the producer that restarts a MessageBroker, it waits until this call stored the
+	 * 			handle of the thread.
+	 *
 	 * @return	true if it succeeds, false if it fails.
 	 */
 	bool Thread::start()
 	{
+		m_pmxHandle->lock();
+
+		// the previous thread might still be on its way out of run(), it must not clear the flag of the new one
+		joinLocked();
+
+		m_uiActive.store( 1 );
+
 #if defined USE_CPP11
 		try {
 			m_pThread = new std::thread( Thread::entryPoint, this );
-			return true;
+			m_bJoinable = true;
 		}
 		catch( std::system_error& e )
 		{
-			Log::getLogRef("oocl") << Log::EL_ERROR << "Unable to start thread: " << e.what() << endl;
-			return false;
+			OOCL_LOG_ERROR( "oocl", "Unable to start thread: " << e.what() );
 		}
 #elif defined linux
-		return !pthread_create(&m_iThreadID, NULL, Thread::entryPoint, this);
+		if( pthread_create(&m_iThreadID, NULL, Thread::entryPoint, this) == 0 )
+			m_bJoinable = true;
 #else
 		m_hThread = CreateThread( NULL, 0, Thread::entryPoint, this, 0, &m_iThreadID);
-		return (m_hThread != NULL);
+		if( m_hThread != NULL )
+			m_bJoinable = true;
 #endif
+
+		bool bStarted = m_bJoinable;
+		if( !bStarted )
+			m_uiActive.store( 0 );
+
+		m_pmxHandle->unlock();
+
+		return bStarted;
 	}
 
 #if defined USE_CPP11
@@ -133,9 +193,8 @@ namespace oocl
 	DWORD WINAPI Thread::entryPoint(LPVOID pthis)
 #endif
 	{
-		((Thread*)pthis)->m_bActive = true;
 		((Thread*)pthis)->run();
-		((Thread*)pthis)->m_bActive = false;
+		((Thread*)pthis)->m_uiActive.store( 0 );
 
 		return 0;
 	}
@@ -169,4 +228,426 @@ namespace oocl
 #endif
 	}
 
+
+
+	/**
+	 * @brief	One thread of a ThreadPool together with its task queue.
+	 */
+	/// the pool the current thread belongs to, NULL if it is not a worker of a pool
+	static OOCL_THREAD_LOCAL ThreadPool* tl_pPool = NULL;
+	/// the index of the current thread in its pool
+	static OOCL_THREAD_LOCAL unsigned int tl_uiWorker = 0;
+
+	class ThreadPool::Worker : public Thread
+	{
+	public:
+		Worker( ThreadPool* pPool, unsigned int uiIndex ) : m_pPool( pPool ), m_uiIndex( uiIndex ) {}
+
+		std::deque<QueuedTask>	m_dqTasks;
+		Mutex					m_mxTasks;
+
+	protected:
+		virtual void run()
+		{
+			tl_pPool = m_pPool;
+			tl_uiWorker = m_uiIndex;
+
+			while( m_pPool->m_uiState.load() != PS_Stopped )
+			{
+				QueuedTask task;
+				if( m_pPool->findTask( m_uiIndex, task ) )
+				{
+					task.pTask->execute();
+					if( task.pFuture )
+						task.pFuture->complete( Future::FS_Done );
+				}
+				else if( m_pPool->m_uiState.load() == PS_Running )
+					m_pPool->waitForTask();
+				else if( m_pPool->m_uiSubmitting.load() == 0 && m_pPool->m_uiPendingTasks.load() == 0 )
+					break;
+				else
+					Thread::sleep( 0 ); // a task that is still being submitted has to be drained as well
+			}
+		}
+
+	private:
+		ThreadPool*		m_pPool;
+		unsigned int	m_uiIndex;
+	};
+
+
+	Atomic<ThreadPool*> ThreadPool::sm_pDefault( NULL );
+
+	/**
+	 * @brief	Constructor, starts the threads of the pool.
+	 *
+	 * @param	uiNumThreads	The number of threads, 0 to start one thread per core.
+	 */
+	ThreadPool::ThreadPool( unsigned int uiNumThreads )
+		: m_uiPendingTasks( 0 )
+		, m_uiSleeping( 0 )
+		, m_uiNextWorker( 0 )
+		, m_uiState( PS_Running )
+		, m_uiSubmitting( 0 )
+		, m_uiWaiting( 0 )
+		, m_pmxSleep( new Mutex() )
+		, m_pcvTaskSubmitted( new Condition() )
+		, m_pcvTaskDone( new Condition() )
+	{
+		if( uiNumThreads == 0 )
+			uiNumThreads = getNumCores();
+
+		for( unsigned int i = 0; i < uiNumThreads; i++ )
+			m_vpWorkers.push_back( new Worker( this, i ) );
+
+		for( unsigned int i = 0; i < uiNumThreads; i++ )
+			m_vpWorkers[i]->start();
+	}
+
+
+	/**
+	 * @brief	Destructor, stops the threads of the pool.
+	 *
+	 * @note	Tasks that are currently executed are finished, tasks that were not started yet are cancelled,
+	 * 			see shutdown().
+	 */
+	ThreadPool::~ThreadPool()
+	{
+		shutdown( false );
+
+		for( unsigned int i = 0; i < m_vpWorkers.size(); i++ )
+			delete m_vpWorkers[i];
+
+		delete m_pcvTaskDone;
+		delete m_pcvTaskSubmitted;
+		delete m_pmxSleep;
+	}
+
+
+	/**
+	 * @brief	Queues a task for execution by one of the threads.
+	 *
+	 * @param	pTask	The task, has to stay valid until it was executed.
+	 *
+	 * @return	true if the task was queued, false if the pool was shut down.
+	 */
+	bool ThreadPool::submit( Task* pTask )
+	{
+		return enqueue( pTask, NULL );
+	}
+
+
+	/**
+	 * @brief	Queues a task for execution by one of the threads and returns a future to wait for it.
+	 *
+	 * @note	If the pool was shut down the task is not queued and the returned future is already cancelled.
+	 *
+	 * @param	pTask	The task, has to stay valid until the future is done.
+	 *
+	 * @return	The future of the task, call Future::release() when you do not need it anymore.
+	 */
+	Future* ThreadPool::submitWithFuture( Task* pTask )
+	{
+		// one reference for the caller and one for the thread that completes the task
+		Future* pFuture = new Future( this, pTask, 2 );
+
+		if( !enqueue( pTask, pFuture ) )
+		{
+			pFuture->m_uiState.store( Future::FS_Cancelled );
+			pFuture->m_uiReferences.store( 1 );
+		}
+
+		return pFuture;
+	}
+
+
+	/**
+	 * @brief	Stops accepting tasks and waits for the threads of the pool to finish.
+	 *
+	 * @note	Tasks submitted afterwards are rejected, so a task that resubmits itself has to handle that.
+	 * 			Tasks that are not executed get Task::cancel() called and their futures are cancelled.
+	 * 			Only the first call has an effect and it must not be made from a task of this pool.
+	 *
+	 * @param	bFinishQueued	true to execute all queued tasks first, false to only finish the running ones.
+	 */
+	void ThreadPool::shutdown( bool bFinishQueued )
+	{
+		unsigned int uiRunning = PS_Running;
+		if( !m_uiState.compareExchange( uiRunning, bFinishQueued ? PS_Draining : PS_Stopped ) )
+			return;
+
+		// a thread that saw the pool running might still put its task into a queue
+		while( m_uiSubmitting.load() > 0 )
+			Thread::sleep( 0 );
+
+		m_pmxSleep->lock();
+		m_pcvTaskSubmitted->broadcast();
+		m_pmxSleep->unlock();
+
+		for( unsigned int i = 0; i < m_vpWorkers.size(); i++ )
+			m_vpWorkers[i]->join();
+
+		QueuedTask task;
+		while( findTask( 0, task ) )
+		{
+			task.pTask->cancel();
+			if( task.pFuture )
+				task.pFuture->complete( Future::FS_Cancelled );
+		}
+	}
+
+
+	/**
+	 * @brief	Get the number of cores of this machine.
+	 *
+	 * @return	The number of online cores, at least 1.
+	 */
+	unsigned int ThreadPool::getNumCores()
+	{
+#ifdef linux
+		long lCores = sysconf( _SC_NPROCESSORS_ONLN );
+		return lCores > 0 ? (unsigned int)lCores : 1;
+#else
+		SYSTEM_INFO sysInfo;
+		GetSystemInfo( &sysInfo );
+		return sysInfo.dwNumberOfProcessors > 0 ? sysInfo.dwNumberOfProcessors : 1;
+#endif
+	}
+
+
+	/**
+	 * @brief	Returns the pool that is shared by the whole process, with one thread per core.
+	 *
+	 * @note	The pool is created by the first call and lives until the process exits,
+	 * 			e.g. MessageBroker::setThreadPool( ThreadPool::getDefault() ) lets the brokers use it.
+	 *
+	 * @return	The default pool.
+	 */
+	ThreadPool* ThreadPool::getDefault()
+	{
+		ThreadPool* pPool = sm_pDefault.load();
+		if( pPool )
+			return pPool;
+
+		// two threads might create a pool at the same time, only one of them is kept
+		ThreadPool* pNewPool = new ThreadPool();
+		if( sm_pDefault.compareExchange( pPool, pNewPool ) )
+			return pNewPool;
+
+		delete pNewPool;
+		return pPool;
+	}
+
+
+	/**
+	 * @brief	Puts a task into the queue of the next worker, used by submit() and submitWithFuture().
+	 *
+	 * @param	pTask  	The task.
+	 * @param	pFuture	The future of the task or NULL.
+	 *
+	 * @return	true if the task was queued, false if the pool was shut down.
+	 */
+	bool ThreadPool::enqueue( Task* pTask, Future* pFuture )
+	{
+		// shutdown() changes the state before it waits for m_uiSubmitting, so either it waits for this task or it is rejected
+		m_uiSubmitting.fetchAdd( 1 );
+		if( m_uiState.load() != PS_Running )
+		{
+			m_uiSubmitting.fetchAdd( (unsigned int)-1 );
+			return false;
+		}
+
+		// a worker keeps the tasks it submits, e.g. a broker that queues itself again stays on the warm thread unless
+		// an idle thread steals it, everyone else distributes the tasks round-robin
+		Worker* pWorker = NULL;
+		if( tl_pPool == this )
+			pWorker = m_vpWorkers[tl_uiWorker];
+		else
+			pWorker = m_vpWorkers[m_uiNextWorker.fetchAdd( 1 ) % m_vpWorkers.size()];
+
+		// count the task first so the counter never drops below the number of queued tasks
+		m_uiPendingTasks.fetchAdd( 1 );
+
+		QueuedTask task;
+		task.pTask = pTask;
+		task.pFuture = pFuture;
+
+		pWorker->m_mxTasks.lock();
+		pWorker->m_dqTasks.push_back( task );
+		pWorker->m_mxTasks.unlock();
+
+		m_uiSubmitting.fetchAdd( (unsigned int)-1 );
+
+		// a thread going to sleep increments m_uiSleeping before checking m_uiPendingTasks, so it can not miss this
+		if( m_uiSleeping.load() > 0 )
+		{
+			m_pmxSleep->lock();
+			m_pcvTaskSubmitted->signal();
+			m_pmxSleep->unlock();
+		}
+
+		return true;
+	}
+
+
+	/**
+	 * @brief	Takes the next task from the queue of the given worker or steals one from another worker.
+	 *
+	 * @param	uiWorker	Index of the worker looking for a task.
+	 * @param	task		Receives the task.
+	 *
+	 * @return	true if a task was found, false if all queues are empty.
+	 */
+	bool ThreadPool::findTask( unsigned int uiWorker, QueuedTask& task )
+	{
+		for( unsigned int i = 0; i < m_vpWorkers.size(); i++ )
+		{
+			Worker* pWorker = m_vpWorkers[(uiWorker + i) % m_vpWorkers.size()];
+
+			pWorker->m_mxTasks.lock();
+			if( !pWorker->m_dqTasks.empty() )
+			{
+				// the own queue is worked off in order, thieves take the most recently submitted task
+				if( i == 0 )
+				{
+					task = pWorker->m_dqTasks.front();
+					pWorker->m_dqTasks.pop_front();
+				}
+				else
+				{
+					task = pWorker->m_dqTasks.back();
+					pWorker->m_dqTasks.pop_back();
+				}
+				pWorker->m_mxTasks.unlock();
+
+				m_uiPendingTasks.fetchAdd( (unsigned int)-1 );
+				return true;
+			}
+			pWorker->m_mxTasks.unlock();
+		}
+
+		return false;
+	}
+
+
+	/**
+	 * @brief	Blocks the calling worker until a task was submitted or the pool is shut down.
+	 */
+	void ThreadPool::waitForTask()
+	{
+		m_pmxSleep->lock();
+		m_uiSleeping.fetchAdd( 1 );
+
+		while( m_uiPendingTasks.load() == 0 && m_uiState.load() == PS_Running )
+			m_pcvTaskSubmitted->wait( *m_pmxSleep );
+
+		m_uiSleeping.fetchAdd( (unsigned int)-1 );
+		m_pmxSleep->unlock();
+	}
+
+
+	// ******************** Future *********************
+
+	/**
+	 * @brief	Get a monotonic time stamp, used for the time limit of Future::wait().
+	 *
+	 * @return	The time in milliseconds since an unspecified point.
+	 */
+	static unsigned int getMilliseconds()
+	{
+#ifdef linux
+		struct timespec ts;
+		clock_gettime( CLOCK_MONOTONIC, &ts );
+		return (unsigned int)( ts.tv_sec * 1000 + ts.tv_nsec / 1000000 );
+#else
+		return (unsigned int)GetTickCount();
+#endif
+	}
+
+
+	/**
+	 * @brief	Constructor, only used by ThreadPool::submitWithFuture().
+	 *
+	 * @param [in]	pPool			The pool that executes the task.
+	 * @param [in]	pTask			The task.
+	 * @param		uiReferences	The number of owners of the future.
+	 */
+	Future::Future( ThreadPool* pPool, Task* pTask, unsigned int uiReferences )
+		: m_pPool( pPool )
+		, m_pTask( pTask )
+		, m_uiState( FS_Pending )
+		, m_uiReferences( uiReferences )
+	{
+	}
+
+
+	/**
+	 * @brief	Blocks until the task was executed or cancelled.
+	 *
+	 * @param	iMilliseconds	The maximum time to wait, -1 to wait without limit.
+	 *
+	 * @return	true if the task is done, false if the time ran out.
+	 */
+	bool Future::wait( int iMilliseconds )
+	{
+		if( isDone() )
+			return true;
+
+		unsigned int uiDeadline = getMilliseconds() + iMilliseconds;
+
+		m_pPool->m_pmxSleep->lock();
+
+		// complete() checks m_uiWaiting after changing the state, so either it sees the waiter or the task is done here
+		m_pPool->m_uiWaiting.fetchAdd( 1 );
+
+		while( !isDone() )
+		{
+			if( iMilliseconds < 0 )
+				m_pPool->m_pcvTaskDone->wait( *m_pPool->m_pmxSleep );
+			else
+			{
+				// the condition is shared by all futures of the pool, so the time left has to be recalculated
+				int iLeft = (int)( uiDeadline - getMilliseconds() );
+				if( iLeft <= 0 )
+					break;
+				m_pPool->m_pcvTaskDone->wait( *m_pPool->m_pmxSleep, iLeft );
+			}
+		}
+
+		m_pPool->m_uiWaiting.fetchAdd( (unsigned int)-1 );
+		m_pPool->m_pmxSleep->unlock();
+
+		return isDone();
+	}
+
+
+	/**
+	 * @brief	Releases the reference of the caller, the future must not be used afterwards.
+	 */
+	void Future::release()
+	{
+		if( m_uiReferences.fetchAdd( (unsigned int)-1 ) == 1 )
+			delete this;
+	}
+
+
+	/**
+	 * @brief	Marks the task as done or cancelled, wakes the waiting threads and releases the reference of the pool.
+	 *
+	 * @param	eState	The new state.
+	 */
+	void Future::complete( EState eState )
+	{
+		m_uiState.store( eState );
+
+		if( m_pPool->m_uiWaiting.load() > 0 )
+		{
+			m_pPool->m_pmxSleep->lock();
+			m_pPool->m_pcvTaskDone->broadcast();
+			m_pPool->m_pmxSleep->unlock();
+		}
+
+		release();
+	}
+
 }
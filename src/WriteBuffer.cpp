@@ -0,0 +1,118 @@
+/*
+Object Oriented Communication Library
+Copyright (c) 2011 Jürgen Lorenz and Jörn Teuber
+
+This software is provided 'as-is', without any express or implied warranty.
+In no event will the authors be held liable for any damages arising from the use of this software.
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it freely,
+subject to the following restrictions:
+
+1. The origin of this software must not be misrepresented; you must not claim that you wrote the original software. If you use this software in a product, an acknowledgment in the product documentation would be appreciated but is not required.
+2. Altered source versions must be plainly marked as such, and must not be misrepresented as being the original software.
+3. This notice may not be removed or altered from any source distribution.
+*/
+// This file was written by Jörn Teuber
+
+#include <algorithm>
+
+#include "WriteBuffer.h"
+
+namespace oocl
+{
+	/**
+	 * @brief	Constructor.
+	 *
+	 * @param	uiCapacity	The initial capacity in bytes.
+	 */
+	WriteBuffer::WriteBuffer( unsigned int uiCapacity )
+		: m_pcData( NULL )
+		, m_uiSize( 0 )
+		, m_uiCapacity( 0 )
+	{
+		reserve( uiCapacity );
+	}
+
+
+	/**
+	 * @brief	Destructor.
+	 */
+	WriteBuffer::~WriteBuffer()
+	{
+		delete[] m_pcData;
+	}
+
+
+	/**
+	 * @brief	Appends bytes to the end of the buffer.
+	 *
+	 * @param	pData   	The bytes to append.
+	 * @param	uiLength	The number of bytes.
+	 */
+	void WriteBuffer::append( const void* pData, unsigned int uiLength )
+	{
+		std::memcpy( grow( uiLength ), pData, uiLength );
+	}
+
+
+	/**
+	 * @brief	Appends uiLength uninitialized bytes and returns a pointer to them, e.g. to write a body in place.
+	 *
+	 * @param	uiLength	The number of bytes to append.
+	 *
+	 * @return	Pointer to the first appended byte, valid until the buffer grows again.
+	 */
+	char* WriteBuffer::grow( unsigned int uiLength )
+	{
+		if( m_uiSize + uiLength > m_uiCapacity )
+		{
+			unsigned int uiNewCapacity = m_uiCapacity * 2;
+			if( uiNewCapacity < m_uiSize + uiLength )
+				uiNewCapacity = m_uiSize + uiLength;
+
+			reserve( uiNewCapacity );
+		}
+
+		char* pcDest = m_pcData + m_uiSize;
+		m_uiSize += uiLength;
+
+		return pcDest;
+	}
+
+
+	/**
+	 * @brief	Makes sure the buffer can hold at least uiCapacity bytes without allocating.
+	 *
+	 * @param	uiCapacity	The needed capacity.
+	 */
+	void WriteBuffer::reserve( unsigned int uiCapacity )
+	{
+		if( uiCapacity <= m_uiCapacity )
+			return;
+
+		char* pcNewData = new char[uiCapacity];
+
+		if( m_pcData != NULL )
+		{
+			std::memcpy( pcNewData, m_pcData, m_uiSize );
+			delete[] m_pcData;
+		}
+
+		m_pcData = pcNewData;
+		m_uiCapacity = uiCapacity;
+	}
+
+
+	/**
+	 * @brief	Exchanges the contents of two buffers without copying them.
+	 *
+	 * @param [in,out]	other	The buffer to swap with.
+	 */
+	void WriteBuffer::swap( WriteBuffer& other )
+	{
+		std::swap( m_pcData, other.m_pcData );
+		std::swap( m_uiSize, other.m_uiSize );
+		std::swap( m_uiCapacity, other.m_uiCapacity );
+	}
+
+}
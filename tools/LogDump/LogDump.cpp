@@ -0,0 +1,76 @@
+// LogDump.cpp : Turns the files of a log in binary mode back into text, see oocl::Log::setBinary().
+// Usage: oocl_logdump [-s] file.blog...
+// The files are printed from the oldest to the newest, -s appends the source file and line of every message.
+//
+
+#include <BinaryLogFile.h>
+
+#include <iostream>
+#include <vector>
+#include <algorithm>
+#include <cstring>
+
+/**
+ * @brief	Orders readers by the time their files were opened.
+ */
+bool isOlder( const oocl::BinaryLogReader* pFirst, const oocl::BinaryLogReader* pSecond )
+{
+	const oocl::BinaryLogFile::FileHeader& first = pFirst->getHeader();
+	const oocl::BinaryLogFile::FileHeader& second = pSecond->getHeader();
+
+	if( first.llStartSeconds != second.llStartSeconds )
+		return first.llStartSeconds < second.llStartSeconds;
+	if( first.llStartMicroseconds != second.llStartMicroseconds )
+		return first.llStartMicroseconds < second.llStartMicroseconds;
+
+	return first.uiSequence < second.uiSequence;
+}
+
+int main( int argc, char** argv )
+{
+	bool bWithSource = false;
+	std::vector<oocl::BinaryLogReader*> vpReaders;
+	int iReturn = 0;
+
+	for( int i = 1; i < argc; i++ )
+	{
+		if( strcmp( argv[i], "-s" ) == 0 )
+		{
+			bWithSource = true;
+			continue;
+		}
+
+		oocl::BinaryLogReader* pReader = new oocl::BinaryLogReader();
+		if( pReader->open( argv[i] ) )
+		{
+			vpReaders.push_back( pReader );
+		}
+		else
+		{
+			std::cerr << argv[i] << " is not a binary log file" << std::endl;
+			delete pReader;
+			iReturn = 1;
+		}
+	}
+
+	if( vpReaders.empty() )
+	{
+		std::cerr << "usage: oocl_logdump [-s] file.blog..." << std::endl;
+		return 1;
+	}
+
+	std::stable_sort( vpReaders.begin(), vpReaders.end(), isOlder );
+
+	std::string strLine;
+	for( std::vector<oocl::BinaryLogReader*>::iterator it = vpReaders.begin(); it != vpReaders.end(); ++it )
+	{
+		while( (*it)->next( strLine, bWithSource ) )
+			std::cout << strLine << '\n';
+
+		delete *it;
+	}
+
+	std::cout.flush();
+
+	return iReturn;
+}